@@ -1514,6 +1514,50 @@ fwupd_client_get_approved_firmware (FwupdClient *client,
 	return retval;
 }
 
+/**
+ * fwupd_client_get_memory_stats:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets the memory used by the daemon, which is only useful for debugging.
+ *
+ * Returns: (transfer full): a #GVariant of type `a{sv}`, or %NULL
+ *
+ * Since: 1.4.0
+ **/
+GVariant *
+fwupd_client_get_memory_stats (FwupdClient *client,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetMemoryStats",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return g_variant_get_child_value (val, 0);
+}
+
 /**
  * fwupd_client_set_approved_firmware:
  * @client: A #FwupdClient
@@ -146,6 +146,9 @@ gboolean	 fwupd_client_set_approved_firmware	(FwupdClient	*client,
 							 gchar		**checksums,
 							 GCancellable	*cancellable,
 							 GError		**error);
+GVariant	*fwupd_client_get_memory_stats		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
 gchar		*fwupd_client_self_sign			(FwupdClient	*client,
 							 const gchar	*value,
 							 FwupdSelfSignFlags flags,
@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuBytesView"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-bytes-view.h"
+#include "fu-common.h"
+
+#include "fwupd-error.h"
+
+/**
+ * SECTION:fu-bytes-view
+ * @title: FuBytesView
+ * @short_description: a composite view of blobs and fill ranges
+ *
+ * An object that presents several #GBytes slices and synthetic fill ranges
+ * as one logical buffer, so that firmware can be padded or aligned without
+ * copying the payload. Use fu_bytes_view_flatten() if contiguous memory is
+ * required.
+ */
+
+typedef struct {
+	gsize			 offset;	/* within the view */
+	gsize			 size;
+	GBytes			*bytes;		/* or %NULL for fill */
+	guint8			 fill;
+	GBytes			*fill_blob;	/* lazily allocated for peek */
+} FuBytesViewSegment;
+
+struct _FuBytesView {
+	GObject			 parent_instance;
+	GPtrArray		*segments;	/* of FuBytesViewSegment */
+	GPtrArray		*scratch;	/* of GBytes, kept for peek */
+	gsize			 size;
+};
+
+G_DEFINE_TYPE (FuBytesView, fu_bytes_view, G_TYPE_OBJECT)
+
+static void
+fu_bytes_view_segment_free (FuBytesViewSegment *seg)
+{
+	if (seg->bytes != NULL)
+		g_bytes_unref (seg->bytes);
+	if (seg->fill_blob != NULL)
+		g_bytes_unref (seg->fill_blob);
+	g_free (seg);
+}
+
+static void
+fu_bytes_view_finalize (GObject *obj)
+{
+	FuBytesView *self = FU_BYTES_VIEW (obj);
+
+	g_ptr_array_unref (self->segments);
+	g_ptr_array_unref (self->scratch);
+	G_OBJECT_CLASS (fu_bytes_view_parent_class)->finalize (obj);
+}
+
+static void
+fu_bytes_view_class_init (FuBytesViewClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_bytes_view_finalize;
+}
+
+static void
+fu_bytes_view_init (FuBytesView *self)
+{
+	self->segments = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_bytes_view_segment_free);
+	self->scratch = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+}
+
+/**
+ * fu_bytes_view_add_bytes:
+ * @self: A #FuBytesView
+ * @bytes: A #GBytes
+ *
+ * Appends a blob to the end of the view. The data is not copied.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_bytes_view_add_bytes (FuBytesView *self, GBytes *bytes)
+{
+	FuBytesViewSegment *seg;
+
+	g_return_if_fail (FU_IS_BYTES_VIEW (self));
+	g_return_if_fail (bytes != NULL);
+
+	if (g_bytes_get_size (bytes) == 0)
+		return;
+	seg = g_new0 (FuBytesViewSegment, 1);
+	seg->offset = self->size;
+	seg->size = g_bytes_get_size (bytes);
+	seg->bytes = g_bytes_ref (bytes);
+	g_ptr_array_add (self->segments, seg);
+	self->size += seg->size;
+}
+
+/**
+ * fu_bytes_view_add_fill:
+ * @self: A #FuBytesView
+ * @value: the byte value, typically 0xff
+ * @sz: size in bytes
+ *
+ * Appends a range of repeated bytes to the end of the view. No memory is
+ * allocated unless the range is later read using fu_bytes_view_peek().
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_bytes_view_add_fill (FuBytesView *self, guint8 value, gsize sz)
+{
+	FuBytesViewSegment *seg;
+
+	g_return_if_fail (FU_IS_BYTES_VIEW (self));
+
+	if (sz == 0)
+		return;
+
+	/* just extend the previous fill */
+	if (self->segments->len > 0) {
+		seg = g_ptr_array_index (self->segments, self->segments->len - 1);
+		if (seg->bytes == NULL && seg->fill == value) {
+			seg->size += sz;
+			self->size += sz;
+			return;
+		}
+	}
+	seg = g_new0 (FuBytesViewSegment, 1);
+	seg->offset = self->size;
+	seg->size = sz;
+	seg->fill = value;
+	g_ptr_array_add (self->segments, seg);
+	self->size += sz;
+}
+
+/**
+ * fu_bytes_view_align:
+ * @self: A #FuBytesView
+ * @blksz: block size in bytes
+ * @padval: the byte used to pad the view
+ *
+ * Aligns the view to @blksz using the @padval value, without copying.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_bytes_view_align (FuBytesView *self, gsize blksz, guint8 padval)
+{
+	g_return_if_fail (FU_IS_BYTES_VIEW (self));
+	g_return_if_fail (blksz > 0);
+
+	if (self->size % blksz != 0) {
+		gsize sz_align = ((self->size / blksz) + 1) * blksz;
+		g_debug ("aligning 0x%x bytes to 0x%x",
+			 (guint) self->size, (guint) sz_align);
+		fu_bytes_view_add_fill (self, padval, sz_align - self->size);
+	}
+}
+
+/**
+ * fu_bytes_view_pad:
+ * @self: A #FuBytesView
+ * @sz: the desired size in bytes
+ * @padval: the byte used to pad the view
+ *
+ * Pads the view to a given @sz using the @padval value, without copying.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_bytes_view_pad (FuBytesView *self, gsize sz, guint8 padval)
+{
+	g_return_if_fail (FU_IS_BYTES_VIEW (self));
+	g_return_if_fail (self->size <= sz);
+	fu_bytes_view_add_fill (self, padval, sz - self->size);
+}
+
+/**
+ * fu_bytes_view_get_size:
+ * @self: A #FuBytesView
+ *
+ * Gets the logical size of the view.
+ *
+ * Returns: size in bytes
+ *
+ * Since: 1.4.0
+ **/
+gsize
+fu_bytes_view_get_size (FuBytesView *self)
+{
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), 0);
+	return self->size;
+}
+
+/**
+ * fu_bytes_view_get_segments:
+ * @self: A #FuBytesView
+ *
+ * Gets the number of blob and fill ranges that make up the view.
+ *
+ * Returns: integer
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_bytes_view_get_segments (FuBytesView *self)
+{
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), 0);
+	return self->segments->len;
+}
+
+static guint
+fu_bytes_view_find_segment (FuBytesView *self, gsize offset)
+{
+	guint lo = 0;
+	guint hi = self->segments->len;
+	while (hi - lo > 1) {
+		guint mid = lo + (hi - lo) / 2;
+		FuBytesViewSegment *seg = g_ptr_array_index (self->segments, mid);
+		if (seg->offset <= offset)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static gboolean
+fu_bytes_view_check_range (FuBytesView *self, gsize offset, gsize length, GError **error)
+{
+	if (offset > self->size || length > self->size - offset) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "requested range 0x%x:0x%x outside of view size 0x%x",
+			     (guint) offset, (guint) length, (guint) self->size);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_bytes_view_read:
+ * @self: A #FuBytesView
+ * @offset: offset into the view
+ * @buf: destination buffer
+ * @bufsz: number of bytes to copy into @buf
+ * @error: A #GError, or %NULL
+ *
+ * Copies a range of the view into a caller-provided buffer.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_bytes_view_read (FuBytesView *self,
+		    gsize offset,
+		    guint8 *buf,
+		    gsize bufsz,
+		    GError **error)
+{
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), FALSE);
+	g_return_val_if_fail (buf != NULL || bufsz == 0, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_bytes_view_check_range (self, offset, bufsz, error))
+		return FALSE;
+	for (guint i = fu_bytes_view_find_segment (self, offset);
+	     bufsz > 0 && i < self->segments->len; i++) {
+		FuBytesViewSegment *seg = g_ptr_array_index (self->segments, i);
+		gsize seg_offset = offset - seg->offset;
+		gsize n = MIN (seg->size - seg_offset, bufsz);
+		if (seg->bytes != NULL) {
+			const guint8 *data = g_bytes_get_data (seg->bytes, NULL);
+			memcpy (buf, data + seg_offset, n);
+		} else {
+			memset (buf, seg->fill, n);
+		}
+		buf += n;
+		offset += n;
+		bufsz -= n;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_bytes_view_peek:
+ * @self: A #FuBytesView
+ * @offset: offset into the view
+ * @length: number of bytes
+ * @error: A #GError, or %NULL
+ *
+ * Gets a pointer to a contiguous range of the view. If the range is contained
+ * in one blob no data is copied, otherwise the range is assembled into
+ * memory owned by @self.
+ *
+ * Returns: (transfer none): data valid for the lifetime of @self, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+const guint8 *
+fu_bytes_view_peek (FuBytesView *self, gsize offset, gsize length, GError **error)
+{
+	FuBytesViewSegment *seg;
+	guint8 *buf;
+
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), NULL);
+	g_return_val_if_fail (length > 0, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!fu_bytes_view_check_range (self, offset, length, error))
+		return NULL;
+	seg = g_ptr_array_index (self->segments, fu_bytes_view_find_segment (self, offset));
+	if (offset + length <= seg->offset + seg->size) {
+		if (seg->bytes != NULL) {
+			const guint8 *data = g_bytes_get_data (seg->bytes, NULL);
+			return data + (offset - seg->offset);
+		}
+
+		/* the fill blob is shared by every range inside this segment,
+		 * so it only ever needs to be as large as the biggest read */
+		if (seg->fill_blob == NULL || g_bytes_get_size (seg->fill_blob) < length) {
+			buf = g_malloc (length);
+			memset (buf, seg->fill, length);
+			if (seg->fill_blob != NULL)
+				g_ptr_array_add (self->scratch, seg->fill_blob);
+			seg->fill_blob = g_bytes_new_take (buf, length);
+		}
+		return g_bytes_get_data (seg->fill_blob, NULL);
+	}
+
+	/* spans a segment boundary */
+	buf = g_malloc (length);
+	if (!fu_bytes_view_read (self, offset, buf, length, error)) {
+		g_free (buf);
+		return NULL;
+	}
+	g_ptr_array_add (self->scratch, g_bytes_new_take (buf, length));
+	return buf;
+}
+
+/**
+ * fu_bytes_view_get_range:
+ * @self: A #FuBytesView
+ * @offset: offset into the view
+ * @length: number of bytes
+ * @error: A #GError, or %NULL
+ *
+ * Gets a range of the view as a new blob. If the range is contained in one
+ * blob then a zero-copy sub-blob is returned.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_bytes_view_get_range (FuBytesView *self, gsize offset, gsize length, GError **error)
+{
+	FuBytesViewSegment *seg;
+	g_autofree guint8 *buf = NULL;
+
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!fu_bytes_view_check_range (self, offset, length, error))
+		return NULL;
+	if (length == 0)
+		return g_bytes_new (NULL, 0);
+	seg = g_ptr_array_index (self->segments, fu_bytes_view_find_segment (self, offset));
+	if (seg->bytes != NULL && offset + length <= seg->offset + seg->size)
+		return g_bytes_new_from_bytes (seg->bytes, offset - seg->offset, length);
+	buf = g_malloc (length);
+	if (!fu_bytes_view_read (self, offset, buf, length, error))
+		return NULL;
+	return g_bytes_new_take (g_steal_pointer (&buf), length);
+}
+
+/**
+ * fu_bytes_view_flatten:
+ * @self: A #FuBytesView
+ *
+ * Gets the whole view as contiguous memory. If the view is made up of just
+ * one blob then no data is copied.
+ *
+ * Returns: (transfer full): a #GBytes
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_bytes_view_flatten (FuBytesView *self)
+{
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), NULL);
+	return fu_bytes_view_get_range (self, 0, self->size, NULL);
+}
+
+/**
+ * fu_bytes_view_is_empty:
+ * @self: A #FuBytesView
+ *
+ * Checks if the view is just empty (0xff) bytes.
+ *
+ * Returns: %TRUE if @self is empty
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_bytes_view_is_empty (FuBytesView *self)
+{
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), FALSE);
+	for (guint i = 0; i < self->segments->len; i++) {
+		FuBytesViewSegment *seg = g_ptr_array_index (self->segments, i);
+		if (seg->bytes == NULL) {
+			if (seg->fill != 0xff)
+				return FALSE;
+			continue;
+		}
+		if (!fu_common_bytes_is_empty (seg->bytes))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_bytes_view_compute_checksum:
+ * @self: A #FuBytesView
+ * @checksum_type: A #GChecksumType, e.g. %G_CHECKSUM_SHA256
+ *
+ * Computes the checksum of the whole view without flattening it.
+ *
+ * Returns: (transfer full): the hexadecimal checksum
+ *
+ * Since: 1.4.0
+ **/
+gchar *
+fu_bytes_view_compute_checksum (FuBytesView *self, GChecksumType checksum_type)
+{
+	guint8 fill[0x400];
+	g_autoptr(GChecksum) csum = g_checksum_new (checksum_type);
+
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), NULL);
+
+	for (guint i = 0; i < self->segments->len; i++) {
+		FuBytesViewSegment *seg = g_ptr_array_index (self->segments, i);
+		if (seg->bytes != NULL) {
+			gsize bufsz = 0;
+			const guint8 *buf = g_bytes_get_data (seg->bytes, &bufsz);
+			g_checksum_update (csum, buf, (gssize) bufsz);
+			continue;
+		}
+		memset (fill, seg->fill, sizeof(fill));
+		for (gsize j = 0; j < seg->size; j += sizeof(fill))
+			g_checksum_update (csum, fill, (gssize) MIN (sizeof(fill), seg->size - j));
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+/**
+ * fu_bytes_view_crc32:
+ * @self: A #FuBytesView
+ * @kind: A #FuCrcKind, e.g. %FU_CRC_KIND_B32_STANDARD
+ *
+ * Computes the 32 bit cyclic redundancy check of the whole view without
+ * flattening it.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_bytes_view_crc32 (FuBytesView *self, FuCrcKind kind)
+{
+	guint8 fill[0x400];
+	guint32 crc = fu_crc32_init (kind);
+
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (self), 0x0);
+
+	for (guint i = 0; i < self->segments->len; i++) {
+		FuBytesViewSegment *seg = g_ptr_array_index (self->segments, i);
+		if (seg->bytes != NULL) {
+			gsize bufsz = 0;
+			const guint8 *buf = g_bytes_get_data (seg->bytes, &bufsz);
+			crc = fu_crc32_step (kind, buf, bufsz, crc);
+			continue;
+		}
+		memset (fill, seg->fill, sizeof(fill));
+		for (gsize j = 0; j < seg->size; j += sizeof(fill))
+			crc = fu_crc32_step (kind, fill, MIN (sizeof(fill), seg->size - j), crc);
+	}
+	return fu_crc32_done (kind, crc);
+}
+
+/**
+ * fu_bytes_view_new_from_bytes:
+ * @bytes: A #GBytes
+ *
+ * Creates a new view containing just @bytes.
+ *
+ * Returns: (transfer full): a #FuBytesView
+ *
+ * Since: 1.4.0
+ **/
+FuBytesView *
+fu_bytes_view_new_from_bytes (GBytes *bytes)
+{
+	FuBytesView *self = fu_bytes_view_new ();
+	fu_bytes_view_add_bytes (self, bytes);
+	return self;
+}
+
+/**
+ * fu_bytes_view_new:
+ *
+ * Creates a new empty view.
+ *
+ * Returns: (transfer full): a #FuBytesView
+ *
+ * Since: 1.4.0
+ **/
+FuBytesView *
+fu_bytes_view_new (void)
+{
+	FuBytesView *self;
+	self = g_object_new (FU_TYPE_BYTES_VIEW, NULL);
+	return FU_BYTES_VIEW (self);
+}
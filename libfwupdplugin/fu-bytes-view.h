@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "fu-crc.h"
+
+#define FU_TYPE_BYTES_VIEW (fu_bytes_view_get_type ())
+
+G_DECLARE_FINAL_TYPE (FuBytesView, fu_bytes_view, FU, BYTES_VIEW, GObject)
+
+FuBytesView	*fu_bytes_view_new		(void);
+FuBytesView	*fu_bytes_view_new_from_bytes	(GBytes		*bytes);
+void		 fu_bytes_view_add_bytes	(FuBytesView	*self,
+						 GBytes		*bytes);
+void		 fu_bytes_view_add_fill		(FuBytesView	*self,
+						 guint8		 value,
+						 gsize		 sz);
+void		 fu_bytes_view_align		(FuBytesView	*self,
+						 gsize		 blksz,
+						 guint8		 padval);
+void		 fu_bytes_view_pad		(FuBytesView	*self,
+						 gsize		 sz,
+						 guint8		 padval);
+gsize		 fu_bytes_view_get_size		(FuBytesView	*self);
+guint		 fu_bytes_view_get_segments	(FuBytesView	*self);
+gboolean	 fu_bytes_view_read		(FuBytesView	*self,
+						 gsize		 offset,
+						 guint8		*buf,
+						 gsize		 bufsz,
+						 GError		**error);
+const guint8	*fu_bytes_view_peek		(FuBytesView	*self,
+						 gsize		 offset,
+						 gsize		 length,
+						 GError		**error);
+GBytes		*fu_bytes_view_get_range	(FuBytesView	*self,
+						 gsize		 offset,
+						 gsize		 length,
+						 GError		**error);
+GBytes		*fu_bytes_view_flatten		(FuBytesView	*self);
+gboolean	 fu_bytes_view_is_empty		(FuBytesView	*self);
+gchar		*fu_bytes_view_compute_checksum	(FuBytesView	*self,
+						 GChecksumType	 checksum_type);
+guint32		 fu_bytes_view_crc32		(FuBytesView	*self,
+						 FuCrcKind	 kind);
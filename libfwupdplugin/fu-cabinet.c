@@ -13,6 +13,7 @@
 
 #include "fu-cabinet.h"
 #include "fu-common.h"
+#include "fu-trace.h"
 
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
@@ -523,9 +524,11 @@ fu_cabinet_build_silo (FuCabinet *self, GBytes *data, GError **error)
 	xb_builder_add_fixup (self->builder, fixup2);
 
 	/* did we get any valid files */
+	FU_TRACE1 (silo_build_start, "cabinet");
 	self->silo = xb_builder_compile (self->builder,
 					 XB_BUILDER_COMPILE_FLAG_NONE,
 					 NULL, error);
+	FU_TRACE2 (silo_build_done, "cabinet", self->silo != NULL);
 	if (self->silo == NULL)
 		return FALSE;
 
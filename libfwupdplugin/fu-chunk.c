@@ -12,6 +12,8 @@
 
 #include "fu-chunk.h"
 
+#include "fwupd-error.h"
+
 /**
  * SECTION:fu-chunk
  * @short_description: A packet of chunked data
@@ -212,3 +214,56 @@ fu_chunk_array_new_from_bytes (GBytes *blob,
 	return fu_chunk_array_new (data, (guint32) sz,
 				   addr_start, page_sz, packet_sz);
 }
+
+/**
+ * fu_chunk_array_new_from_bytes_view: (skip):
+ * @view: a #FuBytesView
+ * @addr_start: the hardware address offset, or 0
+ * @page_sz: the hardware page size, or 0
+ * @packet_sz: the transfer size, or 0
+ * @error: A #GError, or %NULL
+ *
+ * Chunks a composite view into packets, ensuring each packet does not
+ * cross a package boundary and is less that a specific transfer size.
+ *
+ * Packets that are contained in one blob of @view point directly at that
+ * blob, and only packets spanning a blob or fill boundary are copied. The
+ * packet data is only valid for the lifetime of @view.
+ *
+ * Return value: (transfer container) (element-type FuChunk): array of packets, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GPtrArray *
+fu_chunk_array_new_from_bytes_view (FuBytesView *view,
+				    guint32 addr_start,
+				    guint32 page_sz,
+				    guint32 packet_sz,
+				    GError **error)
+{
+	gsize offset = 0;
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	g_return_val_if_fail (FU_IS_BYTES_VIEW (view), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (fu_bytes_view_get_size (view) == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no data to chunk");
+		return NULL;
+	}
+
+	/* get the layout, then point each packet at the view */
+	chunks = fu_chunk_array_new (NULL, (guint32) fu_bytes_view_get_size (view),
+				     addr_start, page_sz, packet_sz);
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		chk->data = fu_bytes_view_peek (view, offset, chk->data_sz, error);
+		if (chk->data == NULL)
+			return NULL;
+		offset += chk->data_sz;
+	}
+	return g_steal_pointer (&chunks);
+}
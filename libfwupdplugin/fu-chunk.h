@@ -9,6 +9,8 @@
 #include <glib.h>
 #include <gusb.h>
 
+#include "fu-bytes-view.h"
+
 typedef struct {
 	guint32		 idx;
 	guint32		 page;
@@ -34,3 +36,8 @@ GPtrArray	*fu_chunk_array_new_from_bytes		(GBytes		*blob,
 							 guint32	 addr_start,
 							 guint32	 page_sz,
 							 guint32	 packet_sz);
+GPtrArray	*fu_chunk_array_new_from_bytes_view	(FuBytesView	*view,
+							 guint32	 addr_start,
+							 guint32	 page_sz,
+							 guint32	 packet_sz,
+							 GError		**error);
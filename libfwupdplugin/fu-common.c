@@ -22,9 +22,24 @@
 #include <archive_entry.h>
 #include <archive.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <string.h>
 #include <stdlib.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef HAVE_STATVFS_H
+#include <sys/statvfs.h>
+#endif
+
+/* only defined by glibc with _GNU_SOURCE */
+#if defined(__linux__) && !defined(F_GET_SEALS)
+#define F_GET_SEALS				1034
+#define F_SEAL_SHRINK				0x0002
+#define F_SEAL_WRITE				0x0008
+#endif
 
 #include "fwupd-error.h"
 
@@ -196,6 +211,37 @@ fu_common_set_contents_bytes (const gchar *filename, GBytes *bytes, GError **err
 	return g_file_set_contents (filename, data, size, error);
 }
 
+#ifndef _WIN32
+/* a mapping is a live view of the file, so only map data that cannot be
+ * changed or truncated while it is being parsed */
+static gboolean
+fu_common_fd_is_immutable (gint fd, const struct stat *st)
+{
+#ifdef F_GET_SEALS
+	gint seals;
+#endif
+#ifdef HAVE_STATVFS_H
+	struct statvfs stvfs = { 0 };
+#endif
+
+	if (!S_ISREG (st->st_mode))
+		return FALSE;
+#ifdef F_GET_SEALS
+	/* a sealed memfd */
+	seals = fcntl (fd, F_GET_SEALS);
+	if (seals >= 0 &&
+	    (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) == (F_SEAL_WRITE | F_SEAL_SHRINK))
+		return TRUE;
+#endif
+#ifdef HAVE_STATVFS_H
+	/* a read-only filesystem, e.g. a squashfs or a read-only bind mount */
+	if (fstatvfs (fd, &stvfs) == 0 && (stvfs.f_flag & ST_RDONLY) > 0)
+		return TRUE;
+#endif
+	return FALSE;
+}
+#endif
+
 /**
  * fu_common_get_contents_bytes:
  * @filename: A filename
@@ -218,6 +264,66 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
 	return g_bytes_new_take (data, len);
 }
 
+/**
+ * fu_common_get_contents_bytes_mapped:
+ * @filename: A filename
+ * @error: A #GError, or %NULL
+ *
+ * Reads a blob of data from a file by mapping it into memory, so that only
+ * the pages that are actually read are loaded from disk. The mapping is
+ * removed when the last reference to the #GBytes is dropped.
+ *
+ * A mapping shows any later change to the file, and truncating the file
+ * would crash the process, so the file is only mapped if it cannot be
+ * modified at all, i.e. it is on a read-only filesystem or is a memfd sealed
+ * against writing and shrinking. Otherwise the contents are copied, exactly
+ * as fu_common_get_contents_bytes() would do.
+ *
+ * Returns: a #GBytes, or %NULL for failure
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_common_get_contents_bytes_mapped (const gchar *filename, GError **error)
+{
+#ifndef _WIN32
+	gint fd;
+	struct stat st = { 0 };
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GMappedFile) mapped = NULL;
+#endif
+
+	g_return_val_if_fail (filename != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+#ifndef _WIN32
+	/* any error is reported by the fallback with the usual domain */
+	fd = g_open (filename, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0)
+		return fu_common_get_contents_bytes (filename, error);
+	if (fstat (fd, &st) < 0 ||
+	    st.st_size == 0 ||
+	    !fu_common_fd_is_immutable (fd, &st)) {
+		g_close (fd, NULL);
+		return fu_common_get_contents_bytes (filename, error);
+	}
+
+	/* the mapping is still valid after the fd is closed */
+	mapped = g_mapped_file_new_from_fd (fd, FALSE, &error_local);
+	g_close (fd, NULL);
+	if (mapped == NULL) {
+		g_debug ("failed to map %s, copying: %s",
+			 filename, error_local->message);
+		return fu_common_get_contents_bytes (filename, error);
+	}
+	g_debug ("mapping %s with %" G_GSIZE_FORMAT " bytes",
+		 filename, g_mapped_file_get_length (mapped));
+	return g_mapped_file_get_bytes (mapped);
+#else
+	return fu_common_get_contents_bytes (filename, error);
+#endif
+}
+
 /**
  * fu_common_get_contents_fd:
  * @fd: A file descriptor
@@ -1443,6 +1549,9 @@ fu_common_dump_bytes (const gchar *log_domain,
  * Aligns a block of memory to @blksize using the @padval value; if
  * the block is already aligned then the original @bytes is returned.
  *
+ * This copies the whole blob; use fu_bytes_view_align() if the result does
+ * not need to be contiguous in memory.
+ *
  * Returns: (transfer full): a #GBytes, possibly @bytes
  *
  * Since: 1.2.4
@@ -1579,6 +1688,9 @@ fu_common_bytes_compare (GBytes *bytes1, GBytes *bytes2, GError **error)
  *
  * Pads a GBytes to a given @sz with `0xff`.
  *
+ * This copies the whole blob; use fu_bytes_view_pad() if the result does
+ * not need to be contiguous in memory.
+ *
  * Return value: (transfer full): a #GBytes
  *
  * Since: 1.3.1
@@ -1963,3 +2075,141 @@ fu_common_kernel_locked_down (void)
 	return FALSE;
 #endif
 }
+
+/* each verbose environment variable gets one bit of the mask */
+#define FU_COMMON_VERBOSE_FLAG_MAX	32
+
+static GMutex		 fu_common_verbose_mutex;
+static GHashTable	*fu_common_verbose_flags = NULL;	/* env:flag */
+static guint		 fu_common_verbose_mask = 0;		/* atomic */
+
+static gboolean
+fu_common_verbose_is_category (const gchar *env)
+{
+	if (!g_str_has_suffix (env, "_VERBOSE"))
+		return FALSE;
+	return g_str_has_prefix (env, "FU_") || g_str_has_prefix (env, "FWUPD_");
+}
+
+/* must be called with the mutex held, and returns 0 if there are no flags left */
+static guint
+fu_common_verbose_register (const gchar *env)
+{
+	guint flag;
+	guint idx = g_hash_table_size (fu_common_verbose_flags);
+
+	flag = GPOINTER_TO_UINT (g_hash_table_lookup (fu_common_verbose_flags, env));
+	if (flag != 0)
+		return flag;
+	if (idx >= FU_COMMON_VERBOSE_FLAG_MAX)
+		return 0;
+	flag = 1u << idx;
+	g_hash_table_insert (fu_common_verbose_flags,
+			     g_strdup (env),
+			     GUINT_TO_POINTER (flag));
+	return flag;
+}
+
+/* must be called with the mutex held */
+static void
+fu_common_verbose_ensure (void)
+{
+	g_auto(GStrv) envp = NULL;
+
+	if (fu_common_verbose_flags != NULL)
+		return;
+
+	/* only look at the environment once */
+	fu_common_verbose_flags = g_hash_table_new_full (g_str_hash, g_str_equal,
+							 g_free, NULL);
+	envp = g_get_environ ();
+	for (guint i = 0; envp[i] != NULL; i++) {
+		guint flag;
+		g_auto(GStrv) split = g_strsplit (envp[i], "=", 2);
+		if (!fu_common_verbose_is_category (split[0]))
+			continue;
+		flag = fu_common_verbose_register (split[0]);
+		if (flag == 0) {
+			g_warning ("no verbose flags left for %s", split[0]);
+			continue;
+		}
+		g_atomic_int_or (&fu_common_verbose_mask, flag);
+	}
+}
+
+/**
+ * fu_common_verbose_get_flag:
+ * @env: an environment variable name, e.g. `FU_HID_DEVICE_VERBOSE`
+ *
+ * Gets the flag used for the verbose category. Most callers should use
+ * the fu_common_is_verbose() macro instead, which caches the flag.
+ *
+ * Returns: a flag, or 0 if all the flags are already in use
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_common_verbose_get_flag (const gchar *env)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_common_verbose_mutex);
+	g_return_val_if_fail (env != NULL, 0);
+	fu_common_verbose_ensure ();
+	return fu_common_verbose_register (env);
+}
+
+/**
+ * fu_common_verbose_has_flag:
+ * @flag: a flag from fu_common_verbose_get_flag()
+ *
+ * Checks if the verbose category is enabled.
+ *
+ * Returns: %TRUE if enabled
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_common_verbose_has_flag (guint flag)
+{
+	return (g_atomic_int_get (&fu_common_verbose_mask) & flag) > 0;
+}
+
+/**
+ * fu_common_verbose_set:
+ * @env: an environment variable name, e.g. `FU_HID_DEVICE_VERBOSE`
+ * @enabled: if the verbose category should be enabled
+ * @error: A #GError, or %NULL
+ *
+ * Enables or disables a verbose category at runtime.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_common_verbose_set (const gchar *env, gboolean enabled, GError **error)
+{
+	guint flag;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_common_verbose_mutex);
+
+	g_return_val_if_fail (env != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	fu_common_verbose_ensure ();
+
+	/* disabling never needs a new flag */
+	if (!enabled) {
+		flag = GPOINTER_TO_UINT (g_hash_table_lookup (fu_common_verbose_flags, env));
+		g_atomic_int_and (&fu_common_verbose_mask, ~flag);
+		return TRUE;
+	}
+	flag = fu_common_verbose_register (env);
+	if (flag == 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "no verbose flags left for %s", env);
+		return FALSE;
+	}
+	g_atomic_int_or (&fu_common_verbose_mask, flag);
+	return TRUE;
+}
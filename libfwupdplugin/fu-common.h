@@ -104,6 +104,8 @@ gboolean	 fu_common_set_contents_bytes	(const gchar	*filename,
 						 GError		**error);
 GBytes		*fu_common_get_contents_bytes	(const gchar	*filename,
 						 GError		**error);
+GBytes		*fu_common_get_contents_bytes_mapped (const gchar	*filename,
+						 GError		**error);
 GBytes		*fu_common_get_contents_fd	(gint		 fd,
 						 gsize		 count,
 						 GError		**error);
@@ -217,3 +219,27 @@ gchar		**fu_common_strnsplit		(const gchar	*str,
 						 const gchar	*delimiter,
 						 gint		 max_tokens);
 gboolean	 fu_common_kernel_locked_down	(void);
+
+guint		 fu_common_verbose_get_flag	(const gchar	*env);
+gboolean	 fu_common_verbose_has_flag	(guint		 flag);
+gboolean	 fu_common_verbose_set		(const gchar	*env,
+						 gboolean	 enabled,
+						 GError		**error);
+
+/**
+ * fu_common_is_verbose:
+ * @env: an environment variable name, e.g. `FU_HID_DEVICE_VERBOSE`
+ *
+ * Checks if the verbose category is enabled. The environment is only
+ * read once, so this is cheap enough to use in I/O helpers.
+ *
+ * Returns: %TRUE if enabled
+ *
+ * Since: 1.4.0
+ **/
+#define fu_common_is_verbose(env) __extension__ ({				\
+	static guint _fu_common_verbose_flag = 0;				\
+	if (G_UNLIKELY (_fu_common_verbose_flag == 0))				\
+		_fu_common_verbose_flag = fu_common_verbose_get_flag (env);	\
+	G_UNLIKELY (fu_common_verbose_has_flag (_fu_common_verbose_flag));	\
+})
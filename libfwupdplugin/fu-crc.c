@@ -0,0 +1,515 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuCommon"
+
+#include <config.h>
+
+#include <string.h>
+
+#if defined(HAVE_CPUID_H) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define FU_CRC_HAVE_PCLMUL
+#endif
+
+#if defined(HAVE_AUXV_H) && defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32				(1 << 7)
+#endif
+#define FU_CRC_HAVE_ARMV8
+#endif
+
+#include "fu-crc.h"
+
+typedef struct {
+	guint		 width;
+	guint32		 poly;
+	guint32		 init;
+	gboolean	 refin;
+	gboolean	 refout;
+	guint32		 xorout;
+} FuCrcMap;
+
+static const FuCrcMap crc_map[] = {
+	[FU_CRC_KIND_UNKNOWN] =		{ 0, 0x0, 0x0, FALSE, FALSE, 0x0 },
+	[FU_CRC_KIND_B8_STANDARD] =	{ 8, 0x07, 0x00, FALSE, FALSE, 0x00 },
+	[FU_CRC_KIND_B8_DVB_S2] =	{ 8, 0xd5, 0x00, FALSE, FALSE, 0x00 },
+	[FU_CRC_KIND_B8_WACOM] =	{ 8, 0x31, 0x00, FALSE, TRUE, 0x00 },
+	[FU_CRC_KIND_B16_USB] =		{ 16, 0x8005, 0xffff, TRUE, TRUE, 0xffff },
+	[FU_CRC_KIND_B16_UMTS] =	{ 16, 0x8005, 0x0000, FALSE, FALSE, 0x0000 },
+	[FU_CRC_KIND_B32_STANDARD] =	{ 32, 0x04c11db7, 0xffffffff, TRUE, TRUE, 0xffffffff },
+	[FU_CRC_KIND_B32_JAMCRC] =	{ 32, 0x04c11db7, 0xffffffff, TRUE, TRUE, 0x00000000 },
+	[FU_CRC_KIND_B32_MPEG2] =	{ 32, 0x04c11db7, 0xffffffff, FALSE, FALSE, 0x00000000 },
+};
+
+typedef guint32 (*FuCrc32UpdateFunc)	(guint32	 crc,
+					 const guint8	*buf,
+					 gsize		 bufsz);
+
+/* one table per kind for the bytewise path, and the slicing-by-8 tables
+ * for the reflected 0x04c11db7 polynomial used by most of the firmware
+ * formats; all are generated on first use */
+static guint32 crc_tables[FU_CRC_KIND_LAST][256];
+static guint32 crc_slice8[8][256];
+static FuCrc32UpdateFunc crc32_update_func = NULL;
+
+const gchar *
+fu_crc_kind_to_string (FuCrcKind kind)
+{
+	if (kind == FU_CRC_KIND_B8_STANDARD)
+		return "b8-standard";
+	if (kind == FU_CRC_KIND_B8_DVB_S2)
+		return "b8-dvb-s2";
+	if (kind == FU_CRC_KIND_B8_WACOM)
+		return "b8-wacom";
+	if (kind == FU_CRC_KIND_B16_USB)
+		return "b16-usb";
+	if (kind == FU_CRC_KIND_B16_UMTS)
+		return "b16-umts";
+	if (kind == FU_CRC_KIND_B32_STANDARD)
+		return "b32-standard";
+	if (kind == FU_CRC_KIND_B32_JAMCRC)
+		return "b32-jamcrc";
+	if (kind == FU_CRC_KIND_B32_MPEG2)
+		return "b32-mpeg2";
+	return NULL;
+}
+
+static guint32
+fu_crc_reflect (guint32 value, guint width)
+{
+	guint32 tmp = 0;
+	for (guint i = 0; i < width; i++) {
+		if (value & (1u << i))
+			tmp |= 1u << (width - 1 - i);
+	}
+	return tmp;
+}
+
+static guint32
+fu_crc_mask (guint width)
+{
+	return width == 32 ? 0xffffffff : (1u << width) - 1;
+}
+
+static void
+fu_crc_tables_init_kind (FuCrcKind kind)
+{
+	const FuCrcMap *map = &crc_map[kind];
+	for (guint i = 0; i < 256; i++) {
+		guint32 crc;
+		if (map->refin) {
+			guint32 poly = fu_crc_reflect (map->poly, map->width);
+			crc = i;
+			for (guint j = 0; j < 8; j++)
+				crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+		} else {
+			guint32 topbit = 1u << (map->width - 1);
+			crc = (guint32) i << (map->width - 8);
+			for (guint j = 0; j < 8; j++)
+				crc = (crc & topbit) ? (crc << 1) ^ map->poly : crc << 1;
+		}
+		crc_tables[kind][i] = crc & fu_crc_mask (map->width);
+	}
+}
+
+static guint32
+fu_crc_update_bytewise (FuCrcKind kind, guint32 crc, const guint8 *buf, gsize bufsz)
+{
+	const FuCrcMap *map = &crc_map[kind];
+	const guint32 *tbl = crc_tables[kind];
+	if (map->refin) {
+		for (gsize i = 0; i < bufsz; i++)
+			crc = tbl[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+		return crc;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		guint8 idx = (guint8) ((crc >> (map->width - 8)) ^ buf[i]);
+		crc = tbl[idx] ^ (crc << 8);
+	}
+	return crc & fu_crc_mask (map->width);
+}
+
+static guint32
+fu_crc32_update_slice8 (guint32 crc, const guint8 *buf, gsize bufsz)
+{
+	while (bufsz >= 8) {
+		guint32 one;
+		guint32 two;
+		memcpy (&one, buf, sizeof(one));
+		memcpy (&two, buf + 4, sizeof(two));
+		one = GUINT32_FROM_LE (one) ^ crc;
+		two = GUINT32_FROM_LE (two);
+		crc = crc_slice8[7][one & 0xff] ^
+		      crc_slice8[6][(one >> 8) & 0xff] ^
+		      crc_slice8[5][(one >> 16) & 0xff] ^
+		      crc_slice8[4][one >> 24] ^
+		      crc_slice8[3][two & 0xff] ^
+		      crc_slice8[2][(two >> 8) & 0xff] ^
+		      crc_slice8[1][(two >> 16) & 0xff] ^
+		      crc_slice8[0][two >> 24];
+		buf += 8;
+		bufsz -= 8;
+	}
+	for (gsize i = 0; i < bufsz; i++)
+		crc = crc_slice8[0][(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef FU_CRC_HAVE_PCLMUL
+/* fold 64 byte blocks using carry-less multiplication, then Barrett reduce;
+ * the constants are for the reflected 0x04c11db7 polynomial as described
+ * in "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ" */
+__attribute__((target("pclmul,sse4.1")))
+static guint32
+fu_crc32_update_pclmul_blocks (guint32 crc, const guint8 *buf, gsize bufsz)
+{
+	static const guint64 k1k2[] __attribute__((aligned(16))) = { 0x0154442bd4, 0x01c6e41596 };
+	static const guint64 k3k4[] __attribute__((aligned(16))) = { 0x01751997d0, 0x00ccaa009e };
+	static const guint64 k5k0[] __attribute__((aligned(16))) = { 0x0163cd6124, 0x0000000000 };
+	static const guint64 poly[] __attribute__((aligned(16))) = { 0x01db710641, 0x01f7011641 };
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	/* there is at least one block of 64 */
+	x1 = _mm_loadu_si128 ((const __m128i *) (buf + 0x00));
+	x2 = _mm_loadu_si128 ((const __m128i *) (buf + 0x10));
+	x3 = _mm_loadu_si128 ((const __m128i *) (buf + 0x20));
+	x4 = _mm_loadu_si128 ((const __m128i *) (buf + 0x30));
+	x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 ((gint32) crc));
+	x0 = _mm_load_si128 ((const __m128i *) k1k2);
+	buf += 64;
+	bufsz -= 64;
+
+	/* parallel fold blocks of 64 */
+	while (bufsz >= 64) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5),
+				    _mm_loadu_si128 ((const __m128i *) (buf + 0x00)));
+		x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6),
+				    _mm_loadu_si128 ((const __m128i *) (buf + 0x10)));
+		x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7),
+				    _mm_loadu_si128 ((const __m128i *) (buf + 0x20)));
+		x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8),
+				    _mm_loadu_si128 ((const __m128i *) (buf + 0x30)));
+		buf += 64;
+		bufsz -= 64;
+	}
+
+	/* fold into 128 bits */
+	x0 = _mm_load_si128 ((const __m128i *) k3k4);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+	x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+	x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+
+	/* single fold blocks of 16 */
+	while (bufsz >= 16) {
+		x2 = _mm_loadu_si128 ((const __m128i *) buf);
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+		buf += 16;
+		bufsz -= 16;
+	}
+
+	/* fold 128 bits to 64 bits */
+	x2 = _mm_clmulepi64_si128 (x1, x0, 0x10);
+	x3 = _mm_setr_epi32 (~0, 0, ~0, 0);
+	x1 = _mm_srli_si128 (x1, 8);
+	x1 = _mm_xor_si128 (x1, x2);
+	x0 = _mm_loadl_epi64 ((const __m128i *) k5k0);
+	x2 = _mm_srli_si128 (x1, 4);
+	x1 = _mm_and_si128 (x1, x3);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	/* Barrett reduce to 32 bits */
+	x0 = _mm_load_si128 ((const __m128i *) poly);
+	x2 = _mm_and_si128 (x1, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x10);
+	x2 = _mm_and_si128 (x2, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+	return (guint32) _mm_extract_epi32 (x1, 1);
+}
+
+static guint32
+fu_crc32_update_pclmul (guint32 crc, const guint8 *buf, gsize bufsz)
+{
+	if (bufsz >= 64) {
+		gsize blocksz = bufsz & ~((gsize) 0xf);
+		crc = fu_crc32_update_pclmul_blocks (crc, buf, blocksz);
+		buf += blocksz;
+		bufsz -= blocksz;
+	}
+	return fu_crc32_update_slice8 (crc, buf, bufsz);
+}
+
+static gboolean
+fu_crc32_pclmul_supported (void)
+{
+	guint eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+		return FALSE;
+	return (ecx & bit_PCLMUL) != 0 && (ecx & bit_SSE4_1) != 0;
+}
+#endif
+
+#ifdef FU_CRC_HAVE_ARMV8
+static guint32
+fu_crc32_update_armv8 (guint32 crc, const guint8 *buf, gsize bufsz)
+{
+	while (bufsz >= 8) {
+		guint64 tmp;
+		memcpy (&tmp, buf, sizeof(tmp));
+		__asm__ (".arch_extension crc\n\t"
+			 "crc32x %w0, %w0, %x1" : "+r" (crc) : "r" (GUINT64_FROM_LE (tmp)));
+		buf += 8;
+		bufsz -= 8;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		__asm__ (".arch_extension crc\n\t"
+			 "crc32b %w0, %w0, %w1" : "+r" (crc) : "r" ((guint32) buf[i]));
+	}
+	return crc;
+}
+#endif
+
+static void
+fu_crc_ensure_tables (void)
+{
+	static gsize done = 0;
+	if (g_once_init_enter (&done)) {
+		for (guint i = FU_CRC_KIND_UNKNOWN + 1; i < FU_CRC_KIND_LAST; i++)
+			fu_crc_tables_init_kind (i);
+		memcpy (crc_slice8[0],
+			crc_tables[FU_CRC_KIND_B32_STANDARD],
+			sizeof(crc_slice8[0]));
+		for (guint i = 0; i < 256; i++) {
+			for (guint j = 1; j < 8; j++) {
+				guint32 tmp = crc_slice8[j - 1][i];
+				crc_slice8[j][i] = (tmp >> 8) ^ crc_slice8[0][tmp & 0xff];
+			}
+		}
+
+		/* use the fastest implementation the CPU supports */
+		crc32_update_func = fu_crc32_update_slice8;
+#ifdef FU_CRC_HAVE_PCLMUL
+		if (fu_crc32_pclmul_supported ()) {
+			g_debug ("using PCLMULQDQ for CRC-32");
+			crc32_update_func = fu_crc32_update_pclmul;
+		}
+#endif
+#ifdef FU_CRC_HAVE_ARMV8
+		if (getauxval (AT_HWCAP) & HWCAP_CRC32) {
+			g_debug ("using ARMv8 CRC32 instructions for CRC-32");
+			crc32_update_func = fu_crc32_update_armv8;
+		}
+#endif
+		g_once_init_leave (&done, 1);
+	}
+}
+
+static guint32
+fu_crc_init_for_kind (FuCrcKind kind)
+{
+	const FuCrcMap *map = &crc_map[kind];
+	if (map->refin)
+		return fu_crc_reflect (map->init, map->width);
+	return map->init;
+}
+
+static guint32
+fu_crc_done_for_kind (FuCrcKind kind, guint32 crc)
+{
+	const FuCrcMap *map = &crc_map[kind];
+	if (map->refin != map->refout)
+		crc = fu_crc_reflect (crc, map->width);
+	return (crc ^ map->xorout) & fu_crc_mask (map->width);
+}
+
+/**
+ * fu_crc8:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B8_STANDARD
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the 8 bit cyclic redundancy check of the buffer.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.4.0
+ **/
+guint8
+fu_crc8 (FuCrcKind kind, const guint8 *buf, gsize bufsz)
+{
+	guint32 crc;
+	g_return_val_if_fail (kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail (crc_map[kind].width == 8, 0x0);
+	fu_crc_ensure_tables ();
+	crc = fu_crc_update_bytewise (kind, fu_crc_init_for_kind (kind), buf, bufsz);
+	return (guint8) fu_crc_done_for_kind (kind, crc);
+}
+
+/**
+ * fu_crc16:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B16_USB
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the 16 bit cyclic redundancy check of the buffer.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.4.0
+ **/
+guint16
+fu_crc16 (FuCrcKind kind, const guint8 *buf, gsize bufsz)
+{
+	guint32 crc;
+	g_return_val_if_fail (kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail (crc_map[kind].width == 16, 0x0);
+	fu_crc_ensure_tables ();
+	crc = fu_crc_update_bytewise (kind, fu_crc_init_for_kind (kind), buf, bufsz);
+	return (guint16) fu_crc_done_for_kind (kind, crc);
+}
+
+/**
+ * fu_crc32_init:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B32_STANDARD
+ *
+ * Returns the initial value to use for fu_crc32_step().
+ *
+ * Returns: CRC register value
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_crc32_init (FuCrcKind kind)
+{
+	g_return_val_if_fail (kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail (crc_map[kind].width == 32, 0x0);
+	return fu_crc_init_for_kind (kind);
+}
+
+/**
+ * fu_crc32_step:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B32_STANDARD
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ * @crc: the CRC register value from fu_crc32_init() or a previous step
+ *
+ * Adds a buffer to a running 32 bit cyclic redundancy check, which is
+ * useful when the data is not contiguous in memory.
+ *
+ * Returns: CRC register value, to be passed to fu_crc32_done()
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_crc32_step (FuCrcKind kind, const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	g_return_val_if_fail (kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail (crc_map[kind].width == 32, 0x0);
+	fu_crc_ensure_tables ();
+	if (crc_map[kind].refin && crc_map[kind].poly == 0x04c11db7)
+		return crc32_update_func (crc, buf, bufsz);
+	return fu_crc_update_bytewise (kind, crc, buf, bufsz);
+}
+
+/**
+ * fu_crc32_done:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B32_STANDARD
+ * @crc: the CRC register value from fu_crc32_step()
+ *
+ * Finishes a running 32 bit cyclic redundancy check.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_crc32_done (FuCrcKind kind, guint32 crc)
+{
+	g_return_val_if_fail (kind < FU_CRC_KIND_LAST, 0x0);
+	g_return_val_if_fail (crc_map[kind].width == 32, 0x0);
+	return fu_crc_done_for_kind (kind, crc);
+}
+
+/**
+ * fu_crc32:
+ * @kind: a #FuCrcKind, e.g. %FU_CRC_KIND_B32_STANDARD
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the 32 bit cyclic redundancy check of the buffer, using
+ * hardware acceleration where the CPU supports it.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_crc32 (FuCrcKind kind, const guint8 *buf, gsize bufsz)
+{
+	guint32 crc = fu_crc32_init (kind);
+	crc = fu_crc32_step (kind, buf, bufsz, crc);
+	return fu_crc32_done (kind, crc);
+}
+
+/**
+ * fu_sum8:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the arithmetic sum of all bytes in the buffer, truncated to 8 bits.
+ *
+ * Returns: sum value
+ *
+ * Since: 1.4.0
+ **/
+guint8
+fu_sum8 (const guint8 *buf, gsize bufsz)
+{
+	guint8 checksum = 0;
+	for (gsize i = 0; i < bufsz; i++)
+		checksum += buf[i];
+	return checksum;
+}
+
+/**
+ * fu_sum32:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the arithmetic sum of all bytes in the buffer.
+ *
+ * Returns: sum value
+ *
+ * Since: 1.4.0
+ **/
+guint32
+fu_sum32 (const guint8 *buf, gsize bufsz)
+{
+	guint32 checksum = 0;
+	for (gsize i = 0; i < bufsz; i++)
+		checksum += buf[i];
+	return checksum;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib.h>
+
+/**
+ * FuCrcKind:
+ * @FU_CRC_KIND_UNKNOWN:		Unknown CRC
+ * @FU_CRC_KIND_B8_STANDARD:		CRC-8, polynomial 0x07, also known as CRC-8/SMBUS
+ * @FU_CRC_KIND_B8_DVB_S2:		CRC-8, polynomial 0xD5
+ * @FU_CRC_KIND_B8_WACOM:		CRC-8, polynomial 0x31 with the output reflected
+ * @FU_CRC_KIND_B16_USB:		CRC-16, polynomial 0x8005, reflected, also known as CRC-16/USB
+ * @FU_CRC_KIND_B16_UMTS:		CRC-16, polynomial 0x8005, also known as CRC-16/BUYPASS
+ * @FU_CRC_KIND_B32_STANDARD:		CRC-32, as used by zlib and ethernet
+ * @FU_CRC_KIND_B32_JAMCRC:		CRC-32 without the final inversion, as used by DFU
+ * @FU_CRC_KIND_B32_MPEG2:		CRC-32, not reflected, as used by the STM32 CRC unit
+ *
+ * The CRC variant to use.
+ **/
+typedef enum {
+	FU_CRC_KIND_UNKNOWN,
+	FU_CRC_KIND_B8_STANDARD,
+	FU_CRC_KIND_B8_DVB_S2,
+	FU_CRC_KIND_B8_WACOM,
+	FU_CRC_KIND_B16_USB,
+	FU_CRC_KIND_B16_UMTS,
+	FU_CRC_KIND_B32_STANDARD,
+	FU_CRC_KIND_B32_JAMCRC,
+	FU_CRC_KIND_B32_MPEG2,
+	/*< private >*/
+	FU_CRC_KIND_LAST
+} FuCrcKind;
+
+const gchar	*fu_crc_kind_to_string		(FuCrcKind	 kind);
+guint8		 fu_crc8			(FuCrcKind	 kind,
+						 const guint8	*buf,
+						 gsize		 bufsz);
+guint16		 fu_crc16			(FuCrcKind	 kind,
+						 const guint8	*buf,
+						 gsize		 bufsz);
+guint32		 fu_crc32			(FuCrcKind	 kind,
+						 const guint8	*buf,
+						 gsize		 bufsz);
+guint32		 fu_crc32_init			(FuCrcKind	 kind);
+guint32		 fu_crc32_step			(FuCrcKind	 kind,
+						 const guint8	*buf,
+						 gsize		 bufsz,
+						 guint32	 crc);
+guint32		 fu_crc32_done			(FuCrcKind	 kind,
+						 guint32	 crc);
+guint8		 fu_sum8			(const guint8	*buf,
+						 gsize		 bufsz);
+guint32		 fu_sum32			(const guint8	*buf,
+						 gsize		 bufsz);
@@ -16,6 +16,8 @@
 #include "fu-common-version.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-poll-scheduler-private.h"
+#include "fu-trace.h"
 
 #include "fwupd-common.h"
 #include "fwupd-device-private.h"
@@ -50,11 +52,19 @@ typedef struct {
 	guint				 order;
 	guint				 priority;
 	guint				 poll_id;
+	guint				 poll_count;
+	guint				 poll_skipped;
+	guint64				 poll_duration_total;	/* us */
+	guint64				 poll_duration_max;	/* us */
 	gboolean			 done_probe;
 	gboolean			 done_setup;
 	guint64				 size_min;
 	guint64				 size_max;
+	gboolean			 firmware_cacheable;
 	gint				 open_refcount;	/* atomic */
+	guint				 close_delay;	/* ms */
+	guint				 close_id;
+	gboolean			 close_now;
 	GType				 specialized_gtype;
 	GPtrArray			*possible_plugins;
 	GPtrArray			*retry_recs;	/* of FuDeviceRetryRecovery */
@@ -318,6 +328,89 @@ fu_device_retry (FuDevice *self,
 	return TRUE;
 }
 
+#define FU_DEVICE_WAIT_FOR_DELAY_MIN	5	/* ms */
+#define FU_DEVICE_WAIT_FOR_DELAY_MAX	200	/* ms */
+
+/**
+ * fu_device_wait_for:
+ * @self: A #FuDevice
+ * @func: (scope call): A function to check if the device is ready
+ * @timeout_ms: the maximum time to wait in milliseconds
+ * @user_data: (nullable): a helper to pass to @func
+ * @error: A #GError
+ *
+ * Calls a specific function until it succeeds or the deadline is reached.
+ *
+ * Rather than sleeping for the worst-case settle time, @func is called
+ * straight away and then with an exponentially increasing delay, starting
+ * at 5ms and capped at 200ms, so a device that becomes ready early is
+ * used early. The deadline uses the monotonic clock and so is not affected
+ * by changes to the wall clock.
+ *
+ * @func should return %FALSE with a %G_IO_ERROR_BUSY error when the device
+ * is not yet ready; any other error is treated as fatal and returned
+ * without waiting further. If the deadline is reached the last busy error
+ * is returned, prefixed with the time waited.
+ *
+ * Returns: %TRUE if @func returned %TRUE before the deadline
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_device_wait_for (FuDevice *self,
+		    FuDeviceRetryFunc func,
+		    guint timeout_ms,
+		    gpointer user_data,
+		    GError **error)
+{
+	gint64 deadline = g_get_monotonic_time () + (gint64) timeout_ms * 1000;
+	guint delay = FU_DEVICE_WAIT_FOR_DELAY_MIN;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (guint i = 0; ; i++) {
+		g_autoptr(GError) error_local =	NULL;
+		gint64 now;
+
+		/* ready */
+		if (func (self, user_data, &error_local))
+			return TRUE;
+		if (error_local == NULL) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "wait failed but no error set!");
+			return FALSE;
+		}
+
+		/* not something that waiting will fix */
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_BUSY)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+
+		/* out of time */
+		now = g_get_monotonic_time ();
+		if (now >= deadline) {
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "timed out after %ums: ",
+						    timeout_ms);
+			return FALSE;
+		}
+		if (fu_common_is_verbose ("FWUPD_DEVICE_VERBOSE")) {
+			g_debug ("not ready on try %u, waiting %ums: %s",
+				 i + 1, delay, error_local->message);
+		}
+
+		/* back off, but never sleep past the deadline */
+		g_usleep (MIN ((gint64) delay * 1000, deadline - now));
+		delay = MIN (delay * 2, FU_DEVICE_WAIT_FOR_DELAY_MAX);
+	}
+}
+
 /**
  * fu_device_poll:
  * @self: A #FuDevice
@@ -345,14 +438,41 @@ fu_device_poll (FuDevice *self, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_device_poll_cb (gpointer user_data)
+/* polls the device from the poll wheel, recording how long the poll took;
+ * nothing is done if the device is busy -- returns %FALSE to stop polling */
+gboolean
+fu_device_poll_scheduled (FuDevice *self)
 {
-	FuDevice *self = FU_DEVICE (user_data);
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gint64 start;
+	guint64 duration;
 	g_autoptr(GError) error_local = NULL;
+
+	/* do not talk to the hardware while it is being updated */
+	if (priv->status != FWUPD_STATUS_UNKNOWN &&
+	    priv->status != FWUPD_STATUS_IDLE) {
+		priv->poll_skipped++;
+		return TRUE;
+	}
+
+	start = g_get_monotonic_time ();
 	if (!fu_device_poll (self, &error_local)) {
 		g_warning ("disabling polling: %s", error_local->message);
+		return FALSE;
+	}
+	duration = g_get_monotonic_time () - start;
+	priv->poll_count++;
+	priv->poll_duration_total += duration;
+	priv->poll_duration_max = MAX (priv->poll_duration_max, duration);
+	return TRUE;
+}
+
+static gboolean
+fu_device_poll_cb (gpointer user_data)
+{
+	FuDevice *self = FU_DEVICE (user_data);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	if (!fu_device_poll_scheduled (self)) {
 		priv->poll_id = 0;
 		return G_SOURCE_REMOVE;
 	}
@@ -368,6 +488,11 @@ fu_device_poll_cb (gpointer user_data)
  * returns %FALSE then a warning is printed to the console and the poll is
  * disabled until the next call to fu_device_set_poll_interval().
  *
+ * Intervals of a second or more are rounded to the nearest second and share
+ * a single timer with all other polled devices, so that devices due at the
+ * same time are polled from one wakeup. Polling is skipped while the device
+ * status is set, for instance when it is being written.
+ *
  * Since: 1.1.2
  **/
 void
@@ -381,17 +506,88 @@ fu_device_set_poll_interval (FuDevice *self, guint interval)
 		g_source_remove (priv->poll_id);
 		priv->poll_id = 0;
 	}
+	fu_poll_scheduler_remove (self);
 	if (interval == 0)
 		return;
-	if (interval % 1000 == 0) {
-		priv->poll_id = g_timeout_add_seconds (interval / 1000,
-						       fu_device_poll_cb,
-						       self);
+	if (interval >= 1000) {
+		fu_poll_scheduler_add (self, interval);
 	} else {
 		priv->poll_id = g_timeout_add (interval, fu_device_poll_cb, self);
 	}
 }
 
+/**
+ * fu_device_get_poll_count:
+ * @self: a #FuDevice
+ *
+ * Gets the number of times the device has been successfully polled.
+ *
+ * Returns: integer
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_device_get_poll_count (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->poll_count;
+}
+
+/**
+ * fu_device_get_poll_skipped:
+ * @self: a #FuDevice
+ *
+ * Gets the number of times polling was skipped as the device was busy.
+ *
+ * Returns: integer
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_device_get_poll_skipped (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->poll_skipped;
+}
+
+/**
+ * fu_device_get_poll_duration_total:
+ * @self: a #FuDevice
+ *
+ * Gets the total time spent polling the device.
+ *
+ * Returns: duration in us
+ *
+ * Since: 1.4.0
+ **/
+guint64
+fu_device_get_poll_duration_total (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->poll_duration_total;
+}
+
+/**
+ * fu_device_get_poll_duration_max:
+ * @self: a #FuDevice
+ *
+ * Gets the longest time spent polling the device.
+ *
+ * Returns: duration in us
+ *
+ * Since: 1.4.0
+ **/
+guint64
+fu_device_get_poll_duration_max (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->poll_duration_max;
+}
+
 /**
  * fu_device_get_order:
  * @self: a #FuPlugin
@@ -965,6 +1161,10 @@ fu_device_set_quirk_kv (FuDevice *self,
 		fu_device_set_install_duration (self, fu_common_strtoull (value));
 		return TRUE;
 	}
+	if (g_strcmp0 (key, FU_QUIRKS_CLOSE_DELAY) == 0) {
+		fu_device_set_close_delay (self, fu_common_strtoull (value));
+		return TRUE;
+	}
 	if (g_strcmp0 (key, FU_QUIRKS_VERSION_FORMAT) == 0) {
 		fu_device_set_version_format (self, fwupd_version_format_from_string (value));
 		return TRUE;
@@ -1079,6 +1279,45 @@ fu_device_set_firmware_size_min (FuDevice *self, guint64 size_min)
 	priv->size_min = size_min;
 }
 
+/**
+ * fu_device_set_firmware_cacheable:
+ * @self: A #FuDevice
+ * @firmware_cacheable: %TRUE if the prepared firmware can be shared
+ *
+ * Sets if the #FuFirmware returned by the ->prepare_firmware() vfunc, or the
+ * default #FuFirmware if the vfunc is not set, can be reused for an identical
+ * device given the same payload. This should only be set if
+ * ->prepare_firmware() only parses the payload, and does not check it against
+ * any runtime state such as the active bank.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_device_set_firmware_cacheable (FuDevice *self, gboolean firmware_cacheable)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->firmware_cacheable = firmware_cacheable;
+}
+
+/**
+ * fu_device_get_firmware_cacheable:
+ * @self: A #FuDevice
+ *
+ * Gets if the prepared firmware can be shared with identical devices.
+ *
+ * Returns: %TRUE if set using fu_device_set_firmware_cacheable()
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_device_get_firmware_cacheable (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	return priv->firmware_cacheable;
+}
+
 /**
  * fu_device_set_firmware_size_max:
  * @self: A #FuDevice
@@ -2014,6 +2253,47 @@ fu_device_set_remove_delay (FuDevice *self, guint remove_delay)
 	priv->remove_delay = remove_delay;
 }
 
+/**
+ * fu_device_set_close_delay:
+ * @self: A #FuDevice
+ * @close_delay: duration in ms, or 0 to close immediately
+ *
+ * Sets the amount of time a device is kept open after the last call to
+ * fu_device_close(). If the device is opened again within this time the
+ * existing handle is reused, which avoids claiming interfaces and reading
+ * descriptors again for consecutive operations.
+ *
+ * The device is always closed immediately after a successful detach or
+ * attach, as the hardware is expected to re-enumerate.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_device_set_close_delay (FuDevice *self, guint close_delay)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->close_delay = close_delay;
+}
+
+/**
+ * fu_device_get_close_delay:
+ * @self: A #FuDevice
+ *
+ * Gets the amount of time a device is kept open after it is no longer used.
+ *
+ * Returns: duration in ms
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_device_get_close_delay (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->close_delay;
+}
+
 /**
  * fu_device_get_status:
  * @self: A #FuDevice
@@ -2105,6 +2385,7 @@ fu_device_set_progress_full (FuDevice *self, gsize progress_done, gsize progress
 {
 	gdouble percentage = 0.f;
 	g_return_if_fail (FU_IS_DEVICE (self));
+	FU_TRACE3 (device_progress, fu_device_get_id (self), progress_done, progress_total);
 	if (progress_total > 0)
 		percentage = (100.f * (gdouble) progress_done) / (gdouble) progress_total;
 	fu_device_set_progress (self, (guint) percentage);
@@ -2144,6 +2425,15 @@ fu_device_add_string (FuDevice *self, guint idt, GString *str)
 		g_autofree gchar *sz = g_strdup_printf ("%" G_GUINT64_FORMAT, priv->size_max);
 		fu_common_string_append_kv (str, idt + 1, "FirmwareSizeMax", sz);
 	}
+	if (priv->poll_count > 0 || priv->poll_skipped > 0) {
+		g_autofree gchar *sz = NULL;
+		sz = g_strdup_printf ("count:%u skipped:%u total:%" G_GUINT64_FORMAT
+				      "us max:%" G_GUINT64_FORMAT "us",
+				      priv->poll_count, priv->poll_skipped,
+				      priv->poll_duration_total,
+				      priv->poll_duration_max);
+		fu_common_string_append_kv (str, idt + 1, "PollStats", sz);
+	}
 	keys = g_hash_table_get_keys (priv->metadata);
 	for (GList *l = keys; l != NULL; l = l->next) {
 		const gchar *key = l->data;
@@ -2264,6 +2554,7 @@ fu_device_write_firmware (FuDevice *self,
 			  GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	gboolean ret;
 	g_autoptr(FuFirmware) firmware = NULL;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
@@ -2284,7 +2575,118 @@ fu_device_write_firmware (FuDevice *self,
 		return FALSE;
 
 	/* call vfunc */
-	return klass->write_firmware (self, firmware, flags, error);
+	FU_TRACE2 (device_write_firmware_start, fu_device_get_id (self), g_bytes_get_size (fw));
+	ret = klass->write_firmware (self, firmware, flags, error);
+	FU_TRACE2 (device_write_firmware_done, fu_device_get_id (self), ret);
+	return ret;
+}
+
+/* while enabled, the result of ->prepare_firmware() is shared between
+ * identical devices being updated with the same payload */
+static GMutex		 fu_device_firmware_cache_mutex;
+static GHashTable	*fu_device_firmware_cache = NULL;	/* key:FuFirmware */
+
+/**
+ * fu_device_set_firmware_cache_enabled:
+ * @enabled: %TRUE to share prepared firmware
+ *
+ * Enables sharing the prepared #FuFirmware between devices with the same GType, protocol and GUIDs that are given
+ * exactly the same payload. Only devices that opted in using
+ * fu_device_set_firmware_cacheable() share firmware. Disabling the cache
+ * frees all the firmware.
+ *
+ * This should only be enabled for the duration of an update of several
+ * devices, and plugins must treat the prepared firmware as read-only.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_device_set_firmware_cache_enabled (gboolean enabled)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_device_firmware_cache_mutex);
+	if (enabled && fu_device_firmware_cache == NULL) {
+		fu_device_firmware_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+								  g_free,
+								  (GDestroyNotify) g_object_unref);
+	} else if (!enabled && fu_device_firmware_cache != NULL) {
+		g_hash_table_unref (fu_device_firmware_cache);
+		fu_device_firmware_cache = NULL;
+	}
+}
+
+static gchar *
+fu_device_get_firmware_cache_key (FuDevice *self, GBytes *fw, FwupdInstallFlags flags)
+{
+	g_autofree gchar *checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, fw);
+	g_autofree gchar *guids = fu_device_get_guids_as_str (self);
+	return g_strdup_printf ("%s:%s:%s:%" G_GUINT64_FORMAT ":%s",
+				G_OBJECT_TYPE_NAME (self),
+				fu_device_get_protocol (self),
+				guids,
+				(guint64) flags,
+				checksum);
+}
+
+static FuFirmware *
+fu_device_prepare_firmware_uncached (FuDevice *self,
+				     GBytes *fw,
+				     FwupdInstallFlags flags,
+				     GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	if (klass->prepare_firmware != NULL)
+		return klass->prepare_firmware (self, fw, flags, error);
+	return fu_firmware_new_from_bytes (fw);
+}
+
+static FuFirmware *
+fu_device_prepare_firmware_cached (FuDevice *self,
+				   GBytes *fw,
+				   FwupdInstallFlags flags,
+				   GError **error)
+{
+	FuFirmware *firmware;
+	g_autofree gchar *key = NULL;
+
+	/* the device checks the payload against runtime state */
+	if (!fu_device_get_firmware_cacheable (self))
+		return fu_device_prepare_firmware_uncached (self, fw, flags, error);
+
+	/* not enabled */
+	g_mutex_lock (&fu_device_firmware_cache_mutex);
+	if (fu_device_firmware_cache == NULL) {
+		g_mutex_unlock (&fu_device_firmware_cache_mutex);
+		return fu_device_prepare_firmware_uncached (self, fw, flags, error);
+	}
+	g_mutex_unlock (&fu_device_firmware_cache_mutex);
+
+	/* already prepared for an identical device */
+	key = fu_device_get_firmware_cache_key (self, fw, flags);
+	g_mutex_lock (&fu_device_firmware_cache_mutex);
+	if (fu_device_firmware_cache != NULL) {
+		firmware = g_hash_table_lookup (fu_device_firmware_cache, key);
+		if (firmware != NULL) {
+			g_debug ("reusing prepared firmware for %s",
+				 fu_device_get_id (self));
+			g_object_ref (firmware);
+			g_mutex_unlock (&fu_device_firmware_cache_mutex);
+			return firmware;
+		}
+	}
+	g_mutex_unlock (&fu_device_firmware_cache_mutex);
+
+	/* prepare and share */
+	firmware = fu_device_prepare_firmware_uncached (self, fw, flags, error);
+	if (firmware == NULL)
+		return NULL;
+	g_mutex_lock (&fu_device_firmware_cache_mutex);
+	if (fu_device_firmware_cache != NULL) {
+		g_hash_table_insert (fu_device_firmware_cache,
+				     g_steal_pointer (&key),
+				     g_object_ref (firmware));
+	}
+	g_mutex_unlock (&fu_device_firmware_cache_mutex);
+	return firmware;
 }
 
 /**
@@ -2312,7 +2714,6 @@ fu_device_prepare_firmware (FuDevice *self,
 			    FwupdInstallFlags flags,
 			    GError **error)
 {
-	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autoptr(GBytes) fw_def = NULL;
@@ -2321,14 +2722,10 @@ fu_device_prepare_firmware (FuDevice *self,
 	g_return_val_if_fail (fw != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	/* optionally subclassed */
-	if (klass->prepare_firmware != NULL) {
-		firmware = klass->prepare_firmware (self, fw, flags, error);
-		if (firmware == NULL)
-			return NULL;
-	} else {
-		firmware = fu_firmware_new_from_bytes (fw);
-	}
+	/* optionally subclassed, and shared between identical devices */
+	firmware = fu_device_prepare_firmware_cached (self, fw, flags, error);
+	if (firmware == NULL)
+		return NULL;
 
 	/* check size */
 	fw_def = fu_firmware_get_image_default_bytes (firmware, NULL);
@@ -2409,6 +2806,7 @@ gboolean
 fu_device_detach (FuDevice *self, GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -2418,7 +2816,12 @@ fu_device_detach (FuDevice *self, GError **error)
 		return TRUE;
 
 	/* call vfunc */
-	return klass->detach (self, error);
+	if (!klass->detach (self, error))
+		return FALSE;
+
+	/* the handle will not survive re-enumeration */
+	priv->close_now = TRUE;
+	return TRUE;
 }
 
 /**
@@ -2436,6 +2839,7 @@ gboolean
 fu_device_attach (FuDevice *self, GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -2445,7 +2849,12 @@ fu_device_attach (FuDevice *self, GError **error)
 		return TRUE;
 
 	/* call vfunc */
-	return klass->attach (self, error);
+	if (!klass->attach (self, error))
+		return FALSE;
+
+	/* the handle will not survive re-enumeration */
+	priv->close_now = TRUE;
+	return TRUE;
 }
 
 /**
@@ -2564,6 +2973,13 @@ fu_device_open (FuDevice *self, GError **error)
 	if (priv->open_refcount > 1)
 		return TRUE;
 
+	/* still open from last time */
+	if (priv->close_id != 0) {
+		g_source_remove (priv->close_id);
+		priv->close_id = 0;
+		return TRUE;
+	}
+
 	/* probe */
 	if (!fu_device_probe (self, error))
 		return FALSE;
@@ -2586,6 +3002,61 @@ fu_device_open (FuDevice *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_device_close_internal (FuDevice *self, GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+
+	/* subclassed */
+	if (klass->close != NULL) {
+		if (!klass->close (self, error))
+			return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_device_close_delay_cb (gpointer user_data)
+{
+	FuDevice *self = FU_DEVICE (user_data);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GError) error_local = NULL;
+
+	priv->close_id = 0;
+	if (!fu_device_close_internal (self, &error_local))
+		g_debug ("failed to close idle device: %s", error_local->message);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * fu_device_flush_close:
+ * @self: A #FuDevice
+ *
+ * Runs a close that was deferred using fu_device_set_close_delay() straight
+ * away. This should be done before the backing device is replaced, so that
+ * the next fu_device_open() opens the new device rather than reusing the
+ * handle for the old one.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_device_flush_close (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_if_fail (FU_IS_DEVICE (self));
+
+	if (priv->close_id == 0)
+		return;
+	g_source_remove (priv->close_id);
+	priv->close_id = 0;
+	if (!fu_device_close_internal (self, &error_local))
+		g_debug ("failed to close replaced device: %s", error_local->message);
+}
+
 /**
  * fu_device_close:
  * @self: A #FuDevice
@@ -2602,6 +3073,9 @@ fu_device_open (FuDevice *self, GError **error)
  * An error is returned if this method is called without having used the
  * fu_device_open() method beforehand.
  *
+ * If fu_device_set_close_delay() has been used then the vfunc is deferred
+ * until the device has not been used for the delay period.
+ *
  * Returns: %TRUE for success
  *
  * Since: 1.1.2
@@ -2609,7 +3083,6 @@ fu_device_open (FuDevice *self, GError **error)
 gboolean
 fu_device_close (FuDevice *self, GError **error)
 {
-	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
@@ -2626,14 +3099,17 @@ fu_device_close (FuDevice *self, GError **error)
 	if (!g_atomic_int_dec_and_test (&priv->open_refcount))
 		return TRUE;
 
-	/* subclassed */
-	if (klass->close != NULL) {
-		if (!klass->close (self, error))
-			return FALSE;
+	/* keep the handle around in case it is needed again soon */
+	if (priv->close_delay > 0 && !priv->close_now) {
+		priv->close_id = g_timeout_add_full (G_PRIORITY_DEFAULT,
+						     priv->close_delay,
+						     fu_device_close_delay_cb,
+						     g_object_ref (self),
+						     (GDestroyNotify) g_object_unref);
+		return TRUE;
 	}
-
-	/* success */
-	return TRUE;
+	priv->close_now = FALSE;
+	return fu_device_close_internal (self, error);
 }
 
 /**
@@ -2819,7 +3295,7 @@ fu_device_activate (FuDevice *self, GError **error)
  * fu_device_setup() actually probe the hardware.
  *
  * This should be done in case the backing device has changed, for instance if
- * a USB device has been replugged.
+ * a USB device has been replugged. Any deferred close is run straight away.
  *
  * Since: 1.1.2
  **/
@@ -2828,6 +3304,7 @@ fu_device_probe_invalidate (FuDevice *self)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FU_IS_DEVICE (self));
+	fu_device_flush_close (self);
 	priv->done_probe = FALSE;
 	priv->done_setup = FALSE;
 }
@@ -3013,6 +3490,7 @@ fu_device_finalize (GObject *object)
 		g_object_unref (priv->quirks);
 	if (priv->poll_id != 0)
 		g_source_remove (priv->poll_id);
+	fu_poll_scheduler_remove (self);
 	g_rw_lock_clear (&priv->metadata_mutex);
 	g_rw_lock_clear (&priv->parent_guids_mutex);
 	g_hash_table_unref (priv->metadata);
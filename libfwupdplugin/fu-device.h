@@ -234,6 +234,9 @@ void		 fu_device_set_name			(FuDevice	*self,
 guint		 fu_device_get_remove_delay		(FuDevice	*self);
 void		 fu_device_set_remove_delay		(FuDevice	*self,
 							 guint		 remove_delay);
+guint		 fu_device_get_close_delay		(FuDevice	*self);
+void		 fu_device_set_close_delay		(FuDevice	*self,
+							 guint		 close_delay);
 FwupdStatus	 fu_device_get_status			(FuDevice	*self);
 void		 fu_device_set_status			(FuDevice	*self,
 							 FwupdStatus	 status);
@@ -245,6 +248,9 @@ void		 fu_device_set_firmware_size_max	(FuDevice	*self,
 							 guint64	 size_max);
 guint64		 fu_device_get_firmware_size_min	(FuDevice	*self);
 guint64		 fu_device_get_firmware_size_max	(FuDevice	*self);
+void		 fu_device_set_firmware_cacheable	(FuDevice	*self,
+							 gboolean	 firmware_cacheable);
+gboolean	 fu_device_get_firmware_cacheable	(FuDevice	*self);
 guint		 fu_device_get_progress			(FuDevice	*self);
 void		 fu_device_set_progress			(FuDevice	*self,
 							 guint		 progress);
@@ -299,6 +305,10 @@ gboolean	 fu_device_poll				(FuDevice	*self,
 							 GError		**error);
 void		 fu_device_set_poll_interval		(FuDevice	*self,
 							 guint		 interval);
+guint		 fu_device_get_poll_count		(FuDevice	*self);
+guint		 fu_device_get_poll_skipped		(FuDevice	*self);
+guint64		 fu_device_get_poll_duration_total	(FuDevice	*self);
+guint64		 fu_device_get_poll_duration_max	(FuDevice	*self);
 void		 fu_device_retry_set_delay		(FuDevice	*self,
 							 guint		 delay);
 void		 fu_device_retry_add_recovery		(FuDevice	*self,
@@ -310,3 +320,8 @@ gboolean	 fu_device_retry			(FuDevice	*self,
 							 guint		 count,
 							 gpointer	 user_data,
 							 GError		**error);
+gboolean	 fu_device_wait_for			(FuDevice	*self,
+							 FuDeviceRetryFunc func,
+							 guint		 timeout_ms,
+							 gpointer	 user_data,
+							 GError		**error);
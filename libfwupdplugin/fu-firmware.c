@@ -12,6 +12,8 @@
 #include "fu-firmware.h"
 #include "fu-firmware-image-private.h"
 
+#include "fwupd-error.h"
+
 /**
  * SECTION:fu-firmware
  * @short_description: a firmware file
@@ -184,6 +186,161 @@ fu_firmware_parse_file (FuFirmware *self, GFile *file, FwupdInstallFlags flags,
 	return fu_firmware_parse (self, fw, flags, error);
 }
 
+/* below this the thread setup costs more than parsing serially */
+#define FU_FIRMWARE_PARSE_IMAGES_PARALLEL_MIN	0x10000
+
+typedef struct {
+	FuFirmware			*self;
+	FuFirmwareImageParseFunc	 func;
+	gpointer			 user_data;
+	FwupdInstallFlags		 flags;
+	gint				 failed_idx;	/* atomic */
+} FuFirmwareParseImagesHelper;
+
+typedef struct {
+	GBytes				*fw;
+	guint				 idx;
+	FuFirmwareImage			*img;
+	GError				*error;
+} FuFirmwareParseImagesJob;
+
+static void
+fu_firmware_parse_images_job (FuFirmwareParseImagesJob *job,
+			      FuFirmwareParseImagesHelper *helper)
+{
+	/* an earlier image already failed, so this result would be ignored */
+	if ((gint) job->idx > g_atomic_int_get (&helper->failed_idx))
+		return;
+	job->img = helper->func (helper->self, job->fw, job->idx,
+				 helper->user_data, helper->flags,
+				 &job->error);
+	if (job->img == NULL) {
+		gint failed_idx;
+		if (job->error == NULL) {
+			g_set_error (&job->error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "failed to parse image %u",
+				     job->idx);
+		}
+		do {
+			failed_idx = g_atomic_int_get (&helper->failed_idx);
+			if ((gint) job->idx >= failed_idx)
+				break;
+		} while (!g_atomic_int_compare_and_exchange (&helper->failed_idx,
+							     failed_idx,
+							     (gint) job->idx));
+	}
+}
+
+static void
+fu_firmware_parse_images_thread_cb (gpointer data, gpointer user_data)
+{
+	fu_firmware_parse_images_job (data, user_data);
+}
+
+/**
+ * fu_firmware_parse_images:
+ * @self: A #FuFirmware
+ * @blobs: (element-type GBytes): The image data, in order
+ * @func: (scope call): A #FuFirmwareImageParseFunc
+ * @user_data: User data to pass to @func
+ * @flags: some #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError, or %NULL
+ *
+ * Parses and verifies each image of a container firmware, typically from
+ * the subclassed parse() after the container has been split up.
+ *
+ * If there is enough data the images are parsed in parallel, but they are
+ * always added to @self in the order of @blobs. If more than one image fails
+ * to parse then the error from the first is returned, and no images are added.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_firmware_parse_images (FuFirmware *self,
+			  GPtrArray *blobs,
+			  FuFirmwareImageParseFunc func,
+			  gpointer user_data,
+			  FwupdInstallFlags flags,
+			  GError **error)
+{
+	gsize total = 0;
+	guint max_threads = g_get_num_processors ();
+	g_autofree FuFirmwareParseImagesJob *jobs = NULL;
+	FuFirmwareParseImagesHelper helper = {
+		.self		= self,
+		.func		= func,
+		.user_data	= user_data,
+		.flags		= flags,
+		.failed_idx	= G_MAXINT,
+	};
+
+	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
+	g_return_val_if_fail (blobs != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* nothing to do */
+	if (blobs->len == 0)
+		return TRUE;
+
+	jobs = g_new0 (FuFirmwareParseImagesJob, blobs->len);
+	for (guint i = 0; i < blobs->len; i++) {
+		jobs[i].fw = g_ptr_array_index (blobs, i);
+		jobs[i].idx = i;
+		total += g_bytes_get_size (jobs[i].fw);
+	}
+
+	/* parse on workers, or inline if not worth it */
+	if (blobs->len > 1 && max_threads > 1 &&
+	    total >= FU_FIRMWARE_PARSE_IMAGES_PARALLEL_MIN) {
+		GThreadPool *pool;
+		g_autoptr(GError) error_pool = NULL;
+		pool = g_thread_pool_new (fu_firmware_parse_images_thread_cb,
+					  &helper, MIN (max_threads, blobs->len),
+					  TRUE, &error_pool);
+		if (pool == NULL) {
+			g_debug ("parsing serially: %s", error_pool->message);
+		} else {
+			for (guint i = 0; i < blobs->len; i++) {
+				if (!g_thread_pool_push (pool, &jobs[i], &error_pool)) {
+					g_debug ("parsing inline: %s", error_pool->message);
+					g_clear_error (&error_pool);
+					fu_firmware_parse_images_job (&jobs[i], &helper);
+				}
+			}
+			g_thread_pool_free (pool, FALSE, TRUE);
+		}
+	}
+	for (guint i = 0; i < blobs->len; i++) {
+		if (jobs[i].img == NULL && jobs[i].error == NULL)
+			fu_firmware_parse_images_job (&jobs[i], &helper);
+	}
+
+	/* the first error wins, so the result does not depend on scheduling */
+	for (guint i = 0; i < blobs->len; i++) {
+		if (jobs[i].error != NULL && error != NULL && *error == NULL) {
+			g_propagate_error (error, jobs[i].error);
+			jobs[i].error = NULL;
+		}
+	}
+	if (g_atomic_int_get (&helper.failed_idx) != G_MAXINT) {
+		for (guint i = 0; i < blobs->len; i++) {
+			g_clear_object (&jobs[i].img);
+			g_clear_error (&jobs[i].error);
+		}
+		return FALSE;
+	}
+	for (guint i = 0; i < blobs->len; i++) {
+		fu_firmware_add_image (self, jobs[i].img);
+		g_object_unref (jobs[i].img);
+	}
+	return TRUE;
+}
+
 /**
  * fu_firmware_write:
  * @self: A #FuFirmware
@@ -36,6 +36,27 @@ struct _FuFirmwareClass
 	gpointer		 padding[28];
 };
 
+/**
+ * FuFirmwareImageParseFunc:
+ * @self: A #FuFirmware
+ * @fw: A #GBytes of the image data
+ * @idx: The index of @fw in the array passed to fu_firmware_parse_images()
+ * @user_data: User data
+ * @flags: some #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError, or %NULL
+ *
+ * Parses and verifies one image of a container firmware. This may be called
+ * from a worker thread and so must not modify @self or @user_data.
+ *
+ * Returns: (transfer full): a #FuFirmwareImage, or %NULL for error
+ **/
+typedef FuFirmwareImage	*(*FuFirmwareImageParseFunc)	(FuFirmware	*self,
+							 GBytes		*fw,
+							 guint		 idx,
+							 gpointer	 user_data,
+							 FwupdInstallFlags flags,
+							 GError		**error);
+
 FuFirmware	*fu_firmware_new			(void);
 FuFirmware	*fu_firmware_new_from_bytes		(GBytes		*fw);
 gchar		*fu_firmware_to_string			(FuFirmware	*self);
@@ -61,6 +82,12 @@ gboolean	 fu_firmware_parse_full			(FuFirmware	*self,
 							 guint64	 addr_end,
 							 FwupdInstallFlags flags,
 							 GError		**error);
+gboolean	 fu_firmware_parse_images		(FuFirmware	*self,
+							 GPtrArray	*blobs,
+							 FuFirmwareImageParseFunc func,
+							 gpointer	 user_data,
+							 FwupdInstallFlags flags,
+							 GError		**error);
 GBytes		*fu_firmware_write			(FuFirmware	*self,
 							 GError		**error);
 gboolean	 fu_firmware_write_file			(FuFirmware	*self,
@@ -9,6 +9,7 @@
 #include "config.h"
 
 #include "fu-hid-device.h"
+#include "fu-trace.h"
 
 #define FU_HID_REPORT_GET				0x01
 #define FU_HID_REPORT_SET				0x09
@@ -217,6 +218,7 @@ fu_hid_device_set_report (FuHidDevice *self,
 {
 	FuHidDevicePrivate *priv = GET_PRIVATE (self);
 	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	gboolean ret;
 	gsize actual_len = 0;
 	guint16 wvalue = (FU_HID_REPORT_TYPE_OUTPUT << 8) | value;
 
@@ -228,18 +230,21 @@ fu_hid_device_set_report (FuHidDevice *self,
 	g_return_val_if_fail (buf != NULL, FALSE);
 	g_return_val_if_fail (bufsz != 0, FALSE);
 
-	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FU_HID_DEVICE_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::SetReport", buf, bufsz);
-	if (!g_usb_device_control_transfer (usb_device,
-					    G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
-					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
-					    G_USB_DEVICE_RECIPIENT_INTERFACE,
-					    FU_HID_REPORT_SET,
-					    wvalue, priv->interface,
-					    buf, bufsz,
-					    &actual_len,
-					    timeout,
-					    NULL, error)) {
+	FU_TRACE2 (hid_set_report_start, value, bufsz);
+	ret = g_usb_device_control_transfer (usb_device,
+					     G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
+					     G_USB_DEVICE_REQUEST_TYPE_CLASS,
+					     G_USB_DEVICE_RECIPIENT_INTERFACE,
+					     FU_HID_REPORT_SET,
+					     wvalue, priv->interface,
+					     buf, bufsz,
+					     &actual_len,
+					     timeout,
+					     NULL, error);
+	FU_TRACE3 (hid_set_report_done, value, actual_len, ret);
+	if (!ret) {
 		g_prefix_error (error, "failed to SetReport: ");
 		return FALSE;
 	}
@@ -279,6 +284,7 @@ fu_hid_device_get_report (FuHidDevice *self,
 {
 	FuHidDevicePrivate *priv = GET_PRIVATE (self);
 	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	gboolean ret;
 	gsize actual_len = 0;
 	guint16 wvalue = (FU_HID_REPORT_TYPE_INPUT << 8) | value;
 
@@ -290,22 +296,25 @@ fu_hid_device_get_report (FuHidDevice *self,
 	if (flags & FU_HID_DEVICE_FLAG_IS_FEATURE)
 		wvalue = (FU_HID_REPORT_TYPE_FEATURE << 8) | value;
 
-	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FU_HID_DEVICE_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::GetReport", buf, actual_len);
-	if (!g_usb_device_control_transfer (usb_device,
-					    G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
-					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
-					    G_USB_DEVICE_RECIPIENT_INTERFACE,
-					    FU_HID_REPORT_GET,
-					    wvalue, priv->interface,
-					    buf, bufsz,
-					    &actual_len, /* actual length */
-					    timeout,
-					    NULL, error)) {
+	FU_TRACE2 (hid_get_report_start, value, bufsz);
+	ret = g_usb_device_control_transfer (usb_device,
+					     G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+					     G_USB_DEVICE_REQUEST_TYPE_CLASS,
+					     G_USB_DEVICE_RECIPIENT_INTERFACE,
+					     FU_HID_REPORT_GET,
+					     wvalue, priv->interface,
+					     buf, bufsz,
+					     &actual_len, /* actual length */
+					     timeout,
+					     NULL, error);
+	FU_TRACE3 (hid_get_report_done, value, actual_len, ret);
+	if (!ret) {
 		g_prefix_error (error, "failed to GetReport: ");
 		return FALSE;
 	}
-	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FU_HID_DEVICE_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::GetReport", buf, actual_len);
 	if ((flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 && actual_len != bufsz) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
@@ -316,6 +325,79 @@ fu_hid_device_get_report (FuHidDevice *self,
 	return TRUE;
 }
 
+static gboolean
+fu_hid_device_queue_set_report_cb (FuUsbTransferQueue *queue,
+				   const guint8 *buf,
+				   gsize bufsz,
+				   gsize actual_len,
+				   gpointer user_data,
+				   GError **error)
+{
+	if (actual_len != bufsz) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+			     "wrote %" G_GSIZE_FORMAT ", requested %" G_GSIZE_FORMAT " bytes",
+			     actual_len, bufsz);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_hid_device_queue_set_report:
+ * @self: A #FuHidDevice
+ * @queue: A #FuUsbTransferQueue
+ * @value: low byte of wValue
+ * @buf: data to send, which is copied
+ * @bufsz: Size of @buf
+ * @flags: #FuHidDeviceFlags e.g. %FU_HID_DEVICE_FLAG_ALLOW_TRUNC
+ * @error: a #GError or %NULL
+ *
+ * Queues a SetReport on the hardware without waiting for it to complete.
+ * Any failure is returned by fu_usb_transfer_queue_drain().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_hid_device_queue_set_report (FuHidDevice *self,
+				FuUsbTransferQueue *queue,
+				guint8 value,
+				const guint8 *buf,
+				gsize bufsz,
+				FuHidDeviceFlags flags,
+				GError **error)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	guint16 wvalue = (FU_HID_REPORT_TYPE_OUTPUT << 8) | value;
+
+	/* special case */
+	if (flags & FU_HID_DEVICE_FLAG_IS_FEATURE)
+		wvalue = (FU_HID_REPORT_TYPE_FEATURE << 8) | value;
+
+	g_return_val_if_fail (FU_HID_DEVICE (self), FALSE);
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (queue), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	g_return_val_if_fail (bufsz != 0, FALSE);
+
+	if (fu_common_is_verbose ("FU_HID_DEVICE_VERBOSE"))
+		fu_common_dump_raw (G_LOG_DOMAIN, "HID::SetReport", buf, bufsz);
+	if (!fu_usb_transfer_queue_add_control (queue,
+						G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
+						G_USB_DEVICE_REQUEST_TYPE_CLASS,
+						G_USB_DEVICE_RECIPIENT_INTERFACE,
+						FU_HID_REPORT_SET,
+						wvalue, priv->interface,
+						buf, bufsz,
+						(flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 ?
+							fu_hid_device_queue_set_report_cb : NULL,
+						NULL, error)) {
+		g_prefix_error (error, "failed to SetReport: ");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_hid_device_init (FuHidDevice *self)
 {
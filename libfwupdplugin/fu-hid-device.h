@@ -9,6 +9,7 @@
 #include <glib-object.h>
 
 #include "fu-usb-device.h"
+#include "fu-usb-transfer-queue.h"
 
 #define FU_TYPE_HID_DEVICE (fu_hid_device_get_type ())
 G_DECLARE_DERIVABLE_TYPE (FuHidDevice, fu_hid_device, FU, HID_DEVICE, FuUsbDevice)
@@ -56,3 +57,10 @@ gboolean	 fu_hid_device_get_report		(FuHidDevice	*self,
 							 guint		 timeout,
 							 FuHidDeviceFlags flags,
 							 GError		**error);
+gboolean	 fu_hid_device_queue_set_report		(FuHidDevice	*self,
+							 FuUsbTransferQueue *queue,
+							 guint8		 value,
+							 const guint8	*buf,
+							 gsize		 bufsz,
+							 FuHidDeviceFlags flags,
+							 GError		**error);
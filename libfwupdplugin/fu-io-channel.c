@@ -17,14 +17,39 @@
 #endif
 #include <string.h>
 #include <sys/stat.h>
+#ifdef HAVE_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #include "fwupd-error.h"
 #include "fu-common.h"
 #include "fu-io-channel.h"
 
+/**
+ * SECTION:fu-io-channel
+ * @short_description: a file descriptor read and write helper
+ *
+ * An object that reads and writes a TTY or other character device.
+ *
+ * By default each read() is treated as one message, as for hidraw where one
+ * read returns one report, and anything beyond the requested size is
+ * dropped. For byte streams such as a serial TTY, protocol parsers can use
+ * fu_io_channel_fill(), fu_io_channel_peek() and fu_io_channel_consume() to
+ * work on data kept in a buffer owned by the channel, or
+ * fu_io_channel_read_frame() and the helpers built on it to read one message
+ * at a time, in which case data received after the end of a frame is kept
+ * for the next read rather than being lost.
+ */
+
+#define FU_IO_CHANNEL_READ_SIZE		0x1000
+#define FU_IO_CHANNEL_BUFFER_MAX	0x100000
+
 struct _FuIOChannel {
 	GObject			 parent_instance;
 	gint			 fd;
+	gint			 epoll_fd;	/* or -1 to use g_poll() */
+	gboolean		 epoll_failed;
+	GByteArray		*buf;		/* received but not consumed */
 };
 
 G_DEFINE_TYPE (FuIOChannel, fu_io_channel, G_TYPE_OBJECT)
@@ -61,12 +86,23 @@ gboolean
 fu_io_channel_shutdown (FuIOChannel *self, GError **error)
 {
 	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), FALSE);
+	if (self->epoll_fd != -1) {
+		g_close (self->epoll_fd, NULL);
+		self->epoll_fd = -1;
+	}
+	g_byte_array_set_size (self->buf, 0);
 	if (!g_close (self->fd, error))
 		return FALSE;
 	self->fd = -1;
 	return TRUE;
 }
 
+static gsize
+fu_io_channel_get_buffered (FuIOChannel *self)
+{
+	return self->buf->len;
+}
+
 static gboolean
 fu_io_channel_flush_input (FuIOChannel *self, GError **error)
 {
@@ -80,6 +116,7 @@ fu_io_channel_flush_input (FuIOChannel *self, GError **error)
 		if (r < 0 && errno != EINTR)
 			break;
 	}
+	g_byte_array_set_size (self->buf, 0);
 	return TRUE;
 }
 
@@ -261,6 +298,488 @@ fu_io_channel_read_bytes (FuIOChannel *self,
 	return g_byte_array_free_to_bytes (buf);
 }
 
+#ifdef HAVE_EPOLL_H
+static gboolean
+fu_io_channel_ensure_epoll (FuIOChannel *self)
+{
+	struct epoll_event ev = {
+		.events = EPOLLIN | EPOLLPRI,
+	};
+
+	if (self->epoll_fd != -1)
+		return TRUE;
+	if (self->epoll_failed)
+		return FALSE;
+
+	/* not all fds can be used with epoll, e.g. regular files */
+	self->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+	if (self->epoll_fd < 0) {
+		g_debug ("failed to create epoll fd: %s", strerror (errno));
+		self->epoll_failed = TRUE;
+		return FALSE;
+	}
+	if (epoll_ctl (self->epoll_fd, EPOLL_CTL_ADD, self->fd, &ev) < 0) {
+		g_debug ("failed to add %i to epoll: %s", self->fd, strerror (errno));
+		g_close (self->epoll_fd, NULL);
+		self->epoll_fd = -1;
+		self->epoll_failed = TRUE;
+		return FALSE;
+	}
+	return TRUE;
+}
+#endif
+
+/* returns %TRUE if the fd is readable, or if the wait was interrupted */
+static gboolean
+fu_io_channel_wait_readable (FuIOChannel *self, gint timeout_ms, GError **error)
+{
+	gint rc;
+	gushort revents = 0;
+
+#ifdef HAVE_EPOLL_H
+	if (fu_io_channel_ensure_epoll (self)) {
+		struct epoll_event ev = { 0 };
+		rc = epoll_wait (self->epoll_fd, &ev, 1, timeout_ms);
+		if (ev.events & EPOLLIN)
+			revents |= G_IO_IN;
+		if (ev.events & EPOLLERR)
+			revents |= G_IO_ERR;
+		if (ev.events & EPOLLHUP)
+			revents |= G_IO_HUP;
+	} else
+#endif
+	{
+		GPollFD fds = {
+			.fd = self->fd,
+			.events = G_IO_IN | G_IO_PRI | G_IO_ERR,
+		};
+		rc = g_poll (&fds, 1, timeout_ms);
+		revents = fds.revents;
+	}
+	if (rc == 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_TIMED_OUT,
+			     "timeout");
+		return FALSE;
+	}
+	if (rc < 0) {
+		if (errno == EINTR)
+			return TRUE;
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "failed to poll %i", self->fd);
+		return FALSE;
+	}
+
+	/* we have data to read */
+	if (revents & G_IO_IN)
+		return TRUE;
+	if (revents & G_IO_ERR) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "error condition");
+		return FALSE;
+	}
+	if (revents & G_IO_HUP) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "connection hung up");
+		return FALSE;
+	}
+	if (revents & G_IO_NVAL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "invalid request");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* appends one read() to @buf, setting @bytes_read to -1 if the read should
+ * be retried and to 0 for end-of-file */
+static gboolean
+fu_io_channel_read_append (FuIOChannel *self,
+			   GByteArray *buf,
+			   gint timeout_ms,
+			   FuIOChannelFlags flags,
+			   gssize *bytes_read,
+			   GError **error)
+{
+	gssize len;
+	guint len_old = buf->len;
+
+	*bytes_read = -1;
+	if ((flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO) == 0) {
+		if (!fu_io_channel_wait_readable (self, timeout_ms, error))
+			return FALSE;
+	}
+
+	/* read directly into the buffer */
+	g_byte_array_set_size (buf, len_old + FU_IO_CHANNEL_READ_SIZE);
+	len = read (self->fd, buf->data + len_old, FU_IO_CHANNEL_READ_SIZE);
+	g_byte_array_set_size (buf, len_old + MAX (len, 0));
+	if (len < 0) {
+		if (errno == EINTR)
+			return TRUE;
+
+		/* the fd is non-blocking, so wait rather than spin */
+		if (errno == EAGAIN) {
+			if (flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO)
+				return fu_io_channel_wait_readable (self, timeout_ms, error);
+			return TRUE;
+		}
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "failed to read %i: %s", self->fd,
+			     strerror (errno));
+		return FALSE;
+	}
+	*bytes_read = len;
+	return TRUE;
+}
+
+/* appends one read() to the stream buffer */
+static gboolean
+fu_io_channel_read_once (FuIOChannel *self,
+			 gint timeout_ms,
+			 FuIOChannelFlags flags,
+			 gssize *bytes_read,
+			 GError **error)
+{
+	if (self->buf->len >= FU_IO_CHANNEL_BUFFER_MAX) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "more than 0x%x bytes buffered from %i",
+			     (guint) FU_IO_CHANNEL_BUFFER_MAX, self->fd);
+		return FALSE;
+	}
+	return fu_io_channel_read_append (self, self->buf, timeout_ms,
+					  flags, bytes_read, error);
+}
+
+static gint
+fu_io_channel_get_remaining (gint64 deadline)
+{
+	gint64 remaining = (deadline - g_get_monotonic_time ()) / 1000;
+	return (gint) CLAMP (remaining, 0, G_MAXINT);
+}
+
+/**
+ * fu_io_channel_fill:
+ * @self: a #FuIOChannel
+ * @min_size: the number of bytes required in the buffer
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
+ * @error: a #GError, or %NULL
+ *
+ * Reads from the TTY until at least @min_size bytes are buffered, or only
+ * until the first read if %FU_IO_CHANNEL_FLAG_SINGLE_SHOT is used.
+ *
+ * Returns: %TRUE if enough data was buffered
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_io_channel_fill (FuIOChannel *self,
+		    gsize min_size,
+		    guint timeout_ms,
+		    FuIOChannelFlags flags,
+		    GError **error)
+{
+	gint64 deadline = g_get_monotonic_time () + ((gint64) timeout_ms * 1000);
+
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	while (fu_io_channel_get_buffered (self) < min_size) {
+		gssize len = 0;
+		if (!fu_io_channel_read_once (self,
+					      fu_io_channel_get_remaining (deadline),
+					      flags, &len, error))
+			return FALSE;
+		if (len == 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "end of file on %i", self->fd);
+			return FALSE;
+		}
+		if (len > 0 && flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
+			break;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_io_channel_peek:
+ * @self: a #FuIOChannel
+ * @bufsz: (out): the number of bytes buffered
+ *
+ * Gets the data that has been read from the TTY but not yet consumed. The
+ * data is valid until the next read or fu_io_channel_consume().
+ *
+ * Returns: (nullable): the buffered data, or %NULL if there is none
+ *
+ * Since: 1.4.0
+ **/
+const guint8 *
+fu_io_channel_peek (FuIOChannel *self, gsize *bufsz)
+{
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
+	g_return_val_if_fail (bufsz != NULL, NULL);
+	*bufsz = fu_io_channel_get_buffered (self);
+	if (*bufsz == 0)
+		return NULL;
+	return self->buf->data;
+}
+
+/**
+ * fu_io_channel_consume:
+ * @self: a #FuIOChannel
+ * @count: the number of bytes to remove from the buffer
+ *
+ * Discards bytes from the start of the buffered data, moving the rest to the
+ * start of the buffer.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_io_channel_consume (FuIOChannel *self, gsize count)
+{
+	g_return_if_fail (FU_IS_IO_CHANNEL (self));
+	g_return_if_fail (count <= fu_io_channel_get_buffered (self));
+	g_byte_array_remove_range (self->buf, 0, count);
+}
+
+static GBytes *
+fu_io_channel_steal_bytes (FuIOChannel *self, gsize count)
+{
+	GBytes *blob = g_bytes_new (self->buf->data, count);
+	fu_io_channel_consume (self, count);
+	return blob;
+}
+
+/**
+ * fu_io_channel_read_frame:
+ * @self: a #FuIOChannel
+ * @func: (scope call): a #FuIOChannelFrameFunc
+ * @user_data: user data for @func
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO
+ * @error: a #GError, or %NULL
+ *
+ * Reads from the TTY until @func finds a complete frame at the start of the
+ * buffered data, which is then removed from the buffer and returned.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_io_channel_read_frame (FuIOChannel *self,
+			  FuIOChannelFrameFunc func,
+			  gpointer user_data,
+			  guint timeout_ms,
+			  FuIOChannelFlags flags,
+			  GError **error)
+{
+	gint64 deadline = g_get_monotonic_time () + ((gint64) timeout_ms * 1000);
+
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
+	g_return_val_if_fail (func != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	while (TRUE) {
+		gsize bufsz = fu_io_channel_get_buffered (self);
+		gsize framesz = 0;
+		gssize len = 0;
+
+		/* check what we already have */
+		if (bufsz > 0) {
+			if (!func (self->buf->data, bufsz,
+				   &framesz, user_data, error))
+				return NULL;
+			if (framesz > 0 && framesz <= bufsz)
+				return fu_io_channel_steal_bytes (self, framesz);
+		}
+
+		/* get more */
+		if (!fu_io_channel_read_once (self,
+					      fu_io_channel_get_remaining (deadline),
+					      flags, &len, error))
+			return NULL;
+		if (len == 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_READ,
+				     "end of file on %i with %" G_GSIZE_FORMAT
+				     " bytes of incomplete frame",
+				     self->fd, bufsz);
+			return NULL;
+		}
+	}
+}
+
+static gboolean
+fu_io_channel_frame_delimited_cb (const guint8 *buf,
+				  gsize bufsz,
+				  gsize *framesz,
+				  gpointer user_data,
+				  GError **error)
+{
+	const guint8 *tmp = memchr (buf, GPOINTER_TO_UINT (user_data), bufsz);
+	if (tmp != NULL)
+		*framesz = (gsize) (tmp - buf) + 1;
+	return TRUE;
+}
+
+/**
+ * fu_io_channel_read_delimited:
+ * @self: a #FuIOChannel
+ * @delimiter: the byte marking the end of a frame, e.g. `\n`
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO
+ * @error: a #GError, or %NULL
+ *
+ * Reads one frame from the TTY, up to and including @delimiter.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_io_channel_read_delimited (FuIOChannel *self,
+			      guint8 delimiter,
+			      guint timeout_ms,
+			      FuIOChannelFlags flags,
+			      GError **error)
+{
+	return fu_io_channel_read_frame (self,
+					 fu_io_channel_frame_delimited_cb,
+					 GUINT_TO_POINTER (delimiter),
+					 timeout_ms, flags, error);
+}
+
+/**
+ * fu_io_channel_read_fixed:
+ * @self: a #FuIOChannel
+ * @size: the frame size in bytes
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO
+ * @error: a #GError, or %NULL
+ *
+ * Reads exactly @size bytes from the TTY.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_io_channel_read_fixed (FuIOChannel *self,
+			  gsize size,
+			  guint timeout_ms,
+			  FuIOChannelFlags flags,
+			  GError **error)
+{
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
+	g_return_val_if_fail (size > 0, NULL);
+	if (!fu_io_channel_fill (self, size, timeout_ms,
+				 flags & ~FU_IO_CHANNEL_FLAG_SINGLE_SHOT,
+				 error))
+		return NULL;
+	return fu_io_channel_steal_bytes (self, size);
+}
+
+typedef struct {
+	gsize		 hdrsz;
+	gsize		 length_offset;
+	guint8		 length_width;
+	FuEndianType	 endian;
+} FuIOChannelPrefixHelper;
+
+static gboolean
+fu_io_channel_frame_prefixed_cb (const guint8 *buf,
+				 gsize bufsz,
+				 gsize *framesz,
+				 gpointer user_data,
+				 GError **error)
+{
+	FuIOChannelPrefixHelper *helper = (FuIOChannelPrefixHelper *) user_data;
+	gsize length = 0;
+
+	/* not enough for the length yet */
+	if (bufsz < helper->length_offset + helper->length_width)
+		return TRUE;
+	if (helper->length_width == 1) {
+		length = buf[helper->length_offset];
+	} else if (helper->length_width == 2) {
+		length = fu_common_read_uint16 (buf + helper->length_offset,
+						helper->endian);
+	} else {
+		length = fu_common_read_uint32 (buf + helper->length_offset,
+						helper->endian);
+	}
+	if (helper->hdrsz + length > FU_IO_CHANNEL_BUFFER_MAX) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "frame length 0x%x too large",
+			     (guint) length);
+		return FALSE;
+	}
+	*framesz = helper->hdrsz + length;
+	return TRUE;
+}
+
+/**
+ * fu_io_channel_read_prefixed:
+ * @self: a #FuIOChannel
+ * @hdrsz: the size of the frame header
+ * @length_offset: the offset of the payload length in the header
+ * @length_width: the size of the payload length, either 1, 2 or 4
+ * @endian: the payload length endianness, e.g. %G_LITTLE_ENDIAN
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO
+ * @error: a #GError, or %NULL
+ *
+ * Reads one frame from the TTY, where the frame is a header of @hdrsz bytes
+ * containing the size of the payload that follows.
+ *
+ * Returns: (transfer full): a #GBytes of the header and payload, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GBytes *
+fu_io_channel_read_prefixed (FuIOChannel *self,
+			     gsize hdrsz,
+			     gsize length_offset,
+			     guint8 length_width,
+			     FuEndianType endian,
+			     guint timeout_ms,
+			     FuIOChannelFlags flags,
+			     GError **error)
+{
+	FuIOChannelPrefixHelper helper = {
+		.hdrsz = hdrsz,
+		.length_offset = length_offset,
+		.length_width = length_width,
+		.endian = endian,
+	};
+	g_return_val_if_fail (length_width == 1 || length_width == 2 || length_width == 4, NULL);
+	g_return_val_if_fail (length_offset + length_width <= hdrsz, NULL);
+	return fu_io_channel_read_frame (self,
+					 fu_io_channel_frame_prefixed_cb,
+					 &helper,
+					 timeout_ms, flags, error);
+}
+
 /**
  * fu_io_channel_read_byte_array:
  * @self: a #FuIOChannel
@@ -271,6 +790,9 @@ fu_io_channel_read_bytes (FuIOChannel *self,
  *
  * Reads bytes from the TTY, that will fail if exceeding @timeout_ms.
  *
+ * Any data already buffered by the frame helpers is returned first. Data
+ * read by this function is never kept for the next call.
+ *
  * Returns: (transfer full): a #GByteArray, or %NULL for error
  *
  * Since: 1.3.2
@@ -282,99 +804,41 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 			       FuIOChannelFlags flags,
 			       GError **error)
 {
-	GPollFD fds = {
-		.fd = self->fd,
-		.events = G_IO_IN | G_IO_PRI | G_IO_ERR,
-	};
 	g_autoptr(GByteArray) buf2 = g_byte_array_new ();
 
 	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
 
+	/* left over from a frame read */
+	if (self->buf->len > 0) {
+		g_byte_array_append (buf2, self->buf->data, self->buf->len);
+		g_byte_array_set_size (self->buf, 0);
+		return g_steal_pointer (&buf2);
+	}
+
 	/* blocking IO */
 	if (flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO) {
-		guint8 buf[1024];
-		gssize len = read (self->fd, buf, sizeof (buf));
-		if (len < 0) {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_READ,
-				     "failed to read %i: %s", self->fd,
-				     strerror (errno));
-			return NULL;
+		gssize len = -1;
+		while (len < 0) {
+			if (!fu_io_channel_read_append (self, buf2, -1, flags, &len, error))
+				return NULL;
 		}
-		if (len > 0)
-			g_byte_array_append (buf2, buf, len);
 		return g_steal_pointer (&buf2);
 	}
 
 	/* nonblocking IO */
 	while (TRUE) {
-		/* wait for data to appear */
-		gint rc = g_poll (&fds, 1, (gint) timeout_ms);
-		if (rc == 0) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_TIMED_OUT,
-				     "timeout");
+		gssize len = 0;
+		if (!fu_io_channel_read_append (self, buf2, (gint) timeout_ms,
+						flags, &len, error))
 			return NULL;
-		}
-		if (rc < 0) {
-			if (errno == EINTR)
-				continue;
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_READ,
-				     "failed to poll %i", self->fd);
-			return NULL;
-		}
-
-		/* we have data to read */
-		if (fds.revents & G_IO_IN) {
-			guint8 buf[1024];
-			gssize len = read (self->fd, buf, sizeof (buf));
-			if (len < 0) {
-				if (errno == EINTR)
-					continue;
-				if (errno == EAGAIN)
-					continue;
-				g_set_error (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_READ,
-					     "failed to read %i: %s", self->fd,
-					     strerror (errno));
-				return NULL;
-			}
-			if (len > 0)
-				g_byte_array_append (buf2, buf, len);
-
-			/* check maximum size */
-			if (max_size > 0 && buf2->len >= (guint) max_size)
-				break;
-			if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
-				break;
+		if (len < 0)
 			continue;
-		}
-		if (fds.revents & G_IO_ERR) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_READ,
-					     "error condition");
-			return NULL;
-		}
-		if (fds.revents & G_IO_HUP) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_READ,
-					     "connection hung up");
-			return NULL;
-		}
-		if (fds.revents & G_IO_NVAL) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_READ,
-					     "invalid request");
-			return NULL;
-		}
+
+		/* check maximum size */
+		if (max_size > 0 && buf2->len >= (guint) max_size)
+			break;
+		if (len == 0 || flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
+			break;
 	}
 
 	/* no data */
@@ -426,7 +890,10 @@ fu_io_channel_read_raw (FuIOChannel *self,
 	if (tmp == NULL)
 		return FALSE;
 	tmpbuf = g_bytes_get_data (tmp, &bytes_read_tmp);
-	if (tmpbuf != NULL)
+
+	/* the rest of the message does not fit and is dropped */
+	bytes_read_tmp = MIN (bytes_read_tmp, bufsz);
+	if (tmpbuf != NULL && buf != NULL)
 		memcpy (buf, tmpbuf, bytes_read_tmp);
 	if (bytes_read != NULL)
 		*bytes_read = bytes_read_tmp;
@@ -437,8 +904,11 @@ static void
 fu_io_channel_finalize (GObject *object)
 {
 	FuIOChannel *self = FU_IO_CHANNEL (object);
+	if (self->epoll_fd != -1)
+		g_close (self->epoll_fd, NULL);
 	if (self->fd != -1)
 		g_close (self->fd, NULL);
+	g_byte_array_unref (self->buf);
 	G_OBJECT_CLASS (fu_io_channel_parent_class)->finalize (object);
 }
 
@@ -453,6 +923,8 @@ static void
 fu_io_channel_init (FuIOChannel *self)
 {
 	self->fd = -1;
+	self->epoll_fd = -1;
+	self->buf = g_byte_array_new ();
 }
 
 /**
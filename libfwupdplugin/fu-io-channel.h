@@ -8,6 +8,8 @@
 
 #include <glib-object.h>
 
+#include "fu-common.h"
+
 #define FU_TYPE_IO_CHANNEL (fu_io_channel_get_type ())
 
 G_DECLARE_FINAL_TYPE (FuIOChannel, fu_io_channel, FU, IO_CHANNEL, GObject)
@@ -30,6 +32,26 @@ typedef enum {
 	FU_IO_CHANNEL_FLAG_LAST
 } FuIOChannelFlags;
 
+/**
+ * FuIOChannelFrameFunc:
+ * @buf: the buffered data
+ * @bufsz: size of @buf
+ * @framesz: (out): the size of the frame at the start of @buf, if known
+ * @user_data: user data
+ * @error: a #GError, or %NULL
+ *
+ * Finds the size of the frame at the start of @buf. Leave @framesz as zero
+ * if more data is required to know the size. The size may be larger than
+ * @bufsz, in which case more data is read.
+ *
+ * Returns: %FALSE if the data is invalid
+ **/
+typedef gboolean (*FuIOChannelFrameFunc)	(const guint8	*buf,
+						 gsize		 bufsz,
+						 gsize		*framesz,
+						 gpointer	 user_data,
+						 GError		**error);
+
 FuIOChannel	*fu_io_channel_unix_new		(gint		 fd);
 FuIOChannel	*fu_io_channel_new_file		(const gchar	*filename,
 						 GError		**error);
@@ -70,3 +92,36 @@ GByteArray	*fu_io_channel_read_byte_array	(FuIOChannel	*self,
 						 guint		 timeout_ms,
 						 FuIOChannelFlags flags,
 						 GError		**error);
+gboolean	 fu_io_channel_fill		(FuIOChannel	*self,
+						 gsize		 min_size,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
+const guint8	*fu_io_channel_peek		(FuIOChannel	*self,
+						 gsize		*bufsz);
+void		 fu_io_channel_consume		(FuIOChannel	*self,
+						 gsize		 count);
+GBytes		*fu_io_channel_read_frame	(FuIOChannel	*self,
+						 FuIOChannelFrameFunc func,
+						 gpointer	 user_data,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
+GBytes		*fu_io_channel_read_delimited	(FuIOChannel	*self,
+						 guint8		 delimiter,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
+GBytes		*fu_io_channel_read_fixed	(FuIOChannel	*self,
+						 gsize		 size,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
+GBytes		*fu_io_channel_read_prefixed	(FuIOChannel	*self,
+						 gsize		 hdrsz,
+						 gsize		 length_offset,
+						 guint8		 length_width,
+						 FuEndianType	 endian,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
@@ -12,12 +12,15 @@
 
 FuPlugin	*fu_plugin_new				(void);
 gboolean	 fu_plugin_is_open			(FuPlugin	*self);
+gboolean	 fu_plugin_has_hook			(FuPlugin	*self,
+							 const gchar	*hook);
 void		 fu_plugin_set_usb_context		(FuPlugin	*self,
 							 GUsbContext	*usb_ctx);
 void		 fu_plugin_set_hwids			(FuPlugin	*self,
 							 FuHwids	*hwids);
 void		 fu_plugin_set_udev_subsystems		(FuPlugin	*self,
 							 GPtrArray	*udev_subsystems);
+GPtrArray	*fu_plugin_get_udev_subsystems		(FuPlugin	*self);
 void		 fu_plugin_set_quirks			(FuPlugin	*self,
 							 FuQuirks	*quirks);
 void		 fu_plugin_set_runtime_versions		(FuPlugin	*self,
@@ -41,6 +44,10 @@ gboolean	 fu_plugin_has_rule			(FuPlugin	*self,
 							 FuPluginRule	 rule,
 							 const gchar	*name);
 GHashTable	*fu_plugin_get_report_metadata		(FuPlugin	*self);
+void		 fu_plugin_add_stats_string		(FuPlugin	*self,
+							 guint		 idt,
+							 GString	*str);
+GVariant	*fu_plugin_get_stats			(FuPlugin	*self);
 gboolean	 fu_plugin_open				(FuPlugin	*self,
 							 const gchar	*filename,
 							 GError		**error);
@@ -20,6 +20,7 @@
 #include "fu-device-private.h"
 #include "fu-plugin-private.h"
 #include "fu-mutex.h"
+#include "fu-trace.h"
 
 /**
  * SECTION:fu-plugin
@@ -38,6 +39,7 @@ typedef struct {
 	GModule			*module;
 	GUsbContext		*usb_ctx;
 	gboolean		 enabled;
+	gboolean		 open_on_demand;
 	guint			 order;
 	guint			 priority;
 	GPtrArray		*rules[FU_PLUGIN_RULE_LAST];
@@ -53,9 +55,17 @@ typedef struct {
 	GHashTable		*devices;	/* platform_id:GObject */
 	GRWLock			 devices_mutex;
 	GHashTable		*report_metadata;	/* key:value */
+	GHashTable		*stats;		/* hook:FuPluginStats */
 	FuPluginData		*data;
 } FuPluginPrivate;
 
+typedef struct {
+	guint			 calls;
+	guint			 failures;
+	guint64			 duration_total;	/* us */
+	guint64			 duration_max;		/* us */
+} FuPluginStats;
+
 enum {
 	SIGNAL_DEVICE_ADDED,
 	SIGNAL_DEVICE_REMOVED,
@@ -105,6 +115,41 @@ typedef gboolean	 (*FuPluginUdevDeviceAddedFunc)	(FuPlugin	*self,
 							 FuUdevDevice	*device,
 							 GError		**error);
 
+/* a plugin ignoring a device it does not support is not a failure */
+static gboolean
+fu_plugin_stats_is_success (gboolean ret, const GError *error)
+{
+	if (ret)
+		return TRUE;
+	return g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+}
+
+static gint64
+fu_plugin_stats_start (FuPlugin *self, const gchar *hook)
+{
+	FU_TRACE2 (plugin_hook_start, fu_plugin_get_name (self), hook);
+	return g_get_monotonic_time ();
+}
+
+static void
+fu_plugin_stats_record (FuPlugin *self, const gchar *hook, gint64 start, gboolean success)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginStats *stats = g_hash_table_lookup (priv->stats, hook);
+	guint64 duration = (guint64) (g_get_monotonic_time () - start);
+
+	FU_TRACE4 (plugin_hook_done, priv->name, hook, duration, success);
+	if (stats == NULL) {
+		stats = g_new0 (FuPluginStats, 1);
+		g_hash_table_insert (priv->stats, g_strdup (hook), stats);
+	}
+	stats->calls++;
+	if (!success)
+		stats->failures++;
+	stats->duration_total += duration;
+	stats->duration_max = MAX (stats->duration_max, duration);
+}
+
 /**
  * fu_plugin_is_open:
  * @self: A #FuPlugin
@@ -122,6 +167,33 @@ fu_plugin_is_open (FuPlugin *self)
 	return priv->module != NULL;
 }
 
+/**
+ * fu_plugin_has_hook:
+ * @self: A #FuPlugin
+ * @hook: A hook name, e.g. `update_prepare`
+ *
+ * Determines if the opened plugin module exports a specific hook.
+ *
+ * Returns: %TRUE if the symbol exists
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_has_hook (FuPlugin *self, const gchar *hook)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gpointer func = NULL;
+	g_autofree gchar *symbol_name = NULL;
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (hook != NULL, FALSE);
+
+	if (priv->module == NULL)
+		return FALSE;
+	symbol_name = g_strdup_printf ("fu_plugin_%s", hook);
+	return g_module_symbol (priv->module, symbol_name, &func);
+}
+
 /**
  * fu_plugin_get_name:
  * @self: A #FuPlugin
@@ -373,6 +445,44 @@ fu_plugin_set_enabled (FuPlugin *self, gboolean enabled)
 	priv->enabled = enabled;
 }
 
+/**
+ * fu_plugin_get_open_on_demand:
+ * @self: A #FuPlugin
+ *
+ * Returns if the plugin module can be opened when a device needs it.
+ *
+ * Returns: %TRUE if the plugin may be opened on demand
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_get_open_on_demand (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	return priv->open_on_demand;
+}
+
+/**
+ * fu_plugin_set_open_on_demand:
+ * @self: A #FuPlugin
+ * @open_on_demand: the open-on-demand value
+ *
+ * Sets if the daemon can wait to open the plugin until a hotplugged device
+ * is routed to it using a `Plugin` quirk. This must only be set by plugins
+ * that do not create devices from their own udev clients, D-Bus watchers
+ * or any other source.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_plugin_set_open_on_demand (FuPlugin *self, gboolean open_on_demand)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	priv->open_on_demand = open_on_demand;
+}
+
 /**
  * fu_plugin_guess_name_from_fn:
  * @filename: filename to guess
@@ -778,6 +888,24 @@ fu_plugin_set_udev_subsystems (FuPlugin *self, GPtrArray *udev_subsystems)
 	priv->udev_subsystems = g_ptr_array_ref (udev_subsystems);
 }
 
+/**
+ * fu_plugin_get_udev_subsystems:
+ * @self: A #FuPlugin
+ *
+ * Gets the udev subsystems used by a plugin.
+ *
+ * Returns: (transfer none) (element-type utf8): subsystems
+ *
+ * Since: 1.4.0
+ **/
+GPtrArray *
+fu_plugin_get_udev_subsystems (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), NULL);
+	return priv->udev_subsystems;
+}
+
 /**
  * fu_plugin_set_quirks:
  * @self: A #FuPlugin
@@ -1090,6 +1218,8 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1105,7 +1235,10 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing startup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_stats_start (self, "startup");
+	ret = func (self, &error_local);
+	fu_plugin_stats_record (self, "startup", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for startup()",
 				    priv->name);
@@ -1130,6 +1263,8 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1146,12 +1281,18 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		if (device_func != NULL) {
 			g_debug ("running superclassed %s() on %s",
 				 symbol_name + 10, priv->name);
-			return device_func (self, device, error);
+			start = fu_plugin_stats_start (self, symbol_name + 10);
+			ret = device_func (self, device, error);
+			fu_plugin_stats_record (self, symbol_name + 10, start, ret);
+			return ret;
 		}
 		return TRUE;
 	}
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, symbol_name + 10);
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, symbol_name + 10, start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1175,6 +1316,8 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginFlaggedDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1190,7 +1333,10 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, flags, device, &error_local)) {
+	start = fu_plugin_stats_start (self, symbol_name + 10);
+	ret = func (self, flags, device, &error_local);
+	fu_plugin_stats_record (self, symbol_name + 10, start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1214,6 +1360,8 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceArrayFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1229,7 +1377,10 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, devices, &error_local)) {
+	start = fu_plugin_stats_start (self, symbol_name + 10);
+	ret = func (self, devices, &error_local);
+	fu_plugin_stats_record (self, symbol_name + 10, start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1262,6 +1413,8 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1277,7 +1430,10 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_stats_start (self, "coldplug");
+	ret = func (self, &error_local);
+	fu_plugin_stats_record (self, "coldplug", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug()",
 				    priv->name);
@@ -1309,6 +1465,8 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1324,7 +1482,10 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing recoldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_stats_start (self, "recoldplug");
+	ret = func (self, &error_local);
+	fu_plugin_stats_record (self, "recoldplug", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for recoldplug()",
 				    priv->name);
@@ -1357,6 +1518,8 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1372,7 +1535,10 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_prepare() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_stats_start (self, "coldplug_prepare");
+	ret = func (self, &error_local);
+	fu_plugin_stats_record (self, "coldplug_prepare", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_prepare()",
 				    priv->name);
@@ -1405,6 +1571,8 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1420,7 +1588,10 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_cleanup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_stats_start (self, "coldplug_cleanup");
+	ret = func (self, &error_local);
+	fu_plugin_stats_record (self, "coldplug_cleanup", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_cleanup()",
 				    priv->name);
@@ -1758,6 +1929,8 @@ fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError *
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUsbDeviceAddedFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1773,13 +1946,23 @@ fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError *
 	if (func == NULL) {
 		if (priv->device_gtype != G_TYPE_INVALID ||
 		    fu_device_get_specialized_gtype (FU_DEVICE (device)) != G_TYPE_INVALID) {
-			if (!fu_plugin_usb_device_added (self, device, error))
+			start = fu_plugin_stats_start (self, "usb_device_added");
+			ret = fu_plugin_usb_device_added (self, device, &error_local);
+			fu_plugin_stats_record (self, "usb_device_added", start,
+						fu_plugin_stats_is_success (ret, error_local));
+			if (!ret) {
+				g_propagate_error (error, g_steal_pointer (&error_local));
 				return FALSE;
+			}
 		}
 		return TRUE;
 	}
 	g_debug ("performing usb_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, "usb_device_added");
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, "usb_device_added", start,
+				fu_plugin_stats_is_success (ret, error_local));
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for usb_device_added()",
 				    priv->name);
@@ -1813,6 +1996,8 @@ fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUdevDeviceAddedFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1828,13 +2013,23 @@ fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError
 	if (func == NULL) {
 		if (priv->device_gtype != G_TYPE_INVALID ||
 		    fu_device_get_specialized_gtype (FU_DEVICE (device)) != G_TYPE_INVALID) {
-			if (!fu_plugin_udev_device_added (self, device, error))
+			start = fu_plugin_stats_start (self, "udev_device_added");
+			ret = fu_plugin_udev_device_added (self, device, &error_local);
+			fu_plugin_stats_record (self, "udev_device_added", start,
+						fu_plugin_stats_is_success (ret, error_local));
+			if (!ret) {
+				g_propagate_error (error, g_steal_pointer (&error_local));
 				return FALSE;
+			}
 		}
 		return TRUE;
 	}
 	g_debug ("performing udev_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, "udev_device_added");
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, "udev_device_added", start,
+				fu_plugin_stats_is_success (ret, error_local));
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for udev_device_added()",
 				    priv->name);
@@ -1868,6 +2063,8 @@ fu_plugin_runner_udev_device_changed (FuPlugin *self, FuUdevDevice *device, GErr
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUdevDeviceAddedFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1883,7 +2080,10 @@ fu_plugin_runner_udev_device_changed (FuPlugin *self, FuUdevDevice *device, GErr
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing udev_device_changed() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, "udev_device_changed");
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, "udev_device_changed", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for udev_device_changed()",
 				    priv->name);
@@ -2008,6 +2208,8 @@ fu_plugin_runner_verify (FuPlugin *self,
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginVerifyFunc func = NULL;
 	GPtrArray *checksums;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -2021,7 +2223,10 @@ fu_plugin_runner_verify (FuPlugin *self,
 	/* optional */
 	g_module_symbol (priv->module, "fu_plugin_verify", (gpointer *) &func);
 	if (func == NULL) {
-		return fu_plugin_device_read_firmware (self, device, error);
+		start = fu_plugin_stats_start (self, "verify");
+		ret = fu_plugin_device_read_firmware (self, device, error);
+		fu_plugin_stats_record (self, "verify", start, ret);
+		return ret;
 	}
 
 	/* clear any existing verification checksums */
@@ -2037,7 +2242,10 @@ fu_plugin_runner_verify (FuPlugin *self,
 
 	/* run vfunc */
 	g_debug ("performing verify() on %s", priv->name);
-	if (!func (self, device, flags, &error_local)) {
+	start = fu_plugin_stats_start (self, "verify");
+	ret = func (self, device, flags, &error_local);
+	fu_plugin_stats_record (self, "verify", start, ret);
+	if (!ret) {
 		g_autoptr(GError) error_attach = NULL;
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for verify()",
@@ -2178,6 +2386,8 @@ fu_plugin_runner_update (FuPlugin *self,
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUpdateFunc update_func;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -2196,11 +2406,17 @@ fu_plugin_runner_update (FuPlugin *self,
 	g_module_symbol (priv->module, "fu_plugin_update", (gpointer *) &update_func);
 	if (update_func == NULL) {
 		g_debug ("running superclassed write_firmware() on %s", priv->name);
-		return fu_plugin_device_write_firmware (self, device, blob_fw, flags, error);
+		start = fu_plugin_stats_start (self, "update");
+		ret = fu_plugin_device_write_firmware (self, device, blob_fw, flags, error);
+		fu_plugin_stats_record (self, "update", start, ret);
+		return ret;
 	}
 
 	/* online */
-	if (!update_func (self, device, blob_fw, flags, &error_local)) {
+	start = fu_plugin_stats_start (self, "update");
+	ret = update_func (self, device, blob_fw, flags, &error_local);
+	fu_plugin_stats_record (self, "update", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for update()",
 				    priv->name);
@@ -2243,6 +2459,8 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -2258,7 +2476,10 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing clear_result() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, "clear_result");
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, "clear_result", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for clear_result()",
 				    priv->name);
@@ -2292,6 +2513,8 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 start;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -2307,7 +2530,10 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing get_results() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_stats_start (self, "get_results");
+	ret = func (self, device, &error_local);
+	fu_plugin_stats_record (self, "get_results", start, ret);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for get_results()",
 				    priv->name);
@@ -2496,6 +2722,84 @@ fu_plugin_get_report_metadata (FuPlugin *self)
 	return priv->report_metadata;
 }
 
+/**
+ * fu_plugin_add_stats_string:
+ * @self: a #FuPlugin
+ * @idt: the indent level
+ * @str: a #GString
+ *
+ * Appends the number of calls, failures and the time spent in each plugin
+ * hook that has been run since the plugin was loaded.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_plugin_add_stats_string (FuPlugin *self, guint idt, GString *str)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GList) keys = NULL;
+
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_return_if_fail (str != NULL);
+
+	keys = g_list_sort (g_hash_table_get_keys (priv->stats),
+			    (GCompareFunc) g_strcmp0);
+	for (GList *l = keys; l != NULL; l = l->next) {
+		const gchar *hook = l->data;
+		FuPluginStats *stats = g_hash_table_lookup (priv->stats, hook);
+		g_autofree gchar *tmp = NULL;
+		tmp = g_strdup_printf ("calls:%u failures:%u total:%.2fms max:%.2fms",
+				       stats->calls, stats->failures,
+				       (gdouble) stats->duration_total / 1000.f,
+				       (gdouble) stats->duration_max / 1000.f);
+		fu_common_string_append_kv (str, idt, hook, tmp);
+	}
+}
+
+/**
+ * fu_plugin_get_stats:
+ * @self: a #FuPlugin
+ *
+ * Gets the statistics for each plugin hook that has been run since the plugin
+ * was loaded, with durations in microseconds.
+ *
+ * Returns: (transfer full): a #GVariant of type `aa{sv}`
+ *
+ * Since: 1.4.0
+ **/
+GVariant *
+fu_plugin_get_stats (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key, value;
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+	g_hash_table_iter_init (&iter, priv->stats);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		FuPluginStats *stats = (FuPluginStats *) value;
+		GVariantBuilder dict;
+		g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&dict, "{sv}", "Plugin",
+				       g_variant_new_string (priv->name));
+		g_variant_builder_add (&dict, "{sv}", "Hook",
+				       g_variant_new_string ((const gchar *) key));
+		g_variant_builder_add (&dict, "{sv}", "Calls",
+				       g_variant_new_uint32 (stats->calls));
+		g_variant_builder_add (&dict, "{sv}", "Failures",
+				       g_variant_new_uint32 (stats->failures));
+		g_variant_builder_add (&dict, "{sv}", "DurationTotal",
+				       g_variant_new_uint64 (stats->duration_total));
+		g_variant_builder_add (&dict, "{sv}", "DurationMax",
+				       g_variant_new_uint64 (stats->duration_max));
+		g_variant_builder_add_value (&builder, g_variant_builder_end (&dict));
+	}
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
 /**
  * fu_plugin_get_config_value:
  * @self: a #FuPlugin
@@ -2654,6 +2958,7 @@ fu_plugin_init (FuPlugin *self)
 					       g_free, (GDestroyNotify) g_object_unref);
 	g_rw_lock_init (&priv->devices_mutex);
 	priv->report_metadata = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	for (guint i = 0; i < FU_PLUGIN_RULE_LAST; i++)
 		priv->rules[i] = g_ptr_array_new_with_free_func (g_free);
 }
@@ -2693,6 +2998,7 @@ fu_plugin_finalize (GObject *object)
 		g_hash_table_unref (priv->compile_versions);
 	g_hash_table_unref (priv->devices);
 	g_hash_table_unref (priv->report_metadata);
+	g_hash_table_unref (priv->stats);
 	g_rw_lock_clear (&priv->devices_mutex);
 	g_free (priv->build_hash);
 	g_free (priv->name);
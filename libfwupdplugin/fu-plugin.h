@@ -98,6 +98,9 @@ FuPluginData	*fu_plugin_alloc_data			(FuPlugin	*self,
 gboolean	 fu_plugin_get_enabled			(FuPlugin	*self);
 void		 fu_plugin_set_enabled			(FuPlugin	*self,
 							 gboolean	 enabled);
+gboolean	 fu_plugin_get_open_on_demand		(FuPlugin	*self);
+void		 fu_plugin_set_open_on_demand		(FuPlugin	*self,
+							 gboolean	 open_on_demand);
 void		 fu_plugin_set_build_hash		(FuPlugin	*self,
 							 const gchar	*build_hash);
 GUsbContext	*fu_plugin_get_usb_context		(FuPlugin	*self);
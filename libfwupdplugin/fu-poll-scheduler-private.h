@@ -0,0 +1,17 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-device.h"
+
+/* not exported from libfwupdplugin, only for fu-device.c and the self tests */
+
+void		 fu_poll_scheduler_add			(FuDevice	*device,
+							 guint		 interval);
+void		 fu_poll_scheduler_remove		(FuDevice	*device);
+guint		 fu_poll_scheduler_get_size		(void);
+gboolean	 fu_device_poll_scheduled		(FuDevice	*self);
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuPollScheduler"
+
+#include "config.h"
+
+#include "fu-device-private.h"
+#include "fu-poll-scheduler-private.h"
+
+/*
+ * All devices polled at an interval of a second or more share one timer
+ * wheel with one-second slots. The wheel is driven by a single
+ * g_timeout_add_seconds() source, which GLib aligns to the whole-second
+ * boundary of the session, so all devices due in the same second are polled
+ * back-to-back from one wakeup rather than each having their own timer.
+ *
+ * Entries are removed lazily: fu_poll_scheduler_remove() detaches the entry
+ * from the device and the wheel frees it when the slot is next visited,
+ * which makes it safe for a poll callback to change its own interval.
+ */
+
+#define FU_POLL_SCHEDULER_SLOTS			64
+
+typedef struct {
+	FuDevice	*device;	/* noref, NULL when removed */
+	guint		 ticks;
+	guint		 rounds;
+} FuPollSchedulerEntry;
+
+typedef struct {
+	GPtrArray	*slots[FU_POLL_SCHEDULER_SLOTS];	/* of FuPollSchedulerEntry */
+	GHashTable	*entries;	/* FuDevice : FuPollSchedulerEntry */
+	guint		 cursor;
+	guint		 source_id;
+} FuPollScheduler;
+
+static FuPollScheduler *
+fu_poll_scheduler_get (void)
+{
+	static FuPollScheduler *self = NULL;
+	if (self == NULL) {
+		self = g_new0 (FuPollScheduler, 1);
+		for (guint i = 0; i < FU_POLL_SCHEDULER_SLOTS; i++)
+			self->slots[i] = g_ptr_array_new ();
+		self->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+	return self;
+}
+
+static void
+fu_poll_scheduler_insert (FuPollScheduler *self, FuPollSchedulerEntry *entry)
+{
+	guint idx = (self->cursor + entry->ticks) % FU_POLL_SCHEDULER_SLOTS;
+	entry->rounds = (entry->ticks - 1) / FU_POLL_SCHEDULER_SLOTS;
+	g_ptr_array_add (self->slots[idx], entry);
+}
+
+static gboolean
+fu_poll_scheduler_tick_cb (gpointer user_data)
+{
+	FuPollScheduler *self = (FuPollScheduler *) user_data;
+	g_autoptr(GPtrArray) due = NULL;
+
+	/* take the whole slot so callbacks can safely add entries */
+	self->cursor = (self->cursor + 1) % FU_POLL_SCHEDULER_SLOTS;
+	due = self->slots[self->cursor];
+	self->slots[self->cursor] = g_ptr_array_new ();
+
+	for (guint i = 0; i < due->len; i++) {
+		FuPollSchedulerEntry *entry = g_ptr_array_index (due, i);
+		g_autoptr(FuDevice) device = NULL;
+
+		/* removed since it was scheduled */
+		if (entry->device == NULL) {
+			g_free (entry);
+			continue;
+		}
+
+		/* not this time around the wheel */
+		if (entry->rounds > 0) {
+			entry->rounds--;
+			g_ptr_array_add (self->slots[self->cursor], entry);
+			continue;
+		}
+
+		/* the callback may remove the device or change the interval */
+		device = g_object_ref (entry->device);
+		if (!fu_device_poll_scheduled (device)) {
+			if (entry->device != NULL)
+				g_hash_table_remove (self->entries, device);
+			entry->device = NULL;
+		}
+		if (entry->device == NULL) {
+			g_free (entry);
+			continue;
+		}
+		fu_poll_scheduler_insert (self, entry);
+	}
+
+	/* nothing left to poll */
+	if (g_hash_table_size (self->entries) == 0) {
+		self->source_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+/* adds a device to the shared poll wheel, replacing any existing entry;
+ * @interval is in ms and is rounded to the nearest second */
+void
+fu_poll_scheduler_add (FuDevice *device, guint interval)
+{
+	FuPollScheduler *self = fu_poll_scheduler_get ();
+	FuPollSchedulerEntry *entry = g_new0 (FuPollSchedulerEntry, 1);
+
+	g_return_if_fail (FU_IS_DEVICE (device));
+
+	fu_poll_scheduler_remove (device);
+	entry->device = device;
+	entry->ticks = MAX ((interval + 500) / 1000, 1);
+	fu_poll_scheduler_insert (self, entry);
+	g_hash_table_insert (self->entries, device, entry);
+	if (self->source_id == 0)
+		self->source_id = g_timeout_add_seconds (1, fu_poll_scheduler_tick_cb, self);
+}
+
+/* removes a device from the shared poll wheel, if present */
+void
+fu_poll_scheduler_remove (FuDevice *device)
+{
+	FuPollScheduler *self = fu_poll_scheduler_get ();
+	FuPollSchedulerEntry *entry = g_hash_table_lookup (self->entries, device);
+	if (entry == NULL)
+		return;
+	entry->device = NULL;
+	g_hash_table_remove (self->entries, device);
+}
+
+/* only used by the self tests */
+guint
+fu_poll_scheduler_get_size (void)
+{
+	FuPollScheduler *self = fu_poll_scheduler_get ();
+	return g_hash_table_size (self->entries);
+}
@@ -16,6 +16,7 @@
 #include "fu-common.h"
 #include "fu-mutex.h"
 #include "fu-quirks.h"
+#include "fu-trace.h"
 
 #include "fwupd-common.h"
 #include "fwupd-error.h"
@@ -200,7 +201,7 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, XbBuilder *builder,
 }
 
 static gboolean
-fu_quirks_check_silo (FuQuirks *self, GError **error)
+fu_quirks_build_silo (FuQuirks *self, GError **error)
 {
 	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_WATCH_BLOB;
 	g_autofree gchar *cachedirpkg = NULL;
@@ -208,14 +209,9 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 	g_autofree gchar *localstatedir = NULL;
 	g_autofree gchar *xmlbfn = NULL;
 	g_autoptr(GFile) file = NULL;
-	g_autoptr(XbBuilder) builder = NULL;
-
-	/* everything is okay */
-	if (self->silo != NULL && xb_silo_is_valid (self->silo))
-		return TRUE;
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
 
 	/* system datadir */
-	builder = xb_builder_new ();
 	datadir = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
 	if (!fu_quirks_add_quirks_for_path (self, builder, datadir, error))
 		return FALSE;
@@ -240,30 +236,30 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 	return self->silo != NULL;
 }
 
-/**
- * fu_quirks_lookup_by_id:
- * @self: A #FuPlugin
- * @group: A string group, e.g. "DeviceInstanceId=USB\VID_1235&PID_AB11"
- * @key: An ID to match the entry, e.g. "Name"
- *
- * Looks up an entry in the hardware database using a string value.
- *
- * Returns: (transfer none): values from the database, or %NULL if not found
- *
- * Since: 1.0.1
- **/
-const gchar *
-fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
+static gboolean
+fu_quirks_check_silo (FuQuirks *self, GError **error)
+{
+	gboolean ret;
+
+	/* everything is okay */
+	if (self->silo != NULL && xb_silo_is_valid (self->silo))
+		return TRUE;
+
+	/* the done probe fires however the build fails */
+	FU_TRACE1 (silo_build_start, "quirks");
+	ret = fu_quirks_build_silo (self, error);
+	FU_TRACE2 (silo_build_done, "quirks", ret);
+	return ret;
+}
+
+static const gchar *
+fu_quirks_lookup_by_id_internal (FuQuirks *self, const gchar *group, const gchar *key)
 {
 	g_autofree gchar *group_key = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(XbNode) n = NULL;
 	g_autoptr(XbQuery) query = NULL;
 
-	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
-	g_return_val_if_fail (group != NULL, NULL);
-	g_return_val_if_fail (key != NULL, NULL);
-
 	/* ensure up to date */
 	if (!fu_quirks_check_silo (self, &error)) {
 		g_warning ("failed to build silo: %s", error->message);
@@ -304,6 +300,33 @@ fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 	return xb_node_get_text (n);
 }
 
+/**
+ * fu_quirks_lookup_by_id:
+ * @self: A #FuPlugin
+ * @group: A string group, e.g. "DeviceInstanceId=USB\VID_1235&PID_AB11"
+ * @key: An ID to match the entry, e.g. "Name"
+ *
+ * Looks up an entry in the hardware database using a string value.
+ *
+ * Returns: (transfer none): values from the database, or %NULL if not found
+ *
+ * Since: 1.0.1
+ **/
+const gchar *
+fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
+{
+	const gchar *value;
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
+	g_return_val_if_fail (group != NULL, NULL);
+	g_return_val_if_fail (key != NULL, NULL);
+
+	FU_TRACE2 (quirk_lookup_start, group, key);
+	value = fu_quirks_lookup_by_id_internal (self, group, key);
+	FU_TRACE3 (quirk_lookup_done, group, key, value);
+	return value;
+}
+
 /**
  * fu_quirks_lookup_by_id_iter:
  * @self: A #FuQuirks
@@ -330,6 +353,8 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 	g_return_val_if_fail (group != NULL, FALSE);
 	g_return_val_if_fail (iter_cb != NULL, FALSE);
 
+	FU_TRACE1 (quirk_lookup_iter, group);
+
 	/* ensure up to date */
 	if (!fu_quirks_check_silo (self, &error)) {
 		g_warning ("failed to build silo: %s", error->message);
@@ -373,6 +398,86 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 	return TRUE;
 }
 
+/**
+ * fu_quirks_get_groups_with_key:
+ * @self: A #FuQuirks
+ * @key: An ID to match the entry, e.g. "Plugin"
+ * @error: A #GError, or %NULL
+ *
+ * Gets all the groups in the hardware database that set a specific key. For
+ * groups specified using `DeviceInstanceId=` or `Guid=` this is the GUID.
+ *
+ * Returns: (transfer container) (element-type utf8): group IDs, or %NULL for error
+ *
+ * Since: 1.4.0
+ **/
+GPtrArray *
+fu_quirks_get_groups_with_key (FuQuirks *self, const gchar *key, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) groups = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbQuery) query = NULL;
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
+	g_return_val_if_fail (key != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* ensure up to date */
+	if (!fu_quirks_check_silo (self, error))
+		return NULL;
+
+	/* query */
+	query = xb_query_new_full (self->silo,
+				   "quirk/device/value[@key=?]",
+				   XB_QUERY_FLAG_NONE,
+				   &error_local);
+	if (query == NULL) {
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+			return g_steal_pointer (&groups);
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+			return g_steal_pointer (&groups);
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	if (!xb_query_bind_str (query, 0, key, error))
+		return NULL;
+	results = xb_silo_query_full (self->silo, query, &error_local);
+	if (results == NULL) {
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+			return g_steal_pointer (&groups);
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	for (guint i = 0; i < results->len; i++) {
+		XbNode *n = g_ptr_array_index (results, i);
+		g_autoptr(XbNode) parent = xb_node_get_parent (n);
+		if (parent == NULL)
+			continue;
+		g_ptr_array_add (groups, g_strdup (xb_node_get_attr (parent, "id")));
+	}
+	return g_steal_pointer (&groups);
+}
+
+/**
+ * fu_quirks_invalidate: (skip)
+ * @self: A #FuQuirks
+ *
+ * Closes the quirk silo, freeing any nodes it created. The silo is opened
+ * again from the cache file when the next quirk is looked up.
+ *
+ * Any strings previously returned by fu_quirks_lookup_by_id() are not valid
+ * after this has been called.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_quirks_invalidate (FuQuirks *self)
+{
+	g_return_if_fail (FU_IS_QUIRKS (self));
+	g_clear_object (&self->silo);
+}
+
 /**
  * fu_quirks_load: (skip)
  * @self: A #FuQuirks
@@ -35,6 +35,7 @@ FuQuirks	*fu_quirks_new				(void);
 gboolean	 fu_quirks_load				(FuQuirks	*self,
 							 FuQuirksLoadFlags load_flags,
 							 GError		**error);
+void		 fu_quirks_invalidate			(FuQuirks	*self);
 const gchar	*fu_quirks_lookup_by_id			(FuQuirks	*self,
 							 const gchar	*group,
 							 const gchar	*key);
@@ -42,6 +43,9 @@ gboolean	 fu_quirks_lookup_by_id_iter		(FuQuirks	*self,
 							 const gchar	*group,
 							 FuQuirksIter	 iter_cb,
 							 gpointer	 user_data);
+GPtrArray	*fu_quirks_get_groups_with_key		(FuQuirks	*self,
+							 const gchar	*key,
+							 GError		**error);
 
 #define	FU_QUIRKS_PLUGIN			"Plugin"
 #define	FU_QUIRKS_FLAGS				"Flags"
@@ -59,6 +63,7 @@ gboolean	 fu_quirks_lookup_by_id_iter		(FuQuirks	*self,
 #define	FU_QUIRKS_FIRMWARE_SIZE_MAX		"FirmwareSizeMax"
 #define	FU_QUIRKS_FIRMWARE_SIZE			"FirmwareSize"
 #define	FU_QUIRKS_INSTALL_DURATION		"InstallDuration"
+#define	FU_QUIRKS_CLOSE_DELAY			"CloseDelay"
 #define	FU_QUIRKS_VERSION_FORMAT		"VersionFormat"
 #define	FU_QUIRKS_GTYPE				"GType"
 #define	FU_QUIRKS_PROTOCOL			"Protocol"
@@ -11,10 +11,17 @@
 #include <fwupdplugin.h>
 #include <libgcab.h>
 #include <glib/gstdio.h>
+#include <glib-unix.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "fu-device-private.h"
 #include "fu-plugin-private.h"
+#include "fu-poll-scheduler-private.h"
 #include "fu-smbios-private.h"
+#include "fu-udev-device-private.h"
+#include "fu-usb-transfer-queue-private.h"
 
 static GMainLoop *_test_loop = NULL;
 static guint _test_loop_timeout_id = 0;
@@ -51,6 +58,64 @@ fu_test_loop_quit (void)
 	}
 }
 
+/* counts calls to the device vfuncs using metadata */
+#define FU_TYPE_TEST_DEVICE (fu_test_device_get_type ())
+G_DECLARE_FINAL_TYPE (FuTestDevice, fu_test_device, FU, TEST_DEVICE, FuDevice)
+
+struct _FuTestDevice {
+	FuDevice		 parent_instance;
+};
+
+G_DEFINE_TYPE (FuTestDevice, fu_test_device, FU_TYPE_DEVICE)
+
+static void
+fu_test_device_incr (FuDevice *device, const gchar *key)
+{
+	guint64 cnt = fu_device_get_metadata_integer (device, key);
+	fu_device_set_metadata_integer (device, key, cnt + 1);
+}
+
+static gboolean
+fu_test_device_open (FuDevice *device, GError **error)
+{
+	fu_test_device_incr (device, "open-cnt");
+	return TRUE;
+}
+
+static gboolean
+fu_test_device_close (FuDevice *device, GError **error)
+{
+	fu_test_device_incr (device, "close-cnt");
+	return TRUE;
+}
+
+static FuFirmware *
+fu_test_device_prepare_firmware (FuDevice *device,
+				 GBytes *fw,
+				 FwupdInstallFlags flags,
+				 GError **error)
+{
+	fu_test_device_incr (device, "prepare-cnt");
+	return fu_firmware_new_from_bytes (fw);
+}
+
+static void
+fu_test_device_init (FuTestDevice *self)
+{
+	fu_device_set_metadata_integer (FU_DEVICE (self), "open-cnt", 0);
+	fu_device_set_metadata_integer (FU_DEVICE (self), "close-cnt", 0);
+	fu_device_set_metadata_integer (FU_DEVICE (self), "prepare-cnt", 0);
+}
+
+static void
+fu_test_device_class_init (FuTestDeviceClass *klass)
+{
+	FuDeviceClass *klass_device = FU_DEVICE_CLASS (klass);
+	klass_device->open = fu_test_device_open;
+	klass_device->close = fu_test_device_close;
+	klass_device->prepare_firmware = fu_test_device_prepare_firmware;
+}
+
 static void
 fu_archive_invalid_func (void)
 {
@@ -174,6 +239,82 @@ fu_device_open_refcount_func (void)
 	g_assert_false (ret);
 }
 
+static void
+fu_device_close_delay_func (void)
+{
+	gboolean ret;
+	g_autoptr(FuDevice) device = g_object_new (FU_TYPE_TEST_DEVICE, NULL);
+	g_autoptr(GError) error = NULL;
+
+	fu_device_set_id (device, "test_device");
+	fu_device_set_close_delay (device, 20);
+
+	/* the close is deferred until the device is idle */
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "open-cnt"), ==, 1);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 0);
+	fu_test_loop_run_with_timeout (100);
+	fu_test_loop_quit ();
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 1);
+
+	/* opening again within the delay reuses the same handle */
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "open-cnt"), ==, 2);
+	fu_test_loop_run_with_timeout (100);
+	fu_test_loop_quit ();
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 1);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	fu_test_loop_run_with_timeout (100);
+	fu_test_loop_quit ();
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "open-cnt"), ==, 2);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 2);
+
+	/* the old handle is not reused when the backing device changes */
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	fu_device_probe_invalidate (device);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 3);
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "open-cnt"), ==, 4);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	fu_test_loop_run_with_timeout (100);
+	fu_test_loop_quit ();
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 4);
+
+	/* no delay closes straight away */
+	fu_device_set_close_delay (device, 0);
+	ret = fu_device_open (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_close (device, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "close-cnt"), ==, 5);
+}
+
 static void
 fu_device_metadata_func (void)
 {
@@ -398,6 +539,11 @@ fu_plugin_quirks_func (void)
 	g_assert_cmpstr (tmp, ==, NULL);
 	tmp = fu_plugin_lookup_quirk_by_id (plugin, "bb9ec3e2-77b3-53bc-a1f1-b05916715627", "Flags");
 	g_assert_cmpstr (tmp, ==, "clever");
+
+	/* reopened when next used */
+	fu_quirks_invalidate (quirks);
+	tmp = fu_plugin_lookup_quirk_by_id (plugin, "USB\\VID_0A5C&PID_6412", "Flags");
+	g_assert_cmpstr (tmp, ==, "ignore-runtime");
 }
 
 static void
@@ -455,6 +601,35 @@ fu_plugin_quirks_device_func (void)
 	g_assert (fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_UPDATABLE));
 }
 
+static void
+fu_plugin_quirks_groups_func (void)
+{
+	gboolean ret;
+	g_autofree gchar *guid = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GPtrArray) groups_none = NULL;
+
+	ret = fu_quirks_load (quirks, FU_QUIRKS_LOAD_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* instance IDs are stored as GUIDs */
+	groups = fu_quirks_get_groups_with_key (quirks, "Children", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (groups);
+	g_assert_cmpint (groups->len, ==, 1);
+	guid = fwupd_guid_hash_string ("USB\\VID_0BDA&PID_1100");
+	g_assert_cmpstr (g_ptr_array_index (groups, 0), ==, guid);
+
+	/* not an error */
+	groups_none = fu_quirks_get_groups_with_key (quirks, "Unfound", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (groups_none);
+	g_assert_cmpint (groups_none->len, ==, 0);
+}
+
 static void fu_common_kernel_lockdown_func (void)
 {
 	gboolean ret;
@@ -640,6 +815,130 @@ fu_common_endian_func (void)
 	g_assert_cmpint (fu_common_read_uint16 (buf, G_BIG_ENDIAN), ==, 0x1234);
 }
 
+static void
+fu_common_get_contents_bytes_mapped_func (void)
+{
+	gboolean ret;
+	gint fd;
+	gsize bufsz = 2 * 1024 * 1024;
+	g_autofree guint8 *buf = g_malloc (bufsz);
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_copy = NULL;
+	g_autoptr(GBytes) blob_mapped = NULL;
+	g_autoptr(GError) error = NULL;
+
+	tmpdir = g_dir_make_tmp ("fwupd-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (tmpdir);
+	fn = g_build_filename (tmpdir, "firmware.bin", NULL);
+	for (gsize i = 0; i < bufsz; i++)
+		buf[i] = (guint8) (i * 7);
+	blob = g_bytes_new (buf, bufsz);
+	ret = fu_common_set_contents_bytes (fn, blob, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (g_chmod (fn, 0644), ==, 0);
+	blob_copy = fu_common_get_contents_bytes (fn, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob_copy);
+	g_assert_true (g_bytes_equal (blob, blob_copy));
+	blob_mapped = fu_common_get_contents_bytes_mapped (fn, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob_mapped);
+	g_assert_true (g_bytes_equal (blob, blob_mapped));
+
+	/* the owner can still change the file, so neither sees it */
+	memset (buf, 0xff, bufsz);
+	fd = g_open (fn, O_WRONLY, 0);
+	g_assert_cmpint (fd, >=, 0);
+	g_assert_cmpint (write (fd, buf, bufsz), ==, (gssize) bufsz);
+	g_assert_true (g_close (fd, NULL));
+	g_assert_true (g_bytes_equal (blob, blob_copy));
+	g_assert_true (g_bytes_equal (blob, blob_mapped));
+
+	/* or truncate it */
+	g_assert_cmpint (truncate (fn, 0), ==, 0);
+	g_assert_true (g_bytes_equal (blob, blob_copy));
+	g_assert_true (g_bytes_equal (blob, blob_mapped));
+
+	/* same error as g_file_get_contents() */
+	g_clear_pointer (&blob_mapped, g_bytes_unref);
+	blob_mapped = fu_common_get_contents_bytes_mapped ("/NOTGOINGTOEXIST", &error);
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+	g_assert_null (blob_mapped);
+
+	g_unlink (fn);
+	g_rmdir (tmpdir);
+}
+
+static guint32
+fu_crc32_bitwise (const guint8 *buf, gsize bufsz)
+{
+	guint32 crc = 0xffffffff;
+	for (gsize i = 0; i < bufsz; i++) {
+		crc ^= buf[i];
+		for (guint j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+	}
+	return ~crc;
+}
+
+static void
+fu_crc_func (void)
+{
+	const guint8 check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	guint8 buf[1024 + 8];
+	guint32 crc;
+
+	/* catalogue check values */
+	g_assert_cmpint (fu_crc8 (FU_CRC_KIND_B8_STANDARD, check, sizeof(check)), ==, 0xf4);
+	g_assert_cmpint (fu_crc8 (FU_CRC_KIND_B8_DVB_S2, check, sizeof(check)), ==, 0xbc);
+	g_assert_cmpint (fu_crc8 (FU_CRC_KIND_B8_WACOM, check, sizeof(check)), ==, 0x45);
+	g_assert_cmpint (fu_crc16 (FU_CRC_KIND_B16_USB, check, sizeof(check)), ==, 0xb4c8);
+	g_assert_cmpint (fu_crc16 (FU_CRC_KIND_B16_UMTS, check, sizeof(check)), ==, 0xfee8);
+	g_assert_cmpint (fu_crc32 (FU_CRC_KIND_B32_STANDARD, check, sizeof(check)), ==, 0xcbf43926);
+	g_assert_cmpint (fu_crc32 (FU_CRC_KIND_B32_JAMCRC, check, sizeof(check)), ==, 0x340bc6d9);
+	g_assert_cmpint (fu_crc32 (FU_CRC_KIND_B32_MPEG2, check, sizeof(check)), ==, 0x0376e6e7);
+	g_assert_cmpint (fu_sum8 (check, sizeof(check)), ==, 0xdd);
+	g_assert_cmpint (fu_sum32 (check, sizeof(check)), ==, 0x1dd);
+
+	/* the accelerated paths must agree for any length and alignment */
+	for (guint i = 0; i < sizeof(buf); i++)
+		buf[i] = (guint8) ((i * 2654435761u) >> 13);
+	for (guint off = 0; off < 8; off++) {
+		for (guint len = 0; len <= 1024; len += (len < 256 ? 1 : 61)) {
+			g_assert_cmpint (fu_crc32 (FU_CRC_KIND_B32_STANDARD, buf + off, len),
+					 ==, fu_crc32_bitwise (buf + off, len));
+		}
+	}
+
+	/* chunked */
+	crc = fu_crc32_init (FU_CRC_KIND_B32_STANDARD);
+	crc = fu_crc32_step (FU_CRC_KIND_B32_STANDARD, buf, 100, crc);
+	crc = fu_crc32_step (FU_CRC_KIND_B32_STANDARD, buf + 100, sizeof(buf) - 100, crc);
+	g_assert_cmpint (fu_crc32_done (FU_CRC_KIND_B32_STANDARD, crc), ==,
+			 fu_crc32_bitwise (buf, sizeof(buf)));
+}
+
+static void
+fu_crc_performance_func (void)
+{
+	gsize bufsz = 32 * 1024 * 1024;
+	g_autofree guint8 *buf = g_malloc0 (bufsz);
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	for (guint i = FU_CRC_KIND_B32_STANDARD; i <= FU_CRC_KIND_B32_MPEG2; i++) {
+		gdouble elapsed;
+		g_timer_reset (timer);
+		fu_crc32 (i, buf, bufsz);
+		elapsed = g_timer_elapsed (timer, NULL);
+		g_test_message ("%s=%.0fMB/s", fu_crc_kind_to_string (i),
+				(bufsz / (1024.f * 1024.f)) / elapsed);
+	}
+}
+
 static GBytes *
 _build_cab (GCabCompression compression, ...)
 {
@@ -950,6 +1249,437 @@ fu_device_poll_cb (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static void
+fu_common_verbose_func (void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+	ret = fu_common_verbose_set ("FU_SELF_TEST_VERBOSE", TRUE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_true (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_OTHER_VERBOSE"));
+	ret = fu_common_verbose_set ("FU_SELF_TEST_VERBOSE", FALSE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+	g_assert_cmpint (fu_common_verbose_get_flag ("FU_SELF_TEST_VERBOSE"), ==,
+			 fu_common_verbose_get_flag ("FU_SELF_TEST_VERBOSE"));
+
+	/* use up all the flags, which must not enable any other category */
+	for (guint i = 0; i < 32; i++) {
+		g_autofree gchar *env = g_strdup_printf ("FU_SELF_TEST%u_VERBOSE", i);
+		if (!fu_common_verbose_set (env, TRUE, &error))
+			break;
+	}
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_OTHER_VERBOSE"));
+	ret = fu_common_verbose_set ("FU_SELF_TEST_VERBOSE", TRUE, NULL);
+	g_assert_true (ret);
+	g_assert_true (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+	ret = fu_common_verbose_set ("FU_SELF_TEST_VERBOSE", FALSE, NULL);
+	g_assert_true (ret);
+	g_assert_false (fu_common_is_verbose ("FU_SELF_TEST_VERBOSE"));
+}
+
+static void
+fu_io_channel_message_func (void)
+{
+	gboolean ret;
+	gint fds[2] = { -1, -1 };
+	gsize bytes_read = 0;
+	guint8 buf[4] = { 0x0 };
+	const guint8 report1[] = { 0x01, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 };
+	const guint8 report2[] = { 0x02, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27 };
+	g_autoptr(FuIOChannel) io_channel = NULL;
+	g_autoptr(GByteArray) res1 = NULL;
+	g_autoptr(GByteArray) res2 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* like hidraw, each read() returns exactly one report */
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, fds), ==, 0);
+	io_channel = fu_io_channel_unix_new (fds[0]);
+	g_assert_cmpint (write (fds[1], report1, sizeof(report1)), ==, sizeof(report1));
+	g_assert_cmpint (write (fds[1], report2, sizeof(report2)), ==, sizeof(report2));
+
+	/* a smaller maximum size does not split the report */
+	res1 = fu_io_channel_read_byte_array (io_channel, 4, 500,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (res1);
+	g_assert_cmpint (res1->len, ==, sizeof(report1));
+	g_assert_cmpint (memcmp (res1->data, report1, sizeof(report1)), ==, 0);
+
+	/* the excess is dropped rather than returned as the next report */
+	ret = fu_io_channel_read_raw (io_channel, buf, sizeof(buf), &bytes_read, 500,
+				      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (bytes_read, ==, sizeof(buf));
+	g_assert_cmpint (memcmp (buf, report2, sizeof(buf)), ==, 0);
+	g_assert_cmpint (write (fds[1], report1, sizeof(report1)), ==, sizeof(report1));
+	res2 = fu_io_channel_read_byte_array (io_channel, -1, 500,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT |
+					      FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (res2);
+	g_assert_cmpint (res2->len, ==, sizeof(report1));
+	g_assert_cmpint (res2->data[0], ==, 0x01);
+	g_close (fds[1], NULL);
+}
+
+static void
+fu_io_channel_frame_func (void)
+{
+	gboolean ret;
+	gint fds[2] = { -1, -1 };
+	gsize bufsz = 0;
+	const guint8 *buf;
+	const gchar data[] = "hello\nworld\n" "\x03\x00" "abc" "\x01\x02\x03\x04" "tail";
+	g_autoptr(FuIOChannel) io_channel = NULL;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GBytes) blob4 = NULL;
+	g_autoptr(GBytes) blob5 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	ret = g_unix_open_pipe (fds, FD_CLOEXEC, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	io_channel = fu_io_channel_unix_new (fds[0]);
+	g_assert_cmpint (write (fds[1], data, sizeof(data) - 1), ==, sizeof(data) - 1);
+
+	/* delimited */
+	blob1 = fu_io_channel_read_delimited (io_channel, '\n', 500,
+					      FU_IO_CHANNEL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob1);
+	g_assert_cmpint (g_bytes_get_size (blob1), ==, 6);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob1, NULL), "hello\n", 6), ==, 0);
+
+	/* the rest was buffered by the same read */
+	buf = fu_io_channel_peek (io_channel, &bufsz);
+	g_assert_nonnull (buf);
+	g_assert_cmpint (bufsz, ==, sizeof(data) - 1 - 6);
+	g_assert_cmpint (memcmp (buf, "world\n", 6), ==, 0);
+	fu_io_channel_consume (io_channel, 6);
+
+	/* length-prefixed */
+	blob2 = fu_io_channel_read_prefixed (io_channel, 2, 0, 2, G_LITTLE_ENDIAN,
+					     500, FU_IO_CHANNEL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob2);
+	g_assert_cmpint (g_bytes_get_size (blob2), ==, 5);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob2, NULL), "\x03\x00" "abc", 5), ==, 0);
+
+	/* fixed size */
+	blob3 = fu_io_channel_read_fixed (io_channel, 4, 500,
+					  FU_IO_CHANNEL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob3);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob3, NULL), "\x01\x02\x03\x04", 4), ==, 0);
+
+	/* legacy API returns the buffered data first */
+	blob4 = fu_io_channel_read_bytes (io_channel, -1, 500,
+					  FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob4);
+	g_assert_cmpint (g_bytes_get_size (blob4), ==, 4);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob4, NULL), "tail", 4), ==, 0);
+
+	/* nothing more to read */
+	blob5 = fu_io_channel_read_fixed (io_channel, 1, 10,
+					  FU_IO_CHANNEL_FLAG_NONE, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert_null (blob5);
+	g_close (fds[1], NULL);
+}
+
+#ifdef HAVE_GUDEV
+static gpointer
+fu_udev_device_cache_thread_cb (gpointer user_data)
+{
+	GUdevDevice *udev_device = G_UDEV_DEVICE (user_data);
+	for (guint i = 0; i < 1000; i++) {
+		g_autoptr(GUdevDevice) parent = fu_udev_device_cache_get_parent (udev_device);
+		g_assert_nonnull (parent);
+		if (i % 100 == 0)
+			fu_udev_device_cache_invalidate (g_udev_device_get_sysfs_path (parent));
+	}
+	return NULL;
+}
+
+static void
+fu_udev_device_cache_func (void)
+{
+	GList *devices;
+	GUdevDevice *udev_device = NULL;
+	GThread *threads[4] = { NULL };
+	g_autofree gchar *attr1 = NULL;
+	g_autofree gchar *attr2 = NULL;
+	g_autoptr(GUdevClient) gudev_client = g_udev_client_new (NULL);
+	g_autoptr(GUdevDevice) parent1 = NULL;
+	g_autoptr(GUdevDevice) parent2 = NULL;
+	g_autoptr(GUdevDevice) parent3 = NULL;
+	g_autoptr(GUdevDevice) parent4 = NULL;
+	g_autoptr(GUdevDevice) parent5 = NULL;
+
+	/* any device with a parent will do */
+	devices = g_udev_client_query_by_subsystem (gudev_client, NULL);
+	for (GList *l = devices; l != NULL; l = l->next) {
+		g_autoptr(GUdevDevice) parent = g_udev_device_get_parent (l->data);
+		if (parent != NULL) {
+			udev_device = g_object_ref (l->data);
+			break;
+		}
+	}
+	g_list_free_full (devices, g_object_unref);
+	if (udev_device == NULL) {
+		g_test_skip ("no udev devices with a parent");
+		return;
+	}
+
+	/* not cached outside of enumeration */
+	parent1 = fu_udev_device_cache_get_parent (udev_device);
+	parent2 = fu_udev_device_cache_get_parent (udev_device);
+	g_assert_nonnull (parent1);
+	g_assert_true (parent1 != parent2);
+
+	/* cached */
+	fu_udev_device_cache_set_enabled (TRUE);
+	parent3 = fu_udev_device_cache_get_parent (udev_device);
+	parent4 = fu_udev_device_cache_get_parent (udev_device);
+	g_assert_true (parent3 == parent4);
+	attr1 = fu_udev_device_cache_get_sysfs_attr (parent3, "uevent");
+	attr2 = fu_udev_device_cache_get_sysfs_attr (parent3, "uevent");
+	g_assert_cmpstr (attr1, ==, attr2);
+
+	/* a uevent for the device drops the cached parent */
+	fu_udev_device_cache_invalidate (g_udev_device_get_sysfs_path (udev_device));
+	parent5 = fu_udev_device_cache_get_parent (udev_device);
+	g_assert_true (parent5 != parent4);
+
+	/* lookups and invalidation from several threads at once */
+	for (guint i = 0; i < G_N_ELEMENTS (threads); i++) {
+		threads[i] = g_thread_new ("fu-udev-device-cache",
+					   fu_udev_device_cache_thread_cb,
+					   udev_device);
+	}
+	for (guint i = 0; i < G_N_ELEMENTS (threads); i++)
+		g_thread_join (threads[i]);
+
+	/* everything is dropped at the end of enumeration */
+	fu_udev_device_cache_set_enabled (FALSE);
+	g_clear_object (&parent3);
+	g_clear_object (&parent4);
+	parent3 = fu_udev_device_cache_get_parent (udev_device);
+	parent4 = fu_udev_device_cache_get_parent (udev_device);
+	g_assert_true (parent3 != parent4);
+	g_object_unref (udev_device);
+}
+#endif
+
+typedef struct {
+	GArray		*sent;		/* of guint8 */
+	GArray		*done;		/* of guint8 */
+	guint8		 fail_idx;
+	guint		 in_flight_max;
+} FuTestUsbTransferQueueHelper;
+
+static gssize
+fu_usb_transfer_queue_emulate_cb (FuUsbTransferQueue *queue,
+				  guint8 *buf,
+				  gsize bufsz,
+				  gpointer user_data,
+				  GError **error)
+{
+	FuTestUsbTransferQueueHelper *helper = (FuTestUsbTransferQueueHelper *) user_data;
+	helper->in_flight_max = MAX (helper->in_flight_max,
+				     fu_usb_transfer_queue_get_in_flight (queue));
+	g_array_append_val (helper->sent, buf[0]);
+	if (buf[0] == helper->fail_idx) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_BROKEN_PIPE,
+			     "stalled on packet %u", buf[0]);
+		return -1;
+	}
+	buf[1] = buf[0] ^ 0xff;
+	return bufsz;
+}
+
+static gboolean
+fu_usb_transfer_queue_done_cb (FuUsbTransferQueue *queue,
+			       const guint8 *buf,
+			       gsize bufsz,
+			       gsize actual_length,
+			       gpointer user_data,
+			       GError **error)
+{
+	FuTestUsbTransferQueueHelper *helper = (FuTestUsbTransferQueueHelper *) user_data;
+	g_assert_cmpint (actual_length, ==, bufsz);
+	g_assert_cmpint (buf[1], ==, buf[0] ^ 0xff);
+	g_array_append_val (helper->done, buf[0]);
+	return TRUE;
+}
+
+static void
+fu_usb_transfer_queue_func (void)
+{
+	gboolean ret;
+	guint8 buf[2] = { 0x0 };
+	g_autoptr(FuUsbDevice) device = fu_usb_device_new (NULL);
+	g_autoptr(FuUsbTransferQueue) queue = fu_usb_transfer_queue_new (device, 4);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GArray) sent = g_array_new (FALSE, FALSE, sizeof(guint8));
+	g_autoptr(GArray) done = g_array_new (FALSE, FALSE, sizeof(guint8));
+	FuTestUsbTransferQueueHelper helper = {
+		.sent = sent,
+		.done = done,
+		.fail_idx = 0xff,
+	};
+
+	/* not open */
+	ret = fu_usb_transfer_queue_add_bulk (queue, 0x01, buf, sizeof(buf),
+					      NULL, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* completed in the order they were sent, never more than 4 at once */
+	fu_usb_transfer_queue_set_emulate_func (queue, fu_usb_transfer_queue_emulate_cb, &helper);
+	for (guint8 i = 0; i < 16; i++) {
+		buf[0] = i;
+		ret = fu_usb_transfer_queue_add_bulk (queue, 0x01, buf, sizeof(buf),
+						      fu_usb_transfer_queue_done_cb,
+						      &helper, &error);
+		g_assert_no_error (error);
+		g_assert_true (ret);
+		g_assert_cmpint (fu_usb_transfer_queue_get_in_flight (queue), <=, 4);
+	}
+	ret = fu_usb_transfer_queue_drain (queue, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (fu_usb_transfer_queue_get_in_flight (queue), ==, 0);
+	g_assert_cmpint (helper.in_flight_max, ==, 4);
+	g_assert_cmpint (sent->len, ==, 16);
+	g_assert_cmpint (done->len, ==, 16);
+	for (guint8 i = 0; i < 16; i++) {
+		g_assert_cmpint (g_array_index (sent, guint8, i), ==, i);
+		g_assert_cmpint (g_array_index (done, guint8, i), ==, i);
+	}
+
+	/* the first failure stops anything else being sent */
+	g_array_set_size (sent, 0);
+	g_array_set_size (done, 0);
+	helper.fail_idx = 5;
+	for (guint8 i = 0; i < 16; i++) {
+		buf[0] = i;
+		ret = fu_usb_transfer_queue_add_bulk (queue, 0x01, buf, sizeof(buf),
+						      fu_usb_transfer_queue_done_cb,
+						      &helper, &error);
+		if (!ret) {
+			g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BROKEN_PIPE);
+			g_clear_error (&error);
+			break;
+		}
+	}
+	ret = fu_usb_transfer_queue_drain (queue, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BROKEN_PIPE);
+	g_assert_false (ret);
+	g_assert_cmpstr (error->message, ==, "failed to send: stalled on packet 5");
+	g_clear_error (&error);
+	g_assert_cmpint (sent->len, ==, 6);
+	g_assert_cmpint (g_array_index (sent, guint8, 5), ==, 5);
+	g_assert_cmpint (done->len, ==, 5);
+
+	/* cancelled before anything was sent */
+	g_array_set_size (sent, 0);
+	g_array_set_size (done, 0);
+	helper.fail_idx = 0xff;
+	for (guint8 i = 0; i < 3; i++) {
+		buf[0] = i;
+		ret = fu_usb_transfer_queue_add_bulk (queue, 0x01, buf, sizeof(buf),
+						      fu_usb_transfer_queue_done_cb,
+						      &helper, &error);
+		g_assert_no_error (error);
+		g_assert_true (ret);
+	}
+	fu_usb_transfer_queue_cancel (queue);
+	ret = fu_usb_transfer_queue_drain (queue, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_false (ret);
+	g_clear_error (&error);
+	g_assert_cmpint (sent->len, ==, 0);
+	g_assert_cmpint (done->len, ==, 0);
+
+	/* usable again after draining */
+	ret = fu_usb_transfer_queue_add_bulk (queue, 0x01, buf, sizeof(buf),
+					      fu_usb_transfer_queue_done_cb,
+					      &helper, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_usb_transfer_queue_drain (queue, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (done->len, ==, 1);
+}
+
+static void
+fu_udev_device_port_xfer_func (void)
+{
+	gboolean ret;
+	gint fd;
+	guint8 buf[0x100] = { 0x0 };
+	guint8 val1 = 0x0;
+	guint8 val2 = 0x0;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(FuUdevDevice) udev_device = g_object_new (FU_TYPE_UDEV_DEVICE, NULL);
+	g_autoptr(GError) error = NULL;
+	FuUdevDevicePortOp ops[] = {
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_WRITE, 0x10, 0xaa, 0x00, NULL, 0 },
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_WRITE, 0x11, 0x55, 0x00, NULL, 0 },
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_POLL, 0x11, 0x05, 0x0f, NULL, 10 },
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_READ, 0x10, 0x00, 0x00, &val1, 0 },
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_READ, 0x11, 0x00, 0x00, &val2, 0 },
+	};
+	FuUdevDevicePortOp ops_timeout[] = {
+		{ FU_UDEV_DEVICE_PORT_OP_KIND_POLL, 0x11, 0x80, 0x80, NULL, 10 },
+	};
+
+	/* a plain file works the same way as /dev/port */
+	tmpdir = g_dir_make_tmp ("fwupd-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (tmpdir);
+	fn = g_build_filename (tmpdir, "port", NULL);
+	ret = g_file_set_contents (fn, (const gchar *) buf, sizeof(buf), &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	fd = g_open (fn, O_RDWR, 0);
+	g_assert_cmpint (fd, >, 0);
+	fu_udev_device_set_fd (udev_device, fd);
+
+	ret = fu_udev_device_port_xfer (udev_device, ops, G_N_ELEMENTS (ops), &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (val1, ==, 0xaa);
+	g_assert_cmpint (val2, ==, 0x55);
+
+	/* bit never gets set */
+	ret = fu_udev_device_port_xfer (udev_device, ops_timeout,
+					G_N_ELEMENTS (ops_timeout), &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert_false (ret);
+
+	g_unlink (fn);
+	g_rmdir (tmpdir);
+}
+
 static void
 fu_device_poll_func (void)
 {
@@ -970,7 +1700,7 @@ fu_device_poll_func (void)
 	fu_device_set_poll_interval (device, 0);
 	fu_test_loop_run_with_timeout (100);
 	fu_test_loop_quit ();
-	g_assert_cmpint (fu_device_get_metadata_integer (device, "cnt"), ==, cnt);
+	g_assert_cmpint (fu_device_get_metadata_integer (device, "prepare-cnt"), ==, cnt);
 }
 
 static void
@@ -1080,6 +1810,84 @@ fu_chunk_func (void)
 					   "#05: page:02 addr:0004 len:02 ZZ\n");
 }
 
+static void
+fu_bytes_view_func (void)
+{
+	FuChunk *chk;
+	gboolean ret;
+	guint8 buf[4] = { 0x0 };
+	g_autofree gchar *checksum1 = NULL;
+	g_autofree gchar *checksum2 = NULL;
+	g_autofree gchar *chunks_str = NULL;
+	g_autoptr(FuBytesView) view = fu_bytes_view_new ();
+	g_autoptr(FuBytesView) view_empty = fu_bytes_view_new ();
+	g_autoptr(GBytes) blob1 = g_bytes_new_static ("12345", 5);
+	g_autoptr(GBytes) blob2 = g_bytes_new_static ("67", 2);
+	g_autoptr(GBytes) blob_flat = NULL;
+	g_autoptr(GBytes) blob_range = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	/* build and align without copying */
+	fu_bytes_view_add_bytes (view, blob1);
+	fu_bytes_view_add_bytes (view, blob2);
+	fu_bytes_view_align (view, 4, 'Z');
+	g_assert_cmpint (fu_bytes_view_get_size (view), ==, 8);
+	g_assert_cmpint (fu_bytes_view_get_segments (view), ==, 3);
+	fu_bytes_view_align (view, 4, 'Z');
+	g_assert_cmpint (fu_bytes_view_get_size (view), ==, 8);
+	fu_bytes_view_pad (view, 10, 'Z');
+	g_assert_cmpint (fu_bytes_view_get_segments (view), ==, 3);
+	g_assert_cmpint (fu_bytes_view_get_size (view), ==, 10);
+
+	/* read across a boundary */
+	ret = fu_bytes_view_read (view, 3, buf, sizeof(buf), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (memcmp (buf, "4567", 4), ==, 0);
+	ret = fu_bytes_view_read (view, 8, buf, sizeof(buf), &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* sub-ranges of one blob are zero-copy */
+	blob_range = fu_bytes_view_get_range (view, 1, 3, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob_range);
+	g_assert (g_bytes_get_data (blob_range, NULL) ==
+		  (const guint8 *) g_bytes_get_data (blob1, NULL) + 1);
+
+	/* chunk */
+	chunks = fu_chunk_array_new_from_bytes_view (view, 0x0, 0x0, 3, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (chunks);
+	chunks_str = fu_chunk_array_to_string (chunks);
+	g_assert_cmpstr (chunks_str, ==, "#00: page:00 addr:0000 len:03 123\n"
+					 "#01: page:00 addr:0003 len:03 456\n"
+					 "#02: page:00 addr:0006 len:03 7ZZ\n"
+					 "#03: page:00 addr:0009 len:01 Z\n");
+	chk = g_ptr_array_index (chunks, 0);
+	g_assert (chk->data == g_bytes_get_data (blob1, NULL));
+
+	/* checksums match the flattened data */
+	blob_flat = fu_bytes_view_flatten (view);
+	g_assert_cmpint (g_bytes_get_size (blob_flat), ==, 10);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob_flat, NULL), "1234567ZZZ", 10), ==, 0);
+	checksum1 = fu_bytes_view_compute_checksum (view, G_CHECKSUM_SHA1);
+	checksum2 = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob_flat);
+	g_assert_cmpstr (checksum1, ==, checksum2);
+	g_assert_cmpint (fu_bytes_view_crc32 (view, FU_CRC_KIND_B32_STANDARD), ==,
+			 fu_crc32 (FU_CRC_KIND_B32_STANDARD,
+				   g_bytes_get_data (blob_flat, NULL),
+				   g_bytes_get_size (blob_flat)));
+	g_assert (!fu_bytes_view_is_empty (view));
+
+	/* fill only */
+	fu_bytes_view_add_fill (view_empty, 0xff, 0x10000);
+	g_assert (fu_bytes_view_is_empty (view_empty));
+	g_assert_cmpint (fu_bytes_view_get_segments (view_empty), ==, 1);
+}
+
 static void
 fu_common_strstrip_func (void)
 {
@@ -1566,6 +2374,81 @@ fu_firmware_func (void)
 				  "  Address:               0x400\n");
 }
 
+static FuFirmwareImage *
+fu_firmware_parse_images_cb (FuFirmware *firmware,
+			     GBytes *fw,
+			     guint idx,
+			     gpointer user_data,
+			     FwupdInstallFlags flags,
+			     GError **error)
+{
+	guint *fail_mask = (guint *) user_data;
+	FuFirmwareImage *img;
+	g_autofree gchar *id = NULL;
+
+	if (*fail_mask & (1u << idx)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "image %u is corrupt", idx);
+		return NULL;
+	}
+	img = fu_firmware_image_new (fw);
+	id = g_strdup_printf ("image%u", idx);
+	fu_firmware_image_set_id (img, id);
+	fu_firmware_image_set_idx (img, idx);
+	return img;
+}
+
+static void
+fu_firmware_parse_images_func (void)
+{
+	gboolean ret;
+	guint fail_mask = 0;
+	g_autoptr(GPtrArray) blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	g_autoptr(GPtrArray) images = NULL;
+	g_autoptr(FuFirmware) firmware = fu_firmware_new ();
+	g_autoptr(FuFirmware) firmware_bad = fu_firmware_new ();
+	g_autoptr(GError) error = NULL;
+
+	/* large enough to use the thread pool */
+	for (guint i = 0; i < 16; i++) {
+		guint8 *buf = g_malloc (0x4000);
+		memset (buf, i, 0x4000);
+		g_ptr_array_add (blobs, g_bytes_new_take (buf, 0x4000));
+	}
+	ret = fu_firmware_parse_images (firmware, blobs,
+					fu_firmware_parse_images_cb,
+					&fail_mask, FWUPD_INSTALL_FLAG_NONE,
+					&error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* order is the same as the input */
+	images = fu_firmware_get_images (firmware);
+	g_assert_cmpint (images->len, ==, 16);
+	for (guint i = 0; i < images->len; i++) {
+		FuFirmwareImage *img = g_ptr_array_index (images, i);
+		g_autoptr(GBytes) blob = fu_firmware_image_write (img, NULL);
+		g_assert_cmpint (fu_firmware_image_get_idx (img), ==, i);
+		g_assert_nonnull (blob);
+		g_assert_cmpint (((const guint8 *) g_bytes_get_data (blob, NULL))[0], ==, i);
+	}
+
+	/* the earliest failure is reported, and nothing is added */
+	fail_mask = (1u << 3) | (1u << 11);
+	ret = fu_firmware_parse_images (firmware_bad, blobs,
+					fu_firmware_parse_images_cb,
+					&fail_mask, FWUPD_INSTALL_FLAG_NONE,
+					&error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_cmpstr (error->message, ==, "image 3 is corrupt");
+	g_assert_false (ret);
+	g_ptr_array_unref (images);
+	images = fu_firmware_get_images (firmware_bad);
+	g_assert_cmpint (images->len, ==, 0);
+}
+
 static void
 fu_efivar_func (void)
 {
@@ -1714,6 +2597,162 @@ fu_device_retry_hardware_func (void)
 	g_assert_cmpint (helper.cnt_failed, ==, 2);
 }
 
+static gboolean
+fu_device_wait_for_3rd_try (FuDevice *device, gpointer user_data, GError **error)
+{
+	FuDeviceRetryHelper *helper = (FuDeviceRetryHelper *) user_data;
+	if (helper->cnt_failed == 2) {
+		helper->cnt_success++;
+		return TRUE;
+	}
+	helper->cnt_failed++;
+	g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_BUSY, "busy");
+	return FALSE;
+}
+
+static gboolean
+fu_device_wait_for_busy (FuDevice *device, gpointer user_data, GError **error)
+{
+	FuDeviceRetryHelper *helper = (FuDeviceRetryHelper *) user_data;
+	helper->cnt_failed++;
+	g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_BUSY, "busy");
+	return FALSE;
+}
+
+static void
+fu_device_wait_for_func (void)
+{
+	gboolean ret;
+	gint64 start;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GError) error = NULL;
+	FuDeviceRetryHelper helper = {
+		.cnt_success = 0,
+		.cnt_failed = 0,
+	};
+
+	/* ready early, so do not wait for the whole timeout */
+	start = g_get_monotonic_time ();
+	ret = fu_device_wait_for (device, fu_device_wait_for_3rd_try, 5000, &helper, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (helper.cnt_success, ==, 1);
+	g_assert_cmpint (helper.cnt_failed, ==, 2);
+	g_assert_cmpint (g_get_monotonic_time () - start, <, 1000 * 1000);
+
+	/* never ready */
+	helper.cnt_failed = 0;
+	start = g_get_monotonic_time ();
+	ret = fu_device_wait_for (device, fu_device_wait_for_busy, 50, &helper, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_BUSY);
+	g_assert_false (ret);
+	g_assert_cmpint (helper.cnt_failed, >, 1);
+	g_assert_cmpint (g_get_monotonic_time () - start, >=, 50 * 1000);
+	g_clear_error (&error);
+
+	/* any other error is fatal straight away */
+	helper.cnt_failed = 0;
+	ret = fu_device_wait_for (device, fu_device_retry_failed, 5000, &helper, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+	g_assert_cmpint (helper.cnt_failed, ==, 1);
+}
+
+static void
+fu_device_firmware_cache_func (void)
+{
+	g_autoptr(FuDevice) device1 = g_object_new (FU_TYPE_TEST_DEVICE, NULL);
+	g_autoptr(FuDevice) device2 = g_object_new (FU_TYPE_TEST_DEVICE, NULL);
+	g_autoptr(FuDevice) device3 = fu_device_new ();
+	g_autoptr(FuDevice) device4 = fu_device_new ();
+	g_autoptr(FuFirmware) firmware1 = NULL;
+	g_autoptr(FuFirmware) firmware2 = NULL;
+	g_autoptr(FuFirmware) firmware3 = NULL;
+	g_autoptr(FuFirmware) firmware4 = NULL;
+	g_autoptr(FuFirmware) firmware5 = NULL;
+	g_autoptr(FuFirmware) firmware6 = NULL;
+	g_autoptr(GBytes) fw = g_bytes_new_static ("hello", 5);
+	g_autoptr(GError) error = NULL;
+
+	/* two identical devices */
+	fu_device_set_protocol (device1, "com.acme");
+	fu_device_add_guid (device1, "12345678-1234-1234-1234-123456789012");
+	fu_device_set_protocol (device2, "com.acme");
+	fu_device_add_guid (device2, "12345678-1234-1234-1234-123456789012");
+	fu_device_set_firmware_cache_enabled (TRUE);
+
+	/* not opted in, so each device checks the payload */
+	firmware1 = fu_device_prepare_firmware (device1, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware1);
+	firmware2 = fu_device_prepare_firmware (device2, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware2);
+	g_assert_cmpint (fu_device_get_metadata_integer (device1, "prepare-cnt"), ==, 1);
+	g_assert_cmpint (fu_device_get_metadata_integer (device2, "prepare-cnt"), ==, 1);
+	g_assert_true (firmware1 != firmware2);
+
+	/* opted in, so the second device reuses the firmware */
+	fu_device_set_firmware_cacheable (device1, TRUE);
+	fu_device_set_firmware_cacheable (device2, TRUE);
+	firmware3 = fu_device_prepare_firmware (device1, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware3);
+	firmware4 = fu_device_prepare_firmware (device2, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware4);
+	g_assert_cmpint (fu_device_get_metadata_integer (device1, "prepare-cnt"), ==, 2);
+	g_assert_cmpint (fu_device_get_metadata_integer (device2, "prepare-cnt"), ==, 1);
+	g_assert_true (firmware3 == firmware4);
+
+	/* no vfunc, so the default firmware is shared */
+	fu_device_set_protocol (device3, "com.acme");
+	fu_device_add_guid (device3, "12345678-1234-1234-1234-123456789012");
+	fu_device_set_firmware_cacheable (device3, TRUE);
+	fu_device_set_protocol (device4, "com.acme");
+	fu_device_add_guid (device4, "12345678-1234-1234-1234-123456789012");
+	fu_device_set_firmware_cacheable (device4, TRUE);
+	firmware5 = fu_device_prepare_firmware (device3, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware5);
+	firmware6 = fu_device_prepare_firmware (device4, fw, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware6);
+	g_assert_true (firmware5 == firmware6);
+	g_assert_true (firmware5 != firmware3);
+
+	fu_device_set_firmware_cache_enabled (FALSE);
+}
+
+static void
+fu_device_poll_wheel_func (void)
+{
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+
+	/* both share the same wheel */
+	fu_device_set_poll_interval (device1, 1000);
+	fu_device_set_poll_interval (device2, 1000);
+	g_assert_cmpint (fu_poll_scheduler_get_size (), ==, 2);
+
+	/* busy devices are not polled */
+	fu_device_set_status (device2, FWUPD_STATUS_DEVICE_WRITE);
+	fu_test_loop_run_with_timeout (2500);
+	fu_test_loop_quit ();
+	g_assert_cmpint (fu_device_get_poll_count (device1), >=, 1);
+	g_assert_cmpint (fu_device_get_poll_skipped (device1), ==, 0);
+	g_assert_cmpint (fu_device_get_poll_count (device2), ==, 0);
+	g_assert_cmpint (fu_device_get_poll_skipped (device2), >=, 1);
+	g_assert_cmpint (fu_device_get_poll_duration_max (device1), <=,
+			 fu_device_get_poll_duration_total (device1));
+
+	/* disabling and destroying both remove from the wheel */
+	fu_device_set_poll_interval (device1, 0);
+	g_assert_cmpint (fu_poll_scheduler_get_size (), ==, 1);
+	g_clear_object (&device2);
+	g_assert_cmpint (fu_poll_scheduler_get_size (), ==, 0);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1733,13 +2772,19 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/plugin{quirks}", fu_plugin_quirks_func);
 	g_test_add_func ("/fwupd/plugin{quirks-performance}", fu_plugin_quirks_performance_func);
 	g_test_add_func ("/fwupd/plugin{quirks-device}", fu_plugin_quirks_device_func);
+	g_test_add_func ("/fwupd/plugin{quirks-groups}", fu_plugin_quirks_groups_func);
 	g_test_add_func ("/fwupd/chunk", fu_chunk_func);
+	g_test_add_func ("/fwupd/bytes-view", fu_bytes_view_func);
 	g_test_add_func ("/fwupd/common{string-append-kv}", fu_common_string_append_kv_func);
 	g_test_add_func ("/fwupd/common{version-guess-format}", fu_common_version_guess_format_func);
 	g_test_add_func ("/fwupd/common{version}", fu_common_version_func);
 	g_test_add_func ("/fwupd/common{vercmp}", fu_common_vercmp_func);
 	g_test_add_func ("/fwupd/common{strstrip}", fu_common_strstrip_func);
 	g_test_add_func ("/fwupd/common{endian}", fu_common_endian_func);
+	g_test_add_func ("/fwupd/common{get-contents-mapped}", fu_common_get_contents_bytes_mapped_func);
+	g_test_add_func ("/fwupd/common{crc}", fu_crc_func);
+	if (g_test_perf ())
+		g_test_add_func ("/fwupd/common{crc-performance}", fu_crc_performance_func);
 	g_test_add_func ("/fwupd/common{cab-success}", fu_common_store_cab_func);
 	g_test_add_func ("/fwupd/common{cab-success-unsigned}", fu_common_store_cab_unsigned_func);
 	g_test_add_func ("/fwupd/common{cab-success-folder}", fu_common_store_cab_folder_func);
@@ -1757,6 +2802,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/smbios", fu_smbios_func);
 	g_test_add_func ("/fwupd/smbios3", fu_smbios3_func);
 	g_test_add_func ("/fwupd/firmware", fu_firmware_func);
+	g_test_add_func ("/fwupd/firmware{parse-images}", fu_firmware_parse_images_func);
 	g_test_add_func ("/fwupd/firmware{ihex}", fu_firmware_ihex_func);
 	g_test_add_func ("/fwupd/firmware{ihex-offset}", fu_firmware_ihex_offset_func);
 	g_test_add_func ("/fwupd/firmware{ihex-signed}", fu_firmware_ihex_signed_func);
@@ -1767,15 +2813,28 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/archive{cab}", fu_archive_cab_func);
 	g_test_add_func ("/fwupd/device{parent}", fu_device_parent_func);
 	g_test_add_func ("/fwupd/device{incorporate}", fu_device_incorporate_func);
-	if (g_test_slow ())
+	if (g_test_slow ()) {
 		g_test_add_func ("/fwupd/device{poll}", fu_device_poll_func);
+		g_test_add_func ("/fwupd/device{poll-wheel}", fu_device_poll_wheel_func);
+	}
+	g_test_add_func ("/fwupd/udev-device{port-xfer}", fu_udev_device_port_xfer_func);
+	g_test_add_func ("/fwupd/usb-transfer-queue", fu_usb_transfer_queue_func);
+#ifdef HAVE_GUDEV
+	g_test_add_func ("/fwupd/udev-device{cache}", fu_udev_device_cache_func);
+#endif
+	g_test_add_func ("/fwupd/io-channel{frame}", fu_io_channel_frame_func);
+	g_test_add_func ("/fwupd/io-channel{message}", fu_io_channel_message_func);
+	g_test_add_func ("/fwupd/common{verbose}", fu_common_verbose_func);
 	g_test_add_func ("/fwupd/device-locker{success}", fu_device_locker_func);
 	g_test_add_func ("/fwupd/device-locker{fail}", fu_device_locker_fail_func);
 	g_test_add_func ("/fwupd/device{metadata}", fu_device_metadata_func);
 	g_test_add_func ("/fwupd/device{open-refcount}", fu_device_open_refcount_func);
+	g_test_add_func ("/fwupd/device{close-delay}", fu_device_close_delay_func);
 	g_test_add_func ("/fwupd/device{version-format}", fu_device_version_format_func);
 	g_test_add_func ("/fwupd/device{retry-success}", fu_device_retry_success_func);
 	g_test_add_func ("/fwupd/device{retry-failed}", fu_device_retry_failed_func);
 	g_test_add_func ("/fwupd/device{retry-hardware}", fu_device_retry_hardware_func);
+	g_test_add_func ("/fwupd/device{wait-for}", fu_device_wait_for_func);
+	g_test_add_func ("/fwupd/device{firmware-cache}", fu_device_firmware_cache_func);
 	return g_test_run ();
 }
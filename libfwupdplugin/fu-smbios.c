@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "fu-common.h"
+#include "fu-crc.h"
 #include "fu-smbios-private.h"
 #include "fwupd-error.h"
 
@@ -144,7 +145,6 @@ static gboolean
 fu_smbios_parse_ep32 (FuSmbios *self, const gchar *buf, gsize sz, GError **error)
 {
 	FuSmbiosStructureEntryPoint32 *ep;
-	guint8 csum = 0;
 
 	/* verify size */
 	if (sz != sizeof(FuSmbiosStructureEntryPoint32)) {
@@ -158,9 +158,7 @@ fu_smbios_parse_ep32 (FuSmbios *self, const gchar *buf, gsize sz, GError **error
 	}
 
 	/* verify checksum */
-	for (guint i = 0; i < sz; i++)
-		csum += buf[i];
-	if (csum != 0x00) {
+	if (fu_sum8 ((const guint8 *) buf, sz) != 0x00) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
@@ -178,9 +176,7 @@ fu_smbios_parse_ep32 (FuSmbios *self, const gchar *buf, gsize sz, GError **error
 			     "intermediate anchor signature invalid, got %s", tmp);
 		return FALSE;
 	}
-	for (guint i = 10; i < sz; i++)
-		csum += buf[i];
-	if (csum != 0x00) {
+	if (fu_sum8 ((const guint8 *) buf + 10, sz - 10) != 0x00) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
@@ -198,7 +194,6 @@ static gboolean
 fu_smbios_parse_ep64 (FuSmbios *self, const gchar *buf, gsize sz, GError **error)
 {
 	FuSmbiosStructureEntryPoint64 *ep;
-	guint8 csum = 0;
 
 	/* verify size */
 	if (sz != sizeof(FuSmbiosStructureEntryPoint64)) {
@@ -212,9 +207,7 @@ fu_smbios_parse_ep64 (FuSmbios *self, const gchar *buf, gsize sz, GError **error
 	}
 
 	/* verify checksum */
-	for (guint i = 0; i < sz; i++)
-		csum += buf[i];
-	if (csum != 0x00) {
+	if (fu_sum8 ((const guint8 *) buf, sz) != 0x00) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
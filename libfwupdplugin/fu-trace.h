@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+/*
+ * Static tracepoints that can be used by systemtap, perf or bpftrace when
+ * sys/sdt.h is available at build time, and which compile to a single nop
+ * otherwise.
+ *
+ * Arguments are not evaluated when probes are not compiled in, so they must
+ * not have side effects. See contrib/fwupd.bt for an example consumer.
+ */
+
+#ifdef HAVE_SDT_H
+#include <sys/sdt.h>
+#define FU_TRACE(name)					DTRACE_PROBE(fwupd, name)
+#define FU_TRACE1(name, a1)				DTRACE_PROBE1(fwupd, name, a1)
+#define FU_TRACE2(name, a1, a2)				DTRACE_PROBE2(fwupd, name, a1, a2)
+#define FU_TRACE3(name, a1, a2, a3)			DTRACE_PROBE3(fwupd, name, a1, a2, a3)
+#define FU_TRACE4(name, a1, a2, a3, a4)			DTRACE_PROBE4(fwupd, name, a1, a2, a3, a4)
+#else
+#define FU_TRACE(name)					do {} while (0)
+#define FU_TRACE1(name, a1)				do {} while (0)
+#define FU_TRACE2(name, a1, a2)				do {} while (0)
+#define FU_TRACE3(name, a1, a2, a3)			do {} while (0)
+#define FU_TRACE4(name, a1, a2, a3, a4)			do {} while (0)
+#endif
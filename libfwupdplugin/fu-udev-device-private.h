@@ -9,3 +9,10 @@
 #include "fu-udev-device.h"
 
 void		 fu_udev_device_emit_changed		(FuUdevDevice	*self);
+gchar		*fu_udev_device_cache_get_sysfs_attr	(GUdevDevice	*udev_device,
+							 const gchar	*attr);
+GUdevDevice	*fu_udev_device_cache_get_parent	(GUdevDevice	*udev_device);
+GUdevDevice	*fu_udev_device_cache_get_parent_with_subsystem	(GUdevDevice	*udev_device,
+								 const gchar	*subsystem);
+void		 fu_udev_device_cache_set_enabled	(gboolean	 enabled);
+void		 fu_udev_device_cache_invalidate	(const gchar	*sysfs_path);
@@ -16,6 +16,9 @@
 #ifdef HAVE_IOCTL_H
 #include <sys/ioctl.h>
 #endif
+#ifdef HAVE_IOPERM
+#include <sys/io.h>
+#endif
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -44,6 +47,9 @@ typedef struct
 	gchar			*device_file;
 	gint			 fd;
 	FuUdevDeviceFlags	 flags;
+	guint8			*ioperm_ports;	/* bitmap, or NULL */
+	GThread			*ioperm_thread;
+	gboolean		 ioperm_failed;
 } FuUdevDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuUdevDevice, fu_udev_device, FU_TYPE_DEVICE)
@@ -81,11 +87,207 @@ fu_udev_device_emit_changed (FuUdevDevice *self)
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 }
 
+#ifdef HAVE_GUDEV
+/* shared between all instances so that parent nodes common to many devices,
+ * e.g. the PCI bridge above each NVMe namespace, are only looked up once;
+ * only used while enumerating as a re-plugged device can reuse the same path */
+typedef struct {
+	GUdevDevice	*parent;	/* nullable */
+	gboolean	 parent_valid;
+	GHashTable	*attrs;		/* attr : value, or NULL if unset */
+} FuUdevDeviceCacheItem;
+
+static GHashTable *fu_udev_device_cache = NULL;	/* sysfs-path : FuUdevDeviceCacheItem */
+static GMutex fu_udev_device_cache_mutex;
+
+static void
+fu_udev_device_cache_item_free (FuUdevDeviceCacheItem *item)
+{
+	if (item->parent != NULL)
+		g_object_unref (item->parent);
+	g_hash_table_unref (item->attrs);
+	g_free (item);
+}
+
+/* must be called with fu_udev_device_cache_mutex held */
+static FuUdevDeviceCacheItem *
+fu_udev_device_cache_get_item (GUdevDevice *udev_device)
+{
+	const gchar *sysfs_path = g_udev_device_get_sysfs_path (udev_device);
+	FuUdevDeviceCacheItem *item;
+
+	item = g_hash_table_lookup (fu_udev_device_cache, sysfs_path);
+	if (item == NULL) {
+		item = g_new0 (FuUdevDeviceCacheItem, 1);
+		item->attrs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		g_hash_table_insert (fu_udev_device_cache, g_strdup (sysfs_path), item);
+	}
+	return item;
+}
+#endif
+
+/**
+ * fu_udev_device_cache_set_enabled:
+ * @enabled: %TRUE to cache sysfs data
+ *
+ * Enables the shared cache used by fu_udev_device_cache_get_sysfs_attr() and
+ * fu_udev_device_cache_get_parent(), typically for the duration of one
+ * enumeration pass. Disabling the cache drops all the cached data.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_udev_device_cache_set_enabled (gboolean enabled)
+{
+#ifdef HAVE_GUDEV
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_udev_device_cache_mutex);
+	if (enabled && fu_udev_device_cache == NULL) {
+		fu_udev_device_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+							      (GDestroyNotify) fu_udev_device_cache_item_free);
+	} else if (!enabled && fu_udev_device_cache != NULL) {
+		g_hash_table_unref (fu_udev_device_cache);
+		fu_udev_device_cache = NULL;
+	}
+#endif
+}
+
+/**
+ * fu_udev_device_cache_get_sysfs_attr:
+ * @udev_device: A #GUdevDevice
+ * @attr: A sysfs attribute name, e.g. `vendor`
+ *
+ * Gets a sysfs attribute, only reading it from the kernel the first time it is
+ * requested for that sysfs path when the cache is enabled.
+ *
+ * Returns: (transfer full): a string, or %NULL if unset
+ *
+ * Since: 1.4.0
+ **/
+gchar *
+fu_udev_device_cache_get_sysfs_attr (GUdevDevice *udev_device, const gchar *attr)
+{
+#ifdef HAVE_GUDEV
+	FuUdevDeviceCacheItem *item;
+	gpointer value = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_udev_device_cache_mutex);
+
+	if (fu_udev_device_cache == NULL)
+		return g_strdup (g_udev_device_get_sysfs_attr (udev_device, attr));
+	item = fu_udev_device_cache_get_item (udev_device);
+	if (!g_hash_table_lookup_extended (item->attrs, attr, NULL, &value)) {
+		value = g_strdup (g_udev_device_get_sysfs_attr (udev_device, attr));
+		g_hash_table_insert (item->attrs, g_strdup (attr), value);
+	}
+
+	/* another thread may invalidate the entry as soon as we unlock */
+	return g_strdup (value);
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * fu_udev_device_cache_get_parent:
+ * @udev_device: A #GUdevDevice
+ *
+ * Gets the parent device, reusing the same #GUdevDevice for all children so
+ * that its own properties and attributes are only read once when the cache is
+ * enabled.
+ *
+ * Returns: (transfer full): a #GUdevDevice, or %NULL for the root
+ *
+ * Since: 1.4.0
+ **/
+GUdevDevice *
+fu_udev_device_cache_get_parent (GUdevDevice *udev_device)
+{
+#ifdef HAVE_GUDEV
+	FuUdevDeviceCacheItem *item;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_udev_device_cache_mutex);
+
+	if (fu_udev_device_cache == NULL)
+		return g_udev_device_get_parent (udev_device);
+	item = fu_udev_device_cache_get_item (udev_device);
+	if (!item->parent_valid) {
+		item->parent = g_udev_device_get_parent (udev_device);
+		item->parent_valid = TRUE;
+	}
+	return item->parent != NULL ? g_object_ref (item->parent) : NULL;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * fu_udev_device_cache_get_parent_with_subsystem:
+ * @udev_device: A #GUdevDevice
+ * @subsystem: A subsystem, e.g. `pci`
+ *
+ * Walks up the device tree using fu_udev_device_cache_get_parent() to find the
+ * first parent with a specific subsystem.
+ *
+ * Returns: (transfer full): a #GUdevDevice, or %NULL if not found
+ *
+ * Since: 1.4.0
+ **/
+GUdevDevice *
+fu_udev_device_cache_get_parent_with_subsystem (GUdevDevice *udev_device,
+						const gchar *subsystem)
+{
+#ifdef HAVE_GUDEV
+	g_autoptr(GUdevDevice) device_tmp = fu_udev_device_cache_get_parent (udev_device);
+	while (device_tmp != NULL) {
+		g_autoptr(GUdevDevice) parent = NULL;
+		if (g_strcmp0 (g_udev_device_get_subsystem (device_tmp), subsystem) == 0)
+			return g_steal_pointer (&device_tmp);
+		parent = fu_udev_device_cache_get_parent (device_tmp);
+		g_set_object (&device_tmp, parent);
+	}
+#endif
+	return NULL;
+}
+
+/**
+ * fu_udev_device_cache_invalidate:
+ * @sysfs_path: (nullable): A sysfs path, or %NULL for all devices
+ *
+ * Invalidates the cached data for a device and all of its children, typically
+ * in response to a uevent.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_udev_device_cache_invalidate (const gchar *sysfs_path)
+{
+#ifdef HAVE_GUDEV
+	GHashTableIter iter;
+	gpointer key;
+	gsize sysfs_pathsz;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_udev_device_cache_mutex);
+
+	if (fu_udev_device_cache == NULL)
+		return;
+	if (sysfs_path == NULL) {
+		g_hash_table_remove_all (fu_udev_device_cache);
+		return;
+	}
+	sysfs_pathsz = strlen (sysfs_path);
+	g_hash_table_iter_init (&iter, fu_udev_device_cache);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		const gchar *tmp = (const gchar *) key;
+		if (strncmp (tmp, sysfs_path, sysfs_pathsz) == 0 &&
+		    (tmp[sysfs_pathsz] == '\0' || tmp[sysfs_pathsz] == '/'))
+			g_hash_table_iter_remove (&iter);
+	}
+#endif
+}
+
 static guint32
 fu_udev_device_get_sysfs_attr_as_uint32 (GUdevDevice *udev_device, const gchar *name)
 {
 #ifdef HAVE_GUDEV
-	guint64 tmp = fu_common_strtoull (g_udev_device_get_sysfs_attr (udev_device, name));
+	g_autofree gchar *str = fu_udev_device_cache_get_sysfs_attr (udev_device, name);
+	guint64 tmp = fu_common_strtoull (str);
 	if (tmp > G_MAXUINT32) {
 		g_warning ("reading %s for %s overflowed",
 			   name,
@@ -102,7 +304,8 @@ static guint8
 fu_udev_device_get_sysfs_attr_as_uint8 (GUdevDevice *udev_device, const gchar *name)
 {
 #ifdef HAVE_GUDEV
-	guint64 tmp = fu_common_strtoull (g_udev_device_get_sysfs_attr (udev_device, name));
+	g_autofree gchar *str = fu_udev_device_cache_get_sysfs_attr (udev_device, name);
+	guint64 tmp = fu_common_strtoull (str);
 	if (tmp > G_MAXUINT8) {
 		g_warning ("reading %s for %s overflowed",
 			   name,
@@ -180,7 +383,7 @@ fu_udev_device_probe (FuDevice *device, GError **error)
 
 #ifdef HAVE_GUDEV
 	/* fallback to the parent */
-	udev_parent = g_udev_device_get_parent (priv->udev_device);
+	udev_parent = fu_udev_device_cache_get_parent (priv->udev_device);
 	if (udev_parent != NULL &&
 	    priv->flags & FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT &&
 	    priv->vendor == 0x0 && priv->model == 0x0 && priv->revision == 0x0) {
@@ -235,7 +438,7 @@ fu_udev_device_probe (FuDevice *device, GError **error)
 				fu_device_set_vendor (device, id_vendor);
 				break;
 			}
-			parent = g_udev_device_get_parent (device_tmp);
+			parent = fu_udev_device_cache_get_parent (device_tmp);
 			if (parent == NULL)
 				break;
 			g_set_object (&device_tmp, parent);
@@ -329,8 +532,8 @@ fu_udev_device_probe (FuDevice *device, GError **error)
 	}
 
 	/* determine if we're wired internally */
-	parent_i2c = g_udev_device_get_parent_with_subsystem (priv->udev_device,
-							      "i2c", NULL);
+	parent_i2c = fu_udev_device_cache_get_parent_with_subsystem (priv->udev_device,
+								     "i2c");
 	if (parent_i2c != NULL)
 		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_INTERNAL);
 #endif
@@ -350,12 +553,16 @@ fu_udev_device_set_dev (FuUdevDevice *self, GUdevDevice *udev_device)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 #ifdef HAVE_GUDEV
-	const gchar *summary;
+	g_autofree gchar *summary = NULL;
 	g_autoptr(GUdevDevice) parent = NULL;
 #endif
 
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
 
+	/* do not reuse a handle for the old device */
+	if (priv->udev_device != udev_device)
+		fu_device_flush_close (FU_DEVICE (self));
+
 	/* set new device */
 	g_set_object (&priv->udev_device, udev_device);
 	if (priv->udev_device == NULL)
@@ -365,11 +572,11 @@ fu_udev_device_set_dev (FuUdevDevice *self, GUdevDevice *udev_device)
 	priv->device_file = g_strdup (g_udev_device_get_device_file (priv->udev_device));
 
 	/* try to get one line summary */
-	summary = g_udev_device_get_sysfs_attr (priv->udev_device, "description");
+	summary = fu_udev_device_cache_get_sysfs_attr (priv->udev_device, "description");
 	if (summary == NULL) {
-		parent = g_udev_device_get_parent (priv->udev_device);
+		parent = fu_udev_device_cache_get_parent (priv->udev_device);
 		if (parent != NULL)
-			summary = g_udev_device_get_sysfs_attr (parent, "description");
+			summary = fu_udev_device_cache_get_sysfs_attr (parent, "description");
 	}
 	if (summary != NULL)
 		fu_device_set_summary (FU_DEVICE (self), summary);
@@ -394,11 +601,11 @@ fu_udev_device_get_slot_depth (FuUdevDevice *self, const gchar *subsystem)
 	GUdevDevice *udev_device = fu_udev_device_get_dev (FU_UDEV_DEVICE (self));
 	g_autoptr(GUdevDevice) device_tmp = NULL;
 
-	device_tmp = g_udev_device_get_parent_with_subsystem (udev_device, subsystem, NULL);
+	device_tmp = fu_udev_device_cache_get_parent_with_subsystem (udev_device, subsystem);
 	if (device_tmp == NULL)
 		return 0;
 	for (guint i = 0; i < 0xff; i++) {
-		g_autoptr(GUdevDevice) parent = g_udev_device_get_parent (device_tmp);
+		g_autoptr(GUdevDevice) parent = fu_udev_device_cache_get_parent (device_tmp);
 		if (parent == NULL)
 			return i;
 		g_set_object (&device_tmp, parent);
@@ -566,7 +773,7 @@ fu_udev_device_get_parent_subsystems (FuUdevDevice *self)
 	if (priv->subsystem != NULL)
 		g_string_append_printf (str, "%s,", priv->subsystem);
 	while (TRUE) {
-		g_autoptr(GUdevDevice) parent = g_udev_device_get_parent (udev_device);
+		g_autoptr(GUdevDevice) parent = fu_udev_device_cache_get_parent (udev_device);
 		if (parent == NULL)
 			break;
 		if (g_udev_device_get_subsystem (parent) != NULL) {
@@ -621,8 +828,8 @@ fu_udev_device_set_physical_id (FuUdevDevice *self, const gchar *subsystems, GEr
 			udev_device = g_object_ref (priv->udev_device);
 			break;
 		}
-		udev_device = g_udev_device_get_parent_with_subsystem (priv->udev_device,
-								       subsystem, NULL);
+		udev_device = fu_udev_device_cache_get_parent_with_subsystem (priv->udev_device,
+									      subsystem);
 		if (udev_device != NULL)
 			break;
 	}
@@ -779,6 +986,25 @@ fu_udev_device_set_flags (FuUdevDevice *self, FuUdevDeviceFlags flags)
 	priv->flags = flags;
 }
 
+/* ioperm() permissions belong to the thread that asked for them */
+static void
+fu_udev_device_ioperm_reset (FuUdevDevice *self)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->ioperm_ports == NULL)
+		return;
+#ifdef HAVE_IOPERM
+	if (priv->ioperm_thread == g_thread_self ()) {
+		for (guint port = 0; port <= G_MAXUINT16; port++) {
+			if (priv->ioperm_ports[port / 8] & (1u << (port % 8)))
+				ioperm (port, 1, 0);
+		}
+	}
+#endif
+	g_clear_pointer (&priv->ioperm_ports, g_free);
+	priv->ioperm_thread = NULL;
+}
+
 static gboolean
 fu_udev_device_open (FuDevice *device, GError **error)
 {
@@ -832,6 +1058,9 @@ fu_udev_device_close (FuDevice *device, GError **error)
 			return FALSE;
 	}
 
+	/* drop any direct port access */
+	fu_udev_device_ioperm_reset (self);
+
 	/* close device */
 	if (priv->fd > 0) {
 		if (!g_close (priv->fd, error))
@@ -986,6 +1215,229 @@ fu_udev_device_pread (FuUdevDevice *self, goffset port, guint8 *data, GError **e
 #endif
 }
 
+/* the largest run of consecutive ports done in one pread() or pwrite() */
+#define FU_UDEV_DEVICE_PORT_XFER_MAX	64
+
+/* get direct access to every port used by @ops */
+static gboolean
+fu_udev_device_port_xfer_ioperm (FuUdevDevice *self,
+				 const FuUdevDevicePortOp *ops,
+				 gsize n_ops)
+{
+#ifdef HAVE_IOPERM
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+
+	if ((priv->flags & FU_UDEV_DEVICE_FLAG_IOPERM) == 0)
+		return FALSE;
+	if (priv->ioperm_failed)
+		return FALSE;
+	if (priv->ioperm_thread != g_thread_self ())
+		fu_udev_device_ioperm_reset (self);
+	if (priv->ioperm_ports == NULL) {
+		priv->ioperm_ports = g_malloc0 ((G_MAXUINT16 + 1) / 8);
+		priv->ioperm_thread = g_thread_self ();
+	}
+	for (gsize i = 0; i < n_ops; i++) {
+		guint16 port = ops[i].port;
+		if (priv->ioperm_ports[port / 8] & (1u << (port % 8)))
+			continue;
+		if (ioperm (port, 1, 1) != 0) {
+			g_debug ("using %s as ioperm() failed: %s",
+				 fu_udev_device_get_device_file (self),
+				 strerror (errno));
+			priv->ioperm_failed = TRUE;
+			fu_udev_device_ioperm_reset (self);
+			return FALSE;
+		}
+		priv->ioperm_ports[port / 8] |= 1u << (port % 8);
+	}
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+static gboolean
+fu_udev_device_port_read (FuUdevDevice *self,
+			  gboolean use_ioperm,
+			  guint16 port,
+			  guint8 *buf,
+			  gsize bufsz,
+			  GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+
+#ifdef HAVE_IOPERM
+	if (use_ioperm) {
+		for (gsize i = 0; i < bufsz; i++)
+			buf[i] = inb (port + i);
+		return TRUE;
+	}
+#endif
+#ifdef HAVE_PWRITE
+	if (pread (priv->fd, buf, bufsz, port) != (gssize) bufsz) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to read from port %04x: %s",
+			     (guint) port,
+			     strerror (errno));
+		return FALSE;
+	}
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as pread() is unavailable");
+	return FALSE;
+#endif
+}
+
+static gboolean
+fu_udev_device_port_write (FuUdevDevice *self,
+			   gboolean use_ioperm,
+			   guint16 port,
+			   const guint8 *buf,
+			   gsize bufsz,
+			   GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+
+#ifdef HAVE_IOPERM
+	if (use_ioperm) {
+		for (gsize i = 0; i < bufsz; i++)
+			outb (buf[i], port + i);
+		return TRUE;
+	}
+#endif
+#ifdef HAVE_PWRITE
+	if (pwrite (priv->fd, buf, bufsz, port) != (gssize) bufsz) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to write to port %04x: %s",
+			     (guint) port,
+			     strerror (errno));
+		return FALSE;
+	}
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as pwrite() is unavailable");
+	return FALSE;
+#endif
+}
+
+static gboolean
+fu_udev_device_port_poll (FuUdevDevice *self,
+			  gboolean use_ioperm,
+			  const FuUdevDevicePortOp *op,
+			  GError **error)
+{
+	gint64 deadline = g_get_monotonic_time () + ((gint64) op->timeout * 1000);
+	guint8 tmp = 0x0;
+
+	do {
+		if (!fu_udev_device_port_read (self, use_ioperm, op->port, &tmp, 1, error))
+			return FALSE;
+		if ((tmp & op->mask) == op->value)
+			return TRUE;
+	} while (g_get_monotonic_time () < deadline);
+	g_set_error (error,
+		     G_IO_ERROR,
+		     G_IO_ERROR_TIMED_OUT,
+		     "timed out whilst waiting for port %04x & 0x%02x to be 0x%02x, got 0x%02x",
+		     (guint) op->port, op->mask, op->value, tmp);
+	return FALSE;
+}
+
+/**
+ * fu_udev_device_port_xfer:
+ * @self: A #FuUdevDevice
+ * @ops: (array length=n_ops): A sequence of #FuUdevDevicePortOp
+ * @n_ops: the number of items in @ops
+ * @error: A #GError, or %NULL
+ *
+ * Runs a sequence of port reads, writes and polls in order, stopping at the
+ * first failure.
+ *
+ * Consecutive reads or writes to ascending ports are done with one syscall.
+ * If the device has %FU_UDEV_DEVICE_FLAG_IOPERM set and the process is allowed
+ * to use ioperm() then the ports are accessed directly with no syscalls at all.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_udev_device_port_xfer (FuUdevDevice *self,
+			  const FuUdevDevicePortOp *ops,
+			  gsize n_ops,
+			  GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	gboolean use_ioperm;
+
+	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
+	g_return_val_if_fail (ops != NULL || n_ops == 0, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* fall back to the device file */
+	use_ioperm = fu_udev_device_port_xfer_ioperm (self, ops, n_ops);
+	if (!use_ioperm && priv->fd <= 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "device is not open");
+		return FALSE;
+	}
+
+	for (gsize i = 0; i < n_ops;) {
+		const FuUdevDevicePortOp *op = &ops[i];
+		guint8 buf[FU_UDEV_DEVICE_PORT_XFER_MAX] = { 0x0 };
+		gsize n = 1;
+
+		if (op->kind == FU_UDEV_DEVICE_PORT_OP_KIND_POLL) {
+			if (!fu_udev_device_port_poll (self, use_ioperm, op, error))
+				return FALSE;
+			i++;
+			continue;
+		}
+
+		/* coalesce a run to consecutive ports */
+		while (i + n < n_ops &&
+		       n < FU_UDEV_DEVICE_PORT_XFER_MAX &&
+		       ops[i + n].kind == op->kind &&
+		       ops[i + n].port == op->port + n)
+			n++;
+		if (op->kind == FU_UDEV_DEVICE_PORT_OP_KIND_WRITE) {
+			for (gsize j = 0; j < n; j++)
+				buf[j] = ops[i + j].value;
+			if (!fu_udev_device_port_write (self, use_ioperm, op->port, buf, n, error))
+				return FALSE;
+		} else if (op->kind == FU_UDEV_DEVICE_PORT_OP_KIND_READ) {
+			if (!fu_udev_device_port_read (self, use_ioperm, op->port, buf, n, error))
+				return FALSE;
+			for (gsize j = 0; j < n; j++) {
+				if (ops[i + j].data != NULL)
+					*ops[i + j].data = buf[j];
+			}
+		} else {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "port operation %u not supported",
+				     (guint) op->kind);
+			return FALSE;
+		}
+		i += n;
+	}
+	return TRUE;
+}
+
 static void
 fu_udev_device_get_property (GObject *object, guint prop_id,
 			    GValue *value, GParamSpec *pspec)
@@ -1042,6 +1494,7 @@ fu_udev_device_finalize (GObject *object)
 		g_object_unref (priv->udev_device);
 	if (priv->fd > 0)
 		g_close (priv->fd, NULL);
+	fu_udev_device_ioperm_reset (self);
 
 	G_OBJECT_CLASS (fu_udev_device_parent_class)->finalize (object);
 }
@@ -38,6 +38,7 @@ struct _FuUdevDeviceClass
  * @FU_UDEV_DEVICE_FLAG_OPEN_READ:		Open the device read-only
  * @FU_UDEV_DEVICE_FLAG_OPEN_WRITE:		Open the device write-only
  * @FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT:	Get the vendor ID fallback from the parent
+ * @FU_UDEV_DEVICE_FLAG_IOPERM:			Use direct port I/O in fu_udev_device_port_xfer() when permitted
  *
  * Flags used when opening the device using fu_device_open().
  **/
@@ -46,10 +47,47 @@ typedef enum {
 	FU_UDEV_DEVICE_FLAG_OPEN_READ		= 1 << 0,
 	FU_UDEV_DEVICE_FLAG_OPEN_WRITE		= 1 << 1,
 	FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT	= 1 << 2,
+	FU_UDEV_DEVICE_FLAG_IOPERM		= 1 << 3,
 	/*< private >*/
 	FU_UDEV_DEVICE_FLAG_LAST
 } FuUdevDeviceFlags;
 
+/**
+ * FuUdevDevicePortOpKind:
+ * @FU_UDEV_DEVICE_PORT_OP_KIND_WRITE:		Write the value to the port
+ * @FU_UDEV_DEVICE_PORT_OP_KIND_READ:		Read the port into the data pointer
+ * @FU_UDEV_DEVICE_PORT_OP_KIND_POLL:		Read the port until the masked bits match the value
+ *
+ * The kind of port operation.
+ **/
+typedef enum {
+	FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+	FU_UDEV_DEVICE_PORT_OP_KIND_READ,
+	FU_UDEV_DEVICE_PORT_OP_KIND_POLL,
+	/*< private >*/
+	FU_UDEV_DEVICE_PORT_OP_KIND_LAST
+} FuUdevDevicePortOpKind;
+
+/**
+ * FuUdevDevicePortOp:
+ * @kind:		A #FuUdevDevicePortOpKind
+ * @port:		The I/O port address
+ * @value:		The value to write, or for a poll the value to match
+ * @mask:		For a poll, the bits of the port that have to match
+ * @data:		For a read, where to store the value
+ * @timeout:		For a poll, the maximum time to wait in ms
+ *
+ * One operation in a sequence passed to fu_udev_device_port_xfer().
+ **/
+typedef struct {
+	FuUdevDevicePortOpKind	 kind;
+	guint16			 port;
+	guint8			 value;
+	guint8			 mask;
+	guint8			*data;
+	guint			 timeout;
+} FuUdevDevicePortOp;
+
 FuUdevDevice	*fu_udev_device_new			(GUdevDevice	*udev_device);
 GUdevDevice	*fu_udev_device_get_dev			(FuUdevDevice	*self);
 const gchar	*fu_udev_device_get_device_file		(FuUdevDevice	*self);
@@ -85,3 +123,7 @@ gboolean	 fu_udev_device_pread			(FuUdevDevice	*self,
 							 goffset	 port,
 							 guint8		*data,
 							 GError		**error);
+gboolean	 fu_udev_device_port_xfer		(FuUdevDevice	*self,
+							 const FuUdevDevicePortOp *ops,
+							 gsize		 n_ops,
+							 GError		**error);
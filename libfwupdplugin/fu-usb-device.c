@@ -24,6 +24,7 @@ typedef struct
 {
 	GUsbDevice		*usb_device;
 	FuDeviceLocker		*usb_device_locker;
+	gboolean		 done_descriptors;
 } FuUsbDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuUsbDevice, fu_usb_device, FU_TYPE_DEVICE)
@@ -155,25 +156,11 @@ fu_usb_device_query_hub (FuUsbDevice *self, GError **error)
 }
 
 static gboolean
-fu_usb_device_open (FuDevice *device, GError **error)
+fu_usb_device_query_descriptors (FuUsbDevice *self, GError **error)
 {
-	FuUsbDevice *self = FU_USB_DEVICE (device);
+	FuDevice *device = FU_DEVICE (self);
 	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
-	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (device);
 	guint idx;
-	g_autoptr(FuDeviceLocker) locker = NULL;
-
-	g_return_val_if_fail (FU_IS_USB_DEVICE (self), FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	/* already open */
-	if (priv->usb_device_locker != NULL)
-		return TRUE;
-
-	/* open */
-	locker = fu_device_locker_new (priv->usb_device, error);
-	if (locker == NULL)
-		return FALSE;
 
 	/* get vendor */
 	if (fu_device_get_vendor (device) == NULL) {
@@ -258,6 +245,36 @@ fu_usb_device_open (FuDevice *device, GError **error)
 		if (!fu_usb_device_query_hub (self, error))
 			return FALSE;
 	}
+	return TRUE;
+}
+
+static gboolean
+fu_usb_device_open (FuDevice *device, GError **error)
+{
+	FuUsbDevice *self = FU_USB_DEVICE (device);
+	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
+	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (device);
+	g_autoptr(FuDeviceLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_USB_DEVICE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* already open */
+	if (priv->usb_device_locker != NULL)
+		return TRUE;
+
+	/* open */
+	locker = fu_device_locker_new (priv->usb_device, error);
+	if (locker == NULL)
+		return FALSE;
+
+	/* string descriptors are slow to read on some hubs and only change
+	 * when the device re-enumerates, which sets a new GUsbDevice */
+	if (!priv->done_descriptors) {
+		if (!fu_usb_device_query_descriptors (self, error))
+			return FALSE;
+		priv->done_descriptors = TRUE;
+	}
 
 	/* subclassed */
 	if (klass->open != NULL) {
@@ -474,6 +491,7 @@ fu_usb_device_set_dev (FuUsbDevice *device, GUsbDevice *usb_device)
 
 	/* need to re-probe hardware */
 	fu_device_probe_invalidate (FU_DEVICE (device));
+	priv->done_descriptors = FALSE;
 
 	/* allow replacement */
 	g_set_object (&priv->usb_device, usb_device);
@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-usb-transfer-queue.h"
+
+typedef gssize	(*FuUsbTransferQueueEmulateFunc)		(FuUsbTransferQueue	*self,
+							 guint8			*buf,
+							 gsize			 bufsz,
+							 gpointer		 user_data,
+							 GError			**error);
+
+void		 fu_usb_transfer_queue_set_emulate_func	(FuUsbTransferQueue	*self,
+							 FuUsbTransferQueueEmulateFunc func,
+							 gpointer		 user_data);
@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuUsbTransferQueue"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-usb-transfer-queue-private.h"
+
+/**
+ * SECTION:fu-usb-transfer-queue
+ * @short_description: a queue of asynchronous USB transfers
+ *
+ * An object that keeps several USB transfers in flight at the same time so
+ * that the host does not wait for a round trip after every packet. Only use
+ * this for protocols where the device processes packets in order and does
+ * not need a reply before accepting the next one.
+ *
+ * The data passed to the queue is copied, and completion callbacks are only
+ * ever called from fu_usb_transfer_queue_drain() or when adding a transfer
+ * to a full queue, so the caller does not need to worry about re-entrancy.
+ * Any in-flight transfers are cancelled when the queue is destroyed.
+ *
+ * See also: #FuUsbDevice
+ */
+
+typedef enum {
+	FU_USB_TRANSFER_KIND_CONTROL,
+	FU_USB_TRANSFER_KIND_BULK,
+	FU_USB_TRANSFER_KIND_INTERRUPT,
+	FU_USB_TRANSFER_KIND_LAST
+} FuUsbTransferKind;
+
+typedef struct {
+	FuUsbTransferQueue	*self;		/* no-ref, queue waits for us */
+	FuUsbTransferKind	 kind;
+	gboolean		 is_read;
+	guint8			*buf;
+	gsize			 bufsz;
+	FuUsbTransferQueueFunc	 func;
+	gpointer		 user_data;
+} FuUsbTransferHelper;
+
+struct _FuUsbTransferQueue {
+	GObject			 parent_instance;
+	FuUsbDevice		*device;
+	GMainContext		*context;
+	GCancellable		*cancellable;
+	GError			*error;		/* first failure */
+	guint			 max_in_flight;
+	guint			 in_flight;
+	guint			 timeout;	/* ms */
+	FuUsbTransferQueueEmulateFunc emulate_func;
+	gpointer		 emulate_user_data;
+};
+
+G_DEFINE_TYPE (FuUsbTransferQueue, fu_usb_transfer_queue, G_TYPE_OBJECT)
+
+#define FU_USB_TRANSFER_QUEUE_TIMEOUT_DEFAULT	5000 /* ms */
+
+static void
+fu_usb_transfer_helper_free (FuUsbTransferHelper *helper)
+{
+	g_free (helper->buf);
+	g_free (helper);
+}
+
+static void
+fu_usb_transfer_queue_set_error (FuUsbTransferQueue *self, GError *error)
+{
+	/* only the first failure is interesting, the rest are cancellations */
+	if (self->error != NULL) {
+		g_debug ("ignoring: %s", error->message);
+		g_error_free (error);
+		return;
+	}
+	self->error = error;
+	g_cancellable_cancel (self->cancellable);
+}
+
+static void
+fu_usb_transfer_queue_iterate (FuUsbTransferQueue *self, guint limit)
+{
+	while (self->in_flight > limit)
+		g_main_context_iteration (self->context, TRUE);
+}
+
+static void
+fu_usb_transfer_queue_complete (FuUsbTransferHelper *helper,
+				gssize actual_length,
+				GError *error)
+{
+	FuUsbTransferQueue *self = helper->self;
+	g_autoptr(GError) error_local = error;
+
+	/* let the caller check the response */
+	if (actual_length >= 0 && helper->func != NULL && self->error == NULL) {
+		if (!helper->func (self, helper->buf, helper->bufsz,
+				   (gsize) actual_length,
+				   helper->user_data, &error_local))
+			actual_length = -1;
+	}
+	if (actual_length < 0) {
+		if (error_local == NULL) {
+			error_local = g_error_new_literal (G_IO_ERROR,
+							   G_IO_ERROR_FAILED,
+							   "transfer failed");
+		}
+		if (helper->is_read)
+			g_prefix_error (&error_local, "failed to receive: ");
+		else
+			g_prefix_error (&error_local, "failed to send: ");
+		fu_usb_transfer_queue_set_error (self, g_steal_pointer (&error_local));
+	}
+	self->in_flight--;
+	fu_usb_transfer_helper_free (helper);
+}
+
+static void
+fu_usb_transfer_queue_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUsbTransferHelper *helper = (FuUsbTransferHelper *) user_data;
+	GUsbDevice *usb_device = G_USB_DEVICE (source);
+	gssize actual_length = -1;
+	GError *error_local = NULL;
+
+	switch (helper->kind) {
+	case FU_USB_TRANSFER_KIND_CONTROL:
+		actual_length = g_usb_device_control_transfer_finish (usb_device, res, &error_local);
+		break;
+	case FU_USB_TRANSFER_KIND_BULK:
+		actual_length = g_usb_device_bulk_transfer_finish (usb_device, res, &error_local);
+		break;
+	case FU_USB_TRANSFER_KIND_INTERRUPT:
+		actual_length = g_usb_device_interrupt_transfer_finish (usb_device, res, &error_local);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	fu_usb_transfer_queue_complete (helper, actual_length, error_local);
+}
+
+static gboolean
+fu_usb_transfer_queue_emulate_cb (gpointer user_data)
+{
+	FuUsbTransferHelper *helper = (FuUsbTransferHelper *) user_data;
+	FuUsbTransferQueue *self = helper->self;
+	gssize actual_length = -1;
+	GError *error_local = NULL;
+
+	if (!g_cancellable_set_error_if_cancelled (self->cancellable, &error_local)) {
+		actual_length = self->emulate_func (self, helper->buf, helper->bufsz,
+						    self->emulate_user_data,
+						    &error_local);
+	}
+	fu_usb_transfer_queue_complete (helper, actual_length, error_local);
+	return G_SOURCE_REMOVE;
+}
+
+/* returns %TRUE if the transfer was handled without using the device */
+static gboolean
+fu_usb_transfer_queue_submit_emulated (FuUsbTransferQueue *self,
+				       FuUsbTransferHelper *helper)
+{
+	g_autoptr(GSource) source = NULL;
+
+	if (self->emulate_func == NULL)
+		return FALSE;
+	source = g_idle_source_new ();
+	g_source_set_callback (source, fu_usb_transfer_queue_emulate_cb, helper, NULL);
+	g_source_attach (source, self->context);
+	self->in_flight++;
+	return TRUE;
+}
+
+static FuUsbTransferHelper *
+fu_usb_transfer_queue_helper_new (FuUsbTransferQueue *self,
+				  FuUsbTransferKind kind,
+				  gboolean is_read,
+				  const guint8 *buf,
+				  gsize bufsz,
+				  FuUsbTransferQueueFunc func,
+				  gpointer user_data,
+				  GError **error)
+{
+	FuUsbTransferHelper *helper;
+
+	/* not open */
+	if (self->emulate_func == NULL &&
+	    fu_usb_device_get_dev (self->device) == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_INITIALIZED,
+				     "device is not open");
+		return NULL;
+	}
+
+	/* wait for a free slot */
+	fu_usb_transfer_queue_iterate (self, self->max_in_flight - 1);
+
+	/* an earlier transfer failed, so do not send any more */
+	if (self->error != NULL) {
+		g_propagate_error (error, g_error_copy (self->error));
+		return NULL;
+	}
+
+	helper = g_new0 (FuUsbTransferHelper, 1);
+	helper->self = self;
+	helper->kind = kind;
+	helper->is_read = is_read;
+	helper->bufsz = bufsz;
+	helper->buf = g_malloc0 (bufsz);
+	if (buf != NULL)
+		memcpy (helper->buf, buf, bufsz);
+	helper->func = func;
+	helper->user_data = user_data;
+	return helper;
+}
+
+/**
+ * fu_usb_transfer_queue_add_control:
+ * @self: A #FuUsbTransferQueue
+ * @direction: a #GUsbDeviceDirection
+ * @request_type: a #GUsbDeviceRequestType
+ * @recipient: a #GUsbDeviceRecipient
+ * @request: the request field of the setup packet
+ * @value: the value field of the setup packet
+ * @idx: the index field of the setup packet
+ * @buf: (nullable): data to send, or %NULL to receive
+ * @bufsz: size of @buf
+ * @func: (scope async) (nullable): a #FuUsbTransferQueueFunc
+ * @user_data: user data for @func
+ * @error: a #GError or %NULL
+ *
+ * Submits an asynchronous control transfer, waiting for an earlier transfer
+ * to complete first if the queue is full.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_usb_transfer_queue_add_control (FuUsbTransferQueue *self,
+				   GUsbDeviceDirection direction,
+				   GUsbDeviceRequestType request_type,
+				   GUsbDeviceRecipient recipient,
+				   guint8 request,
+				   guint16 value,
+				   guint16 idx,
+				   const guint8 *buf,
+				   gsize bufsz,
+				   FuUsbTransferQueueFunc func,
+				   gpointer user_data,
+				   GError **error)
+{
+	FuUsbTransferHelper *helper;
+
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	helper = fu_usb_transfer_queue_helper_new (self, FU_USB_TRANSFER_KIND_CONTROL,
+						   direction == G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+						   buf, bufsz, func, user_data,
+						   error);
+	if (helper == NULL)
+		return FALSE;
+	if (fu_usb_transfer_queue_submit_emulated (self, helper))
+		return TRUE;
+	g_main_context_push_thread_default (self->context);
+	g_usb_device_control_transfer_async (fu_usb_device_get_dev (self->device),
+					     direction, request_type, recipient,
+					     request, value, idx,
+					     helper->buf, helper->bufsz,
+					     self->timeout, self->cancellable,
+					     fu_usb_transfer_queue_done_cb,
+					     helper);
+	g_main_context_pop_thread_default (self->context);
+	self->in_flight++;
+	return TRUE;
+}
+
+/**
+ * fu_usb_transfer_queue_add_bulk:
+ * @self: A #FuUsbTransferQueue
+ * @endpoint: the address of a valid endpoint
+ * @buf: (nullable): data to send, or %NULL to receive
+ * @bufsz: size of @buf
+ * @func: (scope async) (nullable): a #FuUsbTransferQueueFunc
+ * @user_data: user data for @func
+ * @error: a #GError or %NULL
+ *
+ * Submits an asynchronous bulk transfer, waiting for an earlier transfer
+ * to complete first if the queue is full.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_usb_transfer_queue_add_bulk (FuUsbTransferQueue *self,
+				guint8 endpoint,
+				const guint8 *buf,
+				gsize bufsz,
+				FuUsbTransferQueueFunc func,
+				gpointer user_data,
+				GError **error)
+{
+	FuUsbTransferHelper *helper;
+
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	helper = fu_usb_transfer_queue_helper_new (self, FU_USB_TRANSFER_KIND_BULK,
+						   (endpoint & 0x80) > 0,
+						   buf, bufsz, func, user_data,
+						   error);
+	if (helper == NULL)
+		return FALSE;
+	if (fu_usb_transfer_queue_submit_emulated (self, helper))
+		return TRUE;
+	g_main_context_push_thread_default (self->context);
+	g_usb_device_bulk_transfer_async (fu_usb_device_get_dev (self->device),
+					  endpoint,
+					  helper->buf, helper->bufsz,
+					  self->timeout, self->cancellable,
+					  fu_usb_transfer_queue_done_cb,
+					  helper);
+	g_main_context_pop_thread_default (self->context);
+	self->in_flight++;
+	return TRUE;
+}
+
+/**
+ * fu_usb_transfer_queue_add_interrupt:
+ * @self: A #FuUsbTransferQueue
+ * @endpoint: the address of a valid endpoint
+ * @buf: (nullable): data to send, or %NULL to receive
+ * @bufsz: size of @buf
+ * @func: (scope async) (nullable): a #FuUsbTransferQueueFunc
+ * @user_data: user data for @func
+ * @error: a #GError or %NULL
+ *
+ * Submits an asynchronous interrupt transfer, waiting for an earlier
+ * transfer to complete first if the queue is full.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_usb_transfer_queue_add_interrupt (FuUsbTransferQueue *self,
+				     guint8 endpoint,
+				     const guint8 *buf,
+				     gsize bufsz,
+				     FuUsbTransferQueueFunc func,
+				     gpointer user_data,
+				     GError **error)
+{
+	FuUsbTransferHelper *helper;
+
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	helper = fu_usb_transfer_queue_helper_new (self, FU_USB_TRANSFER_KIND_INTERRUPT,
+						   (endpoint & 0x80) > 0,
+						   buf, bufsz, func, user_data,
+						   error);
+	if (helper == NULL)
+		return FALSE;
+	if (fu_usb_transfer_queue_submit_emulated (self, helper))
+		return TRUE;
+	g_main_context_push_thread_default (self->context);
+	g_usb_device_interrupt_transfer_async (fu_usb_device_get_dev (self->device),
+					       endpoint,
+					       helper->buf, helper->bufsz,
+					       self->timeout, self->cancellable,
+					       fu_usb_transfer_queue_done_cb,
+					       helper);
+	g_main_context_pop_thread_default (self->context);
+	self->in_flight++;
+	return TRUE;
+}
+
+/**
+ * fu_usb_transfer_queue_drain:
+ * @self: A #FuUsbTransferQueue
+ * @error: a #GError or %NULL
+ *
+ * Waits for all the in-flight transfers to complete. The queue can be used
+ * again after this function returns.
+ *
+ * Returns: %TRUE if every transfer since the last drain succeeded
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_usb_transfer_queue_drain (FuUsbTransferQueue *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	fu_usb_transfer_queue_iterate (self, 0);
+
+	/* ready for reuse */
+	if (g_cancellable_is_cancelled (self->cancellable)) {
+		g_object_unref (self->cancellable);
+		self->cancellable = g_cancellable_new ();
+	}
+	if (self->error != NULL) {
+		g_propagate_error (error, g_steal_pointer (&self->error));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_usb_transfer_queue_cancel:
+ * @self: A #FuUsbTransferQueue
+ *
+ * Cancels all the in-flight transfers. Use fu_usb_transfer_queue_drain() to
+ * wait for the cancellation to complete.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_usb_transfer_queue_cancel (FuUsbTransferQueue *self)
+{
+	g_return_if_fail (FU_IS_USB_TRANSFER_QUEUE (self));
+	fu_usb_transfer_queue_set_error (self,
+					 g_error_new_literal (G_IO_ERROR,
+							      G_IO_ERROR_CANCELLED,
+							      "transfer queue was cancelled"));
+}
+
+/**
+ * fu_usb_transfer_queue_set_timeout:
+ * @self: A #FuUsbTransferQueue
+ * @timeout: timeout in ms
+ *
+ * Sets the timeout used for each transfer submitted after this call.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_usb_transfer_queue_set_timeout (FuUsbTransferQueue *self, guint timeout)
+{
+	g_return_if_fail (FU_IS_USB_TRANSFER_QUEUE (self));
+	self->timeout = timeout;
+}
+
+/**
+ * fu_usb_transfer_queue_set_emulate_func: (skip):
+ * @self: A #FuUsbTransferQueue
+ * @func: (nullable): a #FuUsbTransferQueueEmulateFunc
+ * @user_data: user data for @func
+ *
+ * Completes each transfer submitted after this call using @func rather than
+ * the device, which is only useful for self tests.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_usb_transfer_queue_set_emulate_func (FuUsbTransferQueue *self,
+					FuUsbTransferQueueEmulateFunc func,
+					gpointer user_data)
+{
+	g_return_if_fail (FU_IS_USB_TRANSFER_QUEUE (self));
+	self->emulate_func = func;
+	self->emulate_user_data = user_data;
+}
+
+/**
+ * fu_usb_transfer_queue_get_in_flight:
+ * @self: A #FuUsbTransferQueue
+ *
+ * Gets the number of transfers that have been submitted but not completed.
+ *
+ * Returns: integer
+ *
+ * Since: 1.4.0
+ **/
+guint
+fu_usb_transfer_queue_get_in_flight (FuUsbTransferQueue *self)
+{
+	g_return_val_if_fail (FU_IS_USB_TRANSFER_QUEUE (self), 0);
+	return self->in_flight;
+}
+
+static void
+fu_usb_transfer_queue_init (FuUsbTransferQueue *self)
+{
+	self->context = g_main_context_new ();
+	self->cancellable = g_cancellable_new ();
+	self->max_in_flight = 1;
+	self->timeout = FU_USB_TRANSFER_QUEUE_TIMEOUT_DEFAULT;
+}
+
+static void
+fu_usb_transfer_queue_finalize (GObject *object)
+{
+	FuUsbTransferQueue *self = FU_USB_TRANSFER_QUEUE (object);
+
+	/* the helpers point at the queue, so wait for them */
+	g_cancellable_cancel (self->cancellable);
+	fu_usb_transfer_queue_iterate (self, 0);
+
+	if (self->error != NULL)
+		g_error_free (self->error);
+	g_object_unref (self->cancellable);
+	g_main_context_unref (self->context);
+	g_object_unref (self->device);
+
+	G_OBJECT_CLASS (fu_usb_transfer_queue_parent_class)->finalize (object);
+}
+
+static void
+fu_usb_transfer_queue_class_init (FuUsbTransferQueueClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_usb_transfer_queue_finalize;
+}
+
+/**
+ * fu_usb_transfer_queue_new:
+ * @device: A #FuUsbDevice
+ * @max_in_flight: the maximum number of transfers submitted at once
+ *
+ * Creates a new transfer queue for the device, which must be open before
+ * any transfers are added.
+ *
+ * Returns: (transfer full): a #FuUsbTransferQueue
+ *
+ * Since: 1.4.0
+ **/
+FuUsbTransferQueue *
+fu_usb_transfer_queue_new (FuUsbDevice *device, guint max_in_flight)
+{
+	FuUsbTransferQueue *self;
+	g_return_val_if_fail (FU_IS_USB_DEVICE (device), NULL);
+	self = g_object_new (FU_TYPE_USB_TRANSFER_QUEUE, NULL);
+	self->device = g_object_ref (device);
+	self->max_in_flight = MAX (max_in_flight, 1);
+	return self;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gusb.h>
+
+#include "fu-usb-device.h"
+
+#define FU_TYPE_USB_TRANSFER_QUEUE (fu_usb_transfer_queue_get_type ())
+
+G_DECLARE_FINAL_TYPE (FuUsbTransferQueue, fu_usb_transfer_queue, FU, USB_TRANSFER_QUEUE, GObject)
+
+/**
+ * FuUsbTransferQueueFunc:
+ * @self: A #FuUsbTransferQueue
+ * @buf: the transfer buffer
+ * @bufsz: the requested size of @buf
+ * @actual_length: the number of bytes actually transferred
+ * @user_data: user data
+ * @error: a #GError or %NULL
+ *
+ * Called when a queued transfer completes successfully.
+ *
+ * Returns: %TRUE for success, otherwise the queue is cancelled
+ **/
+typedef gboolean (*FuUsbTransferQueueFunc)		(FuUsbTransferQueue	*self,
+							 const guint8		*buf,
+							 gsize			 bufsz,
+							 gsize			 actual_length,
+							 gpointer		 user_data,
+							 GError			**error);
+
+FuUsbTransferQueue *fu_usb_transfer_queue_new		(FuUsbDevice		*device,
+							 guint			 max_in_flight);
+void		 fu_usb_transfer_queue_set_timeout	(FuUsbTransferQueue	*self,
+							 guint			 timeout);
+guint		 fu_usb_transfer_queue_get_in_flight	(FuUsbTransferQueue	*self);
+gboolean	 fu_usb_transfer_queue_add_control	(FuUsbTransferQueue	*self,
+							 GUsbDeviceDirection	 direction,
+							 GUsbDeviceRequestType	 request_type,
+							 GUsbDeviceRecipient	 recipient,
+							 guint8			 request,
+							 guint16		 value,
+							 guint16		 idx,
+							 const guint8		*buf,
+							 gsize			 bufsz,
+							 FuUsbTransferQueueFunc	 func,
+							 gpointer		 user_data,
+							 GError			**error);
+gboolean	 fu_usb_transfer_queue_add_bulk		(FuUsbTransferQueue	*self,
+							 guint8			 endpoint,
+							 const guint8		*buf,
+							 gsize			 bufsz,
+							 FuUsbTransferQueueFunc	 func,
+							 gpointer		 user_data,
+							 GError			**error);
+gboolean	 fu_usb_transfer_queue_add_interrupt	(FuUsbTransferQueue	*self,
+							 guint8			 endpoint,
+							 const guint8		*buf,
+							 gsize			 bufsz,
+							 FuUsbTransferQueueFunc	 func,
+							 gpointer		 user_data,
+							 GError			**error);
+gboolean	 fu_usb_transfer_queue_drain		(FuUsbTransferQueue	*self,
+							 GError			**error);
+void		 fu_usb_transfer_queue_cancel		(FuUsbTransferQueue	*self);
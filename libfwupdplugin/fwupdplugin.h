@@ -14,11 +14,13 @@
 #define __FWUPDPLUGIN_H_INSIDE__
 
 #include <libfwupdplugin/fu-archive.h>
+#include <libfwupdplugin/fu-bytes-view.h>
 #include <libfwupdplugin/fu-chunk.h>
 #include <libfwupdplugin/fu-common.h>
 #include <libfwupdplugin/fu-common-cab.h>
 #include <libfwupdplugin/fu-common-guid.h>
 #include <libfwupdplugin/fu-common-version.h>
+#include <libfwupdplugin/fu-crc.h>
 #include <libfwupdplugin/fu-device.h>
 #include <libfwupdplugin/fu-device-locker.h>
 #include <libfwupdplugin/fu-device-metadata.h>
@@ -37,6 +39,7 @@
 #include <libfwupdplugin/fu-efivar.h>
 #include <libfwupdplugin/fu-udev-device.h>
 #include <libfwupdplugin/fu-usb-device.h>
+#include <libfwupdplugin/fu-usb-transfer-queue.h>
 
 #ifndef FWUPD_DISABLE_DEPRECATED
 #include <libfwupdplugin/fu-deprecated.h>
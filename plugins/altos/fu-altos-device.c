@@ -104,7 +104,7 @@ fu_altos_device_tty_write (FuAltosDevice *self,
 	/* lets assume this is text */
 	if (data_len < 0)
 		data_len = strlen (data);
-	if (g_getenv ("FWUPD_ALTOS_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_ALTOS_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "write", (const guint8 *) data, (gsize) data_len);
 	return fu_io_channel_write_raw (self->io_channel,
 					(const guint8 *) data,
@@ -125,7 +125,7 @@ fu_altos_device_tty_read (FuAltosDevice *self,
 					timeout_ms, FU_IO_CHANNEL_FLAG_NONE, error);
 	if (buf == NULL)
 		return NULL;
-	if (g_getenv ("FWUPD_ALTOS_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_ALTOS_VERBOSE"))
 		fu_common_dump_bytes (G_LOG_DOMAIN, "read", buf);
 	return g_string_new_len (g_bytes_get_data (buf, NULL), g_bytes_get_size (buf));
 }
@@ -198,14 +198,19 @@ fu_altos_device_tty_close (FuAltosDevice *self, GError **error)
 static GString *
 fu_altos_device_read_page (FuAltosDevice *self, guint address, GError **error)
 {
-	g_autoptr(GString) str = NULL;
+	g_autoptr(GBytes) buf = NULL;
 	g_autofree gchar *cmd = g_strdup_printf ("R %x\n", address);
 	if (!fu_altos_device_tty_write (self, cmd, -1, error))
 		return NULL;
-	str = fu_altos_device_tty_read (self, 1500, 256, error);
-	if (str == NULL)
+
+	/* pages are always 256 bytes, even if split over several reads */
+	buf = fu_io_channel_read_fixed (self->io_channel, 256, 1500,
+					FU_IO_CHANNEL_FLAG_NONE, error);
+	if (buf == NULL)
 		return NULL;
-	return g_steal_pointer (&str);
+	if (fu_common_is_verbose ("FWUPD_ALTOS_VERBOSE"))
+		fu_common_dump_bytes (G_LOG_DOMAIN, "read", buf);
+	return g_string_new_len (g_bytes_get_data (buf, NULL), g_bytes_get_size (buf));
 }
 
 static gboolean
@@ -562,6 +567,7 @@ fu_altos_device_init (FuAltosDevice *self)
 	fu_device_set_vendor (FU_DEVICE (self), "altusmetrum.org");
 	fu_device_set_summary (FU_DEVICE (self), "A USB hardware random number generator");
 	fu_device_set_protocol (FU_DEVICE (self), "org.altusmetrum.altos");
+	fu_device_set_firmware_cacheable (FU_DEVICE (self), TRUE);
 
 	/* requires manual step */
 	if (!fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
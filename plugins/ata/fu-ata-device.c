@@ -525,7 +525,7 @@ fu_ata_device_command (FuAtaDevice *self, struct ata_tf *tf,
 	cdb[7] = tf->lbah;
 	cdb[8] = tf->dev;
 	cdb[9] = tf->command;
-	if (g_getenv ("FWUPD_ATA_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_ATA_VERBOSE")) {
 		fu_common_dump_raw (G_LOG_DOMAIN, "CBD", cdb, sizeof(cdb));
 		if (dxfer_direction == SG_DXFER_TO_DEV && dxferp != NULL) {
 			fu_common_dump_raw (G_LOG_DOMAIN, "outgoing_data",
@@ -550,7 +550,7 @@ fu_ata_device_command (FuAtaDevice *self, struct ata_tf *tf,
 		return FALSE;
 	g_debug ("ATA_%u status=0x%x, host_status=0x%x, driver_status=0x%x",
 		io_hdr.cmd_len, io_hdr.status, io_hdr.host_status, io_hdr.driver_status);
-	if (g_getenv ("FWUPD_ATA_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_ATA_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "SB", sb, sizeof(sb));
 
 	/* error check */
@@ -617,7 +617,7 @@ fu_ata_device_setup (FuDevice *device, GError **error)
 		g_prefix_error (error, "failed to IDENTIFY");
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_ATA_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_ATA_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "IDENTIFY", id, sizeof(id));
 	if (!fu_ata_device_parse_id (self, id, sizeof(id), error))
 		return FALSE;
@@ -835,6 +835,7 @@ fu_ata_device_init (FuAtaDevice *self)
 	fu_device_set_summary (FU_DEVICE (self), "ATA Drive");
 	fu_device_add_icon (FU_DEVICE (self), "drive-harddisk");
 	fu_device_set_protocol (FU_DEVICE (self), "org.t13.ata");
+	fu_device_set_firmware_cacheable (FU_DEVICE (self), TRUE);
 	fu_device_set_version_format (FU_DEVICE (self), FWUPD_VERSION_FORMAT_PLAIN);
 	fu_udev_device_set_flags (FU_UDEV_DEVICE (self), FU_UDEV_DEVICE_FLAG_OPEN_READ);
 }
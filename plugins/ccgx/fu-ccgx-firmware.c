@@ -9,6 +9,7 @@
 
 #include "fu-common.h"
 #include "fu-common-version.h"
+#include "fu-crc.h"
 #include "fu-firmware-common.h"
 
 #include "fu-ccgx-common.h"
@@ -193,8 +194,7 @@ fu_ccgx_firmware_parse_md_block (FuCcgxFirmware *self, FuFirmwareImage *img, GEr
 		rcd = g_ptr_array_index (self->records, i);
 		buf = g_bytes_get_data (rcd->data, &bufsz);
 		fw_size += bufsz;
-		for (gsize j = 0; j < bufsz; j++)
-			checksum_calc += buf[j];
+		checksum_calc += fu_sum8 (buf, bufsz);
 	}
 	if (fw_size != metadata.fw_size)  {
 		g_set_error (error,
@@ -86,7 +86,7 @@ fu_colorhug_device_msg (FuColorhugDevice *self, guint8 cmd,
 	}
 
 	/* request */
-	if (g_getenv ("FWUPD_COLORHUG_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_COLORHUG_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "REQ", buf, ibufsz + 1);
 	if (!g_usb_device_interrupt_transfer (usb_device,
 					      CH_USB_HID_EP_OUT,
@@ -120,7 +120,7 @@ fu_colorhug_device_msg (FuColorhugDevice *self, guint8 cmd,
 		g_prefix_error (error, "failed to get reply: ");
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_COLORHUG_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_COLORHUG_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "RES", buf, actual_length);
 
 	/* old bootloaders do not return the full block */
@@ -16,4 +16,5 @@ fu_plugin_init (FuPlugin *plugin)
 {
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 	fu_plugin_set_device_gtype (plugin, FU_TYPE_COLORHUG_DEVICE);
+	fu_plugin_set_open_on_demand (plugin, TRUE);
 }
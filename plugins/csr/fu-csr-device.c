@@ -339,7 +339,7 @@ fu_csr_device_prepare_firmware (FuDevice *device,
 	/* parse the file */
 	if (!fu_firmware_parse (firmware, fw, flags, error))
 		return NULL;
-	if (g_getenv ("FWUPD_CSR_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_CSR_VERBOSE")) {
 		g_autofree gchar *fw_str = NULL;
 		fw_str = fu_firmware_to_string (firmware);
 		g_debug ("%s", fw_str);
@@ -425,6 +425,7 @@ static void
 fu_csr_device_init (FuCsrDevice *self)
 {
 	fu_device_set_protocol (FU_DEVICE (self), "com.qualcomm.dfu");
+	fu_device_set_firmware_cacheable (FU_DEVICE (self), TRUE);
 }
 
 static void
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "fu-common.h"
+#include "fu-crc.h"
 
 #include "fu-dell-dock-common.h"
 
@@ -454,10 +455,7 @@ fu_dell_dock_mst_checksum_bank (FuDevice *symbiote,
 	}
 
 	/* checksum the file */
-	for (guint i = attribs->start; i < attribs->length + attribs->start;
-	     i++) {
-		payload_sum += data[i];
-	}
+	payload_sum = fu_sum32 (data + attribs->start, attribs->length);
 	g_debug ("MST: Payload checksum: 0x%x", payload_sum);
 
 	/* checksum the bank */
@@ -823,7 +823,7 @@ fu_plugin_init (FuPlugin *plugin)
 	g_debug ("Using libsmbios %s", tmp);
 
 	data->smi_obj = g_malloc0 (sizeof (FuDellSmiObj));
-	if (g_getenv ("FWUPD_DELL_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_DELL_VERBOSE"))
 		g_setenv ("LIBSMBIOS_C_DEBUG_OUTPUT_ALL", "1", TRUE);
 	else
 		g_setenv ("TSS2_LOG", "esys+error,tcti+none", FALSE);
@@ -189,6 +189,66 @@ dfu_image_from_dfuse (const guint8 *data,
 	return g_object_ref (image);
 }
 
+/**
+ * dfu_image_get_dfuse_size: (skip)
+ * @data: data buffer
+ * @length: length of @data we can access
+ * @consumed: (out): the number of bytes used by the image
+ * @error: a #GError, or %NULL
+ *
+ * Finds the size of a DfuSe image without unpacking the elements.
+ *
+ * Returns: %TRUE for success
+ **/
+static gboolean
+dfu_image_get_dfuse_size (const guint8 *data,
+			  guint32 length,
+			  guint32 *consumed,
+			  GError **error)
+{
+	DfuSeImagePrefix *im = (DfuSeImagePrefix *) data;
+	guint32 elements;
+	guint32 offset = sizeof(DfuSeImagePrefix);
+
+	/* check input buffer size */
+	if (length < sizeof(DfuSeImagePrefix)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "invalid image data size %u",
+			     (guint32) length);
+		return FALSE;
+	}
+
+	/* skip over each element */
+	elements = GUINT32_FROM_LE (im->elements);
+	for (guint j = 0; j < elements; j++) {
+		DfuSeElementPrefix *el = (DfuSeElementPrefix *) (data + offset);
+		guint32 size;
+		if (length - offset < sizeof(DfuSeElementPrefix)) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "invalid element data size %u",
+				     length - offset);
+			return FALSE;
+		}
+		size = GUINT32_FROM_LE (el->size);
+		if (size > length - offset - sizeof(DfuSeElementPrefix)) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "invalid element size %u, only %u bytes left",
+				     size,
+				     (guint32) (length - offset - sizeof(DfuSeElementPrefix)));
+			return FALSE;
+		}
+		offset += sizeof(DfuSeElementPrefix) + size;
+	}
+	*consumed = offset;
+	return TRUE;
+}
+
 /**
  * dfu_image_to_dfuse: (skip)
  * @image: a #DfuImage
@@ -319,6 +379,24 @@ dfu_firmware_to_dfuse (DfuFirmware *firmware, GError **error)
 	return g_bytes_new (buf, sizeof (DfuSePrefix) + image_size_total);
 }
 
+static FuFirmwareImage *
+dfu_firmware_from_dfuse_image_cb (FuFirmware *firmware,
+				  GBytes *fw,
+				  guint idx,
+				  gpointer user_data,
+				  FwupdInstallFlags flags,
+				  GError **error)
+{
+	gsize len = 0;
+	const guint8 *data = g_bytes_get_data (fw, &len);
+	DfuImage *image = dfu_image_from_dfuse (data, (guint32) len, NULL, error);
+	if (image == NULL) {
+		g_prefix_error (error, "target %u: ", idx);
+		return NULL;
+	}
+	return FU_FIRMWARE_IMAGE (image);
+}
+
 /**
  * dfu_firmware_from_dfuse: (skip)
  * @firmware: a #DfuFirmware
@@ -340,6 +418,7 @@ dfu_firmware_from_dfuse (DfuFirmware *firmware,
 	gsize len;
 	guint32 offset = sizeof(DfuSePrefix);
 	guint8 *data;
+	g_autoptr(GPtrArray) blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
 
 	/* check the prefix (BE) */
 	data = (guint8 *) g_bytes_get_data (bytes, &len);
@@ -375,18 +454,20 @@ dfu_firmware_from_dfuse (DfuFirmware *firmware,
 		return FALSE;
 	}
 
-	/* parse the image targets */
+	/* find the image targets */
 	len -= sizeof(DfuSePrefix);
 	for (guint i = 0; i < prefix->targets; i++) {
-		guint consumed;
-		g_autoptr(DfuImage) image = NULL;
-		image = dfu_image_from_dfuse (data + offset, (guint32) len,
-					      &consumed, error);
-		if (image == NULL)
+		guint32 consumed = 0;
+		if (!dfu_image_get_dfuse_size (data + offset, (guint32) len,
+					       &consumed, error))
 			return FALSE;
-		fu_firmware_add_image (FU_FIRMWARE (firmware), FU_FIRMWARE_IMAGE (image));
+		g_ptr_array_add (blobs, g_bytes_new_from_bytes (bytes, offset, consumed));
 		offset += consumed;
 		len -= consumed;
 	}
-	return TRUE;
+
+	/* unpack and verify each one, possibly in parallel */
+	return fu_firmware_parse_images (FU_FIRMWARE (firmware), blobs,
+					 dfu_firmware_from_dfuse_image_cb,
+					 NULL, flags, error);
 }
@@ -65,7 +65,7 @@ fu_ebitdo_pkt_cmd_to_string (FuEbitdoPktCmd cmd)
 }
 
 void
-fu_ebitdo_dump_pkt (FuEbitdoPkt *hdr)
+fu_ebitdo_dump_pkt (const FuEbitdoPkt *hdr)
 {
 	g_print ("PktLength:   0x%02x\n", hdr->pkt_len);
 	g_print ("PktType:     0x%02x [%s]\n",
@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "fu-chunk.h"
+#include "fu-usb-transfer-queue.h"
 
 #include "fu-ebitdo-common.h"
 #include "fu-ebitdo-device.h"
@@ -22,25 +23,17 @@ struct _FuEbitdoDevice {
 G_DEFINE_TYPE (FuEbitdoDevice, fu_ebitdo_device, FU_TYPE_USB_DEVICE)
 
 static gboolean
-fu_ebitdo_device_send (FuEbitdoDevice *self,
-		       FuEbitdoPktType type,
-		       FuEbitdoPktCmd subtype,
-		       FuEbitdoPktCmd cmd,
-		       const guint8 *in,
-		       gsize in_len,
-		       GError **error)
+fu_ebitdo_device_build_packet (FuEbitdoDevice *self,
+			       FuEbitdoPktType type,
+			       FuEbitdoPktCmd subtype,
+			       FuEbitdoPktCmd cmd,
+			       const guint8 *in,
+			       gsize in_len,
+			       guint8 *packet,
+			       GError **error)
 {
-	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
-	gsize actual_length;
-	guint8 ep_out = FU_EBITDO_USB_RUNTIME_EP_OUT;
-	g_autoptr(GError) error_local = NULL;
 	FuEbitdoPkt *hdr = (FuEbitdoPkt *) packet;
 
-	/* different */
-	if (fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
-		ep_out = FU_EBITDO_USB_BOOTLOADER_EP_OUT;
-
 	/* check size */
 	if (in_len > 64 - 8) {
 		g_set_error (error,
@@ -71,51 +64,51 @@ fu_ebitdo_device_send (FuEbitdoDevice *self,
 	}
 
 	/* debug */
-	if (g_getenv ("FWUPD_EBITDO_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_EBITDO_VERBOSE")) {
 		fu_common_dump_raw (G_LOG_DOMAIN, "->DEVICE", packet, (gsize) hdr->pkt_len + 1);
 		fu_ebitdo_dump_pkt (hdr);
 	}
-
-	/* get data from device */
-	if (!g_usb_device_interrupt_transfer (usb_device,
-					      ep_out,
-					      packet,
-					      FU_EBITDO_USB_EP_SIZE,
-					      &actual_length,
-					      FU_EBITDO_USB_TIMEOUT,
-					      NULL, /* cancellable */
-					      &error_local)) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_INVALID_DATA,
-			     "failed to send to device on ep 0x%02x: %s",
-			     (guint) FU_EBITDO_USB_BOOTLOADER_EP_OUT,
-			     error_local->message);
-		return FALSE;
-	}
 	return TRUE;
 }
 
+static guint8
+fu_ebitdo_device_get_ep_out (FuEbitdoDevice *self)
+{
+	if (fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
+		return FU_EBITDO_USB_BOOTLOADER_EP_OUT;
+	return FU_EBITDO_USB_RUNTIME_EP_OUT;
+}
+
+static guint8
+fu_ebitdo_device_get_ep_in (FuEbitdoDevice *self)
+{
+	if (fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
+		return FU_EBITDO_USB_BOOTLOADER_EP_IN;
+	return FU_EBITDO_USB_RUNTIME_EP_IN;
+}
+
 static gboolean
-fu_ebitdo_device_receive (FuEbitdoDevice *self,
-		       guint8 *out,
-		       gsize out_len,
+fu_ebitdo_device_send (FuEbitdoDevice *self,
+		       FuEbitdoPktType type,
+		       FuEbitdoPktCmd subtype,
+		       FuEbitdoPktCmd cmd,
+		       const guint8 *in,
+		       gsize in_len,
 		       GError **error)
 {
 	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
 	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
 	gsize actual_length;
-	guint8 ep_in = FU_EBITDO_USB_RUNTIME_EP_IN;
+	guint8 ep_out = fu_ebitdo_device_get_ep_out (self);
 	g_autoptr(GError) error_local = NULL;
-	FuEbitdoPkt *hdr = (FuEbitdoPkt *) packet;
 
-	/* different */
-	if (fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
-		ep_in = FU_EBITDO_USB_BOOTLOADER_EP_IN;
+	if (!fu_ebitdo_device_build_packet (self, type, subtype, cmd,
+					    in, in_len, packet, error))
+		return FALSE;
 
 	/* get data from device */
 	if (!g_usb_device_interrupt_transfer (usb_device,
-					      ep_in,
+					      ep_out,
 					      packet,
 					      FU_EBITDO_USB_EP_SIZE,
 					      &actual_length,
@@ -125,14 +118,26 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 		g_set_error (error,
 			     G_IO_ERROR,
 			     G_IO_ERROR_INVALID_DATA,
-			     "failed to retrieve from device on ep 0x%02x: %s",
-			     (guint) ep_in,
+			     "failed to send to device on ep 0x%02x: %s",
+			     (guint) FU_EBITDO_USB_BOOTLOADER_EP_OUT,
 			     error_local->message);
 		return FALSE;
 	}
+	return TRUE;
+}
+
+static gboolean
+fu_ebitdo_device_parse_packet (FuEbitdoDevice *self,
+			       const guint8 *packet,
+			       gsize actual_length,
+			       guint8 *out,
+			       gsize out_len,
+			       GError **error)
+{
+	const FuEbitdoPkt *hdr = (const FuEbitdoPkt *) packet;
 
 	/* debug */
-	if (g_getenv ("FWUPD_EBITDO_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_EBITDO_VERBOSE")) {
 		fu_common_dump_raw (G_LOG_DOMAIN, "<-DEVICE", packet, actual_length);
 		fu_ebitdo_dump_pkt (hdr);
 	}
@@ -152,7 +157,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), sizeof(FuEbitdoPkt),	/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, sizeof(FuEbitdoPkt),	/* src */
 					     hdr->payload_len, error))
 				return FALSE;
 		}
@@ -171,7 +176,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), 0x1,			/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, 0x1,			/* src */
 					     4, error))
 				return FALSE;
 		}
@@ -192,7 +197,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), sizeof(FuEbitdoPkt) - 3,	/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, sizeof(FuEbitdoPkt) - 3,	/* src */
 					     hdr->cmd_len, error))
 				return FALSE;
 		}
@@ -222,6 +227,82 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 	return FALSE;
 }
 
+static gboolean
+fu_ebitdo_device_receive (FuEbitdoDevice *self,
+			  guint8 *out,
+			  gsize out_len,
+			  GError **error)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
+	gsize actual_length;
+	guint8 ep_in = fu_ebitdo_device_get_ep_in (self);
+	g_autoptr(GError) error_local = NULL;
+
+	/* get data from device */
+	if (!g_usb_device_interrupt_transfer (usb_device,
+					      ep_in,
+					      packet,
+					      FU_EBITDO_USB_EP_SIZE,
+					      &actual_length,
+					      FU_EBITDO_USB_TIMEOUT,
+					      NULL, /* cancellable */
+					      &error_local)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "failed to retrieve from device on ep 0x%02x: %s",
+			     (guint) ep_in,
+			     error_local->message);
+		return FALSE;
+	}
+	return fu_ebitdo_device_parse_packet (self, packet, actual_length,
+					      out, out_len, error);
+}
+
+static gboolean
+fu_ebitdo_device_queue_ack_cb (FuUsbTransferQueue *queue,
+			       const guint8 *buf,
+			       gsize bufsz,
+			       gsize actual_length,
+			       gpointer user_data,
+			       GError **error)
+{
+	FuEbitdoDevice *self = FU_EBITDO_DEVICE (user_data);
+	return fu_ebitdo_device_parse_packet (self, buf, actual_length, NULL, 0, error);
+}
+
+/* the ACK read is submitted before the request so it is already waiting
+ * on the endpoint when the device replies */
+static gboolean
+fu_ebitdo_device_queue_send_receive (FuEbitdoDevice *self,
+				     FuUsbTransferQueue *queue,
+				     FuEbitdoPktType type,
+				     FuEbitdoPktCmd subtype,
+				     FuEbitdoPktCmd cmd,
+				     const guint8 *in,
+				     gsize in_len,
+				     GError **error)
+{
+	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
+
+	if (!fu_ebitdo_device_build_packet (self, type, subtype, cmd,
+					    in, in_len, packet, error))
+		return FALSE;
+	if (!fu_usb_transfer_queue_add_interrupt (queue,
+						  fu_ebitdo_device_get_ep_in (self),
+						  NULL, FU_EBITDO_USB_EP_SIZE,
+						  fu_ebitdo_device_queue_ack_cb,
+						  self, error))
+		return FALSE;
+	if (!fu_usb_transfer_queue_add_interrupt (queue,
+						  fu_ebitdo_device_get_ep_out (self),
+						  packet, sizeof(packet),
+						  NULL, NULL, error))
+		return FALSE;
+	return fu_usb_transfer_queue_drain (queue, error);
+}
+
 static void
 fu_ebitdo_device_set_version (FuEbitdoDevice *self, guint32 version)
 {
@@ -368,6 +449,7 @@ fu_ebitdo_device_write_firmware (FuDevice *device,
 	g_autoptr(GBytes) fw_payload = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(FuUsbTransferQueue) queue = NULL;
 	const guint32 app_key_index[16] = {
 		0x186976e5, 0xcac67acd, 0x38f27fee, 0x0a4948f1,
 		0xb75b7753, 0x1f8ffa5c, 0xbff8cf43, 0xc4936167,
@@ -446,30 +528,26 @@ fu_ebitdo_device_write_firmware (FuDevice *device,
 	}
 
 	/* flash the firmware in 32 byte blocks */
+	queue = fu_usb_transfer_queue_new (FU_USB_DEVICE (self), 2);
+	fu_usb_transfer_queue_set_timeout (queue, FU_EBITDO_USB_TIMEOUT);
 	chunks = fu_chunk_array_new_from_bytes (fw_payload, 0x0, 0x0, 32);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chunk = g_ptr_array_index (chunks, i);
-		if (g_getenv ("FWUPD_EBITDO_VERBOSE") != NULL) {
+		if (fu_common_is_verbose ("FWUPD_EBITDO_VERBOSE")) {
 			g_debug ("writing %u bytes to 0x%04x of 0x%04x",
 				 chunk->data_sz, chunk->address, chunk->data_sz);
 		}
-		if (!fu_ebitdo_device_send (self,
-					    FU_EBITDO_PKT_TYPE_USER_CMD,
-					    FU_EBITDO_PKT_CMD_UPDATE_FIRMWARE_DATA,
-					    FU_EBITDO_PKT_CMD_FW_UPDATE_DATA,
-					    chunk->data, chunk->data_sz,
-					    error)) {
+		if (!fu_ebitdo_device_queue_send_receive (self, queue,
+							  FU_EBITDO_PKT_TYPE_USER_CMD,
+							  FU_EBITDO_PKT_CMD_UPDATE_FIRMWARE_DATA,
+							  FU_EBITDO_PKT_CMD_FW_UPDATE_DATA,
+							  chunk->data, chunk->data_sz,
+							  error)) {
 			g_prefix_error (error,
 					"failed to write firmware @0x%04x: ",
 					chunk->address);
 			return FALSE;
 		}
-		if (!fu_ebitdo_device_receive (self, NULL, 0, error)) {
-			g_prefix_error (error,
-					"failed to get ACK for write firmware @0x%04x: ",
-					chunk->address);
-			return FALSE;
-		}
 		fu_device_set_progress_full (device, chunk->idx, chunks->len);
 	}
 
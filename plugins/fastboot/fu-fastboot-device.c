@@ -73,7 +73,7 @@ fu_fastboot_device_open (FuUsbDevice *device, GError **error)
 static void
 fu_fastboot_buffer_dump (const gchar *title, const guint8 *buf, gsize sz)
 {
-	if (g_getenv ("FWUPD_FASTBOOT_VERBOSE") == NULL)
+	if (!fu_common_is_verbose ("FWUPD_FASTBOOT_VERBOSE"))
 		return;
 	g_print ("%s (%" G_GSIZE_FORMAT "):\n", title, sz);
 	for (gsize i = 0; i < sz; i++) {
@@ -69,7 +69,7 @@ fu_plugin_flashrom_debug_cb (enum flashrom_log_level lvl, const char *fmt, va_li
 		break;
 	case FLASHROM_MSG_DEBUG:
 	case FLASHROM_MSG_DEBUG2:
-		if (g_getenv ("FWUPD_FLASHROM_VERBOSE") != NULL)
+		if (fu_common_is_verbose ("FWUPD_FLASHROM_VERBOSE"))
 			g_debug ("%s", tmp);
 		break;
 	case FLASHROM_MSG_SPEW:
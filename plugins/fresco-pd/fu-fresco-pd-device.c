@@ -40,7 +40,7 @@ fu_fresco_pd_device_transfer_read (FuFrescoPdDevice *self,
 	g_return_val_if_fail (bufsz != 0, FALSE);
 
 	/* to device */
-	if (g_getenv ("FWUPD_FRESCO_PD_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_FRESCO_PD_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "read", buf, bufsz);
 	if (!g_usb_device_control_transfer (usb_device,
 					    G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
@@ -79,7 +79,7 @@ fu_fresco_pd_device_transfer_write (FuFrescoPdDevice *self,
 	g_return_val_if_fail (bufsz != 0, FALSE);
 
 	/* to device */
-	if (g_getenv ("FWUPD_FRESCO_PD_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_FRESCO_PD_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "write", buf, bufsz);
 	if (!g_usb_device_control_transfer (usb_device,
 					    G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
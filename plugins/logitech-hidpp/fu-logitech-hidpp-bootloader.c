@@ -323,6 +323,60 @@ fu_logitech_hidpp_bootloader_close (FuUsbDevice *device, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_logitech_hidpp_bootloader_response_cb (FuUsbTransferQueue *queue,
+					  const guint8 *buf,
+					  gsize bufsz,
+					  gsize actual_length,
+					  gpointer user_data,
+					  GError **error)
+{
+	GByteArray *response = (GByteArray *) user_data;
+	g_byte_array_append (response, buf, actual_length);
+	return TRUE;
+}
+
+/* the response read is submitted before the request so that it is already
+ * waiting on EP1 when the device replies */
+static gboolean
+fu_logitech_hidpp_bootloader_queue_request (FuLogitechHidPpBootloader *self,
+					    const guint8 *buf_request,
+					    gsize buf_requestsz,
+					    guint8 *buf_response,
+					    gsize buf_responsesz,
+					    gsize *actual_length,
+					    GError **error)
+{
+	g_autoptr(FuUsbTransferQueue) queue = NULL;
+	g_autoptr(GByteArray) response = g_byte_array_new ();
+
+	/* the queue refs the device, so do not keep it around */
+	queue = fu_usb_transfer_queue_new (FU_USB_DEVICE (self), 2);
+	fu_usb_transfer_queue_set_timeout (queue, FU_UNIFYING_DEVICE_TIMEOUT_MS);
+	if (!fu_usb_transfer_queue_add_interrupt (queue,
+						  FU_UNIFYING_DEVICE_EP1,
+						  NULL, buf_responsesz,
+						  fu_logitech_hidpp_bootloader_response_cb,
+						  response, error))
+		return FALSE;
+	if (!fu_hid_device_queue_set_report (FU_HID_DEVICE (self), queue, 0x0,
+					     buf_request, buf_requestsz,
+					     FU_HID_DEVICE_FLAG_NONE,
+					     error)) {
+		g_prefix_error (error, "failed to send data: ");
+		fu_usb_transfer_queue_cancel (queue);
+		fu_usb_transfer_queue_drain (queue, NULL);
+		return FALSE;
+	}
+
+	/* the error says if the request or the response failed */
+	if (!fu_usb_transfer_queue_drain (queue, error))
+		return FALSE;
+	*actual_length = MIN (response->len, buf_responsesz);
+	memcpy (buf_response, response->data, *actual_length);
+	return TRUE;
+}
+
 gboolean
 fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 				      FuLogitechHidPpBootloaderRequest *req,
@@ -349,7 +403,18 @@ fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 		fu_common_dump_raw (G_LOG_DOMAIN, "host->device",
 				    buf_request, sizeof (buf_request));
 	}
-	if (usb_device != NULL) {
+	memset (buf_response, 0x00, sizeof (buf_response));
+	if (usb_device != NULL &&
+	    req->cmd != FU_UNIFYING_BOOTLOADER_CMD_REBOOT) {
+		if (!fu_logitech_hidpp_bootloader_queue_request (self,
+								 buf_request,
+								 sizeof(buf_request),
+								 buf_response,
+								 sizeof(buf_response),
+								 &actual_length,
+								 error))
+			return FALSE;
+	} else if (usb_device != NULL) {
 		if (!fu_hid_device_set_report (FU_HID_DEVICE (self), 0x0,
 					       buf_request, sizeof(buf_request),
 					       FU_UNIFYING_DEVICE_TIMEOUT_MS,
@@ -383,20 +448,7 @@ fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 	}
 
 	/* get response */
-	memset (buf_response, 0x00, sizeof (buf_response));
-	if (usb_device != NULL) {
-		if (!g_usb_device_interrupt_transfer (usb_device,
-						      FU_UNIFYING_DEVICE_EP1,
-						      buf_response,
-						      sizeof (buf_response),
-						      &actual_length,
-						      FU_UNIFYING_DEVICE_TIMEOUT_MS,
-						      NULL,
-						      error)) {
-			g_prefix_error (error, "failed to get data: ");
-			return FALSE;
-		}
-	} else {
+	if (usb_device == NULL) {
 		/* emulated */
 		buf_response[0] = buf_request[0];
 		if (buf_response[0] == FU_UNIFYING_BOOTLOADER_CMD_GET_MEMINFO) {
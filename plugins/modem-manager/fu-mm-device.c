@@ -286,6 +286,26 @@ fu_mm_device_probe (FuDevice *device, GError **error)
 	}
 }
 
+/* the response is the first non-empty line, including the leading CRLF */
+static gboolean
+fu_mm_device_at_frame_cb (const guint8 *buf,
+			  gsize bufsz,
+			  gsize *framesz,
+			  gpointer user_data,
+			  GError **error)
+{
+	gsize i = 0;
+	while (i < bufsz && (buf[i] == '\r' || buf[i] == '\n'))
+		i++;
+	for (; i + 1 < bufsz; i++) {
+		if (buf[i] == '\r' && buf[i + 1] == '\n') {
+			*framesz = i + 2;
+			break;
+		}
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_mm_device_at_cmd (FuMmDevice *self, const gchar *cmd, GError **error)
 {
@@ -297,7 +317,7 @@ fu_mm_device_at_cmd (FuMmDevice *self, const gchar *cmd, GError **error)
 
 	/* command */
 	at_req = g_bytes_new (cmd_cr, strlen (cmd_cr));
-	if (g_getenv ("FWUPD_MODEM_MANAGER_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_MODEM_MANAGER_VERBOSE"))
 		fu_common_dump_bytes (G_LOG_DOMAIN, "writing", at_req);
 	if (!fu_io_channel_write_bytes (self->io_channel, at_req, 1500,
 					FU_IO_CHANNEL_FLAG_FLUSH_INPUT, error)) {
@@ -306,13 +326,14 @@ fu_mm_device_at_cmd (FuMmDevice *self, const gchar *cmd, GError **error)
 	}
 
 	/* response */
-	at_res = fu_io_channel_read_bytes (self->io_channel, -1, 1500,
-					   FU_IO_CHANNEL_FLAG_SINGLE_SHOT, error);
+	at_res = fu_io_channel_read_frame (self->io_channel,
+					   fu_mm_device_at_frame_cb, NULL,
+					   1500, FU_IO_CHANNEL_FLAG_NONE, error);
 	if (at_res == NULL) {
 		g_prefix_error (error, "failed to read response for %s: ", cmd);
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_MODEM_MANAGER_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_MODEM_MANAGER_VERBOSE"))
 		fu_common_dump_bytes (G_LOG_DOMAIN, "read", at_res);
 	buf = g_bytes_get_data (at_res, &bufsz);
 	if (bufsz < 6) {
@@ -119,7 +119,7 @@ fu_nitrokey_device_setup (FuDevice *device, GError **error)
 		g_prefix_error (error, "failed to do get firmware version: ");
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_NITROKEY_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_NITROKEY_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "payload", buf_reply, sizeof(buf_reply));
 	memcpy (&payload, buf_reply, sizeof(payload));
 	version = g_strdup_printf ("%u.%u", payload.VersionMajor, payload.VersionMinor);
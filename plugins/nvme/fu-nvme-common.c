@@ -138,3 +138,19 @@ fu_nvme_status_to_string (guint32 status)
 		return "Unknown";
 	}
 }
+
+/* MDTS is a power of two in units of the minimum memory page size, which we
+ * cannot read from userspace but is 4kB on all known hardware */
+guint32
+fu_nvme_get_transfer_size (guint8 mdts, guint32 granularity)
+{
+	guint32 max_size = FU_NVME_TRANSFER_SIZE_MAX;
+
+	g_return_val_if_fail (granularity > 0, 0);
+
+	if (mdts != 0 && mdts < 12)
+		max_size = MIN (max_size, (guint32) 0x1000 << mdts);
+	if (max_size < granularity)
+		return granularity;
+	return max_size - (max_size % granularity);
+}
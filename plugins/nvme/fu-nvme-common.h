@@ -119,4 +119,9 @@ enum {
 	NVME_SC_DNR			= 0x4000,
 };
 
+/* larger than most controllers support, and well under the kernel limit */
+#define FU_NVME_TRANSFER_SIZE_MAX	0x20000
+
 const gchar	*fu_nvme_status_to_string	(guint32	 status);
+guint32		 fu_nvme_get_transfer_size	(guint8		 mdts,
+						 guint32	 granularity);
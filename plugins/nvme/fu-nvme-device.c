@@ -19,6 +19,8 @@ struct _FuNvmeDevice {
 	FuUdevDevice		 parent_instance;
 	guint			 pci_depth;
 	guint64			 write_block_size;
+	guint8			 mdts;
+	gboolean		 write_block_size_quirk;
 };
 
 G_DEFINE_TYPE (FuNvmeDevice, fu_nvme_device, FU_TYPE_UDEV_DEVICE)
@@ -28,6 +30,7 @@ fu_nvme_device_to_string (FuDevice *device, guint idt, GString *str)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
 	fu_common_string_append_ku (str, idt, "PciDepth", self->pci_depth);
+	fu_common_string_append_ku (str, idt, "Mdts", self->mdts);
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -217,6 +220,9 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 	if (sr != NULL)
 		fu_device_set_version (FU_DEVICE (self), sr);
 
+	/* maximum data transfer size (MDTS) */
+	self->mdts = buf[77];
+
 	/* firmware update granularity (FWUG) */
 	fwug = buf[319];
 	if (fwug != 0x00 && fwug != 0xff)
@@ -249,7 +255,7 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 static void
 fu_nvme_device_dump (const gchar *title, const guint8 *buf, gsize sz)
 {
-	if (g_getenv ("FWPUD_NVME_VERBOSE") == NULL)
+	if (!fu_common_is_verbose ("FWUPD_NVME_VERBOSE"))
 		return;
 	g_print ("%s (%" G_GSIZE_FORMAT "):", title, sz);
 	for (gsize i = 0; i < sz; i++) {
@@ -304,6 +310,25 @@ fu_nvme_device_setup (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_nvme_device_write_chunks (FuNvmeDevice *self, GPtrArray *chunks, GError **error)
+{
+	FuDevice *device = FU_DEVICE (self);
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		if (!fu_nvme_device_fw_download (self,
+						 chk->address,
+						 chk->data,
+						 chk->data_sz,
+						 error)) {
+			g_prefix_error (error, "failed to write chunk %u: ", i);
+			return FALSE;
+		}
+		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_nvme_device_write_firmware (FuDevice *device,
 			       FuFirmware *firmware,
@@ -311,11 +336,13 @@ fu_nvme_device_write_firmware (FuDevice *device,
 			       GError **error)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
-	g_autoptr(GBytes) fw2 = NULL;
+	g_autoptr(FuBytesView) view = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(GError) error_local = NULL;
 	guint64 block_size = self->write_block_size > 0 ?
 			     self->write_block_size : 0x1000;
+	guint64 transfer_size = block_size;
 
 	/* get default image */
 	fw = fu_firmware_get_image_default_bytes (firmware, error);
@@ -324,31 +351,47 @@ fu_nvme_device_write_firmware (FuDevice *device,
 
 	/* some vendors provide firmware files whose sizes are not multiples
 	 * of blksz *and* the device won't accept blocks of different sizes */
-	if (fu_device_has_custom_flag (device, "force-align")) {
-		fw2 = fu_common_bytes_align (fw, block_size, 0xff);
-	} else {
-		fw2 = g_bytes_ref (fw);
-	}
+	view = fu_bytes_view_new_from_bytes (fw);
+	if (fu_device_has_custom_flag (device, "force-align"))
+		fu_bytes_view_align (view, block_size, 0xff);
+
+	/* send as much as the controller accepts in each command, as long as
+	 * it stays a multiple of the update granularity */
+	if (!self->write_block_size_quirk &&
+	    !fu_device_has_custom_flag (device, "force-align") &&
+	    block_size <= G_MAXUINT32)
+		transfer_size = fu_nvme_get_transfer_size (self->mdts, block_size);
+	g_debug ("using transfer size of 0x%x", (guint) transfer_size);
 
 	/* build packets */
-	chunks = fu_chunk_array_new_from_bytes (fw2,
-						0x00,		/* start_addr */
-						0x00,		/* page_sz */
-						block_size);	/* block size */
+	chunks = fu_chunk_array_new_from_bytes_view (view,
+						     0x00,		/* start_addr */
+						     0x00,		/* page_sz */
+						     transfer_size,	/* block size */
+						     error);
+	if (chunks == NULL)
+		return FALSE;
 
 	/* write each block */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_nvme_device_fw_download (self,
-						 chk->address,
-						 chk->data,
-						 chk->data_sz,
-						 error)) {
-			g_prefix_error (error, "failed to write chunk %u: ", i);
+	if (!fu_nvme_device_write_chunks (self, chunks, &error_local)) {
+		if (transfer_size == block_size) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
 			return FALSE;
 		}
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
+
+		/* the kernel may have a lower limit than the controller, and
+		 * an interrupted download is restarted from offset zero */
+		g_debug ("failed with transfer size 0x%x, retrying with 0x%x: %s",
+			 (guint) transfer_size, (guint) block_size,
+			 error_local->message);
+		g_ptr_array_unref (chunks);
+		chunks = fu_chunk_array_new_from_bytes_view (view, 0x00, 0x00,
+							     block_size, error);
+		if (chunks == NULL)
+			return FALSE;
+		if (!fu_nvme_device_write_chunks (self, chunks, error))
+			return FALSE;
 	}
 
 	/* commit */
@@ -375,6 +418,7 @@ fu_nvme_device_set_quirk_kv (FuDevice *device,
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
 	if (g_strcmp0 (key, "NvmeBlockSize") == 0) {
 		self->write_block_size = fu_common_strtoull (value);
+		self->write_block_size_quirk = TRUE;
 		return TRUE;
 	}
 
@@ -394,6 +438,7 @@ fu_nvme_device_init (FuNvmeDevice *self)
 	fu_device_set_summary (FU_DEVICE (self), "NVM Express Solid State Drive");
 	fu_device_add_icon (FU_DEVICE (self), "drive-harddisk");
 	fu_device_set_protocol (FU_DEVICE (self), "org.nvmexpress");
+	fu_device_set_firmware_cacheable (FU_DEVICE (self), TRUE);
 	fu_udev_device_set_flags (FU_UDEV_DEVICE (self),
 				  FU_UDEV_DEVICE_FLAG_OPEN_READ |
 				  FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT);
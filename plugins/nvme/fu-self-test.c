@@ -9,6 +9,7 @@
 #include <fwupd.h>
 
 #include "fu-device-private.h"
+#include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
 static void
@@ -72,6 +73,23 @@ fu_nvme_cns_all_func (void)
 	}
 }
 
+static void
+fu_nvme_transfer_size_func (void)
+{
+	/* no limit reported */
+	g_assert_cmpint (fu_nvme_get_transfer_size (0, 0x1000), ==, FU_NVME_TRANSFER_SIZE_MAX);
+
+	/* limited by MDTS, 2^5 * 4kB */
+	g_assert_cmpint (fu_nvme_get_transfer_size (5, 0x1000), ==, 0x20000);
+	g_assert_cmpint (fu_nvme_get_transfer_size (3, 0x1000), ==, 0x8000);
+
+	/* rounded down to the update granularity */
+	g_assert_cmpint (fu_nvme_get_transfer_size (3, 0x3000), ==, 0x6000);
+
+	/* never smaller than the update granularity */
+	g_assert_cmpint (fu_nvme_get_transfer_size (1, 0x4000), ==, 0x4000);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -83,5 +101,6 @@ main (int argc, char **argv)
 	/* tests go here */
 	g_test_add_func ("/fwupd/cns", fu_nvme_cns_func);
 	g_test_add_func ("/fwupd/cns{all}", fu_nvme_cns_all_func);
+	g_test_add_func ("/fwupd/transfer-size", fu_nvme_transfer_size_func);
 	return g_test_run ();
 }
@@ -153,7 +153,7 @@ fu_solokey_device_packet_tx (FuSolokeyDevice *self, GByteArray *req, GError **er
 		fu_byte_array_append_uint8 (req, 0x0);
 
 	/* request */
-	if (g_getenv ("FWUPD_SOLOKEY_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SOLOKEY_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "REQ", req->data, req->len,
 				     16, FU_DUMP_FLAGS_SHOW_ADDRESSES);
 	}
@@ -209,7 +209,7 @@ fu_solokey_device_packet_rx (FuSolokeyDevice *self, GError **error)
 		g_prefix_error (error, "failed to get reply: ");
 		return NULL;
 	}
-	if (g_getenv ("FWUPD_SOLOKEY_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_SOLOKEY_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "RES", buf, actual_length);
 
 	/* copy back optional buf */
@@ -10,6 +10,7 @@
 #include "fu-superio-device.h"
 
 #define FU_PLUGIN_SUPERIO_TIMEOUT	0.25 /* s */
+#define FU_PLUGIN_SUPERIO_TIMEOUT_MS	250
 
 typedef struct
 {
@@ -32,27 +33,120 @@ enum {
 	PROP_LAST
 };
 
+/* build up a sequence of port operations with the fu_superio_device_ops_*()
+ * helpers, and then send them all at once with fu_superio_device_ops_run() */
+GArray *
+fu_superio_device_ops_new (void)
+{
+	return g_array_new (FALSE, FALSE, sizeof(FuUdevDevicePortOp));
+}
+
+static void
+fu_superio_device_ops_add (GArray *ops,
+			   FuUdevDevicePortOpKind kind,
+			   guint16 port,
+			   guint8 value,
+			   guint8 mask,
+			   guint8 *data)
+{
+	FuUdevDevicePortOp op = {
+		.kind		= kind,
+		.port		= port,
+		.value		= value,
+		.mask		= mask,
+		.data		= data,
+		.timeout	= FU_PLUGIN_SUPERIO_TIMEOUT_MS,
+	};
+	g_array_append_val (ops, op);
+}
+
+void
+fu_superio_device_ops_regval (FuSuperioDevice *self, GArray *ops,
+			      guint8 addr, guint8 *data)
+{
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+				   priv->port, addr, 0x0, NULL);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_READ,
+				   priv->port + 1, 0x0, 0x0, data);
+}
+
+void
+fu_superio_device_ops_regwrite (FuSuperioDevice *self, GArray *ops,
+				guint8 addr, guint8 data)
+{
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+				   priv->port, addr, 0x0, NULL);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+				   priv->port + 1, data, 0x0, NULL);
+}
+
+/* wait for output buffer full, then read the data port */
+void
+fu_superio_device_ops_ec_read (FuSuperioDevice *self, GArray *ops, guint8 *data)
+{
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_POLL,
+				   priv->pm1_iobad1, SIO_STATUS_EC_OBF,
+				   SIO_STATUS_EC_OBF, NULL);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_READ,
+				   priv->pm1_iobad0, 0x0, 0x0, data);
+}
+
+/* wait for input buffer empty, then write the data port */
+void
+fu_superio_device_ops_ec_write0 (FuSuperioDevice *self, GArray *ops, guint8 data)
+{
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_POLL,
+				   priv->pm1_iobad1, 0x0, SIO_STATUS_EC_IBF, NULL);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+				   priv->pm1_iobad0, data, 0x0, NULL);
+}
+
+/* wait for input buffer empty, then write the command port */
+void
+fu_superio_device_ops_ec_write1 (FuSuperioDevice *self, GArray *ops, guint8 data)
+{
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_POLL,
+				   priv->pm1_iobad1, 0x0, SIO_STATUS_EC_IBF, NULL);
+	fu_superio_device_ops_add (ops, FU_UDEV_DEVICE_PORT_OP_KIND_WRITE,
+				   priv->pm1_iobad1, data, 0x0, NULL);
+}
+
+/* sends all the pending operations, and clears @ops for reuse */
+gboolean
+fu_superio_device_ops_run (FuSuperioDevice *self, GArray *ops, GError **error)
+{
+	gboolean ret;
+	ret = fu_udev_device_port_xfer (FU_UDEV_DEVICE (self),
+					(const FuUdevDevicePortOp *) ops->data,
+					ops->len, error);
+	g_array_set_size (ops, 0);
+	return ret;
+}
+
 gboolean
 fu_superio_device_regval (FuSuperioDevice *self, guint8 addr,
 			  guint8 *data, GError **error)
 {
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port, addr, error))
-		return FALSE;
-	if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->port + 1, data, error))
-		return FALSE;
-	return TRUE;
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_regval (self, ops, addr, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 gboolean
 fu_superio_device_regval16 (FuSuperioDevice *self, guint8 addr,
 			    guint16 *data, GError **error)
 {
-	guint8 msb;
-	guint8 lsb;
-	if (!fu_superio_device_regval (self, addr, &msb, error))
-		return FALSE;
-	if (!fu_superio_device_regval (self, addr + 1, &lsb, error))
+	guint8 msb = 0;
+	guint8 lsb = 0;
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_regval (self, ops, addr, &msb);
+	fu_superio_device_ops_regval (self, ops, addr + 1, &lsb);
+	if (!fu_superio_device_ops_run (self, ops, error))
 		return FALSE;
 	*data = ((guint16) msb << 8) | (guint16) lsb;
 	return TRUE;
@@ -62,12 +156,9 @@ gboolean
 fu_superio_device_regwrite (FuSuperioDevice *self, guint8 addr,
 			    guint8 data, GError **error)
 {
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port, addr, error))
-		return FALSE;
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port + 1, data, error))
-		return FALSE;
-	return TRUE;
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_regwrite (self, ops, addr, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 static gboolean
@@ -83,15 +174,16 @@ fu_superio_device_regdump (FuSuperioDevice *self, guint8 ldn, GError **error)
 	guint8 buf[0xff] = { 0x00 };
 	guint16 iobad0 = 0x0;
 	guint16 iobad1 = 0x0;
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
 	g_autoptr(GString) str = g_string_new (NULL);
 
 	/* set LDN */
 	if (!fu_superio_device_set_ldn (self, ldn, error))
 		return FALSE;
-	for (guint i = 0x00; i < 0xff; i++) {
-		if (!fu_superio_device_regval (self, i, &buf[i], error))
-			return FALSE;
-	}
+	for (guint i = 0x00; i < 0xff; i++)
+		fu_superio_device_ops_regval (self, ops, i, &buf[i]);
+	if (!fu_superio_device_ops_run (self, ops, error))
+		return FALSE;
 
 	/* get the i/o base addresses */
 	if (!fu_superio_device_regval16 (self, SIO_LDNxx_IDX_IOBAD0, &iobad0, error))
@@ -143,54 +235,28 @@ fu_superio_device_check_id (FuSuperioDevice *self, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_superio_device_wait_for (FuSuperioDevice *self, guint8 mask, gboolean set, GError **error)
-{
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	g_autoptr(GTimer) timer = g_timer_new ();
-	do {
-		guint8 status = 0x00;
-		if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad1, &status, error))
-			return FALSE;
-		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT)
-			break;
-		if (set && (status & mask) != 0)
-			return TRUE;
-		if (!set && (status & mask) == 0)
-			return TRUE;
-	} while (TRUE);
-	g_set_error (error,
-		     G_IO_ERROR,
-		     G_IO_ERROR_TIMED_OUT,
-		     "timed out whilst waiting for 0x%02x:%i", mask, set);
-	return FALSE;
-}
-
 gboolean
 fu_superio_device_ec_read (FuSuperioDevice *self, guint8 *data, GError **error)
 {
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_OBF, TRUE, error))
-		return FALSE;
-	return fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad0, data, error);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_ec_read (self, ops, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 gboolean
 fu_superio_device_ec_write0 (FuSuperioDevice *self, guint8 data, GError **error)
 {
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_IBF, FALSE, error))
-		return FALSE;
-	return fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->pm1_iobad0, data, error);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_ec_write0 (self, ops, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 gboolean
 fu_superio_device_ec_write1 (FuSuperioDevice *self, guint8 data, GError **error)
 {
-	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_IBF, FALSE, error))
-		return FALSE;
-	return fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->pm1_iobad1, data, error);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_ec_write1 (self, ops, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 static gboolean
@@ -221,11 +287,11 @@ fu_superio_device_ec_flush (FuSuperioDevice *self, GError **error)
 gboolean
 fu_superio_device_ec_get_param (FuSuperioDevice *self, guint8 param, guint8 *data, GError **error)
 {
-	if (!fu_superio_device_ec_write1 (self, SIO_CMD_EC_READ, error))
-		return FALSE;
-	if (!fu_superio_device_ec_write0 (self, param, error))
-		return FALSE;
-	return fu_superio_device_ec_read (self, data, error);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_CMD_EC_READ);
+	fu_superio_device_ops_ec_write0 (self, ops, param);
+	fu_superio_device_ops_ec_read (self, ops, data);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 #if 0
@@ -271,7 +337,7 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 	}
 
 	/* dump LDNs */
-	if (g_getenv ("FWUPD_SUPERIO_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SUPERIO_VERBOSE")) {
 		for (guint j = 0; j < SIO_LDN_LAST; j++) {
 			if (!fu_superio_device_regdump (self, j, error))
 				return FALSE;
@@ -299,7 +365,7 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 	}
 
 	/* dump PMC register map */
-	if (g_getenv ("FWUPD_SUPERIO_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SUPERIO_VERBOSE")) {
 		guint8 buf[0xff] = { 0x00 };
 		for (guint i = 0x00; i < 0xff; i++) {
 			g_autoptr(GError) error_local = NULL;
@@ -394,6 +460,10 @@ static void
 fu_superio_device_init (FuSuperioDevice *self)
 {
 	fu_device_set_physical_id (FU_DEVICE (self), "/dev/port");
+	fu_udev_device_set_flags (FU_UDEV_DEVICE (self),
+				  FU_UDEV_DEVICE_FLAG_OPEN_READ |
+				  FU_UDEV_DEVICE_FLAG_OPEN_WRITE |
+				  FU_UDEV_DEVICE_FLAG_IOPERM);
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_INTERNAL);
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE);
 	fu_device_set_protocol (FU_DEVICE (self), "tw.com.ite.superio");
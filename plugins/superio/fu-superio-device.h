@@ -43,3 +43,25 @@ gboolean	 fu_superio_device_regwrite	(FuSuperioDevice	*self,
 						 guint8			 addr,
 						 guint8			 data,
 						 GError			**error);
+
+GArray		*fu_superio_device_ops_new	(void);
+void		 fu_superio_device_ops_regval	(FuSuperioDevice	*self,
+						 GArray			*ops,
+						 guint8			 addr,
+						 guint8			*data);
+void		 fu_superio_device_ops_regwrite	(FuSuperioDevice	*self,
+						 GArray			*ops,
+						 guint8			 addr,
+						 guint8			 data);
+void		 fu_superio_device_ops_ec_read	(FuSuperioDevice	*self,
+						 GArray			*ops,
+						 guint8			*data);
+void		 fu_superio_device_ops_ec_write0 (FuSuperioDevice	*self,
+						 GArray			*ops,
+						 guint8			 data);
+void		 fu_superio_device_ops_ec_write1 (FuSuperioDevice	*self,
+						 GArray			*ops,
+						 guint8			 data);
+gboolean	 fu_superio_device_ops_run	(FuSuperioDevice	*self,
+						 GArray			*ops,
+						 GError			**error);
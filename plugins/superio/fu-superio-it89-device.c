@@ -22,34 +22,26 @@ fu_superio_it89_device_read_ec_register (FuSuperioDevice *self,
 					 guint8 *outval,
 					 GError **error)
 {
-	if (!fu_superio_device_regwrite (self,
-					 SIO_LDNxx_IDX_D2ADR,
-					 SIO_DEPTH2_I2EC_ADDRH,
-					 error))
-		return FALSE;
-	if (!fu_superio_device_regwrite (self,
-					 SIO_LDNxx_IDX_D2DAT,
-					 addr >> 8,
-					 error))
-		return FALSE;
-	if (!fu_superio_device_regwrite (self,
-					 SIO_LDNxx_IDX_D2ADR,
-					 SIO_DEPTH2_I2EC_ADDRL,
-					 error))
-		return FALSE;
-	if (!fu_superio_device_regwrite (self,
-					 SIO_LDNxx_IDX_D2DAT,
-					 addr & 0xff, error))
-		return FALSE;
-	if (!fu_superio_device_regwrite (self,
-					 SIO_LDNxx_IDX_D2ADR,
-					 SIO_DEPTH2_I2EC_DATA,
-					 error))
-		return FALSE;
-	return fu_superio_device_regval (self,
-					 SIO_LDNxx_IDX_D2DAT,
-					 outval,
-					 error);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+	fu_superio_device_ops_regwrite (self, ops,
+					SIO_LDNxx_IDX_D2ADR,
+					SIO_DEPTH2_I2EC_ADDRH);
+	fu_superio_device_ops_regwrite (self, ops,
+					SIO_LDNxx_IDX_D2DAT,
+					addr >> 8);
+	fu_superio_device_ops_regwrite (self, ops,
+					SIO_LDNxx_IDX_D2ADR,
+					SIO_DEPTH2_I2EC_ADDRL);
+	fu_superio_device_ops_regwrite (self, ops,
+					SIO_LDNxx_IDX_D2DAT,
+					addr & 0xff);
+	fu_superio_device_ops_regwrite (self, ops,
+					SIO_LDNxx_IDX_D2ADR,
+					SIO_DEPTH2_I2EC_DATA);
+	fu_superio_device_ops_regval (self, ops,
+				      SIO_LDNxx_IDX_D2DAT,
+				      outval);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 static gboolean
@@ -121,115 +113,106 @@ fu_superio_it89_device_setup (FuSuperioDevice *self, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_superio_it89_device_ec_pm1do_sci (FuSuperioDevice *self, guint8 val, GError **error)
+/* the operations are only queued in @ops, which is run by the caller */
+static void
+fu_superio_it89_device_ec_pm1do_sci (FuSuperioDevice *self, GArray *ops, guint8 val)
 {
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DOSCI, error))
-		return FALSE;
-	if (!fu_superio_device_ec_write1 (self, val, error))
-		return FALSE;
-	return TRUE;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DOSCI);
+	fu_superio_device_ops_ec_write1 (self, ops, val);
 }
 
-static gboolean
-fu_superio_it89_device_ec_pm1do_smi (FuSuperioDevice *self, guint8 val, GError **error)
+static void
+fu_superio_it89_device_ec_pm1do_smi (FuSuperioDevice *self, GArray *ops, guint8 val)
 {
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DOCMI, error))
-		return FALSE;
-	if (!fu_superio_device_ec_write1 (self, val, error))
-		return FALSE;
-	return TRUE;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DOCMI);
+	fu_superio_device_ops_ec_write1 (self, ops, val);
 }
 
+static void
+fu_superio_it89_device_ec_pm1do_addr (FuSuperioDevice *self, GArray *ops, guint32 addr)
+{
+	/* MSB, MID, LSB */
+	fu_superio_it89_device_ec_pm1do_smi (self, ops, addr >> 16);
+	fu_superio_it89_device_ec_pm1do_smi (self, ops, addr >> 8);
+	fu_superio_it89_device_ec_pm1do_smi (self, ops, addr & 0xff);
+}
+
+/* sends SPI command @cmd and then polls the result until the bits in @mask
+ * are @value -- the pending operations in @ops are sent first, and the final
+ * write to watch SCI events is left queued in @ops */
 static gboolean
-fu_superio_device_ec_read_status (FuSuperioDevice *self, GError **error)
+fu_superio_it89_device_ec_wait_status (FuSuperioDevice *self,
+				       GArray *ops,
+				       guint8 cmd,
+				       guint8 mask,
+				       guint8 value,
+				       GError **error)
 {
 	guint8 tmp = 0x00;
 
-	/* read status register */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_RDSR, error))
-		return FALSE;
-
-	/* wait for write */
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, cmd);
 	do {
-		if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DI, error))
-			return FALSE;
-		if (!fu_superio_device_ec_read (self, &tmp, error))
+		fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DI);
+		fu_superio_device_ops_ec_read (self, ops, &tmp);
+		if (!fu_superio_device_ops_run (self, ops, error))
 			return FALSE;
-	} while ((tmp & SIO_STATUS_EC_OBF) != 0);
+	} while ((tmp & mask) != value);
 
 	/* watch SCI events */
-	return fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DISCI, error);
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DISCI);
+	return TRUE;
 }
 
 static gboolean
-fu_superio_device_ec_write_disable (FuSuperioDevice *self, GError **error)
+fu_superio_device_ec_read_status (FuSuperioDevice *self, GArray *ops, GError **error)
 {
-	guint8 tmp = 0x00;
+	/* read status register, and wait for write */
+	return fu_superio_it89_device_ec_wait_status (self, ops,
+						      SIO_SPI_CMD_RDSR,
+						      SIO_STATUS_EC_OBF, 0x0,
+						      error);
+}
 
+static gboolean
+fu_superio_device_ec_write_disable (FuSuperioDevice *self, GArray *ops, GError **error)
+{
 	/* read existing status */
-	if (!fu_superio_device_ec_read_status (self, error))
+	if (!fu_superio_device_ec_read_status (self, ops, error))
 		return FALSE;
 
 	/* write disable */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_WRDI, error))
-		return FALSE;
-
-	/* read status register */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_RDSR, error))
-		return FALSE;
-
-	/* wait for read */
-	do {
-		if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DI, error))
-			return FALSE;
-		if (!fu_superio_device_ec_read (self, &tmp, error))
-			return FALSE;
-	} while ((tmp & SIO_STATUS_EC_IBF) != 0);
-
-	/* watch SCI events */
-	return fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DISCI, error);
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_WRDI);
+
+	/* read status register, and wait for read */
+	return fu_superio_it89_device_ec_wait_status (self, ops,
+						      SIO_SPI_CMD_RDSR,
+						      SIO_STATUS_EC_IBF, 0x0,
+						      error);
 }
 
 static gboolean
-fu_superio_device_ec_write_enable (FuSuperioDevice *self, GError **error)
+fu_superio_device_ec_write_enable (FuSuperioDevice *self, GArray *ops, GError **error)
 {
-	guint8 tmp = 0x0;
-
 	/* read existing status */
-	if (!fu_superio_device_ec_read_status (self, error))
+	if (!fu_superio_device_ec_read_status (self, ops, error))
 		return FALSE;
 
 	/* write enable */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_WREN, error))
-		return FALSE;
-
-	/* read status register */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_RDSR, error))
-		return FALSE;
-
-	/* wait for !BUSY */
-	do {
-		if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DI, error))
-			return FALSE;
-		if (!fu_superio_device_ec_read (self, &tmp, error))
-			return FALSE;
-	} while ((tmp & 3) != SIO_STATUS_EC_IBF);
-
-	/* watch SCI events */
-	return fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DISCI, error);
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_WREN);
+
+	/* read status register, and wait for !BUSY */
+	return fu_superio_it89_device_ec_wait_status (self, ops,
+						      SIO_SPI_CMD_RDSR,
+						      0x3, SIO_STATUS_EC_IBF,
+						      error);
 }
 
+/* the number of bytes read in each batch, so progress can be updated */
+#define FU_SUPERIO_IT89_READ_BLOCK	0x100
+
 static GBytes *
 fu_superio_it89_device_read_addr (FuSuperioDevice *self,
 				  guint32 addr,
@@ -238,37 +221,30 @@ fu_superio_it89_device_read_addr (FuSuperioDevice *self,
 				  GError **error)
 {
 	g_autofree guint8 *buf = NULL;
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
 
 	/* check... */
-	if (!fu_superio_device_ec_write_disable (self, error))
+	if (!fu_superio_device_ec_write_disable (self, ops, error))
 		return NULL;
-	if (!fu_superio_device_ec_read_status (self, error))
+	if (!fu_superio_device_ec_read_status (self, ops, error))
 		return NULL;
 
 	/* high speed read */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return NULL;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_HS_READ, error))
-		return NULL;
-
-	/* set address, MSB, MID, LSB */
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 16, error))
-		return NULL;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 8, error))
-		return NULL;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr & 0xff, error))
-		return NULL;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_HS_READ);
+	fu_superio_it89_device_ec_pm1do_addr (self, ops, addr);
 
 	/* padding for HS? */
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, 0x0, error))
-		return NULL;
+	fu_superio_it89_device_ec_pm1do_smi (self, ops, 0x0);
 
 	/* read out data */
 	buf = g_malloc0 (size);
 	for (guint i = 0; i < size; i++) {
-		if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DI, error))
-			return NULL;
-		if (!fu_superio_device_ec_read (self, &buf[i], error))
+		fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DI);
+		fu_superio_device_ops_ec_read (self, ops, &buf[i]);
+		if ((i + 1) % FU_SUPERIO_IT89_READ_BLOCK != 0 && i + 1 != size)
+			continue;
+		if (!fu_superio_device_ops_run (self, ops, error))
 			return NULL;
 
 		/* update progress */
@@ -277,7 +253,9 @@ fu_superio_it89_device_read_addr (FuSuperioDevice *self,
 	}
 
 	/* check again... */
-	if (!fu_superio_device_ec_read_status (self, error))
+	if (!fu_superio_device_ec_read_status (self, ops, error))
+		return NULL;
+	if (!fu_superio_device_ops_run (self, ops, error))
 		return NULL;
 
 	/* success */
@@ -296,6 +274,7 @@ fu_superio_it89_device_write_addr (FuSuperioDevice *self, guint addr, GBytes *fw
 {
 	gsize size = 0;
 	const guint8 *buf = g_bytes_get_data (fw, &size);
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
 
 	/* sanity check */
 	if ((addr & 0xff) != 0x00) {
@@ -314,72 +293,55 @@ fu_superio_it89_device_write_addr (FuSuperioDevice *self, guint addr, GBytes *fw
 	}
 
 	/* enable writes */
-	if (!fu_superio_device_ec_write_enable (self, error))
+	if (!fu_superio_device_ec_write_enable (self, ops, error))
 		return FALSE;
 
 	/* write DWORDs */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_WRITE_WORD, error))
-		return FALSE;
-
-	/* set address, MSB, MID, LSB */
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 16, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 8, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr & 0xff, error))
-		return FALSE;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_WRITE_WORD);
+	fu_superio_it89_device_ec_pm1do_addr (self, ops, addr);
 
-	/* write data two bytes at a time */
+	/* write data two bytes at a time, sending each word along with the
+	 * status read that has to complete before the next one */
 	for (guint i = 0; i < size; i += 2) {
 		if (i > 0) {
-			if (!fu_superio_device_ec_read_status (self, error))
-				return FALSE;
-			if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-				return FALSE;
-			if (!fu_superio_it89_device_ec_pm1do_sci (self,
-								  SIO_SPI_CMD_WRITE_WORD,
-								  error))
+			if (!fu_superio_device_ec_read_status (self, ops, error))
 				return FALSE;
+			fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+			fu_superio_it89_device_ec_pm1do_sci (self, ops,
+							     SIO_SPI_CMD_WRITE_WORD);
 		}
-		if (!fu_superio_it89_device_ec_pm1do_smi (self, buf[i+0], error))
-			return FALSE;
-		if (!fu_superio_it89_device_ec_pm1do_smi (self, buf[i+1], error))
-			return FALSE;
+		fu_superio_it89_device_ec_pm1do_smi (self, ops, buf[i+0]);
+		fu_superio_it89_device_ec_pm1do_smi (self, ops, buf[i+1]);
 	}
 
 	/* reset back? */
-	if (!fu_superio_device_ec_write_disable (self, error))
+	if (!fu_superio_device_ec_write_disable (self, ops, error))
 		return FALSE;
-	return fu_superio_device_ec_read_status (self, error);
+	if (!fu_superio_device_ec_read_status (self, ops, error))
+		return FALSE;
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 static gboolean
 fu_superio_it89_device_erase_addr (FuSuperioDevice *self, guint addr, GError **error)
 {
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+
 	/* enable writes */
-	if (!fu_superio_device_ec_write_enable (self, error))
+	if (!fu_superio_device_ec_write_enable (self, ops, error))
 		return FALSE;
 
 	/* sector erase */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_4K_SECTOR_ERASE, error))
-		return FALSE;
-
-	/* set address, MSB, MID, LSB */
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 16, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr >> 8, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_smi (self, addr & 0xff, error))
-		return FALSE;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_4K_SECTOR_ERASE);
+	fu_superio_it89_device_ec_pm1do_addr (self, ops, addr);
 
 	/* watch SCI events */
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DISCI, error))
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DISCI);
+	if (!fu_superio_device_ec_read_status (self, ops, error))
 		return FALSE;
-	return fu_superio_device_ec_read_status (self, error);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 /* The 14th byte of the 16 byte signature is always read from the hardware as
@@ -571,24 +533,23 @@ fu_superio_it89_device_write_chunk (FuSuperioDevice *self, FuChunk *chk, GError
 static gboolean
 fu_superio_it89_device_get_jedec_id (FuSuperioDevice *self, guint8 *id, GError **error)
 {
+	g_autoptr(GArray) ops = fu_superio_device_ops_new ();
+
 	/* read status register */
-	if (!fu_superio_device_ec_read_status (self, error))
-		return FALSE;
-	if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DO, error))
-		return FALSE;
-	if (!fu_superio_it89_device_ec_pm1do_sci (self, SIO_SPI_CMD_JEDEC_ID, error))
+	if (!fu_superio_device_ec_read_status (self, ops, error))
 		return FALSE;
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DO);
+	fu_superio_it89_device_ec_pm1do_sci (self, ops, SIO_SPI_CMD_JEDEC_ID);
 
 	/* wait for reads */
 	for (guint i = 0; i < 4; i++) {
-		if (!fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DI, error))
-			return FALSE;
-		if (!fu_superio_device_ec_read (self, &id[i], error))
-			return FALSE;
+		fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DI);
+		fu_superio_device_ops_ec_read (self, ops, &id[i]);
 	}
 
 	/* watch SCI events */
-	return fu_superio_device_ec_write1 (self, SIO_EC_PMC_PM1DISCI, error);
+	fu_superio_device_ops_ec_write1 (self, ops, SIO_EC_PMC_PM1DISCI);
+	return fu_superio_device_ops_run (self, ops, error);
 }
 
 static gboolean
@@ -86,7 +86,7 @@ fu_synaprom_device_cmd_send (FuSynapromDevice *device,
 	gboolean ret;
 	gsize actual_len = 0;
 
-	if (g_getenv ("FWUPD_SYNAPROM_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPROM_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "REQST",
 				     request->data, request->len, 16,
 				     FU_DUMP_FLAGS_SHOW_ADDRESSES);
@@ -120,7 +120,7 @@ fu_synaprom_device_cmd_send (FuSynapromDevice *device,
 		g_prefix_error (error, "failed to reply: ");
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_SYNAPROM_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPROM_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "REPLY",
 				     reply->data, actual_len, 16,
 				     FU_DUMP_FLAGS_SHOW_ADDRESSES);
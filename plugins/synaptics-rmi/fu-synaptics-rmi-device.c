@@ -184,7 +184,7 @@ fu_synaptics_rmi_device_read (FuSynapticsRmiDevice *self, guint16 addr, gsize re
 	/* request */
 	for (guint j = req->len; j < 21; j++)
 		fu_byte_array_append_uint8 (req, 0x0);
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "ReportWrite",
 				     req->data, req->len,
 				     80, FU_DUMP_FLAGS_NONE);
@@ -211,7 +211,7 @@ fu_synaptics_rmi_device_read (FuSynapticsRmiDevice *self, guint16 addr, gsize re
 					     "response zero sized");
 			return NULL;
 		}
-		if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+		if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 			fu_common_dump_full (G_LOG_DOMAIN, "ReportRead",
 					     res->data, res->len,
 					     80, FU_DUMP_FLAGS_NONE);
@@ -252,7 +252,7 @@ fu_synaptics_rmi_device_read (FuSynapticsRmiDevice *self, guint16 addr, gsize re
 				     input_count_sz);
 
 	}
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "DeviceRead", buf->data, buf->len,
 				     80, FU_DUMP_FLAGS_NONE);
 	}
@@ -295,7 +295,7 @@ fu_synaptics_rmi_device_write (FuSynapticsRmiDevice *self, guint16 addr, GByteAr
 	/* pad out to 21 bytes for some reason */
 	for (guint i = buf->len; i < 21; i++)
 		fu_byte_array_append_uint8 (buf, 0x0);
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "DeviceWrite", buf->data, buf->len,
 				     80, FU_DUMP_FLAGS_NONE);
 	}
@@ -375,7 +375,7 @@ fu_synaptics_rmi_device_scan_pdt (FuSynapticsRmiDevice *self, GError **error)
 	}
 
 	/* for debug */
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 		for (guint i = 0; i < priv->functions->len; i++) {
 			FuSynapticsRmiFunction *func = g_ptr_array_index (priv->functions, i);
 			g_debug ("PDT-%02u fn:0x%02x vr:%d sc:%d ms:0x%x "
@@ -405,7 +405,7 @@ fu_synaptics_rmi_device_set_mode (FuSynapticsRmiDevice *self,
 				  GError **error)
 {
 	const guint8 data[] = { 0x0f, mode };
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "SetMode", data, sizeof(data));
 	return fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
 				     HIDIOCSFEATURE(sizeof(data)), (guint8 *) data,
@@ -748,7 +748,7 @@ fu_synaptics_rmi_device_wait_for_attr (FuSynapticsRmiDevice *self,
 			g_propagate_error (error, g_steal_pointer (&error_local));
 			return FALSE;
 		}
-		if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+		if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 			fu_common_dump_full (G_LOG_DOMAIN, "ReportRead",
 					     res->data, res->len,
 					     80, FU_DUMP_FLAGS_NONE);
@@ -473,7 +473,7 @@ fu_synaptics_rmi_device_read_flash_config_v7 (FuSynapticsRmiDevice *self, GError
 	}
 
 	/* debugging */
-	if (g_getenv ("FWUPD_SYNAPTICS_RMI_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_SYNAPTICS_RMI_VERBOSE")) {
 		fu_common_dump_full (G_LOG_DOMAIN, "FlashConfig", res->data, res->len,
 				     80, FU_DUMP_FLAGS_NONE);
 	}
@@ -28,10 +28,42 @@ fu_plugin_destroy (FuPlugin *plugin)
 	g_debug ("destroy");
 }
 
+/* used by fwupd-bench, with a GUID count similar to a real USB device */
+static gboolean
+fu_plugin_test_coldplug_bench (FuPlugin *plugin, GError **error)
+{
+	guint64 devices = fu_common_strtoull (g_getenv ("FWUPD_PLUGIN_TEST_DEVICES"));
+	for (guint i = 0; i < devices; i++) {
+		g_autofree gchar *id = g_strdup_printf ("BenchDevice%04X", i);
+		g_autofree gchar *devid0 = g_strdup_printf ("BENCH\\VEN_%04X", i % 0x10);
+		g_autofree gchar *devid1 = g_strdup_printf ("BENCH\\VEN_%04X&DEV_%04X", i % 0x10, i);
+		g_autofree gchar *devid2 = g_strdup_printf ("BENCH\\VEN_%04X&DEV_%04X&REV_01", i % 0x10, i);
+		g_autoptr(FuDevice) device = fu_device_new ();
+		fu_device_set_quirks (device, fu_plugin_get_quirks (plugin));
+		fu_device_set_id (device, id);
+		fu_device_set_name (device, "Bench Device");
+		fu_device_set_vendor_id (device, "USB:0xFFFF");
+		fu_device_set_protocol (device, "com.acme.test");
+		fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version (device, "1.2.2");
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_add_instance_id_full (device, devid0,
+						FU_DEVICE_INSTANCE_FLAG_ONLY_QUIRKS);
+		fu_device_add_instance_id (device, devid1);
+		fu_device_add_instance_id (device, devid2);
+		fu_plugin_device_add (plugin, device);
+	}
+	return TRUE;
+}
+
 gboolean
 fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 {
 	g_autoptr(FuDevice) device = NULL;
+
+	if (g_strcmp0 (g_getenv ("FWUPD_PLUGIN_TEST"), "bench") == 0)
+		return fu_plugin_test_coldplug_bench (plugin, error);
+
 	device = fu_device_new ();
 	fu_device_set_id (device, "FakeDevice");
 	fu_device_add_guid (device, "b585990a-003e-5270-89d5-3705a17f9a43");
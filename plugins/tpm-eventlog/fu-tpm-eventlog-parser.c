@@ -175,7 +175,7 @@ fu_tpm_eventlog_parser_parse_blob_v2 (const guint8 *buf, gsize bufsz,
 				return NULL;
 
 			/* not normally required */
-			if (g_getenv ("FWUPD_TPM_EVENTLOG_VERBOSE") != NULL) {
+			if (fu_common_is_verbose ("FWUPD_TPM_EVENTLOG_VERBOSE")) {
 				fu_common_dump_full (G_LOG_DOMAIN, "Event Data",
 						     data, datasz, 20,
 						     FU_DUMP_FLAGS_SHOW_ASCII);
@@ -266,7 +266,7 @@ fu_tpm_eventlog_parser_new (const guint8 *buf, gsize bufsz,
 			g_ptr_array_add (items, item);
 
 			/* not normally required */
-			if (g_getenv ("FWUPD_TPM_EVENTLOG_VERBOSE") != NULL)
+			if (fu_common_is_verbose ("FWUPD_TPM_EVENTLOG_VERBOSE"))
 				fu_common_dump_bytes (G_LOG_DOMAIN, "Event Data", item->blob);
 		}
 		idx += datasz;
@@ -11,6 +11,7 @@
 #include <gio/gunixmounts.h>
 #include <glib/gi18n.h>
 
+#include "fu-crc.h"
 #include "fu-device-metadata.h"
 #include "fu-plugin-vfuncs.h"
 #include "fu-hash.h"
@@ -162,15 +163,6 @@ fu_plugin_uefi_get_splash_data (guint width, guint height, GError **error)
 	return g_bytes_new_take (g_steal_pointer (&buf), buf_idx);
 }
 
-static guint8
-fu_plugin_uefi_calc_checksum (const guint8 *buf, gsize sz)
-{
-	guint8 csum = 0;
-	for (gsize i = 0; i < sz; i++)
-		csum += buf[i];
-	return csum;
-}
-
 static gboolean
 fu_plugin_uefi_write_splash_data (FuPlugin *plugin,
 				  FuDevice *device,
@@ -231,12 +223,9 @@ fu_plugin_uefi_write_splash_data (FuPlugin *plugin,
 				fu_uefi_bgrt_get_height (data->bgrt);
 
 	/* header, payload and image has to add to zero */
-	csum += fu_plugin_uefi_calc_checksum ((guint8 *) &capsule_header,
-					      sizeof(capsule_header));
-	csum += fu_plugin_uefi_calc_checksum ((guint8 *) &header,
-					      sizeof(header));
-	csum += fu_plugin_uefi_calc_checksum (g_bytes_get_data (blob, NULL),
-					      g_bytes_get_size (blob));
+	csum += fu_sum8 ((guint8 *) &capsule_header, sizeof(capsule_header));
+	csum += fu_sum8 ((guint8 *) &header, sizeof(header));
+	csum += fu_sum8 (g_bytes_get_data (blob, NULL), g_bytes_get_size (blob));
 	header.checksum = 0x100 - csum;
 
 	/* write capsule file */
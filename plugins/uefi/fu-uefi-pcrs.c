@@ -111,7 +111,7 @@ fu_uefi_pcrs_setup_tpm20 (FuUefiPcrs *self, GError **error)
 	g_autofree TPML_DIGEST *pcr_values = NULL;
 
 	/* suppress warning messages about missing TCTI libraries for tpm2-tss <2.3 */
-	if (g_getenv ("FWUPD_UEFI_VERBOSE") == NULL) {
+	if (!fu_common_is_verbose ("FWUPD_UEFI_VERBOSE")) {
 		g_setenv ("TSS2_LOG", "esys+error,tcti+none", FALSE);
 	}
 
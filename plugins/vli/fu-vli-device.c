@@ -172,31 +172,55 @@ fu_vli_device_spi_write_data (FuVliDevice *self, guint32 addr,
 	return TRUE;
 }
 
+/* the status has to stay idle for this long to debounce it */
+#define FU_VLI_DEVICE_SPI_CONFIRM_DELAY	1000	/* ms */
+
 static gboolean
-fu_vli_device_spi_wait_finish (FuVliDevice *self, GError **error)
+fu_vli_device_spi_wait_finish_cb (FuDevice *device, gpointer user_data, GError **error)
 {
-	const guint32 rdy_cnt = 2;
-	guint32 cnt = 0;
-
-	for (guint32 idx = 0; idx < 1000; idx++) {
-		guint8 status = 0x7f;
+	FuVliDevice *self = FU_VLI_DEVICE (device);
+	gint64 *idle_since = (gint64 *) user_data;
+	gint64 now;
+	guint8 status = 0x7f;
 
-		/* must get bit[1:0] == 0 twice in a row for success */
-		if (!fu_vli_device_spi_read_status (self, &status, error))
-			return FALSE;
-		if ((status & 0x03) == 0x00) {
-			if (cnt++ >= rdy_cnt)
-				return TRUE;
-		} else {
-			cnt = 0;
-		}
-		g_usleep (500 * 1000);
+	/* must get bit[1:0] == 0 for every read in the confirm window */
+	if (!fu_vli_device_spi_read_status (self, &status, error))
+		return FALSE;
+	now = g_get_monotonic_time ();
+	if ((status & 0x03) != 0x00) {
+		*idle_since = 0;
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_BUSY,
+			     "SPI busy, status 0x%02x", status);
+		return FALSE;
 	}
-	g_set_error (error,
-		     G_IO_ERROR,
-		     G_IO_ERROR_FAILED,
-		     "failed to wait for SPI");
-	return FALSE;
+	if (*idle_since == 0)
+		*idle_since = now;
+	if (now - *idle_since < FU_VLI_DEVICE_SPI_CONFIRM_DELAY * 1000) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_BUSY,
+			     "SPI idle for %" G_GINT64_FORMAT "ms",
+			     (now - *idle_since) / 1000);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_vli_device_spi_wait_finish_full (FuVliDevice *self, guint timeout_ms, GError **error)
+{
+	gint64 idle_since = 0;
+	return fu_device_wait_for (FU_DEVICE (self),
+				   fu_vli_device_spi_wait_finish_cb,
+				   timeout_ms, &idle_since, error);
+}
+
+static gboolean
+fu_vli_device_spi_wait_finish (FuVliDevice *self, GError **error)
+{
+	return fu_vli_device_spi_wait_finish_full (self, 500 * 1000, error);
 }
 
 gboolean
@@ -296,7 +320,7 @@ fu_vli_device_spi_write_block (FuVliDevice *self,
 	}
 
 	/* write */
-	if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_VLI_USBHUB_VERBOSE"))
 		g_debug ("writing 0x%x block @0x%x", (guint) bufsz, address);
 	if (!fu_vli_device_spi_write_enable (self, error)) {
 		g_prefix_error (error, "enabling SPI write failed: ");
@@ -370,7 +394,10 @@ fu_vli_device_spi_erase_all (FuVliDevice *self, GError **error)
 		return FALSE;
 	if (!fu_vli_device_spi_chip_erase (self, error))
 		return FALSE;
-	g_usleep (4 * G_USEC_PER_SEC);
+	if (!fu_vli_device_spi_wait_finish_full (self, 10 * 1000, error)) {
+		g_prefix_error (error, "failed to wait for chip erase: ");
+		return FALSE;
+	}
 
 	/* verify chip was erased */
 	for (guint addr = 0; addr < 0x10000; addr += 0x1000) {
@@ -401,7 +428,7 @@ fu_vli_device_spi_erase (FuVliDevice *self, guint32 addr, gsize sz, GError **err
 	g_debug ("erasing 0x%x bytes @0x%x", (guint) sz, addr);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chunk = g_ptr_array_index (chunks, i);
-		if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
+		if (fu_common_is_verbose ("FWUPD_VLI_USBHUB_VERBOSE"))
 			g_debug ("erasing @0x%x", chunk->address);
 		if (!fu_vli_device_spi_erase_sector (FU_VLI_DEVICE (self), chunk->address, error)) {
 			g_prefix_error (error,
@@ -509,7 +536,7 @@ fu_vli_device_spi_read_flash_id (FuVliDevice *self, GError **error)
 		g_prefix_error (error, "failed to read chip ID: ");
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
+	if (fu_common_is_verbose ("FWUPD_VLI_USBHUB_VERBOSE"))
 		fu_common_dump_raw (G_LOG_DOMAIN, "SpiCmdReadId", buf, sizeof(buf));
 	if (priv->spi_cmd_read_id_sz == 4)
 		priv->flash_id = fu_common_read_uint32 (buf, G_BIG_ENDIAN);
@@ -36,7 +36,7 @@ fu_vli_pd_device_read_regs (FuVliPdDevice *self, guint16 addr,
 		g_prefix_error (error, "failed to write register @0x%x: ", addr);
 		return FALSE;
 	}
-	if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_VLI_USBHUB_VERBOSE")) {
 		g_autofree gchar *title = g_strdup_printf ("ReadRegs@0x%x", addr);
 		fu_common_dump_raw (G_LOG_DOMAIN, title, buf, bufsz);
 	}
@@ -52,7 +52,7 @@ fu_vli_pd_device_read_reg (FuVliPdDevice *self, guint16 addr, guint8 *value, GEr
 static gboolean
 fu_vli_pd_device_write_reg (FuVliPdDevice *self, guint16 addr, guint8 value, GError **error)
 {
-	if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_VLI_USBHUB_VERBOSE")) {
 		g_autofree gchar *title = g_strdup_printf ("WriteReg@0x%x", addr);
 		fu_common_dump_raw (G_LOG_DOMAIN, title, &value, sizeof(value));
 	}
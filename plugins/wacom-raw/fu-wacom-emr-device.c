@@ -10,6 +10,7 @@
 #include <gio/gio.h>
 
 #include "fu-chunk.h"
+#include "fu-crc.h"
 #include "fu-wacom-common.h"
 #include "fu-wacom-emr-device.h"
 
@@ -52,10 +53,7 @@ fu_wacom_emr_device_setup (FuDevice *device, GError **error)
 static guint8
 fu_wacom_emr_device_calc_checksum (guint8 init1, const guint8 *buf, guint8 bufsz)
 {
-	guint8 sum = 0;
-	sum += init1;
-	for (guint i = 0; i < bufsz; i++)
-		sum += buf[i];
+	guint8 sum = init1 + fu_sum8 (buf, bufsz);
 	return ~sum + 1;
 }
 
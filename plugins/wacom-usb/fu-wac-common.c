@@ -25,11 +25,21 @@ fu_wac_calculate_checksum32le (const guint8 *data, gsize len)
 }
 
 guint32
-fu_wac_calculate_checksum32le_bytes (GBytes *blob)
+fu_wac_calculate_checksum32le_bytes_view (FuBytesView *view)
 {
-	gsize len = 0;
-	const guint8 *data = g_bytes_get_data (blob, &len);
-	return fu_wac_calculate_checksum32le (data, len);
+	guint8 buf[0x1000];
+	guint32 csum = 0x0;
+	gsize len = fu_bytes_view_get_size (view);
+
+	/* a page at a time so that padding is not copied into one buffer */
+	g_return_val_if_fail (len % 4 == 0, 0xff);
+	for (gsize offset = 0; offset < len; offset += sizeof(buf)) {
+		gsize bufsz = MIN (len - offset, sizeof(buf));
+		if (!fu_bytes_view_read (view, offset, buf, bufsz, NULL))
+			return 0xff;
+		csum += GUINT32_FROM_LE (fu_wac_calculate_checksum32le (buf, bufsz));
+	}
+	return GUINT32_TO_LE (csum);
 }
 
 const gchar *
@@ -78,7 +88,7 @@ void
 fu_wac_buffer_dump (const gchar *title, guint8 cmd, const guint8 *buf, gsize sz)
 {
 	g_autofree gchar *tmp = NULL;
-	if (g_getenv ("FWUPD_WACOM_USB_VERBOSE") == NULL)
+	if (!fu_common_is_verbose ("FWUPD_WACOM_USB_VERBOSE"))
 		return;
 	tmp = g_strdup_printf ("%s %s (%" G_GSIZE_FORMAT ")",
 			       title, fu_wac_report_id_to_string (cmd), sz);
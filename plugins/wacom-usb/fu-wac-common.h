@@ -8,6 +8,8 @@
 
 #include <glib-object.h>
 
+#include "fu-bytes-view.h"
+
 #define FU_WAC_PACKET_LEN				512
 
 #define FU_WAC_REPORT_ID_COMMAND			0x01
@@ -39,7 +41,7 @@
 
 guint32		 fu_wac_calculate_checksum32le		(const guint8	*data,
 							 gsize		 len);
-guint32		 fu_wac_calculate_checksum32le_bytes	(GBytes		*blob);
+guint32		 fu_wac_calculate_checksum32le_bytes_view	(FuBytesView	*view);
 const gchar	*fu_wac_report_id_to_string		(guint8		 report_id);
 void		 fu_wac_buffer_dump			(const gchar	*title,
 							 guint8		 cmd,
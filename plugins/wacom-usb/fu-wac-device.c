@@ -32,6 +32,7 @@ typedef enum {
 } FuWacStatus;
 
 #define FU_WAC_DEVICE_TIMEOUT			5000	/* ms */
+#define FU_WAC_DEVICE_WRITES_IN_FLIGHT		4
 
 struct _FuWacDevice
 {
@@ -46,6 +47,7 @@ struct _FuWacDevice
 	guint16			 write_block_sz;	/* usb transfer size */
 	guint16			 nr_flash_blocks;
 	guint16			 configuration;
+	gboolean		 emulate;
 };
 
 G_DEFINE_TYPE (FuWacDevice, fu_wac_device, FU_TYPE_HID_DEVICE)
@@ -167,7 +169,7 @@ fu_wac_device_set_feature_report (FuWacDevice *self,
 				  GError **error)
 {
 	/* hit hardware */
-	if (g_getenv ("FWUPD_WAC_EMULATE") != NULL)
+	if (self->emulate)
 		return TRUE;
 	return fu_hid_device_set_report (FU_HID_DEVICE (self), buf[0],
 					 buf, bufsz,
@@ -302,6 +304,7 @@ fu_wac_device_ensure_parameters (FuWacDevice *self, GError **error)
 
 static gboolean
 fu_wac_device_write_block (FuWacDevice *self,
+			   FuUsbTransferQueue *queue,
 			   guint32 addr,
 			   GBytes *blob,
 			   GError **error)
@@ -334,10 +337,13 @@ fu_wac_device_write_block (FuWacDevice *self,
 			return FALSE;
 	}
 
-	/* hit hardware */
-	return fu_wac_device_set_feature_report (self, buf, bufsz,
-						 FU_HID_DEVICE_FLAG_NONE,
-						 error);
+	/* hit hardware, the block checksum is checked after the last write */
+	if (self->emulate)
+		return TRUE;
+	return fu_hid_device_queue_set_report (FU_HID_DEVICE (self), queue,
+					       buf[0], buf, bufsz,
+					       FU_HID_DEVICE_FLAG_IS_FEATURE,
+					       error);
 }
 
 static gboolean
@@ -453,6 +459,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 	g_autofree guint32 *csum_local = NULL;
 	g_autoptr(FuFirmwareImage) img = NULL;
 	g_autoptr(GHashTable) fd_blobs = NULL;
+	g_autoptr(FuUsbTransferQueue) queue = NULL;
 
 	/* use the correct image from the firmware */
 	img = fu_firmware_get_image_by_idx (firmware, self->firmware_index == 1 ? 1 : 0, error);
@@ -490,12 +497,12 @@ fu_wac_device_write_firmware (FuDevice *device,
 			return FALSE;
 	}
 
-	/* get the blobs for each chunk */
+	/* get the blobs for each chunk, padded without copying */
 	fd_blobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-					  NULL, (GDestroyNotify) g_bytes_unref);
+					  NULL, (GDestroyNotify) g_object_unref);
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
 		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		GBytes *blob_block;
+		FuBytesView *blob_block;
 		g_autoptr(GBytes) blob_tmp = NULL;
 
 		if (fu_wav_device_flash_descriptor_is_wp (fd))
@@ -506,7 +513,8 @@ fu_wac_device_write_firmware (FuDevice *device,
 							  NULL);
 		if (blob_tmp == NULL)
 			break;
-		blob_block = fu_common_bytes_pad (blob_tmp, fd->block_sz);
+		blob_block = fu_bytes_view_new_from_bytes (blob_tmp);
+		fu_bytes_view_pad (blob_block, fd->block_sz, 0xff);
 		g_hash_table_insert (fd_blobs, fd, blob_block);
 	}
 
@@ -515,10 +523,13 @@ fu_wac_device_write_firmware (FuDevice *device,
 
 	/* write the data into the flash page */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	queue = fu_usb_transfer_queue_new (FU_USB_DEVICE (self),
+					   FU_WAC_DEVICE_WRITES_IN_FLIGHT);
+	fu_usb_transfer_queue_set_timeout (queue, FU_WAC_DEVICE_TIMEOUT);
 	csum_local = g_new0 (guint32, self->flash_descriptors->len);
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
 		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		GBytes *blob_block;
+		FuBytesView *blob_block;
 		g_autoptr(GPtrArray) chunks = NULL;
 
 		/* if page is protected */
@@ -531,7 +542,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 			break;
 
 		/* ignore empty blocks */
-		if (fu_common_bytes_is_empty (blob_block)) {
+		if (fu_bytes_view_is_empty (blob_block)) {
 			g_debug ("empty block, ignoring");
 			fu_device_set_progress_full (device, blocks_done++, blocks_total);
 			continue;
@@ -541,20 +552,27 @@ fu_wac_device_write_firmware (FuDevice *device,
 		if (!fu_wac_device_erase_block (self, i, error))
 			return FALSE;
 
-		/* write block in chunks */
-		chunks = fu_chunk_array_new_from_bytes (blob_block,
-							fd->start_addr,
-							0, /* page_sz */
-							self->write_block_sz);
+		/* write block in chunks, without waiting for each one */
+		chunks = fu_chunk_array_new_from_bytes_view (blob_block,
+							     fd->start_addr,
+							     0, /* page_sz */
+							     self->write_block_sz,
+							     error);
+		if (chunks == NULL)
+			return FALSE;
 		for (guint j = 0; j < chunks->len; j++) {
 			FuChunk *chk = g_ptr_array_index (chunks, j);
-			g_autoptr(GBytes) blob_chunk = g_bytes_new (chk->data, chk->data_sz);
-			if (!fu_wac_device_write_block (self, chk->address, blob_chunk, error))
+			g_autoptr(GBytes) blob_chunk = g_bytes_new_static (chk->data, chk->data_sz);
+			if (!fu_wac_device_write_block (self, queue, chk->address, blob_chunk, error))
 				return FALSE;
 		}
+		if (!fu_usb_transfer_queue_drain (queue, error)) {
+			g_prefix_error (error, "failed to write block %u: ", i);
+			return FALSE;
+		}
 
 		/* calculate expected checksum and save to device RAM */
-		csum_local[i] = fu_wac_calculate_checksum32le_bytes (blob_block);
+		csum_local[i] = fu_wac_calculate_checksum32le_bytes_view (blob_block);
 		g_debug ("block checksum %02u: 0x%08x", i, csum_local[i]);
 		if (!fu_wac_device_set_checksum_of_block (self, i, csum_local[i], error))
 			return FALSE;
@@ -577,7 +595,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 		return FALSE;
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
 		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		GBytes *blob_block;
+		FuBytesView *blob_block;
 		guint32 csum_rom;
 
 		/* if page is protected */
@@ -588,7 +606,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 		blob_block = g_hash_table_lookup (fd_blobs, fd);
 		if (blob_block == NULL)
 			continue;
-		if (fu_common_bytes_is_empty (blob_block))
+		if (fu_bytes_view_is_empty (blob_block))
 			continue;
 
 		/* check checksum matches */
@@ -786,6 +804,7 @@ fu_wac_device_init (FuWacDevice *self)
 	self->checksums = g_array_new (FALSE, FALSE, sizeof(guint32));
 	self->configuration = 0xffff;
 	self->firmware_index = 0xffff;
+	self->emulate = g_getenv ("FWUPD_WAC_EMULATE") != NULL;
 	fu_device_set_protocol (FU_DEVICE (self), "com.wacom.usb");
 	fu_device_add_icon (FU_DEVICE (self), "input-tablet");
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_UPDATABLE);
@@ -27,6 +27,29 @@ typedef struct {
 	guint32 prog_start_addr;
 } FuFirmwareWacHeaderRecord;
 
+static FuFirmwareImage *
+fu_wac_firmware_parse_image_cb (FuFirmware *firmware,
+				GBytes *fw,
+				guint idx,
+				gpointer user_data,
+				FwupdInstallFlags flags,
+				GError **error)
+{
+	GPtrArray *header_infos = (GPtrArray *) user_data;
+	FuFirmwareWacHeaderRecord *hdr = g_ptr_array_index (header_infos, idx);
+	FuFirmwareImage *img;
+	g_autoptr(FuFirmware) firmware_srec = fu_srec_firmware_new ();
+
+	/* use the correct relocated start address */
+	if (!fu_firmware_parse_full (firmware_srec, fw, hdr->addr, 0x0, flags, error))
+		return NULL;
+	img = fu_firmware_get_image_default (firmware_srec, error);
+	if (img == NULL)
+		return NULL;
+	fu_firmware_image_set_idx (img, idx);
+	return img;
+}
+
 static gboolean
 fu_wac_firmware_parse (FuFirmware *firmware,
 		       GBytes *fw,
@@ -40,6 +63,7 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 	guint8 images_cnt = 0;
 	g_auto(GStrv) lines = NULL;
 	g_autoptr(GPtrArray) header_infos = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
 	g_autoptr(GString) image_buffer = NULL;
 
 	/* check the prefix (BE) */
@@ -161,12 +185,7 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 
 		/* end */
 		if (g_strcmp0 (cmd, "S7") == 0) {
-			g_autoptr(GBytes) blob = NULL;
-			g_autoptr(FuFirmware) firmware_srec = fu_srec_firmware_new ();
-			g_autoptr(FuFirmwareImage) img = NULL;
-			FuFirmwareWacHeaderRecord *hdr;
-
-			/* get the correct relocated start address */
+			/* each image needs a relocated start address */
 			if (images_cnt >= header_infos->len) {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -174,7 +193,6 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 					     "%s without header", cmd);
 				return FALSE;
 			}
-			hdr = g_ptr_array_index (header_infos, images_cnt);
 
 			if (image_buffer == NULL) {
 				g_set_error (error,
@@ -184,15 +202,8 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 				return FALSE;
 			}
 
-			/* parse SREC file and add as image */
-			blob = g_bytes_new (image_buffer->str, image_buffer->len);
-			if (!fu_firmware_parse_full (firmware_srec, blob, hdr->addr, 0x0, flags, error))
-				return FALSE;
-			img = fu_firmware_get_image_default (firmware_srec, error);
-			if (img == NULL)
-				return FALSE;
-			fu_firmware_image_set_idx (img, images_cnt);
-			fu_firmware_add_image (firmware, img);
+			/* SREC is parsed once all the images are found */
+			g_ptr_array_add (blobs, g_bytes_new (image_buffer->str, image_buffer->len));
 			images_cnt++;
 
 			/* clear the image buffer */
@@ -221,8 +232,10 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 		return FALSE;
 	}
 
-	/* success */
-	return TRUE;
+	/* parse each SREC image, possibly in parallel */
+	return fu_firmware_parse_images (firmware, blobs,
+					 fu_wac_firmware_parse_image_cb,
+					 header_infos, flags, error);
 }
 
 static void
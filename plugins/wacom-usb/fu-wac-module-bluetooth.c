@@ -8,6 +8,8 @@
 
 #include <string.h>
 
+#include "fu-crc.h"
+
 #include "fu-wac-common.h"
 #include "fu-wac-device.h"
 #include "fu-wac-module-bluetooth.h"
@@ -30,47 +32,6 @@ typedef struct {
 	guint8		 cdata[FU_WAC_MODULE_BLUETOOTH_PAYLOAD_SZ];
 } FuWacModuleBluetoothBlockData;
 
-static void
-fu_wac_module_bluetooth_calculate_crc_byte (guint8 *crc, guint8 data)
-{
-	guint8 c[8];
-	guint8 m[8];
-	guint8 r[8];
-
-	/* find out what bits are set */
-	for (guint i = 0; i < 8; i++) {
-		c[i] = (*crc & (1 << i)) != 0;
-		m[i] = (data & (1 << i)) != 0;
-	}
-
-	/* do CRC on byte */
-	r[7] = (c[7] ^ m[4] ^ c[3] ^ m[3] ^ c[4] ^ m[6] ^ c[1] ^ m[0]);
-	r[6] = (c[6] ^ m[5] ^ c[2] ^ m[4] ^ c[3] ^ m[7] ^ c[0] ^ m[1]);
-	r[5] = (c[5] ^ m[6] ^ c[1] ^ m[5] ^ c[2] ^ m[2]);
-	r[4] = (c[4] ^ m[7] ^ c[0] ^ m[6] ^ c[1] ^ m[3]);
-	r[3] = (m[7] ^ m[0] ^ c[7] ^ c[0] ^ m[3] ^ c[4] ^ m[6] ^ c[1]);
-	r[2] = (m[1] ^ c[6] ^ m[0] ^ c[7] ^ m[3] ^ c[4] ^ m[7] ^ c[0] ^ m[6] ^ c[1]);
-	r[1] = (m[2] ^ c[5] ^ m[1] ^ c[6] ^ m[4] ^ c[3] ^ m[7] ^ c[0]);
-	r[0] = (m[3] ^ c[4] ^ m[2] ^ c[5] ^ m[5] ^ c[2]);
-
-	/* copy back into CRC */
-	*crc = 0;
-	for (guint i = 0; i < 8; i++) {
-		if (r[i] == 0)
-			continue;
-		*crc |= (1 << i);
-	}
-}
-
-static guint8
-fu_wac_module_bluetooth_calculate_crc (const guint8 *data, gsize sz)
-{
-	guint8 crc = 0;
-	for (gsize i = 0; i < sz; i++)
-		fu_wac_module_bluetooth_calculate_crc_byte (&crc, data[i]);
-	return crc;
-}
-
 static GPtrArray *
 fu_wac_module_bluetooth_parse_blocks (const guint8 *data, gsize sz, gboolean skip_user_data, GError **error)
 {
@@ -100,8 +61,8 @@ fu_wac_module_bluetooth_parse_blocks (const guint8 *data, gsize sz, gboolean ski
 				     data, sz, addr,			/* src */
 				     cdata_sz, error))
 			return NULL;
-		bd->crc = fu_wac_module_bluetooth_calculate_crc (bd->cdata,
-								 FU_WAC_MODULE_BLUETOOTH_PAYLOAD_SZ);
+		bd->crc = fu_crc8 (FU_CRC_KIND_B8_WACOM, bd->cdata,
+				   FU_WAC_MODULE_BLUETOOTH_PAYLOAD_SZ);
 		g_ptr_array_add (blocks, bd);
 	}
 	return blocks;
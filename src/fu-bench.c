@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuBench"
+
+#include "config.h"
+
+#include <fwupd.h>
+#include <json-glib/json-glib.h>
+#include <stdlib.h>
+#include <xmlb.h>
+
+#include "fu-common.h"
+#include "fu-engine.h"
+#include "fu-install-task.h"
+#include "fu-plugin-private.h"
+#include "fu-quirks.h"
+
+typedef struct {
+	FuEngine		*engine;
+	FuPlugin		*plugin;
+	FuQuirks		*quirks;
+	XbSilo			*silo;
+	GPtrArray		*devices;	/* of FuDevice */
+	GPtrArray		*results;	/* of FuBenchResult */
+	gchar			*tmpdir;
+	guint			 device_count;
+	guint			 component_count;
+	guint			 iterations;
+	gboolean		 json;
+} FuBenchPrivate;
+
+typedef struct {
+	gchar			*id;
+	guint			 count;
+	guint			 failed;
+	gdouble			 elapsed;
+} FuBenchResult;
+
+static void
+fu_bench_result_free (FuBenchResult *result)
+{
+	g_free (result->id);
+	g_free (result);
+}
+
+static void
+fu_bench_private_free (FuBenchPrivate *priv)
+{
+	if (priv->engine != NULL)
+		g_object_unref (priv->engine);
+	if (priv->plugin != NULL)
+		g_object_unref (priv->plugin);
+	if (priv->quirks != NULL)
+		g_object_unref (priv->quirks);
+	if (priv->silo != NULL)
+		g_object_unref (priv->silo);
+	if (priv->tmpdir != NULL) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_common_rmtree (priv->tmpdir, &error_local))
+			g_warning ("failed to remove %s: %s", priv->tmpdir, error_local->message);
+		g_free (priv->tmpdir);
+	}
+	g_ptr_array_unref (priv->devices);
+	g_ptr_array_unref (priv->results);
+	g_free (priv);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuBenchPrivate, fu_bench_private_free)
+
+static FuBenchResult *
+fu_bench_result_new (FuBenchPrivate *priv, const gchar *id)
+{
+	FuBenchResult *result = g_new0 (FuBenchResult, 1);
+	result->id = g_strdup (id);
+	g_ptr_array_add (priv->results, result);
+	return result;
+}
+
+static void
+fu_bench_result_add (FuBenchResult *result, gint64 start, guint count)
+{
+	result->elapsed += (gdouble) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+	result->count += count;
+}
+
+/* so that nothing from the installed system is used */
+static gboolean
+fu_bench_setup_root (FuBenchPrivate *priv, GError **error)
+{
+	g_autofree gchar *localstatedir = NULL;
+	g_autofree gchar *offline_trigger = NULL;
+
+	priv->tmpdir = g_dir_make_tmp ("fwupd-bench-XXXXXX", error);
+	if (priv->tmpdir == NULL)
+		return FALSE;
+	localstatedir = g_build_filename (priv->tmpdir, "var", NULL);
+	offline_trigger = g_build_filename (priv->tmpdir, "system-update", NULL);
+	g_setenv ("FWUPD_DATADIR", priv->tmpdir, TRUE);
+	g_setenv ("FWUPD_PLUGINDIR", priv->tmpdir, TRUE);
+	g_setenv ("FWUPD_SYSCONFDIR", priv->tmpdir, TRUE);
+	g_setenv ("FWUPD_SYSFSFWDIR", priv->tmpdir, TRUE);
+	g_setenv ("FWUPD_LOCALSTATEDIR", localstatedir, TRUE);
+	g_setenv ("FWUPD_OFFLINE_TRIGGER", offline_trigger, TRUE);
+	g_unsetenv ("CONFIGURATION_DIRECTORY");
+	g_unsetenv ("STATE_DIRECTORY");
+	g_unsetenv ("CACHE_DIRECTORY");
+	g_setenv ("FWUPD_PLUGIN_TEST", "bench", TRUE);
+	return TRUE;
+}
+
+/* one group for each device, matching the instance IDs from the test plugin */
+static gboolean
+fu_bench_write_quirks (FuBenchPrivate *priv, GError **error)
+{
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	for (guint i = 0; i < priv->device_count; i++) {
+		g_string_append_printf (str, "[DeviceInstanceId=BENCH\\VEN_%04X&DEV_%04X]\n",
+					i % 0x10, i);
+		g_string_append_printf (str, "Summary = Synthetic device %u\n", i);
+		g_string_append (str, "InstallDuration = 60\n");
+		g_string_append (str, "FirmwareSizeMax = 0x10000\n\n");
+	}
+	fn = g_build_filename (priv->tmpdir, "quirks.d", "bench.quirk", NULL);
+	if (!fu_common_mkdir_parent (fn, error))
+		return FALSE;
+	return g_file_set_contents (fn, str->str, str->len, error);
+}
+
+/* each component provides the GUID of a device, with an upgrade and a downgrade */
+static gchar *
+fu_bench_build_metadata (FuBenchPrivate *priv)
+{
+	const gchar *versions[] = { "1.2.3", "1.2.1", NULL };
+	GString *str = g_string_new ("<components>\n");
+	for (guint i = 0; i < priv->component_count; i++) {
+		guint idx = i % priv->device_count;
+		g_autofree gchar *devid = NULL;
+		g_autofree gchar *guid = NULL;
+
+		devid = g_strdup_printf ("BENCH\\VEN_%04X&DEV_%04X", idx % 0x10, idx);
+		guid = fwupd_guid_hash_string (devid);
+		g_string_append (str, "  <component type=\"firmware\">\n");
+		g_string_append_printf (str, "    <id>com.acme.Bench%u.firmware</id>\n", i);
+		g_string_append_printf (str, "    <name>Bench Device %u</name>\n", idx);
+		g_string_append (str, "    <provides>\n");
+		g_string_append_printf (str, "      <firmware type=\"flashed\">%s</firmware>\n", guid);
+		g_string_append (str, "    </provides>\n");
+		g_string_append (str, "    <requires>\n");
+		g_string_append (str, "      <id compare=\"ge\" version=\"1.0.0\">org.freedesktop.fwupd</id>\n");
+		g_string_append (str, "    </requires>\n");
+		g_string_append (str, "    <releases>\n");
+		for (guint j = 0; versions[j] != NULL; j++) {
+			g_string_append_printf (str, "      <release version=\"%s\" date=\"2020-01-01\">\n", versions[j]);
+			g_string_append (str, "        <location>https://test.org/foo.cab</location>\n");
+			g_string_append_printf (str, "        <checksum filename=\"foo.cab\" target=\"container\" type=\"sha1\">%040x</checksum>\n", i * 2 + j);
+			g_string_append (str, "      </release>\n");
+		}
+		g_string_append (str, "    </releases>\n");
+		g_string_append (str, "    <custom>\n");
+		g_string_append (str, "      <value key=\"LVFS::UpdateProtocol\">com.acme.test</value>\n");
+		g_string_append (str, "    </custom>\n");
+		g_string_append (str, "  </component>\n");
+	}
+	g_string_append (str, "</components>\n");
+	return g_string_free (str, FALSE);
+}
+
+static void
+fu_bench_plugin_device_added_cb (FuPlugin *plugin, FuDevice *device, gpointer user_data)
+{
+	FuBenchPrivate *priv = (FuBenchPrivate *) user_data;
+	g_ptr_array_add (priv->devices, g_object_ref (device));
+}
+
+static gboolean
+fu_bench_load_engine (FuBenchPrivate *priv, GError **error)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "engine-load");
+	gint64 start = g_get_monotonic_time ();
+
+	priv->engine = fu_engine_new (FU_APP_FLAGS_NO_IDLE_SOURCES);
+	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, error))
+		return FALSE;
+	fu_bench_result_add (result, start, 1);
+	return TRUE;
+}
+
+static gboolean
+fu_bench_load_metadata (FuBenchPrivate *priv, GError **error)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "metadata-load");
+	gint64 start;
+	g_autofree gchar *xml = fu_bench_build_metadata (priv);
+
+	start = g_get_monotonic_time ();
+	priv->silo = xb_silo_new_from_xml (xml, error);
+	if (priv->silo == NULL)
+		return FALSE;
+	fu_engine_set_silo (priv->engine, priv->silo);
+	fu_bench_result_add (result, start, priv->component_count);
+	return TRUE;
+}
+
+static gboolean
+fu_bench_coldplug (FuBenchPrivate *priv, GError **error)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "coldplug");
+	gint64 start;
+	g_autofree gchar *devices_str = g_strdup_printf ("%u", priv->device_count);
+	g_autofree gchar *pluginfn = NULL;
+
+	/* the quirks are shared so the lookups can be timed separately */
+	priv->quirks = fu_quirks_new ();
+	if (!fu_quirks_load (priv->quirks, FU_QUIRKS_LOAD_FLAG_NONE, error))
+		return FALSE;
+
+	g_setenv ("FWUPD_PLUGIN_TEST_DEVICES", devices_str, TRUE);
+	priv->plugin = fu_plugin_new ();
+	pluginfn = g_build_filename (PLUGINBUILDDIR,
+				     "libfu_plugin_test." G_MODULE_SUFFIX,
+				     NULL);
+	if (!fu_plugin_open (priv->plugin, pluginfn, error))
+		return FALSE;
+	fu_plugin_set_quirks (priv->plugin, priv->quirks);
+	fu_engine_add_plugin (priv->engine, priv->plugin);
+	g_signal_connect (priv->plugin, "device-added",
+			  G_CALLBACK (fu_bench_plugin_device_added_cb),
+			  priv);
+
+	/* create the devices and add them to the engine */
+	start = g_get_monotonic_time ();
+	if (!fu_plugin_runner_startup (priv->plugin, error))
+		return FALSE;
+	if (!fu_plugin_runner_coldplug (priv->plugin, error))
+		return FALSE;
+	for (guint i = 0; i < priv->devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (priv->devices, i);
+		fu_engine_add_device (priv->engine, device);
+	}
+	fu_bench_result_add (result, start, priv->devices->len);
+	if (priv->devices->len != priv->device_count) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "expected %u devices, got %u",
+			     priv->device_count, priv->devices->len);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_bench_get_devices (FuBenchPrivate *priv, GError **error)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "get-devices");
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 start = g_get_monotonic_time ();
+		g_autoptr(GPtrArray) devices = fu_engine_get_devices (priv->engine, error);
+		if (devices == NULL)
+			return FALSE;
+		fu_bench_result_add (result, start, 1);
+	}
+	return TRUE;
+}
+
+static void
+fu_bench_get_device (FuBenchPrivate *priv)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "device-list-lookup");
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 start = g_get_monotonic_time ();
+		for (guint j = 0; j < priv->devices->len; j++) {
+			FuDevice *device = g_ptr_array_index (priv->devices, j);
+			g_autoptr(FuDevice) device_tmp = NULL;
+			device_tmp = fu_engine_get_device (priv->engine,
+							   fu_device_get_id (device),
+							   NULL);
+			if (device_tmp == NULL)
+				result->failed++;
+		}
+		fu_bench_result_add (result, start, priv->devices->len);
+	}
+}
+
+static void
+fu_bench_get_upgrades (FuBenchPrivate *priv)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "get-upgrades");
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 start = g_get_monotonic_time ();
+		for (guint j = 0; j < priv->devices->len; j++) {
+			FuDevice *device = g_ptr_array_index (priv->devices, j);
+			g_autoptr(GError) error_local = NULL;
+			g_autoptr(GPtrArray) releases = NULL;
+			releases = fu_engine_get_upgrades (priv->engine,
+							   fu_device_get_id (device),
+							   &error_local);
+			if (releases == NULL)
+				result->failed++;
+		}
+		fu_bench_result_add (result, start, priv->devices->len);
+	}
+}
+
+static void
+fu_bench_quirk_lookups (FuBenchPrivate *priv)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "quirk-lookup");
+	const gchar *keys[] = { "Summary", "InstallDuration", "FirmwareSizeMax", NULL };
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 start = g_get_monotonic_time ();
+		for (guint j = 0; j < priv->device_count; j++) {
+			g_autofree gchar *group = NULL;
+			group = g_strdup_printf ("DeviceInstanceId=BENCH\\VEN_%04X&DEV_%04X",
+						 j % 0x10, j);
+			for (guint k = 0; keys[k] != NULL; k++) {
+				if (fu_quirks_lookup_by_id (priv->quirks, group, keys[k]) == NULL)
+					result->failed++;
+			}
+		}
+		fu_bench_result_add (result, start, priv->device_count * (G_N_ELEMENTS (keys) - 1));
+	}
+}
+
+static gboolean
+fu_bench_check_requirements (FuBenchPrivate *priv, GError **error)
+{
+	FuBenchResult *result = fu_bench_result_new (priv, "check-requirements");
+	g_autoptr(GPtrArray) components = NULL;
+
+	components = xb_silo_query (priv->silo, "components/component", 0, error);
+	if (components == NULL)
+		return FALSE;
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 start = g_get_monotonic_time ();
+		for (guint j = 0; j < components->len; j++) {
+			XbNode *component = g_ptr_array_index (components, j);
+			FuDevice *device = g_ptr_array_index (priv->devices, j % priv->devices->len);
+			g_autoptr(FuInstallTask) task = fu_install_task_new (device, component);
+			g_autoptr(GError) error_local = NULL;
+			if (!fu_engine_check_requirements (priv->engine, task,
+							   FWUPD_INSTALL_FLAG_OFFLINE |
+							   FWUPD_INSTALL_FLAG_ALLOW_REINSTALL |
+							   FWUPD_INSTALL_FLAG_ALLOW_OLDER,
+							   &error_local)) {
+				g_debug ("%s", error_local->message);
+				result->failed++;
+			}
+		}
+		fu_bench_result_add (result, start, components->len);
+	}
+	return TRUE;
+}
+
+/* in microseconds */
+static gdouble
+fu_bench_result_get_per_op (FuBenchResult *result)
+{
+	if (result->count == 0)
+		return 0.f;
+	return result->elapsed * G_USEC_PER_SEC / result->count;
+}
+
+static void
+fu_bench_print_text (FuBenchPrivate *priv)
+{
+	g_print ("%-24s %10s %8s %12s %12s\n",
+		 "Test", "Count", "Failed", "Total ms", "Per op us");
+	for (guint i = 0; i < priv->results->len; i++) {
+		FuBenchResult *result = g_ptr_array_index (priv->results, i);
+		g_print ("%-24s %10u %8u %12.2f %12.2f\n",
+			 result->id,
+			 result->count,
+			 result->failed,
+			 result->elapsed * 1000.f,
+			 fu_bench_result_get_per_op (result));
+	}
+}
+
+static void
+fu_bench_print_json (FuBenchPrivate *priv)
+{
+	g_autofree gchar *data = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Devices");
+	json_builder_add_int_value (builder, priv->device_count);
+	json_builder_set_member_name (builder, "Components");
+	json_builder_add_int_value (builder, priv->component_count);
+	json_builder_set_member_name (builder, "Iterations");
+	json_builder_add_int_value (builder, priv->iterations);
+	json_builder_set_member_name (builder, "Results");
+	json_builder_begin_array (builder);
+	for (guint i = 0; i < priv->results->len; i++) {
+		FuBenchResult *result = g_ptr_array_index (priv->results, i);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "Id");
+		json_builder_add_string_value (builder, result->id);
+		json_builder_set_member_name (builder, "Count");
+		json_builder_add_int_value (builder, result->count);
+		json_builder_set_member_name (builder, "Failed");
+		json_builder_add_int_value (builder, result->failed);
+		json_builder_set_member_name (builder, "Elapsed");
+		json_builder_add_double_value (builder, result->elapsed);
+		json_builder_set_member_name (builder, "MicrosecondsPerOperation");
+		json_builder_add_double_value (builder, fu_bench_result_get_per_op (result));
+		json_builder_end_object (builder);
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	g_print ("%s\n", data);
+}
+
+int
+main (int argc, char *argv[])
+{
+	gboolean verbose = FALSE;
+	g_autoptr(FuBenchPrivate) priv = g_new0 (FuBenchPrivate, 1);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	const GOptionEntry options[] = {
+		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
+			"Show extra debugging information", NULL },
+		{ "json", '\0', 0, G_OPTION_ARG_NONE, &priv->json,
+			"Output in JSON format", NULL },
+		{ "iterations", 'i', 0, G_OPTION_ARG_INT, &priv->iterations,
+			"Number of times to run each test", NULL },
+		{ "devices", 'd', 0, G_OPTION_ARG_INT, &priv->device_count,
+			"Number of synthetic devices", NULL },
+		{ "components", 'c', 0, G_OPTION_ARG_INT, &priv->component_count,
+			"Number of synthetic metadata components", NULL },
+		{ NULL}
+	};
+
+	/* defaults */
+	priv->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->results = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_bench_result_free);
+	priv->iterations = 10;
+	priv->device_count = 100;
+	priv->component_count = 1000;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context,
+				      "Measure engine performance with synthetic devices");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (verbose)
+		g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+	if (priv->iterations == 0) {
+		g_printerr ("--iterations must be at least 1\n");
+		return EXIT_FAILURE;
+	}
+	if (priv->device_count < 10 || priv->device_count > 10000) {
+		g_printerr ("--devices must be between 10 and 10000\n");
+		return EXIT_FAILURE;
+	}
+
+	/* set up an empty tree with the synthetic quirks */
+	if (!fu_bench_setup_root (priv, &error) ||
+	    !fu_bench_write_quirks (priv, &error)) {
+		g_printerr ("Failed to set up: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	/* run each test in turn, as each depends on the one before */
+	if (!fu_bench_load_engine (priv, &error) ||
+	    !fu_bench_load_metadata (priv, &error) ||
+	    !fu_bench_coldplug (priv, &error) ||
+	    !fu_bench_get_devices (priv, &error)) {
+		g_printerr ("Failed to run: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	fu_bench_get_device (priv);
+	fu_bench_get_upgrades (priv);
+	fu_bench_quirk_lookups (priv);
+	if (!fu_bench_check_requirements (priv, &error)) {
+		g_printerr ("Failed to run: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	if (priv->json)
+		fu_bench_print_json (priv);
+	else
+		fu_bench_print_text (priv);
+	return EXIT_SUCCESS;
+}
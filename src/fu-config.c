@@ -35,6 +35,8 @@ struct _FuConfig
 	gchar			*config_file;
 	gboolean		 update_motd;
 	gboolean		 enumerate_all_devices;
+	gboolean		 warm_start;
+	guint			 progress_rate_max;
 };
 
 G_DEFINE_TYPE (FuConfig, fu_config, G_TYPE_OBJECT)
@@ -51,6 +53,7 @@ fu_config_reload (FuConfig *self, GError **error)
 {
 	guint64 archive_size_max;
 	guint idle_timeout;
+	guint progress_rate_max;
 	g_auto(GStrv) approved_firmware = NULL;
 	g_auto(GStrv) devices = NULL;
 	g_auto(GStrv) plugins = NULL;
@@ -58,6 +61,7 @@ fu_config_reload (FuConfig *self, GError **error)
 	g_autoptr(GKeyFile) keyfile = g_key_file_new ();
 	g_autoptr(GError) error_update_motd = NULL;
 	g_autoptr(GError) error_enumerate_all = NULL;
+	g_autoptr(GError) error_progress_rate = NULL;
 
 	g_debug ("loading config values from %s", self->config_file);
 	if (!g_key_file_load_from_file (keyfile, self->config_file,
@@ -151,6 +155,20 @@ fu_config_reload (FuConfig *self, GError **error)
 		self->enumerate_all_devices = TRUE;
 	}
 
+	/* whether to persist the device tree for the next activation */
+	self->warm_start = g_key_file_get_boolean (keyfile,
+						   "fwupd",
+						   "WarmStart",
+						   NULL);
+
+	/* how often clients are told about progress, where 0 is unlimited */
+	progress_rate_max = g_key_file_get_uint64 (keyfile,
+						   "fwupd",
+						   "ProgressRateMax",
+						   &error_progress_rate);
+	if (error_progress_rate == NULL)
+		self->progress_rate_max = progress_rate_max;
+
 	return TRUE;
 }
 
@@ -262,6 +280,20 @@ fu_config_get_enumerate_all_devices (FuConfig *self)
 	return self->enumerate_all_devices;
 }
 
+gboolean
+fu_config_get_warm_start (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->warm_start;
+}
+
+guint
+fu_config_get_progress_rate_max (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), 0);
+	return self->progress_rate_max;
+}
+
 static void
 fu_config_class_init (FuConfigClass *klass)
 {
@@ -279,6 +311,7 @@ static void
 fu_config_init (FuConfig *self)
 {
 	self->archive_size_max = 512 * 0x100000;
+	self->progress_rate_max = 10;
 	self->blacklist_devices = g_ptr_array_new_with_free_func (g_free);
 	self->blacklist_plugins = g_ptr_array_new_with_free_func (g_free);
 	self->approved_firmware = g_ptr_array_new_with_free_func (g_free);
@@ -28,3 +28,5 @@ GPtrArray	*fu_config_get_blacklist_plugins	(FuConfig	*self);
 GPtrArray	*fu_config_get_approved_firmware	(FuConfig	*self);
 gboolean	 fu_config_get_update_motd		(FuConfig	*self);
 gboolean	 fu_config_get_enumerate_all_devices	(FuConfig	*self);
+gboolean	 fu_config_get_warm_start		(FuConfig	*self);
+guint		 fu_config_get_progress_rate_max	(FuConfig	*self);
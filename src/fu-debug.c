@@ -13,6 +13,9 @@
 
 #include <fu-debug.h>
 
+#include "fu-common.h"
+#include "fu-plugin.h"
+
 typedef struct {
 	GOptionGroup	*group;
 	gboolean	 verbose;
@@ -190,11 +193,54 @@ fu_debug_post_parse_hook (GOptionContext *context,
 			varname = g_strdup_printf ("FWUPD_%s_VERBOSE", name_caps);
 			g_debug ("setting %s=1", varname);
 			g_setenv (varname, "1", TRUE);
+			if (!fu_common_verbose_set (varname, TRUE, error))
+				return FALSE;
 		}
 	}
 	return TRUE;
 }
 
+static gchar *
+fu_debug_get_plugin_verbose_varname (const gchar *name)
+{
+	g_autofree gchar *name_caps = g_ascii_strup (name, -1);
+	g_strdelimit (name_caps, "-", '_');
+	return g_strdup_printf ("FWUPD_%s_VERBOSE", name_caps);
+}
+
+/* @name is either a plugin name, e.g. "dfu", or the variable name for that
+ * plugin such as "FWUPD_DFU_VERBOSE", and @plugins is the #FuPlugin array of
+ * loaded plugins so that only real categories can be used */
+gboolean
+fu_debug_set_plugin_verbose (GPtrArray *plugins,
+			     const gchar *name,
+			     gboolean enabled,
+			     GError **error)
+{
+	g_autofree gchar *varname = NULL;
+
+	/* already a variable name */
+	if (g_str_has_suffix (name, "_VERBOSE")) {
+		varname = g_strdup (name);
+	} else {
+		varname = fu_debug_get_plugin_verbose_varname (name);
+	}
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		g_autofree gchar *tmp = NULL;
+		tmp = fu_debug_get_plugin_verbose_varname (fu_plugin_get_name (plugin));
+		if (g_strcmp0 (tmp, varname) == 0) {
+			g_debug ("setting %s=%i", varname, enabled);
+			return fu_common_verbose_set (varname, enabled, error);
+		}
+	}
+	g_set_error (error,
+		     G_IO_ERROR,
+		     G_IO_ERROR_INVALID_ARGUMENT,
+		     "unknown verbose category %s", name);
+	return FALSE;
+}
+
 /*(transfer): full */
 GOptionGroup *
 fu_debug_get_option_group (void)
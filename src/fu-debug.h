@@ -9,3 +9,7 @@
 #include <glib.h>
 
 GOptionGroup	*fu_debug_get_option_group	(void);
+gboolean	 fu_debug_set_plugin_verbose	(GPtrArray	*plugins,
+						 const gchar	*name,
+						 gboolean	 enabled,
+						 GError		**error);
@@ -14,6 +14,7 @@
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-trace.h"
 
 #include "fwupd-error.h"
 
@@ -390,6 +391,8 @@ fu_device_list_remove (FuDeviceList *self, FuDevice *device)
 	g_return_if_fail (FU_IS_DEVICE_LIST (self));
 	g_return_if_fail (FU_IS_DEVICE (device));
 
+	FU_TRACE2 (device_list_remove, fu_device_get_id (device), fu_device_get_plugin (device));
+
 	/* check the device already exists */
 	item = fu_device_list_find_by_id (self, fu_device_get_id (device), NULL);
 	if (item == NULL) {
@@ -548,6 +551,8 @@ fu_device_list_add (FuDeviceList *self, FuDevice *device)
 	g_return_if_fail (FU_IS_DEVICE_LIST (self));
 	g_return_if_fail (FU_IS_DEVICE (device));
 
+	FU_TRACE2 (device_list_add, fu_device_get_id (device), fu_device_get_plugin (device));
+
 	/* is the device waiting to be replugged? */
 	item = fu_device_list_find_by_id (self, fu_device_get_id (device), NULL);
 	if (item != NULL && item->remove_id != 0) {
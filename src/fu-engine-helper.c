@@ -9,9 +9,20 @@
 #include "config.h"
 
 #include <glib/gi18n.h>
+#include <string.h>
 
+#if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
+#include "fu-common.h"
 #include "fu-engine.h"
 #include "fu-engine-helper.h"
+#include "fu-firmware.h"
+#include "fu-install-task.h"
+
+/* daemon version, time saved, daemon properties, devices */
+#define FU_ENGINE_SNAPSHOT_FORMAT		"(sxa{sv}aa{sv})"
 
 gboolean
 fu_engine_update_motd (FuEngine *self, GError **error)
@@ -74,3 +85,196 @@ fu_engine_update_motd (FuEngine *self, GError **error)
 	return g_file_set_contents (target, str->str, str->len, error);
 }
 
+
+static gchar *
+fu_engine_get_snapshot_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "devices.snapshot", NULL);
+}
+
+gboolean
+fu_engine_save_snapshot (FuEngine *self, GError **error)
+{
+	const gchar *host_product = fu_engine_get_host_product (self);
+	const gchar *host_machine_id = fu_engine_get_host_machine_id (self);
+	GVariantBuilder builder_devices;
+	GVariantBuilder builder_props;
+	g_autofree gchar *filename = fu_engine_get_snapshot_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) snapshot = NULL;
+
+	/* nothing worth serving on the next activation */
+	devices = fu_engine_get_devices (self, NULL);
+	if (devices == NULL)
+		return fu_engine_remove_snapshot (error);
+
+	/* only what an unprivileged client would see is written to disk */
+	g_variant_builder_init (&builder_devices, G_VARIANT_TYPE ("aa{sv}"));
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		g_variant_builder_add_value (&builder_devices,
+					     fwupd_device_to_variant (dev));
+	}
+	g_variant_builder_init (&builder_props, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder_props, "{sv}", "Tainted",
+			       g_variant_new_boolean (fu_engine_get_tainted (self)));
+	if (host_product != NULL) {
+		g_variant_builder_add (&builder_props, "{sv}", "HostProduct",
+				       g_variant_new_string (host_product));
+	}
+	if (host_machine_id != NULL) {
+		g_variant_builder_add (&builder_props, "{sv}", "HostMachineId",
+				       g_variant_new_string (host_machine_id));
+	}
+	snapshot = g_variant_ref_sink (g_variant_new (FU_ENGINE_SNAPSHOT_FORMAT,
+						      SOURCE_VERSION,
+						      g_get_real_time (),
+						      &builder_props,
+						      &builder_devices));
+	blob = g_variant_get_data_as_bytes (snapshot);
+	return fu_common_set_contents_bytes (filename, blob, error);
+}
+
+GVariant *
+fu_engine_load_snapshot (GError **error)
+{
+	const gchar *version = NULL;
+	g_autofree gchar *filename = fu_engine_get_snapshot_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GVariant) snapshot = NULL;
+
+	blob = fu_common_get_contents_bytes (filename, error);
+	if (blob == NULL)
+		return NULL;
+	snapshot = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (FU_ENGINE_SNAPSHOT_FORMAT),
+								 blob, FALSE));
+
+	/* the device flags and keys may have changed */
+	g_variant_get_child (snapshot, 0, "&s", &version);
+	if (g_strcmp0 (version, SOURCE_VERSION) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "snapshot %s was saved by version %s",
+			     filename, version);
+		return NULL;
+	}
+	return g_steal_pointer (&snapshot);
+}
+
+gboolean
+fu_engine_remove_snapshot (GError **error)
+{
+	g_autofree gchar *filename = fu_engine_get_snapshot_filename ();
+	g_autoptr(GFile) file = g_file_new_for_path (filename);
+	g_autoptr(GError) error_local = NULL;
+
+	if (!g_file_delete (file, NULL, &error_local)) {
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+			return TRUE;
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* only set when the process was started with GOBJECT_DEBUG=instance-count */
+static gboolean
+fu_engine_get_instance_counting (void)
+{
+	const GDebugKey keys[] = { { "instance-count", 1 } };
+	return g_parse_debug_string (g_getenv ("GOBJECT_DEBUG"),
+				     keys, G_N_ELEMENTS (keys)) > 0;
+}
+
+/* instance counts are per concrete type, so add every subclass too */
+static void
+fu_engine_memory_stats_add_type (GVariantBuilder *builder, GType gtype)
+{
+	gint instances = g_type_get_instance_count (gtype);
+	guint n_children = 0;
+	g_autofree GType *children = NULL;
+
+	if (instances > 0) {
+		GTypeQuery query = { 0 };
+		GVariantBuilder builder_type;
+		g_type_query (gtype, &query);
+		g_variant_builder_init (&builder_type, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&builder_type, "{sv}", "Type",
+				       g_variant_new_string (g_type_name (gtype)));
+		g_variant_builder_add (&builder_type, "{sv}", "Instances",
+				       g_variant_new_uint32 (instances));
+		g_variant_builder_add (&builder_type, "{sv}", "Bytes",
+				       g_variant_new_uint64 ((guint64) instances *
+							     query.instance_size));
+		g_variant_builder_add_value (builder,
+					     g_variant_builder_end (&builder_type));
+	}
+	children = g_type_children (gtype, &n_children);
+	for (guint i = 0; i < n_children; i++)
+		fu_engine_memory_stats_add_type (builder, children[i]);
+}
+
+/* in kB, or 0 if unknown */
+static guint64
+fu_engine_memory_stats_get_status (const gchar *key)
+{
+	g_autofree gchar *buf = NULL;
+	g_auto(GStrv) lines = NULL;
+
+	if (!g_file_get_contents ("/proc/self/status", &buf, NULL, NULL))
+		return 0;
+	lines = g_strsplit (buf, "\n", -1);
+	for (guint i = 0; lines[i] != NULL; i++) {
+		if (g_str_has_prefix (lines[i], key))
+			return g_ascii_strtoull (lines[i] + strlen (key), NULL, 10);
+	}
+	return 0;
+}
+
+GVariant *
+fu_engine_get_memory_stats (void)
+{
+	GVariantBuilder builder;
+	GVariantBuilder builder_types;
+	GType gtypes[] = {
+		FWUPD_TYPE_DEVICE,
+		FWUPD_TYPE_RELEASE,
+		FWUPD_TYPE_REMOTE,
+		FU_TYPE_FIRMWARE,
+		FU_TYPE_FIRMWARE_IMAGE,
+		FU_TYPE_INSTALL_TASK,
+		FU_TYPE_PLUGIN,
+		XB_TYPE_NODE,
+		XB_TYPE_SILO,
+	};
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "InstanceCounting",
+			       g_variant_new_boolean (fu_engine_get_instance_counting ()));
+	g_variant_builder_add (&builder, "{sv}", "ResidentSetSize",
+			       g_variant_new_uint64 (fu_engine_memory_stats_get_status ("VmRSS:")));
+	g_variant_builder_add (&builder, "{sv}", "ResidentSetSizePeak",
+			       g_variant_new_uint64 (fu_engine_memory_stats_get_status ("VmHWM:")));
+#if defined(HAVE_MALLINFO2)
+	{
+		struct mallinfo2 mi = mallinfo2 ();
+		g_variant_builder_add (&builder, "{sv}", "HeapUsed",
+				       g_variant_new_uint64 (mi.uordblks));
+	}
+#elif defined(HAVE_MALLINFO)
+	{
+		struct mallinfo mi = mallinfo ();
+		g_variant_builder_add (&builder, "{sv}", "HeapUsed",
+				       g_variant_new_uint64 ((guint) mi.uordblks));
+	}
+#endif
+	g_variant_builder_init (&builder_types, G_VARIANT_TYPE ("aa{sv}"));
+	for (guint i = 0; i < G_N_ELEMENTS (gtypes); i++)
+		fu_engine_memory_stats_add_type (&builder_types, gtypes[i]);
+	g_variant_builder_add (&builder, "{sv}", "Types",
+			       g_variant_builder_end (&builder_types));
+	return g_variant_builder_end (&builder);
+}
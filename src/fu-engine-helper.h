@@ -9,3 +9,8 @@
 
 gboolean	fu_engine_update_motd		(FuEngine	*self,
 						 GError		**error);
+gboolean	fu_engine_save_snapshot		(FuEngine	*self,
+						 GError		**error);
+GVariant	*fu_engine_load_snapshot	(GError		**error);
+gboolean	fu_engine_remove_snapshot	(GError		**error);
+GVariant	*fu_engine_get_memory_stats	(void);
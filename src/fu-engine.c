@@ -21,6 +21,9 @@
 #include <sys/utsname.h>
 #endif
 #include <errno.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 #include "fwupd-common-private.h"
 #include "fwupd-enums-private.h"
@@ -45,11 +48,14 @@
 #include "fu-history.h"
 #include "fu-mutex.h"
 #include "fu-plugin.h"
+#include "fu-plugin-index.h"
 #include "fu-plugin-list.h"
 #include "fu-plugin-private.h"
+#include "fu-profile.h"
 #include "fu-quirks.h"
 #include "fu-remote-list.h"
 #include "fu-smbios-private.h"
+#include "fu-trace.h"
 #include "fu-udev-device-private.h"
 #include "fu-usb-device-private.h"
 
@@ -62,6 +68,9 @@
 #endif
 
 static void fu_engine_finalize	 (GObject *obj);
+static FuPlugin *fu_engine_find_plugin_by_name (FuEngine	*self,
+						const gchar	*name,
+						GError		**error);
 
 struct _FuEngine
 {
@@ -77,6 +86,11 @@ struct _FuEngine
 	FwupdStatus		 status;
 	gboolean		 tainted;
 	guint			 percentage;
+	guint			 progress_id;
+	guint			 progress_pending;
+	gint64			 progress_last;		/* monotonic, in µs */
+	gint64			 monotonic_time_fake;	/* for the self tests, or 0 */
+	GPtrArray		*progress_devices;	/* of FuDevice */
 	FuHistory		*history;
 	FuIdle			*idle;
 	XbSilo			*silo;
@@ -84,8 +98,12 @@ struct _FuEngine
 	guint			 coldplug_id;
 	guint			 coldplug_delay;
 	FuPluginList		*plugin_list;
+	FuPluginIndex		*plugin_index;
+	GHashTable		*plugins_deferred;	/* name:filename */
 	GPtrArray		*plugin_filter;
 	GPtrArray		*udev_subsystems;
+	GHashTable		*udev_routes;		/* subsystem:GPtrArray of FuPlugin */
+	GHashTable		*usb_routes;		/* guid */
 #ifdef HAVE_GUDEV
 	GHashTable		*udev_changed_ids;	/* sysfs:FuEngineUdevChangedHelper */
 #endif
@@ -98,6 +116,7 @@ struct _FuEngine
 	GHashTable		*firmware_gtypes;
 	gchar			*host_machine_id;
 	JcatContext		*jcat_context;
+	FuProfile		*profile;
 	gboolean		 loaded;
 };
 
@@ -199,18 +218,92 @@ fu_engine_set_percentage (FuEngine *self, guint percentage)
 	g_signal_emit (self, signals[SIGNAL_PERCENTAGE_CHANGED], 0, percentage);
 }
 
+static gint64
+fu_engine_get_monotonic_time (FuEngine *self)
+{
+	if (self->monotonic_time_fake != 0)
+		return self->monotonic_time_fake;
+	return g_get_monotonic_time ();
+}
+
+/* send the latest percentage, and tell clients the devices have changed */
+static void
+fu_engine_progress_flush (FuEngine *self)
+{
+	g_autoptr(GPtrArray) devices = self->progress_devices;
+
+	if (self->progress_id != 0) {
+		g_source_remove (self->progress_id);
+		self->progress_id = 0;
+	}
+	self->progress_devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	self->progress_last = fu_engine_get_monotonic_time (self);
+	fu_engine_set_percentage (self, self->progress_pending);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_engine_emit_device_changed (self, device);
+	}
+}
+
+static gboolean
+fu_engine_progress_flush_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	self->progress_id = 0;
+	fu_engine_progress_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_engine_progress_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *self)
 {
+	gboolean found = FALSE;
+	guint rate_max = fu_config_get_progress_rate_max (self->config);
+	gint64 elapsed;
+	gint64 interval;
+
 	if (fu_device_get_status (device) == FWUPD_STATUS_UNKNOWN)
 		return;
-	fu_engine_set_percentage (self, fu_device_get_progress (device));
-	fu_engine_emit_device_changed (self, device);
+	self->progress_pending = fu_device_get_progress (device);
+	for (guint i = 0; i < self->progress_devices->len; i++) {
+		if (g_ptr_array_index (self->progress_devices, i) == device) {
+			found = TRUE;
+			break;
+		}
+	}
+	if (!found)
+		g_ptr_array_add (self->progress_devices, g_object_ref (device));
+
+	/* the start and end are never delayed */
+	if (rate_max == 0 ||
+	    self->progress_pending == 0 ||
+	    self->progress_pending == 100) {
+		fu_engine_progress_flush (self);
+		return;
+	}
+
+	/* the main loop is not run during a blocking update, so send as soon
+	 * as the interval is over rather than waiting for the timeout */
+	interval = G_USEC_PER_SEC / rate_max;
+	elapsed = fu_engine_get_monotonic_time (self) - self->progress_last;
+	if (elapsed >= interval) {
+		fu_engine_progress_flush (self);
+		return;
+	}
+
+	/* deliver the last value if the updates stop arriving */
+	if (self->progress_id == 0) {
+		self->progress_id = g_timeout_add ((interval - elapsed) / 1000 + 1,
+						   fu_engine_progress_flush_cb, self);
+	}
 }
 
 static void
 fu_engine_status_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *self)
 {
+	/* clients should see the final percentage of the last phase first */
+	if (self->progress_devices->len > 0)
+		fu_engine_progress_flush (self);
 	fu_engine_set_status (self, fu_device_get_status (device));
 	fu_engine_emit_device_changed (self, device);
 }
@@ -254,6 +347,7 @@ static void
 fu_engine_device_removed_cb (FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_device_runner_device_removed (self, device);
+	g_ptr_array_remove (self->progress_devices, device);
 	g_signal_handlers_disconnect_by_data (device, self);
 	g_signal_emit (self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
 }
@@ -481,9 +575,9 @@ fu_engine_unlock (FuEngine *self, const gchar *device_id, GError **error)
 		return FALSE;
 
 	/* get the plugin */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -666,9 +760,9 @@ fu_engine_verify_update (FuEngine *self, const gchar *device_id, GError **error)
 		return FALSE;
 
 	/* get the plugin */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -793,9 +887,9 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 		return FALSE;
 
 	/* get the plugin */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -1462,11 +1556,15 @@ fu_engine_install_tasks (FuEngine *self,
 		return FALSE;
 	}
 
-	/* all authenticated, so install all the things */
+	/* all authenticated, so install all the things, parsing the payload
+	 * only once for identical devices */
+	if (install_tasks->len > 1)
+		fu_device_set_firmware_cache_enabled (TRUE);
 	for (guint i = 0; i < install_tasks->len; i++) {
 		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
 		if (!fu_engine_install (self, task, blob_cab, flags, error)) {
 			g_autoptr(GError) error_local = NULL;
+			fu_device_set_firmware_cache_enabled (FALSE);
 			if (!fu_engine_composite_cleanup (self, devices, &error_local)) {
 				g_warning ("failed to cleanup failed composite action: %s",
 					   error_local->message);
@@ -1474,6 +1572,7 @@ fu_engine_install_tasks (FuEngine *self,
 			return FALSE;
 		}
 	}
+	fu_device_set_firmware_cache_enabled (FALSE);
 
 	/* set all the device statuses back to unknown */
 	for (guint i = 0; i < install_tasks->len; i++) {
@@ -1536,9 +1635,9 @@ fu_engine_create_release_metadata (FuEngine *self, FuPlugin *plugin, GError **er
 		const gchar *plugin_name = g_ptr_array_index (metadata_sources, i);
 		g_autoptr(GError) error_local = NULL;
 
-		plugin_tmp = fu_plugin_list_find_by_name (self->plugin_list,
-							  plugin_name,
-							  &error_local);
+		plugin_tmp = fu_engine_find_plugin_by_name (self,
+							    plugin_name,
+							    &error_local);
 		if (plugin_tmp == NULL) {
 			g_warning ("could not add metadata for %s: %s",
 				   plugin_name,
@@ -1768,9 +1867,9 @@ fu_engine_install_release (FuEngine *self,
 	}
 
 	/* get the plugin */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -2015,7 +2114,7 @@ fu_engine_install (FuEngine *self,
 			g_prefix_error (error, "failed to get release version: ");
 			return FALSE;
 		}
-		plugin = fu_plugin_list_find_by_name (self->plugin_list, "upower", NULL);
+		plugin = fu_engine_find_plugin_by_name (self, "upower", NULL);
 		if (plugin != NULL) {
 			if (!fu_plugin_runner_update_prepare (plugin, flags, device, error))
 				return FALSE;
@@ -2228,9 +2327,9 @@ fu_engine_update_detach (FuEngine *self, const gchar *device_id, GError **error)
 		return FALSE;
 	str = fu_device_to_string (device);
 	g_debug ("performing detach on %s", str);
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 	if (!fu_plugin_runner_update_detach (plugin, device, error))
@@ -2253,9 +2352,9 @@ fu_engine_update_attach (FuEngine *self, const gchar *device_id, GError **error)
 	}
 	str = fu_device_to_string (device);
 	g_debug ("performing attach on %s", str);
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -2286,9 +2385,9 @@ fu_engine_activate (FuEngine *self, const gchar *device_id, GError **error)
 		return FALSE;
 	str = fu_device_to_string (device);
 	g_debug ("performing activate on %s", str);
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 	g_debug ("Activating %s", fu_device_get_name (device));
@@ -2317,9 +2416,9 @@ fu_engine_update_reload (FuEngine *self, const gchar *device_id, GError **error)
 	}
 	str = fu_device_to_string (device);
 	g_debug ("performing reload on %s", str);
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 
@@ -2360,9 +2459,9 @@ fu_engine_update (FuEngine *self,
 	device_pending = fu_history_get_device_by_id (self->history, device_id, NULL);
 	str = fu_device_to_string (device);
 	g_debug ("performing update on %s", str);
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 	if (!fu_plugin_runner_update (plugin, device, blob_fw2, flags, error)) {
@@ -2578,6 +2677,14 @@ fu_engine_set_silo (FuEngine *self, XbSilo *silo)
 	g_set_object (&self->silo, silo);
 }
 
+/* for the self tests, where 0 uses the real clock again */
+void
+fu_engine_set_monotonic_time (FuEngine *self, gint64 monotonic_time)
+{
+	g_return_if_fail (FU_IS_ENGINE (self));
+	self->monotonic_time_fake = monotonic_time;
+}
+
 static gboolean
 fu_engine_appstream_upgrade_cb (XbBuilderFixup *self,
 				XbBuilderNode *bn,
@@ -2952,7 +3059,9 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 	cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
 	xmlbfn = g_build_filename (cachedirpkg, "metadata.xmlb", NULL);
 	xmlb = g_file_new_for_path (xmlbfn);
+	FU_TRACE1 (silo_build_start, "metadata");
 	self->silo = xb_builder_ensure (builder, xmlb, compile_flags, NULL, error);
+	FU_TRACE2 (silo_build_done, "metadata", self->silo != NULL);
 	if (self->silo == NULL)
 		return FALSE;
 
@@ -2975,6 +3084,31 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 	return TRUE;
 }
 
+/* reloading the silos must not be done while components are in use */
+void
+fu_engine_drop_caches (FuEngine *self, gboolean reload_silos)
+{
+	g_return_if_fail (FU_IS_ENGINE (self));
+
+	/* sysfs attributes are read again when next used */
+	fu_udev_device_cache_invalidate (NULL);
+
+	/* the silos keep every node that has been queried */
+	if (reload_silos) {
+		g_autoptr(GError) error_local = NULL;
+		fu_quirks_invalidate (self->quirks);
+		if (!fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE,
+						    &error_local))
+			g_warning ("Failed to reload metadata store: %s",
+				   error_local->message);
+	}
+
+#ifdef HAVE_MALLOC_TRIM
+	/* give the free pages back to the kernel */
+	malloc_trim (0);
+#endif
+}
+
 static void
 fu_engine_config_changed_cb (FuConfig *config, FuEngine *self)
 {
@@ -4174,9 +4308,9 @@ fu_engine_clear_results (FuEngine *self, const gchar *device_id, GError **error)
 	}
 
 	/* call into the plugin if it still exists */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (device),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (device),
+					        error);
 	if (plugin != NULL) {
 		if (!fu_plugin_runner_clear_results (plugin, device, error))
 			return FALSE;
@@ -4233,10 +4367,12 @@ fu_engine_plugins_setup (FuEngine *self)
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, fu_plugin_get_name (plugin));
 		if (!fu_plugin_runner_startup (plugin, &error)) {
 			fu_plugin_set_enabled (plugin, FALSE);
 			g_message ("disabling plugin because: %s", error->message);
 		}
+		fu_profile_pop (self->profile);
 	}
 }
 
@@ -4251,23 +4387,31 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 
 	/* prepare */
 	plugins = fu_plugin_list_get_all (self->plugin_list);
+	fu_profile_push (self->profile, "prepare");
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, fu_plugin_get_name (plugin));
 		if (!fu_plugin_runner_coldplug_prepare (plugin, &error))
 			g_warning ("failed to prepare coldplug: %s", error->message);
+		fu_profile_pop (self->profile);
 	}
+	fu_profile_pop (self->profile);
 
 	/* do this in one place */
 	if (self->coldplug_delay > 0) {
 		g_debug ("sleeping for %ums", self->coldplug_delay);
+		fu_profile_push (self->profile, "delay");
 		g_usleep (self->coldplug_delay * 1000);
+		fu_profile_pop (self->profile);
 	}
 
 	/* exec */
+	fu_profile_push (self->profile, "exec");
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, fu_plugin_get_name (plugin));
 		if (is_recoldplug) {
 			if (!fu_plugin_runner_recoldplug (plugin, &error))
 				g_message ("failed recoldplug: %s", error->message);
@@ -4278,15 +4422,21 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 					   error->message);
 			}
 		}
+		fu_profile_pop (self->profile);
 	}
+	fu_profile_pop (self->profile);
 
 	/* cleanup */
+	fu_profile_push (self->profile, "cleanup");
 	for (guint i = 0; i < plugins->len; i++) {
 		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, fu_plugin_get_name (plugin));
 		if (!fu_plugin_runner_coldplug_cleanup (plugin, &error))
 			g_warning ("failed to cleanup coldplug: %s", error->message);
+		fu_profile_pop (self->profile);
 	}
+	fu_profile_pop (self->profile);
 
 	/* print what we do have */
 	for (guint i = 0; i < plugins->len; i++) {
@@ -4561,6 +4711,14 @@ fu_engine_plugin_rules_changed_cb (FuPlugin *plugin, gpointer user_data)
 	}
 }
 
+void
+fu_engine_remove_device (FuEngine *self, FuDevice *device)
+{
+	/* make the UI update */
+	fu_device_list_remove (self->device_list, device);
+	fu_engine_emit_changed (self);
+}
+
 static void
 fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 				    FuDevice *device,
@@ -4580,9 +4738,9 @@ fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 	}
 
 	/* get the plugin */
-	plugin_old = fu_plugin_list_find_by_name (self->plugin_list,
-						  fu_device_get_plugin (device),
-						  &error);
+	plugin_old = fu_engine_find_plugin_by_name (self,
+						    fu_device_get_plugin (device),
+						    &error);
 	if (plugin_old == NULL) {
 		g_debug ("%s", error->message);
 		return;
@@ -4595,10 +4753,7 @@ fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 			 fu_plugin_get_name (plugin));
 		return;
 	}
-
-	/* make the UI update */
-	fu_device_list_remove (self->device_list, device);
-	fu_engine_emit_changed (self);
+	fu_engine_remove_device (self, device);
 }
 
 static gboolean
@@ -4611,21 +4766,104 @@ fu_engine_recoldplug_delay_cb (gpointer user_data)
 	return FALSE;
 }
 
+static void
+fu_engine_check_plugin_build_hash (FuEngine *self, FuPlugin *plugin)
+{
+	/* plugin does not match built version */
+	if (fu_plugin_get_build_hash (plugin) == NULL) {
+		const gchar *name = fu_plugin_get_name (plugin);
+		g_warning ("%s should call fu_plugin_set_build_hash()",
+			   name);
+		self->tainted = TRUE;
+	} else if (g_strcmp0 (fu_plugin_get_build_hash (plugin),
+			      FU_BUILD_HASH) != 0) {
+		const gchar *name = fu_plugin_get_name (plugin);
+		g_warning ("%s has incorrect built version %s",
+			   name, fu_plugin_get_build_hash (plugin));
+		self->tainted = TRUE;
+	}
+}
+
+/* open a plugin that was deferred at startup, as a device now needs it */
+static gboolean
+fu_engine_ensure_plugin_open (FuEngine *self, FuPlugin *plugin, GError **error)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	filename = g_strdup (g_hash_table_lookup (self->plugins_deferred, name));
+	if (filename == NULL)
+		return TRUE;
+	g_hash_table_remove (self->plugins_deferred, name);
+	g_debug ("opening deferred plugin %s", filename);
+	if (!fu_plugin_open (plugin, filename, error)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		return FALSE;
+	}
+	fu_engine_check_plugin_build_hash (self, plugin);
+
+	/* do what would have happened at startup */
+	if (!fu_plugin_runner_startup (plugin, &error_local)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		g_message ("disabling plugin because: %s", error_local->message);
+		return TRUE;
+	}
+	if (!fu_plugin_runner_coldplug_prepare (plugin, &error_local)) {
+		g_warning ("failed to prepare coldplug: %s", error_local->message);
+		g_clear_error (&error_local);
+	}
+	if (!fu_plugin_runner_coldplug (plugin, &error_local)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		g_message ("disabling plugin because: %s", error_local->message);
+		g_clear_error (&error_local);
+	}
+	if (!fu_plugin_runner_coldplug_cleanup (plugin, &error_local))
+		g_warning ("failed to cleanup coldplug: %s", error_local->message);
+	return TRUE;
+}
+
+/* the plugin may have been deferred, so open it before using it */
+static FuPlugin *
+fu_engine_find_plugin_by_name (FuEngine *self, const gchar *name, GError **error)
+{
+	FuPlugin *plugin = fu_plugin_list_find_by_name (self->plugin_list, name, error);
+	if (plugin == NULL)
+		return NULL;
+	if (!fu_engine_ensure_plugin_open (self, plugin, error))
+		return NULL;
+	return plugin;
+}
+
 #ifdef HAVE_GUDEV
+static gboolean
+fu_engine_udev_device_has_route (FuEngine *self, GUdevDevice *udev_device)
+{
+	const gchar *subsystem = g_udev_device_get_subsystem (udev_device);
+	if (subsystem == NULL)
+		return FALSE;
+	return g_hash_table_contains (self->udev_routes, subsystem);
+}
+
 static void
 fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 {
-	g_autoptr(FuUdevDevice) device = fu_udev_device_new (udev_device);
+	g_autoptr(FuUdevDevice) device = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) possible_plugins = NULL;
 
 	/* debug */
-	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 		g_debug ("UDEV %s added",
 			 g_udev_device_get_sysfs_path (udev_device));
 	}
 
+	/* only watched by plugins that are now disabled */
+	if (!fu_engine_udev_device_has_route (self, udev_device))
+		return;
+
 	/* add any extra quirks */
+	device = fu_udev_device_new (udev_device);
 	fu_device_set_quirks (FU_DEVICE (device), self->quirks);
 	if (!fu_device_probe (FU_DEVICE (device), &error_local)) {
 		g_warning ("failed to probe device %s: %s",
@@ -4639,6 +4877,7 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 	for (guint i = 0; i < possible_plugins->len; i++) {
 		FuPlugin *plugin;
 		const gchar *plugin_name = g_ptr_array_index (possible_plugins, i);
+		gboolean ret;
 		g_autoptr(GError) error = NULL;
 
 		plugin = fu_plugin_list_find_by_name (self->plugin_list,
@@ -4648,9 +4887,17 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 				 plugin_name, error->message);
 			continue;
 		}
-		if (!fu_plugin_runner_udev_device_added (plugin, device, &error)) {
+		if (!fu_engine_ensure_plugin_open (self, plugin, &error)) {
+			g_warning ("failed to open plugin %s: %s",
+				   plugin_name, error->message);
+			continue;
+		}
+		fu_profile_push (self->profile, plugin_name);
+		ret = fu_plugin_runner_udev_device_added (plugin, device, &error);
+		fu_profile_pop (self->profile);
+		if (!ret) {
 			if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-				if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+				if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 					g_debug ("%s ignoring: %s",
 						 fu_plugin_get_name (plugin),
 						 error->message);
@@ -4671,7 +4918,7 @@ fu_engine_udev_device_remove (FuEngine *self, GUdevDevice *udev_device)
 	g_autoptr(GPtrArray) devices = NULL;
 
 	/* debug */
-	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 		g_debug ("UDEV %s removed",
 			 g_udev_device_get_sysfs_path (udev_device));
 	}
@@ -4719,10 +4966,11 @@ static gboolean
 fu_engine_udev_changed_cb (gpointer user_data)
 {
 	FuEngineUdevChangedHelper *helper = (FuEngineUdevChangedHelper *) user_data;
-	GPtrArray *plugins = fu_plugin_list_get_all (helper->self->plugin_list);
+	const gchar *subsystem = g_udev_device_get_subsystem (helper->udev_device);
+	GPtrArray *plugins = g_hash_table_lookup (helper->self->udev_routes, subsystem);
 	g_autoptr(FuUdevDevice) device = fu_udev_device_new (helper->udev_device);
 
-	/* run all plugins */
+	/* run all plugins watching the subsystem */
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
 		g_autoptr(GError) error = NULL;
@@ -4766,6 +5014,10 @@ fu_engine_udev_device_changed (FuEngine *self, GUdevDevice *udev_device)
 		}
 	}
 
+	/* no enabled plugin watches this subsystem */
+	if (!fu_engine_udev_device_has_route (self, udev_device))
+		return;
+
 	/* run all plugins, with per-device rate limiting */
 	if (g_hash_table_remove (self->udev_changed_ids, sysfs_path)) {
 		g_debug ("re-adding rate-limited timeout for %s", sysfs_path);
@@ -4780,6 +5032,9 @@ fu_engine_udev_device_changed (FuEngine *self, GUdevDevice *udev_device)
 static void
 fu_engine_enumerate_udev (FuEngine *self)
 {
+	/* parents are shared by many devices, but only cache them for this pass */
+	fu_udev_device_cache_set_enabled (TRUE);
+
 	/* get all devices of class */
 	for (guint i = 0; i < self->udev_subsystems->len; i++) {
 		const gchar *subsystem = g_ptr_array_index (self->udev_subsystems, i);
@@ -4787,13 +5042,20 @@ fu_engine_enumerate_udev (FuEngine *self)
 								   subsystem);
 		g_debug ("%u devices with subsystem %s",
 			 g_list_length (devices), subsystem);
+		fu_profile_push (self->profile, subsystem);
 		for (GList *l = devices; l != NULL; l = l->next) {
 			GUdevDevice *udev_device = l->data;
+			fu_profile_push (self->profile, g_udev_device_get_name (udev_device));
 			fu_engine_udev_device_add (self, udev_device);
+			fu_profile_pop (self->profile);
 		}
+		fu_profile_pop (self->profile);
 		g_list_foreach (devices, (GFunc) g_object_unref, NULL);
 		g_list_free (devices);
 	}
+
+	/* hotplugged devices can reuse the same sysfs path */
+	fu_udev_device_cache_set_enabled (FALSE);
 }
 #endif
 
@@ -4830,25 +5092,126 @@ fu_engine_plugin_set_coldplug_delay_cb (FuPlugin *plugin, guint duration, FuEngi
 void
 fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
 {
-	if (fu_plugin_is_open (plugin)) {
-		/* plugin does not match built version */
-		if (fu_plugin_get_build_hash (plugin) == NULL) {
-			const gchar *name = fu_plugin_get_name (plugin);
-			g_warning ("%s should call fu_plugin_set_build_hash()",
-				   name);
-			self->tainted = TRUE;
-		} else if (g_strcmp0 (fu_plugin_get_build_hash (plugin),
-				      FU_BUILD_HASH) != 0) {
-			const gchar *name = fu_plugin_get_name (plugin);
-			g_warning ("%s has incorrect built version %s",
-				   name, fu_plugin_get_build_hash (plugin));
-			self->tainted = TRUE;
-		}
+	if (fu_plugin_is_open (plugin))
+		fu_engine_check_plugin_build_hash (self, plugin);
+	fu_plugin_list_add (self->plugin_list, plugin);
+}
+
+static void
+fu_engine_plugin_index_add_sysfs_ids (GPtrArray *ids,
+				      const gchar *bus,
+				      const gchar *vendor_fn,
+				      const gchar *product_fn)
+{
+	const gchar *fn;
+	g_autofree gchar *path = g_build_filename ("/sys/bus", bus, "devices", NULL);
+	g_autoptr(GDir) dir = NULL;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *fn_vendor = g_build_filename (path, fn, vendor_fn, NULL);
+		g_autofree gchar *fn_product = g_build_filename (path, fn, product_fn, NULL);
+		g_autofree gchar *vendor = NULL;
+		g_autofree gchar *product = NULL;
+		if (!g_file_get_contents (fn_vendor, &vendor, NULL, NULL))
+			continue;
+		if (!g_file_get_contents (fn_product, &product, NULL, NULL))
+			continue;
+		g_ptr_array_add (ids, g_strdup_printf ("%s:%s:%s", bus,
+						       g_strstrip (vendor),
+						       g_strstrip (product)));
 	}
+}
 
-	fu_plugin_list_add (self->plugin_list, plugin);
+static gint
+fu_engine_plugin_index_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* changes when the plugins, the machine or the attached hardware change */
+static gchar *
+fu_engine_get_plugin_index_key (FuEngine *self)
+{
+	const gchar *fn;
+	GPtrArray *guids = fu_hwids_get_guids (self->hwids);
+	g_autofree gchar *plugin_path = fu_common_get_path (FU_PATH_KIND_PLUGINDIR_PKG);
+	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GPtrArray) ids = g_ptr_array_new_with_free_func (g_free);
+
+	dir = g_dir_open (plugin_path, 0, NULL);
+	if (dir != NULL) {
+		while ((fn = g_dir_read_name (dir)) != NULL)
+			g_ptr_array_add (ids, g_strdup (fn));
+	}
+	for (guint i = 0; i < guids->len; i++) {
+		const gchar *guid = g_ptr_array_index (guids, i);
+		g_ptr_array_add (ids, g_strdup (guid));
+	}
+	fu_engine_plugin_index_add_sysfs_ids (ids, "usb", "idVendor", "idProduct");
+	fu_engine_plugin_index_add_sysfs_ids (ids, "pci", "vendor", "device");
+	g_ptr_array_sort (ids, fu_engine_plugin_index_sort_cb);
+
+	g_checksum_update (csum, (const guchar *) FU_BUILD_HASH, -1);
+	for (guint i = 0; i < ids->len; i++) {
+		const gchar *id = g_ptr_array_index (ids, i);
+		g_checksum_update (csum, (const guchar *) id, -1);
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+static void
+fu_engine_load_plugin_index (FuEngine *self)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *filename = g_build_filename (cachedirpkg, "plugins.index", NULL);
+	g_autofree gchar *key = fu_engine_get_plugin_index_key (self);
+	g_autoptr(GError) error = NULL;
+	if (!fu_plugin_index_load (self->plugin_index, filename, key, &error)) {
+		g_warning ("failed to load plugin index: %s", error->message);
+		return;
+	}
+
+	/* only written back if the engine loads successfully */
+	if (!fu_plugin_index_invalidate (self->plugin_index, &error))
+		g_warning ("failed to invalidate plugin index: %s", error->message);
+}
+
+static void
+fu_engine_save_plugin_index (FuEngine *self)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) device_counts = g_hash_table_new (g_str_hash, g_str_equal);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_all (self->device_list);
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		const gchar *name = fu_device_get_plugin (device);
+		guint cnt;
+		if (name == NULL)
+			continue;
+		cnt = GPOINTER_TO_UINT (g_hash_table_lookup (device_counts, name));
+		g_hash_table_insert (device_counts, (gpointer) name, GUINT_TO_POINTER (cnt + 1));
+	}
+
+	/* deferred plugins keep what was recorded before */
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		const gchar *name = fu_plugin_get_name (plugin);
+		if (!fu_plugin_is_open (plugin))
+			continue;
+		fu_plugin_index_add_plugin (self->plugin_index, plugin,
+					    GPOINTER_TO_UINT (g_hash_table_lookup (device_counts, name)));
+	}
+	if (!fu_plugin_index_save (self->plugin_index, &error))
+		g_warning ("failed to save plugin index: %s", error->message);
 }
 
+
 static gboolean
 fu_engine_is_plugin_name_blacklisted (FuEngine *self, const gchar *name)
 {
@@ -4904,6 +5267,13 @@ fu_engine_get_tainted (FuEngine *self)
 	return self->tainted;
 }
 
+FuProfile *
+fu_engine_get_profile (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	return self->profile;
+}
+
 const gchar *
 fu_engine_get_host_product (FuEngine *self)
 {
@@ -4920,6 +5290,42 @@ fu_engine_get_host_machine_id (FuEngine *self)
 	return self->host_machine_id;
 }
 
+/* watch everything any plugin asked for, even if it later disables itself */
+static void
+fu_engine_add_udev_subsystems (FuEngine *self, FuPlugin *plugin)
+{
+	GPtrArray *udev_subsystems = fu_plugin_get_udev_subsystems (plugin);
+	for (guint i = 0; i < udev_subsystems->len; i++) {
+		const gchar *subsystem = g_ptr_array_index (udev_subsystems, i);
+		gboolean found = FALSE;
+		for (guint j = 0; j < self->udev_subsystems->len; j++) {
+			const gchar *subsystem_tmp = g_ptr_array_index (self->udev_subsystems, j);
+			if (g_strcmp0 (subsystem_tmp, subsystem) == 0) {
+				found = TRUE;
+				break;
+			}
+		}
+		if (!found)
+			g_ptr_array_add (self->udev_subsystems, g_strdup (subsystem));
+	}
+}
+
+/* only enabled plugins are sent udev events for the subsystems they watch */
+static void
+fu_engine_add_udev_routes (FuEngine *self, FuPlugin *plugin)
+{
+	GPtrArray *udev_subsystems = fu_plugin_get_udev_subsystems (plugin);
+	for (guint i = 0; i < udev_subsystems->len; i++) {
+		const gchar *subsystem = g_ptr_array_index (udev_subsystems, i);
+		GPtrArray *plugins = g_hash_table_lookup (self->udev_routes, subsystem);
+		if (plugins == NULL) {
+			plugins = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+			g_hash_table_insert (self->udev_routes, g_strdup (subsystem), plugins);
+		}
+		g_ptr_array_add (plugins, g_object_ref (plugin));
+	}
+}
+
 gboolean
 fu_engine_load_plugins (FuEngine *self, GError **error)
 {
@@ -4963,7 +5369,6 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 		fu_plugin_set_usb_context (plugin, self->usb_ctx);
 		fu_plugin_set_hwids (plugin, self->hwids);
 		fu_plugin_set_smbios (plugin, self->smbios);
-		fu_plugin_set_udev_subsystems (plugin, self->udev_subsystems);
 		fu_plugin_set_quirks (plugin, self->quirks);
 		fu_plugin_set_runtime_versions (plugin, self->runtime_versions);
 		fu_plugin_set_compile_versions (plugin, self->compile_versions);
@@ -4972,13 +5377,32 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 				  self);
 		g_debug ("adding plugin %s", filename);
 
+		/* found nothing on this hardware last time, so open it
+		 * only when a device is routed to it */
+		if (fu_plugin_index_can_defer (self->plugin_index, name)) {
+			g_debug ("deferring open of %s", name);
+			fu_plugin_index_restore (self->plugin_index, plugin);
+			g_hash_table_insert (self->plugins_deferred,
+					     g_strdup (name),
+					     g_strdup (filename));
+
 		/* if loaded from fu_engine_load() open the plugin */
-		if (self->usb_ctx != NULL) {
-			if (!fu_plugin_open (plugin, filename, &error_local)) {
+		} else if (self->usb_ctx != NULL) {
+			gboolean ret;
+
+			fu_profile_push (self->profile, name);
+			ret = fu_plugin_open (plugin, filename, &error_local);
+			fu_profile_pop (self->profile);
+			if (!ret) {
 				g_warning ("%s", error_local->message);
 				continue;
 			}
+
+			/* so that udev events can be routed when deferred */
+			fu_plugin_index_set_udev_subsystems (self->plugin_index, name,
+							     fu_plugin_get_udev_subsystems (plugin));
 		}
+		fu_engine_add_udev_subsystems (self, plugin);
 
 		/* self disabled */
 		if (!fu_plugin_get_enabled (plugin)) {
@@ -5011,6 +5435,7 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 				  self);
 
 		/* add */
+		fu_engine_add_udev_routes (self, plugin);
 		fu_engine_add_plugin (self, plugin);
 	}
 
@@ -5045,6 +5470,12 @@ fu_engine_get_archive_size_max (FuEngine *self)
 	return fu_config_get_archive_size_max (self->config);
 }
 
+gboolean
+fu_engine_get_warm_start (FuEngine *self)
+{
+	return fu_config_get_warm_start (self->config);
+}
+
 static void
 fu_engine_usb_device_removed_cb (GUsbContext *ctx,
 				 GUsbDevice *usb_device,
@@ -5053,7 +5484,7 @@ fu_engine_usb_device_removed_cb (GUsbContext *ctx,
 	g_autoptr(GPtrArray) devices = NULL;
 
 	/* debug */
-	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 		g_debug ("USB %04x:%04x removed",
 			 g_usb_device_get_vid (usb_device),
 			 g_usb_device_get_pid (usb_device));
@@ -5073,23 +5504,81 @@ fu_engine_usb_device_removed_cb (GUsbContext *ctx,
 	}
 }
 
+/* uses the same instance IDs as fu_usb_device_probe() */
+static gboolean
+fu_engine_usb_device_has_route (FuEngine *self, GUsbDevice *usb_device)
+{
+	guint16 vid = g_usb_device_get_vid (usb_device);
+	guint16 pid = g_usb_device_get_pid (usb_device);
+	g_autoptr(GPtrArray) instance_ids = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) intfs = NULL;
+
+	/* quirks failed to load, so probe everything */
+	if (g_hash_table_size (self->usb_routes) == 0)
+		return TRUE;
+
+	g_ptr_array_add (instance_ids,
+			 g_strdup_printf ("USB\\VID_%04X&PID_%04X&REV_%04X",
+					  vid, pid, g_usb_device_get_release (usb_device)));
+	g_ptr_array_add (instance_ids,
+			 g_strdup_printf ("USB\\VID_%04X&PID_%04X", vid, pid));
+	g_ptr_array_add (instance_ids,
+			 g_strdup_printf ("USB\\VID_%04X", vid));
+
+	/* let the probe report the error */
+	intfs = g_usb_device_get_interfaces (usb_device, NULL);
+	if (intfs == NULL)
+		return TRUE;
+	for (guint i = 0; i < intfs->len; i++) {
+		GUsbInterface *intf = g_ptr_array_index (intfs, i);
+		g_ptr_array_add (instance_ids,
+				 g_strdup_printf ("USB\\CLASS_%02X&SUBCLASS_%02X&PROT_%02X",
+						  g_usb_interface_get_class (intf),
+						  g_usb_interface_get_subclass (intf),
+						  g_usb_interface_get_protocol (intf)));
+		g_ptr_array_add (instance_ids,
+				 g_strdup_printf ("USB\\CLASS_%02X&SUBCLASS_%02X",
+						  g_usb_interface_get_class (intf),
+						  g_usb_interface_get_subclass (intf)));
+		g_ptr_array_add (instance_ids,
+				 g_strdup_printf ("USB\\CLASS_%02X",
+						  g_usb_interface_get_class (intf)));
+	}
+	for (guint i = 0; i < instance_ids->len; i++) {
+		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
+		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		if (g_hash_table_contains (self->usb_routes, guid))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static void
-fu_engine_usb_device_added_cb (GUsbContext *ctx,
-			       GUsbDevice *usb_device,
-			       FuEngine *self)
+fu_engine_usb_device_add (FuEngine *self, GUsbDevice *usb_device)
 {
-	g_autoptr(FuUsbDevice) device = fu_usb_device_new (usb_device);
+	g_autoptr(FuUsbDevice) device = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) possible_plugins = NULL;
 
 	/* debug */
-	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+	if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 		g_debug ("USB %04x:%04x added",
 			 g_usb_device_get_vid (usb_device),
 			 g_usb_device_get_pid (usb_device));
 	}
 
+	/* no quirk can set a plugin for this device */
+	if (!fu_engine_usb_device_has_route (self, usb_device)) {
+		if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
+			g_debug ("USB %04x:%04x has no route",
+				 g_usb_device_get_vid (usb_device),
+				 g_usb_device_get_pid (usb_device));
+		}
+		return;
+	}
+
 	/* add any extra quirks */
+	device = fu_usb_device_new (usb_device);
 	fu_device_set_quirks (FU_DEVICE (device), self->quirks);
 	if (!fu_device_probe (FU_DEVICE (device), &error_local)) {
 		g_warning ("failed to probe device %s: %s",
@@ -5103,6 +5592,7 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 	for (guint i = 0; i < possible_plugins->len; i++) {
 		FuPlugin *plugin;
 		const gchar *plugin_name = g_ptr_array_index (possible_plugins, i);
+		gboolean ret;
 		g_autoptr(GError) error = NULL;
 
 		plugin = fu_plugin_list_find_by_name (self->plugin_list,
@@ -5112,9 +5602,17 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 				 plugin_name, error->message);
 			continue;
 		}
-		if (!fu_plugin_runner_usb_device_added (plugin, device, &error)) {
+		if (!fu_engine_ensure_plugin_open (self, plugin, &error)) {
+			g_warning ("failed to open plugin %s: %s",
+				   plugin_name, error->message);
+			continue;
+		}
+		fu_profile_push (self->profile, plugin_name);
+		ret = fu_plugin_runner_usb_device_added (plugin, device, &error);
+		fu_profile_pop (self->profile);
+		if (!ret) {
 			if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-				if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+				if (fu_common_is_verbose ("FWUPD_PROBE_VERBOSE")) {
 					g_debug ("%s ignoring: %s",
 						 fu_plugin_get_name (plugin),
 						 error->message);
@@ -5130,12 +5628,54 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 	}
 }
 
+static void
+fu_engine_usb_device_added_cb (GUsbContext *ctx,
+			       GUsbDevice *usb_device,
+			       FuEngine *self)
+{
+	g_autofree gchar *id = NULL;
+
+	/* only allocate when the span is actually going to be recorded */
+	if (fu_profile_get_enabled (self->profile)) {
+		id = g_strdup_printf ("%04x:%04x",
+				      g_usb_device_get_vid (usb_device),
+				      g_usb_device_get_pid (usb_device));
+		fu_profile_push (self->profile, id);
+	}
+	fu_engine_usb_device_add (self, usb_device);
+	if (id != NULL)
+		fu_profile_pop (self->profile);
+}
+
 static void
 fu_engine_load_quirks (FuEngine *self, FuQuirksLoadFlags quirks_flags)
 {
+	const gchar *keys[] = { FU_QUIRKS_PLUGIN, FU_QUIRKS_GUID, NULL };
 	g_autoptr(GError) error = NULL;
-	if (!fu_quirks_load (self->quirks, quirks_flags, &error))
+	if (!fu_quirks_load (self->quirks, quirks_flags, &error)) {
 		g_warning ("Failed to load quirks: %s", error->message);
+		return;
+	}
+
+	/* a USB device has to match one of these groups to have a plugin set,
+	 * and a Guid may add a group that sets the plugin so is included too */
+	g_hash_table_remove_all (self->usb_routes);
+	for (guint i = 0; keys[i] != NULL; i++) {
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) groups = NULL;
+		groups = fu_quirks_get_groups_with_key (self->quirks, keys[i], &error_local);
+		if (groups == NULL) {
+			g_warning ("failed to get quirks with %s: %s",
+				   keys[i], error_local->message);
+			g_hash_table_remove_all (self->usb_routes);
+			return;
+		}
+		for (guint j = 0; j < groups->len; j++) {
+			const gchar *group = g_ptr_array_index (groups, j);
+			g_hash_table_add (self->usb_routes, g_strdup (group));
+		}
+	}
+	g_debug ("%u USB quirk routes", g_hash_table_size (self->usb_routes));
 }
 
 static void
@@ -5212,9 +5752,9 @@ fu_engine_update_history_device (FuEngine *self, FuDevice *dev_history, GError *
 	}
 
 	/* does the plugin know the update failure */
-	plugin = fu_plugin_list_find_by_name (self->plugin_list,
-					      fu_device_get_plugin (dev),
-					      error);
+	plugin = fu_engine_find_plugin_by_name (self,
+					        fu_device_get_plugin (dev),
+					        error);
 	if (plugin == NULL)
 		return FALSE;
 	if (!fu_plugin_runner_get_results (plugin, dev, error))
@@ -5263,6 +5803,9 @@ fu_engine_udev_uevent_cb (GUdevClient *gudev_client,
 			  GUdevDevice *udev_device,
 			  FuEngine *self)
 {
+	/* sysfs attributes of this device and its children may have changed */
+	fu_udev_device_cache_invalidate (g_udev_device_get_sysfs_path (udev_device));
+
 	if (g_strcmp0 (action, "add") == 0) {
 		fu_engine_udev_device_add (self, udev_device);
 		return;
@@ -5329,31 +5872,43 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	if (self->loaded)
 		return TRUE;
 
+	/* each phase is recorded, and left open if it fails */
+	fu_profile_push (self->profile, "load");
+
 /* TODO: Read registry key [HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Cryptography] "MachineGuid" */
 #ifndef _WIN32
 	/* cache machine ID so we can use it from a sandboxed app */
+	fu_profile_push (self->profile, "machine-id");
 	self->host_machine_id = fwupd_build_machine_id ("fwupd", &error_local);
 	if (self->host_machine_id == NULL)
 		g_debug ("%s", error_local->message);
+	fu_profile_pop (self->profile);
 #endif
 	/* read config file */
+	fu_profile_push (self->profile, "config");
 	if (!fu_config_load (self->config, error)) {
 		g_prefix_error (error, "Failed to load config: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* read remotes */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
 		remote_list_flags |= FU_REMOTE_LIST_LOAD_FLAG_READONLY_FS;
+	fu_profile_push (self->profile, "remotes");
 	if (!fu_remote_list_load (self->remote_list, remote_list_flags, error)) {
 		g_prefix_error (error, "Failed to load remotes: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* create client certificate */
+	fu_profile_push (self->profile, "client-certificate");
 	fu_engine_ensure_client_certificate (self);
+	fu_profile_pop (self->profile);
 
 	/* get hardcoded approved firmware */
+	fu_profile_push (self->profile, "approved-firmware");
 	checksums = fu_config_get_approved_firmware (self->config);
 	for (guint i = 0; i < checksums->len; i++) {
 		const gchar *csum = g_ptr_array_index (checksums, i);
@@ -5368,24 +5923,33 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		const gchar *csum = g_ptr_array_index (checksums, i);
 		fu_engine_add_approved_firmware (self, csum);
 	}
+	fu_profile_pop (self->profile);
 
 	/* set up idle exit */
 	if ((self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0)
 		fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (self->config));
 
 	/* load quirks, SMBIOS and the hwids */
+	fu_profile_push (self->profile, "smbios");
 	fu_engine_load_smbios (self);
+	fu_profile_pop (self->profile);
+	fu_profile_push (self->profile, "hwids");
 	fu_engine_load_hwids (self);
+	fu_profile_pop (self->profile);
 	/* on a read-only filesystem don't care about the cache GUID */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
 		quirks_flags |= FU_QUIRKS_LOAD_FLAG_READONLY_FS;
+	fu_profile_push (self->profile, "quirks");
 	fu_engine_load_quirks (self, quirks_flags);
+	fu_profile_pop (self->profile);
 
 	/* load AppStream metadata */
+	fu_profile_push (self->profile, "metadata");
 	if (!fu_engine_load_metadata_store (self, flags, error)) {
 		g_prefix_error (error, "Failed to load AppStream data: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* add the "built-in" firmware types */
 	fu_engine_add_firmware_gtype (self, "raw", FU_TYPE_FIRMWARE);
@@ -5394,23 +5958,31 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	fu_engine_add_firmware_gtype (self, "srec", FU_TYPE_SREC_FIRMWARE);
 
 	/* set shared USB context */
+	fu_profile_push (self->profile, "usb-context");
 	self->usb_ctx = g_usb_context_new (error);
 	if (self->usb_ctx == NULL) {
 		g_prefix_error (error, "Failed to get USB context: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* delete old data files */
+	fu_profile_push (self->profile, "cleanup-state");
 	if (!fu_engine_cleanup_state (error)) {
 		g_prefix_error (error, "Failed to clean up: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* load plugin */
+	fu_profile_push (self->profile, "plugins-open");
+	if (flags & FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS)
+		fu_engine_load_plugin_index (self);
 	if (!fu_engine_load_plugins (self, error)) {
 		g_prefix_error (error, "Failed to load plugins: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* watch the device list for updates and proxy */
 	g_signal_connect (self->device_list, "added",
@@ -5440,9 +6012,14 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	fu_engine_set_status (self, FWUPD_STATUS_LOADING);
 
 	/* add devices */
+	fu_profile_push (self->profile, "plugins-startup");
 	fu_engine_plugins_setup (self);
-	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
+	fu_profile_pop (self->profile);
+	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0) {
+		fu_profile_push (self->profile, "plugins-coldplug");
 		fu_engine_plugins_coldplug (self, FALSE);
+		fu_profile_pop (self->profile);
+	}
 
 	/* coldplug USB devices */
 	g_signal_connect (self->usb_ctx, "device-added",
@@ -5451,25 +6028,43 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	g_signal_connect (self->usb_ctx, "device-removed",
 			  G_CALLBACK (fu_engine_usb_device_removed_cb),
 			  self);
-	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
+	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0) {
+		fu_profile_push (self->profile, "usb-enumerate");
 		g_usb_context_enumerate (self->usb_ctx);
+		fu_profile_pop (self->profile);
+	}
 
 #ifdef HAVE_GUDEV
 	/* coldplug udev devices */
-	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
+	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0) {
+		fu_profile_push (self->profile, "udev-enumerate");
 		fu_engine_enumerate_udev (self);
+		fu_profile_pop (self->profile);
+	}
 #endif
 
 	/* set device properties from the metadata */
+	fu_profile_push (self->profile, "md-refresh-devices");
 	fu_engine_md_refresh_devices (self);
+	fu_profile_pop (self->profile);
 
 	/* update the db for devices that were updated during the reboot */
+	fu_profile_push (self->profile, "history");
 	if (!fu_engine_update_history_database (self, error))
 		return FALSE;
+	fu_profile_pop (self->profile);
+
+	/* remember which plugins found hardware for the next start */
+	if (flags & FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS)
+		fu_engine_save_plugin_index (self);
 
 	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
 	self->loaded = TRUE;
 
+	/* hotplug and recoldplug are not part of startup */
+	fu_profile_pop (self->profile);
+	fu_profile_set_enabled (self->profile, FALSE);
+
 	/* let clients know engine finished starting up */
 	fu_engine_emit_changed (self);
 
@@ -5551,6 +6146,7 @@ fu_engine_init (FuEngine *self)
 	g_autofree gchar *pkidir_md = NULL;
 	g_autofree gchar *sysconfdir = NULL;
 	self->percentage = 0;
+	self->progress_devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	self->status = FWUPD_STATUS_IDLE;
 	self->config = fu_config_new ();
 	self->remote_list = fu_remote_list_new ();
@@ -5558,11 +6154,17 @@ fu_engine_init (FuEngine *self)
 	self->smbios = fu_smbios_new ();
 	self->hwids = fu_hwids_new ();
 	self->idle = fu_idle_new ();
+	self->profile = fu_profile_new ();
 	self->quirks = fu_quirks_new ();
 	self->history = fu_history_new ();
 	self->plugin_list = fu_plugin_list_new ();
+	self->plugin_index = fu_plugin_index_new ();
+	self->plugins_deferred = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->plugin_filter = g_ptr_array_new_with_free_func (g_free);
 	self->udev_subsystems = g_ptr_array_new_with_free_func (g_free);
+	self->udev_routes = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, (GDestroyNotify) g_ptr_array_unref);
+	self->usb_routes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 #ifdef HAVE_GUDEV
 	self->udev_changed_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
 							g_free, (GDestroyNotify) fu_engine_udev_changed_helper_free);
@@ -5637,9 +6239,12 @@ fu_engine_finalize (GObject *obj)
 #endif
 	if (self->coldplug_id != 0)
 		g_source_remove (self->coldplug_id);
+	if (self->progress_id != 0)
+		g_source_remove (self->progress_id);
 
 	g_free (self->host_machine_id);
 	g_object_unref (self->idle);
+	g_object_unref (self->profile);
 	g_object_unref (self->config);
 	g_object_unref (self->remote_list);
 	g_object_unref (self->smbios);
@@ -5649,7 +6254,10 @@ fu_engine_finalize (GObject *obj)
 	g_object_unref (self->device_list);
 	g_object_unref (self->jcat_context);
 	g_ptr_array_unref (self->plugin_filter);
+	g_ptr_array_unref (self->progress_devices);
 	g_ptr_array_unref (self->udev_subsystems);
+	g_hash_table_unref (self->udev_routes);
+	g_hash_table_unref (self->usb_routes);
 #ifdef HAVE_GUDEV
 	g_hash_table_unref (self->udev_changed_ids);
 #endif
@@ -5657,6 +6265,8 @@ fu_engine_finalize (GObject *obj)
 	g_hash_table_unref (self->compile_versions);
 	g_hash_table_unref (self->approved_firmware);
 	g_hash_table_unref (self->firmware_gtypes);
+	g_hash_table_unref (self->plugins_deferred);
+	g_object_unref (self->plugin_index);
 	g_object_unref (self->plugin_list);
 
 	G_OBJECT_CLASS (fu_engine_parent_class)->finalize (obj);
@@ -16,6 +16,7 @@
 #include "fu-common.h"
 #include "fu-install-task.h"
 #include "fu-plugin.h"
+#include "fu-profile.h"
 
 #define FU_TYPE_ENGINE (fu_engine_get_type ())
 G_DECLARE_FINAL_TYPE (FuEngine, fu_engine, FU, ENGINE, GObject)
@@ -24,6 +25,8 @@ G_DECLARE_FINAL_TYPE (FuEngine, fu_engine, FU, ENGINE, GObject)
  * FuEngineLoadFlags:
  * @FU_ENGINE_LOAD_FLAG_NONE:		No flags set
  * @FU_ENGINE_LOAD_FLAG_READONLY_FS:	Ignore readonly filesystem errors
+ * @FU_ENGINE_LOAD_FLAG_NO_ENUMERATE:	Do not enumerate devices
+ * @FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS:	Only open plugins that found hardware last time
  *
  * The flags to use when loading the engine.
  **/
@@ -31,6 +34,7 @@ typedef enum {
 	FU_ENGINE_LOAD_FLAG_NONE		= 0,
 	FU_ENGINE_LOAD_FLAG_READONLY_FS		= 1 << 0,
 	FU_ENGINE_LOAD_FLAG_NO_ENUMERATE	= 1 << 1,
+	FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS	= 1 << 2,
 	/*< private >*/
 	FU_ENGINE_LOAD_FLAG_LAST
 } FuEngineLoadFlags;
@@ -47,6 +51,7 @@ gboolean	 fu_engine_load				(FuEngine	*self,
 gboolean	 fu_engine_load_plugins			(FuEngine	*self,
 							 GError		**error);
 gboolean	 fu_engine_get_tainted			(FuEngine	*self);
+FuProfile	*fu_engine_get_profile			(FuEngine	*self);
 const gchar	*fu_engine_get_host_product		(FuEngine *self);
 const gchar	*fu_engine_get_host_machine_id		(FuEngine *self);
 FwupdStatus	 fu_engine_get_status			(FuEngine	*self);
@@ -54,6 +59,7 @@ XbSilo		*fu_engine_get_silo_from_blob		(FuEngine	*self,
 							 GBytes		*blob_cab,
 							 GError		**error);
 guint64		 fu_engine_get_archive_size_max		(FuEngine	*self);
+gboolean	 fu_engine_get_warm_start		(FuEngine	*self);
 GPtrArray	*fu_engine_get_plugins			(FuEngine	*self);
 GPtrArray	*fu_engine_get_devices			(FuEngine	*self,
 							 GError		**error);
@@ -162,10 +168,14 @@ void		 fu_engine_md_refresh_device_from_component (FuEngine	*self,
 GPtrArray	*fu_engine_get_releases_for_device 	(FuEngine	*self,
 							FuDevice	*device,
 							GError		**error);
+void		 fu_engine_drop_caches			(FuEngine	*self,
+							 gboolean	 reload_silos);
 
 /* for the self tests */
 void		 fu_engine_add_device			(FuEngine	*self,
 							 FuDevice	*device);
+void		 fu_engine_remove_device		(FuEngine	*self,
+							 FuDevice	*device);
 void		 fu_engine_add_plugin			(FuEngine	*self,
 							 FuPlugin	*plugin);
 void		 fu_engine_add_runtime_version		(FuEngine	*self,
@@ -177,6 +187,8 @@ gboolean	 fu_engine_check_requirements		(FuEngine	*self,
 							 GError		**error);
 void		 fu_engine_set_silo			(FuEngine	*self,
 							 XbSilo		*silo);
+void		 fu_engine_set_monotonic_time		(FuEngine	*self,
+							 gint64		 monotonic_time);
 XbNode		*fu_engine_get_component_by_guids	(FuEngine	*self,
 							 FuDevice	*device);
 gboolean	 fu_engine_schedule_update		(FuEngine	*self,
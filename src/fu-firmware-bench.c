@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuFirmwareBench"
+
+#include "config.h"
+
+#include <json-glib/json-glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
+#include "fu-common.h"
+#include "fu-engine.h"
+#include "fu-firmware.h"
+
+#include "fwupd-error.h"
+
+typedef struct {
+	FuEngine		*engine;
+	guint			 iterations;
+	guint			 scale;
+	gchar			*firmware_type;
+	gboolean		 json;
+} FuBenchPrivate;
+
+typedef struct {
+	gchar			*id;
+	guint			 files;
+	guint			 parses_ok;
+	guint			 parses_failed;
+	guint64			 bytes;
+	gdouble			 elapsed;
+	gint64			 allocs;
+	gint64			 heap_max;
+	gint64			 rss_peak;
+	gboolean		 synthetic;
+} FuBenchResult;
+
+static void
+fu_bench_result_free (FuBenchResult *result)
+{
+	g_free (result->id);
+	g_free (result);
+}
+
+static void
+fu_bench_private_free (FuBenchPrivate *priv)
+{
+	if (priv->engine != NULL)
+		g_object_unref (priv->engine);
+	g_free (priv->firmware_type);
+	g_free (priv);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuBenchPrivate, fu_bench_private_free)
+
+#ifdef HAVE_LIBC_MALLOC
+/* glibc allows the executable to replace the allocator, so wrap it to count
+ * every call; memalign() and friends are not wrapped, so the magazines used
+ * by GSlice in older GLib versions are not counted */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static volatile gint fu_bench_allocs = 0;
+
+void *
+malloc (size_t size)
+{
+	g_atomic_int_inc (&fu_bench_allocs);
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	g_atomic_int_inc (&fu_bench_allocs);
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	g_atomic_int_inc (&fu_bench_allocs);
+	return __libc_realloc (ptr, size);
+}
+#endif
+
+/* number of heap allocations so far, wrapping at G_MAXUINT, or -1 if unknown */
+static gint64
+fu_bench_get_allocs (void)
+{
+#ifdef HAVE_LIBC_MALLOC
+	return (guint) g_atomic_int_get (&fu_bench_allocs);
+#else
+	return -1;
+#endif
+}
+
+/* bytes currently allocated on the heap, or -1 if unknown */
+static gint64
+fu_bench_get_heap_used (void)
+{
+#if defined(HAVE_MALLINFO2)
+	struct mallinfo2 mi = mallinfo2 ();
+	return (gint64) mi.uordblks;
+#elif defined(HAVE_MALLINFO)
+	struct mallinfo mi = mallinfo ();
+	return (gint64) mi.uordblks;
+#else
+	return -1;
+#endif
+}
+
+/* reset the kernel high-water mark so each format gets its own peak */
+static void
+fu_bench_reset_rss_peak (void)
+{
+	g_autoptr(GError) error_local = NULL;
+	if (!g_file_set_contents ("/proc/self/clear_refs", "5", -1, &error_local))
+		g_debug ("cannot reset peak RSS: %s", error_local->message);
+}
+
+/* peak resident set size in kB */
+static gint64
+fu_bench_get_rss_peak (void)
+{
+	struct rusage usage = { 0 };
+	g_autofree gchar *buf = NULL;
+
+	if (g_file_get_contents ("/proc/self/status", &buf, NULL, NULL)) {
+		g_auto(GStrv) lines = g_strsplit (buf, "\n", -1);
+		for (guint i = 0; lines[i] != NULL; i++) {
+			if (g_str_has_prefix (lines[i], "VmHWM:"))
+				return g_ascii_strtoll (lines[i] + 6, NULL, 10);
+		}
+	}
+	if (getrusage (RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+	return -1;
+}
+
+static void
+fu_bench_result_add_blob (FuBenchPrivate *priv,
+			  FuBenchResult *result,
+			  GType gtype,
+			  GBytes *blob)
+{
+	for (guint i = 0; i < priv->iterations; i++) {
+		gint64 heap_before = fu_bench_get_heap_used ();
+		g_autoptr(FuFirmware) firmware = g_object_new (gtype, NULL);
+		g_autoptr(GError) error_local = NULL;
+		gint64 allocs_before;
+		gint64 start;
+		gboolean ret;
+
+		/* only count the time and allocations spent in the parser */
+		allocs_before = fu_bench_get_allocs ();
+		start = g_get_monotonic_time ();
+		ret = fu_firmware_parse (firmware, blob,
+					 FWUPD_INSTALL_FLAG_FORCE,
+					 &error_local);
+		if (!ret) {
+			/* no point retrying the same failure */
+			g_debug ("%s: %s", result->id, error_local->message);
+			result->parses_failed++;
+			return;
+		}
+		result->elapsed += (gdouble) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+		if (allocs_before >= 0)
+			result->allocs += (guint) fu_bench_get_allocs () - (guint) allocs_before;
+		result->parses_ok++;
+		result->bytes += g_bytes_get_size (blob);
+
+		/* how much the parsed firmware is holding on to */
+		if (heap_before >= 0) {
+			gint64 heap_used = fu_bench_get_heap_used () - heap_before;
+			result->heap_max = MAX (result->heap_max, heap_used);
+		}
+	}
+}
+
+/* build a large image and have the format write it so it can be parsed back */
+static GBytes *
+fu_bench_build_synthetic (FuBenchPrivate *priv, GType gtype, GError **error)
+{
+	gsize sz = (gsize) priv->scale * 0x100000;
+	g_autofree guint8 *buf = g_malloc (sz);
+	g_autoptr(FuFirmware) firmware = g_object_new (gtype, NULL);
+	g_autoptr(FuFirmwareImage) img = NULL;
+	g_autoptr(GBytes) payload = NULL;
+
+	/* not all zeros, so no format can cheat with a fill */
+	for (gsize i = 0; i < sz; i++)
+		buf[i] = (guint8) ((i * 31) ^ (i >> 8));
+	payload = g_bytes_new_take (g_steal_pointer (&buf), sz);
+	img = fu_firmware_image_new (payload);
+	fu_firmware_image_set_addr (img, 0x0);
+	fu_firmware_add_image (firmware, img);
+	return fu_firmware_write (firmware, error);
+}
+
+static FuBenchResult *
+fu_bench_run_type (FuBenchPrivate *priv, const gchar *id, GPtrArray *files)
+{
+	GType gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, id);
+	FuBenchResult *result = g_new0 (FuBenchResult, 1);
+	g_autoptr(GBytes) synthetic = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	result->id = g_strdup (id);
+	result->allocs = fu_bench_get_allocs () >= 0 ? 0 : -1;
+	result->heap_max = fu_bench_get_heap_used () >= 0 ? 0 : -1;
+	fu_bench_reset_rss_peak ();
+
+	/* every corpus file, even if it was written for another format */
+	for (guint i = 0; i < files->len; i++) {
+		GBytes *blob = g_ptr_array_index (files, i);
+		guint parses_ok = result->parses_ok;
+		fu_bench_result_add_blob (priv, result, gtype, blob);
+		if (result->parses_ok > parses_ok)
+			result->files++;
+	}
+
+	/* scaled-up input, if the format can write one */
+	if (priv->scale > 0) {
+		synthetic = fu_bench_build_synthetic (priv, gtype, &error_local);
+		if (synthetic == NULL) {
+			g_debug ("no synthetic input for %s: %s",
+				 id, error_local->message);
+		} else {
+			guint parses_ok = result->parses_ok;
+			fu_bench_result_add_blob (priv, result, gtype, synthetic);
+			result->synthetic = result->parses_ok > parses_ok;
+		}
+	}
+	result->rss_peak = fu_bench_get_rss_peak ();
+	return result;
+}
+
+static gboolean
+fu_bench_load_corpus (GPtrArray *files, const gchar *path, GError **error)
+{
+	g_autoptr(GPtrArray) fns = NULL;
+
+	fns = fu_common_get_files_recursive (path, error);
+	if (fns == NULL)
+		return FALSE;
+	for (guint i = 0; i < fns->len; i++) {
+		const gchar *fn = g_ptr_array_index (fns, i);
+		GBytes *blob = fu_common_get_contents_bytes (fn, error);
+		if (blob == NULL)
+			return FALSE;
+		g_ptr_array_add (files, blob);
+	}
+	return TRUE;
+}
+
+static gint
+fu_bench_sort_id_cb (gconstpointer a, gconstpointer b)
+{
+	const gchar *id1 = *((const gchar **) a);
+	const gchar *id2 = *((const gchar **) b);
+	return g_strcmp0 (id1, id2);
+}
+
+static gdouble
+fu_bench_result_get_mbs (FuBenchResult *result)
+{
+	if (result->elapsed <= 0.f)
+		return 0.f;
+	return (gdouble) result->bytes / result->elapsed / 0x100000;
+}
+
+/* mean number of allocations for each successful parse, or -1 if unknown */
+static gint64
+fu_bench_result_get_allocs_per_parse (FuBenchResult *result)
+{
+	if (result->allocs < 0)
+		return -1;
+	if (result->parses_ok == 0)
+		return 0;
+	return result->allocs / result->parses_ok;
+}
+
+static void
+fu_bench_print_text (GPtrArray *results)
+{
+	g_print ("%-24s %6s %6s %10s %12s %10s %10s %10s\n",
+		 "Type", "Files", "Failed", "MB/s", "Bytes", "Allocs", "Heap kB", "RSS kB");
+	for (guint i = 0; i < results->len; i++) {
+		FuBenchResult *result = g_ptr_array_index (results, i);
+		g_print ("%-24s %6u %6u %10.2f %12" G_GUINT64_FORMAT " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT "%s\n",
+			 result->id,
+			 result->files,
+			 result->parses_failed,
+			 fu_bench_result_get_mbs (result),
+			 result->bytes,
+			 fu_bench_result_get_allocs_per_parse (result),
+			 result->heap_max >= 0 ? result->heap_max / 1024 : -1,
+			 result->rss_peak,
+			 result->synthetic ? " (+synthetic)" : "");
+	}
+}
+
+static void
+fu_bench_print_json (FuBenchPrivate *priv, GPtrArray *results)
+{
+	g_autofree gchar *data = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Iterations");
+	json_builder_add_int_value (builder, priv->iterations);
+	json_builder_set_member_name (builder, "Scale");
+	json_builder_add_int_value (builder, priv->scale);
+	json_builder_set_member_name (builder, "Results");
+	json_builder_begin_array (builder);
+	for (guint i = 0; i < results->len; i++) {
+		FuBenchResult *result = g_ptr_array_index (results, i);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "Id");
+		json_builder_add_string_value (builder, result->id);
+		json_builder_set_member_name (builder, "Files");
+		json_builder_add_int_value (builder, result->files);
+		json_builder_set_member_name (builder, "ParsesOk");
+		json_builder_add_int_value (builder, result->parses_ok);
+		json_builder_set_member_name (builder, "ParsesFailed");
+		json_builder_add_int_value (builder, result->parses_failed);
+		json_builder_set_member_name (builder, "Synthetic");
+		json_builder_add_boolean_value (builder, result->synthetic);
+		json_builder_set_member_name (builder, "Bytes");
+		json_builder_add_int_value (builder, result->bytes);
+		json_builder_set_member_name (builder, "Elapsed");
+		json_builder_add_double_value (builder, result->elapsed);
+		json_builder_set_member_name (builder, "MegabytesPerSecond");
+		json_builder_add_double_value (builder, fu_bench_result_get_mbs (result));
+		json_builder_set_member_name (builder, "Allocations");
+		json_builder_add_int_value (builder, result->allocs);
+		json_builder_set_member_name (builder, "AllocationsPerParse");
+		json_builder_add_int_value (builder, fu_bench_result_get_allocs_per_parse (result));
+		json_builder_set_member_name (builder, "HeapMax");
+		json_builder_add_int_value (builder, result->heap_max);
+		json_builder_set_member_name (builder, "RssPeak");
+		json_builder_add_int_value (builder, result->rss_peak);
+		json_builder_end_object (builder);
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	g_print ("%s\n", data);
+}
+
+int
+main (int argc, char *argv[])
+{
+	gboolean verbose = FALSE;
+	g_autoptr(FuBenchPrivate) priv = g_new0 (FuBenchPrivate, 1);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(GPtrArray) files = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	g_autoptr(GPtrArray) results = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_bench_result_free);
+	g_autoptr(GPtrArray) ids = NULL;
+	const GOptionEntry options[] = {
+		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
+			"Show extra debugging information", NULL },
+		{ "json", '\0', 0, G_OPTION_ARG_NONE, &priv->json,
+			"Output in JSON format", NULL },
+		{ "iterations", 'i', 0, G_OPTION_ARG_INT, &priv->iterations,
+			"Number of times to parse each input", NULL },
+		{ "scale", 's', 0, G_OPTION_ARG_INT, &priv->scale,
+			"Size of the synthetic input in MB, or 0 to disable", NULL },
+		{ "type", 't', 0, G_OPTION_ARG_STRING, &priv->firmware_type,
+			"Only benchmark this firmware type", NULL },
+		{ NULL}
+	};
+
+	/* defaults */
+	priv->iterations = 10;
+	priv->scale = 4;
+
+	context = g_option_context_new ("DIRECTORY...");
+	g_option_context_set_summary (context,
+				      "Measure firmware parser throughput, allocations and memory use");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (verbose)
+		g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+	if (priv->iterations == 0) {
+		g_printerr ("--iterations must be at least 1\n");
+		return EXIT_FAILURE;
+	}
+
+	/* load all the firmware types, including the ones from plugins */
+	priv->engine = fu_engine_new (FU_APP_FLAGS_NO_IDLE_SOURCES);
+	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, &error)) {
+		g_printerr ("Failed to load engine: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	/* load all the corpora up-front so I/O is not measured */
+	for (gint i = 1; i < argc; i++) {
+		if (!fu_bench_load_corpus (files, argv[i], &error)) {
+			g_printerr ("Failed to load %s: %s\n", argv[i], error->message);
+			return EXIT_FAILURE;
+		}
+	}
+	if (files->len == 0 && priv->scale == 0) {
+		g_printerr ("No corpus files and no synthetic input\n");
+		return EXIT_FAILURE;
+	}
+
+	/* stable order so that runs can be diffed */
+	ids = fu_engine_get_firmware_gtype_ids (priv->engine);
+	g_ptr_array_sort (ids, fu_bench_sort_id_cb);
+	for (guint i = 0; i < ids->len; i++) {
+		const gchar *id = g_ptr_array_index (ids, i);
+		if (priv->firmware_type != NULL &&
+		    g_strcmp0 (priv->firmware_type, id) != 0)
+			continue;
+		g_ptr_array_add (results, fu_bench_run_type (priv, id, files));
+	}
+	if (results->len == 0) {
+		g_printerr ("No firmware types matched\n");
+		return EXIT_FAILURE;
+	}
+
+	if (priv->json)
+		fu_bench_print_json (priv, results);
+	else
+		fu_bench_print_text (results);
+	return EXIT_SUCCESS;
+}
@@ -28,7 +28,10 @@
 #include "fu-debug.h"
 #include "fu-device-private.h"
 #include "fu-engine.h"
+#include "fu-engine-helper.h"
 #include "fu-install-task.h"
+#include "fu-plugin-private.h"
+#include "fu-trace.h"
 
 #ifndef HAVE_POLKIT_0_114
 #pragma clang diagnostic push
@@ -52,6 +55,9 @@ typedef struct {
 	FuEngine		*engine;
 	gboolean		 update_in_progress;
 	gboolean		 pending_sigterm;
+	gboolean		 load_failed;
+	GPtrArray		*snapshot;		/* (element-type FwupdDevice) */
+	GVariant		*snapshot_properties;
 } FuMainPrivate;
 
 static gboolean
@@ -82,41 +88,43 @@ fu_main_engine_changed_cb (FuEngine *engine, FuMainPrivate *priv)
 }
 
 static void
-fu_main_engine_device_added_cb (FuEngine *engine,
-				FuDevice *device,
-				FuMainPrivate *priv)
+fu_main_emit_device_signal (FuMainPrivate *priv,
+			    const gchar *signal_name,
+			    FwupdDevice *device)
 {
 	GVariant *val;
 
 	/* not yet connected */
 	if (priv->connection == NULL)
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
+	val = fwupd_device_to_variant (device);
 	g_dbus_connection_emit_signal (priv->connection,
 				       NULL,
 				       FWUPD_DBUS_PATH,
 				       FWUPD_DBUS_INTERFACE,
-				       "DeviceAdded",
+				       signal_name,
 				       g_variant_new_tuple (&val, 1), NULL);
 }
 
+static void
+fu_main_engine_device_added_cb (FuEngine *engine,
+				FuDevice *device,
+				FuMainPrivate *priv)
+{
+	/* clients are told about the difference to the snapshot afterwards */
+	if (priv->snapshot != NULL)
+		return;
+	fu_main_emit_device_signal (priv, "DeviceAdded", FWUPD_DEVICE (device));
+}
+
 static void
 fu_main_engine_device_removed_cb (FuEngine *engine,
 				  FuDevice *device,
 				  FuMainPrivate *priv)
 {
-	GVariant *val;
-
-	/* not yet connected */
-	if (priv->connection == NULL)
+	if (priv->snapshot != NULL)
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceRemoved",
-				       g_variant_new_tuple (&val, 1), NULL);
+	fu_main_emit_device_signal (priv, "DeviceRemoved", FWUPD_DEVICE (device));
 }
 
 static void
@@ -124,18 +132,9 @@ fu_main_engine_device_changed_cb (FuEngine *engine,
 				  FuDevice *device,
 				  FuMainPrivate *priv)
 {
-	GVariant *val;
-
-	/* not yet connected */
-	if (priv->connection == NULL)
+	if (priv->snapshot != NULL)
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceChanged",
-				       g_variant_new_tuple (&val, 1), NULL);
+	fu_main_emit_device_signal (priv, "DeviceChanged", FWUPD_DEVICE (device));
 }
 
 static void
@@ -471,6 +470,33 @@ fu_main_modify_config_cb (GObject *source, GAsyncResult *res, gpointer user_data
 	g_dbus_method_invocation_return_value (helper->invocation, NULL);
 }
 
+static void
+fu_main_set_verbose_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PolkitAuthorizationResult) auth = NULL;
+
+	/* get result */
+	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
+							    res, &error);
+	if (!fu_main_authorization_is_valid (auth, &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	if (!fu_debug_set_plugin_verbose (fu_engine_get_plugins (helper->priv->engine),
+					  helper->key,
+					  helper->flags > 0,
+					  &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	/* success */
+	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+}
+
 static void
 fu_main_authorize_activate_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -796,6 +822,135 @@ fu_main_device_id_valid (const gchar *device_id, GError **error)
 	return FALSE;
 }
 
+static FwupdDevice *
+fu_main_snapshot_get_device (GPtrArray *devices, const gchar *device_id)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *device = g_ptr_array_index (devices, i);
+		if (g_strcmp0 (fwupd_device_get_id (device), device_id) == 0)
+			return device;
+	}
+	return NULL;
+}
+
+static gboolean
+fu_main_snapshot_load (FuMainPrivate *priv, GError **error)
+{
+	g_autoptr(GPtrArray) snapshot = NULL;
+	g_autoptr(GVariant) blob = NULL;
+	g_autoptr(GVariant) devices = NULL;
+
+	blob = fu_engine_load_snapshot (error);
+	if (blob == NULL)
+		return FALSE;
+	devices = g_variant_get_child_value (blob, 3);
+	snapshot = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (gsize i = 0; i < g_variant_n_children (devices); i++) {
+		g_autoptr(GVariant) val = g_variant_get_child_value (devices, i);
+		g_ptr_array_add (snapshot, fwupd_device_from_variant (val));
+	}
+	if (snapshot->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "snapshot has no devices");
+		return FALSE;
+	}
+	priv->snapshot_properties = g_variant_get_child_value (blob, 2);
+	priv->snapshot = g_steal_pointer (&snapshot);
+	return TRUE;
+}
+
+static void
+fu_main_snapshot_save (FuMainPrivate *priv)
+{
+	g_autoptr(GError) error = NULL;
+
+	/* do not serve a stale tree if this was turned off */
+	if (!fu_engine_get_warm_start (priv->engine)) {
+		if (!fu_engine_remove_snapshot (&error))
+			g_warning ("failed to remove snapshot: %s", error->message);
+		return;
+	}
+	if (!fu_engine_save_snapshot (priv->engine, &error))
+		g_warning ("failed to save snapshot: %s", error->message);
+}
+
+static void
+fu_main_snapshot_reconcile (FuMainPrivate *priv, GPtrArray *snapshot)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = fu_engine_get_devices (priv->engine, NULL);
+	if (devices == NULL)
+		devices = g_ptr_array_new ();
+
+	/* unplugged while the daemon was not running */
+	for (guint i = 0; i < snapshot->len; i++) {
+		FwupdDevice *device_old = g_ptr_array_index (snapshot, i);
+		if (fu_main_snapshot_get_device (devices, fwupd_device_get_id (device_old)) == NULL)
+			fu_main_emit_device_signal (priv, "DeviceRemoved", device_old);
+	}
+
+	/* new, or different to what was served */
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *device = g_ptr_array_index (devices, i);
+		FwupdDevice *device_old;
+		g_autoptr(GVariant) val = NULL;
+		g_autoptr(GVariant) val_old = NULL;
+
+		device_old = fu_main_snapshot_get_device (snapshot, fwupd_device_get_id (device));
+		if (device_old == NULL) {
+			fu_main_emit_device_signal (priv, "DeviceAdded", device);
+			continue;
+		}
+		val = g_variant_ref_sink (fwupd_device_to_variant (device));
+		val_old = g_variant_ref_sink (fwupd_device_to_variant (device_old));
+		if (!g_variant_equal (val, val_old))
+			fu_main_emit_device_signal (priv, "DeviceChanged", device);
+	}
+}
+
+static gboolean
+fu_main_load_engine (FuMainPrivate *priv, GError **error)
+{
+	g_autoptr(GPtrArray) snapshot = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (priv->load_failed) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "engine failed to load");
+		return FALSE;
+	}
+
+	/* already loaded when the daemon started */
+	if (priv->snapshot == NULL)
+		return TRUE;
+	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS, &error_local)) {
+		g_printerr ("Failed to load engine: %s\n", error_local->message);
+		priv->load_failed = TRUE;
+		g_main_loop_quit (priv->loop);
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+
+	/* tell clients how the hardware differs from what was served */
+	snapshot = g_steal_pointer (&priv->snapshot);
+	g_clear_pointer (&priv->snapshot_properties, g_variant_unref);
+	fu_main_snapshot_reconcile (priv, snapshot);
+	return TRUE;
+}
+
+static gboolean
+fu_main_load_engine_cb (gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	fu_main_load_engine (priv, NULL);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			    const gchar *object_path, const gchar *interface_name,
@@ -808,6 +963,23 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 
 	/* activity */
 	fu_engine_idle_reset (priv->engine);
+	FU_TRACE2 (dbus_method_call, sender, method_name);
+
+	/* answer from the snapshot while the hardware is being rescanned */
+	if (priv->snapshot != NULL && g_strcmp0 (method_name, "GetDevices") == 0) {
+		g_debug ("Called %s() using snapshot", method_name);
+		val = fu_main_device_array_to_variant (priv, sender, priv->snapshot, &error);
+		if (val == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+	if (!fu_main_load_engine (priv, &error)) {
+		g_dbus_method_invocation_return_gerror (invocation, error);
+		return;
+	}
 
 	if (g_strcmp0 (method_name, "GetDevices") == 0) {
 		g_autoptr(GPtrArray) devices = NULL;
@@ -856,6 +1028,55 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 						       g_variant_new_tuple (&val, 1));
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetPluginStats") == 0) {
+		GPtrArray *plugins = fu_engine_get_plugins (priv->engine);
+		GVariantBuilder builder;
+		g_debug ("Called %s()", method_name);
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+		for (guint i = 0; i < plugins->len; i++) {
+			FuPlugin *plugin = g_ptr_array_index (plugins, i);
+			g_autoptr(GVariant) stats = fu_plugin_get_stats (plugin);
+			GVariantIter iter;
+			GVariant *child;
+			g_variant_iter_init (&iter, stats);
+			while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+				g_variant_builder_add_value (&builder, child);
+				g_variant_unref (child);
+			}
+		}
+		val = g_variant_builder_end (&builder);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new_tuple (&val, 1));
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetProfile") == 0) {
+		const gchar *format_str = NULL;
+		FuProfileFormat format;
+		g_autofree gchar *profile = NULL;
+
+		g_variant_get (parameters, "(&s)", &format_str);
+		g_debug ("Called %s(%s)", method_name, format_str);
+		format = fu_profile_format_from_string (format_str);
+		if (format == FU_PROFILE_FORMAT_UNKNOWN) {
+			g_dbus_method_invocation_return_error (invocation,
+							       FWUPD_ERROR,
+							       FWUPD_ERROR_INVALID_ARGS,
+							       "profile format %s not supported",
+							       format_str);
+			return;
+		}
+		profile = fu_profile_to_string (fu_engine_get_profile (priv->engine), format);
+		val = g_variant_new ("(s)", profile);
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetMemoryStats") == 0) {
+		g_debug ("Called %s()", method_name);
+		val = fu_engine_get_memory_stats ();
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new_tuple (&val, 1));
+		return;
+	}
 	if (g_strcmp0 (method_name, "SetApprovedFirmware") == 0) {
 		g_autofree gchar *checksums_str = NULL;
 		g_auto(GStrv) checksums = NULL;
@@ -1155,6 +1376,31 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 						      g_steal_pointer (&helper));
 		return;
 	}
+	if (g_strcmp0 (method_name, "SetVerbose") == 0) {
+		g_autofree gchar *name = NULL;
+		gboolean enabled = FALSE;
+		g_autoptr(FuMainAuthHelper) helper = NULL;
+		g_autoptr(PolkitSubject) subject = NULL;
+
+		g_variant_get (parameters, "(sb)", &name, &enabled);
+		g_debug ("Called %s(%s,%i)", method_name, name, enabled);
+
+		/* authenticate */
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->priv = priv;
+		helper->key = g_steal_pointer (&name);
+		helper->flags = enabled;
+		helper->invocation = g_object_ref (invocation);
+		subject = polkit_system_bus_name_new (sender);
+		polkit_authority_check_authorization (priv->authority, subject,
+						      "org.freedesktop.fwupd.modify-config",
+						      NULL,
+						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
+						      NULL,
+						      fu_main_set_verbose_cb,
+						      g_steal_pointer (&helper));
+		return;
+	}
 	if (g_strcmp0 (method_name, "ModifyRemote") == 0) {
 		const gchar *remote_id = NULL;
 		const gchar *key = NULL;
@@ -1376,21 +1622,31 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	if (g_strcmp0 (property_name, "DaemonVersion") == 0)
 		return g_variant_new_string (SOURCE_VERSION);
 
-	if (g_strcmp0 (property_name, "Tainted") == 0)
-		return g_variant_new_boolean (fu_engine_get_tainted (priv->engine));
-
 	if (g_strcmp0 (property_name, "Status") == 0)
 		return g_variant_new_uint32 (fu_engine_get_status (priv->engine));
 
+	if (g_strcmp0 (property_name, "Interactive") == 0)
+		return g_variant_new_boolean (isatty (fileno (stdout)) != 0);
+
+	/* the others are saved in the snapshot or need the engine loaded */
+	if (priv->snapshot_properties != NULL) {
+		GVariant *val = g_variant_lookup_value (priv->snapshot_properties,
+							property_name, NULL);
+		if (val != NULL)
+			return val;
+	}
+	if (!fu_main_load_engine (priv, error))
+		return NULL;
+
+	if (g_strcmp0 (property_name, "Tainted") == 0)
+		return g_variant_new_boolean (fu_engine_get_tainted (priv->engine));
+
 	if (g_strcmp0 (property_name, "HostProduct") == 0)
 		return g_variant_new_string (fu_engine_get_host_product (priv->engine));
 
 	if (g_strcmp0 (property_name, "HostMachineId") == 0)
 		return g_variant_new_string (fu_engine_get_host_machine_id (priv->engine));
 
-	if (g_strcmp0 (property_name, "Interactive") == 0)
-		return g_variant_new_boolean (isatty (fileno (stdout)) != 0);
-
 	/* return an error */
 	g_set_error (error,
 		     G_DBUS_ERROR,
@@ -1446,7 +1702,12 @@ fu_main_on_name_acquired_cb (GDBusConnection *connection,
 			     const gchar *name,
 			     gpointer user_data)
 {
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
 	g_debug ("FuMain: acquired name: %s", name);
+
+	/* give the activating client a chance to be answered from the snapshot */
+	if (priv->snapshot != NULL)
+		g_timeout_add_full (G_PRIORITY_LOW, 250, fu_main_load_engine_cb, priv, NULL);
 }
 
 static void
@@ -1483,19 +1744,56 @@ fu_main_argv_changed_cb (GFileMonitor *monitor, GFile *file, GFile *other_file,
 }
 
 #if GLIB_CHECK_VERSION(2,63,3)
+static guint64
+fu_main_get_memory_stat (const gchar *key)
+{
+	guint64 value = 0;
+	g_autoptr(GVariant) stats = g_variant_ref_sink (fu_engine_get_memory_stats ());
+	g_variant_lookup (stats, key, "t", &value);
+	return value;
+}
+
+static gchar *
+fu_main_format_size_freed (guint64 before, guint64 after)
+{
+	return g_format_size (before > after ? before - after : 0);
+}
+
 static void
 fu_main_memory_monitor_warning_cb (GMemoryMonitor *memory_monitor,
 				   GMemoryMonitorWarningLevel level,
 				   FuMainPrivate *priv)
 {
-	/* can do straight away? */
-	if (priv->update_in_progress) {
-		g_warning ("OOM during a firmware update, ignoring");
-		priv->pending_sigterm = TRUE;
+	guint64 heap_before;
+	guint64 rss_before;
+	g_autofree gchar *heap_str = NULL;
+	g_autofree gchar *rss_str = NULL;
+
+	/* we can just rescan hardware, but only once it is safe */
+	if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL) {
+		if (priv->update_in_progress) {
+			g_warning ("OOM during a firmware update, ignoring");
+			priv->pending_sigterm = TRUE;
+			return;
+		}
+		g_debug ("OOM event, shutting down");
+		g_main_loop_quit (priv->loop);
 		return;
 	}
-	g_debug ("OOM event, shutting down");
-	g_main_loop_quit (priv->loop);
+
+	/* restarting costs more than reading things again, and the silos
+	 * are only reloaded when medium pressure is reached */
+	heap_before = fu_main_get_memory_stat ("HeapUsed");
+	rss_before = fu_main_get_memory_stat ("ResidentSetSize");
+	fu_engine_drop_caches (priv->engine,
+			       level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM &&
+			       !priv->update_in_progress);
+	heap_str = fu_main_format_size_freed (heap_before,
+					      fu_main_get_memory_stat ("HeapUsed"));
+	rss_str = fu_main_format_size_freed (rss_before * 1024,
+					     fu_main_get_memory_stat ("ResidentSetSize") * 1024);
+	g_message ("low memory warning %u, freed %s of heap and %s resident",
+		   (guint) level, heap_str, rss_str);
 }
 #endif
 
@@ -1537,6 +1835,10 @@ fu_main_private_free (FuMainPrivate *priv)
 		g_object_unref (priv->argv0_monitor);
 	if (priv->introspection_daemon != NULL)
 		g_dbus_node_info_unref (priv->introspection_daemon);
+	if (priv->snapshot != NULL)
+		g_ptr_array_unref (priv->snapshot);
+	if (priv->snapshot_properties != NULL)
+		g_variant_unref (priv->snapshot_properties);
 #if GLIB_CHECK_VERSION(2,63,3)
 	if (priv->memory_monitor != NULL)
 		g_object_unref (priv->memory_monitor);
@@ -1565,6 +1867,7 @@ main (int argc, char *argv[])
 	};
 	g_autoptr(FuMainPrivate) priv = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GError) error_snapshot = NULL;
 	g_autoptr(GFile) argv0_file = g_file_new_for_path (argv[0]);
 	g_autoptr(GOptionContext) context = NULL;
 
@@ -1610,9 +1913,17 @@ main (int argc, char *argv[])
 	g_signal_connect (priv->engine, "percentage-changed",
 			  G_CALLBACK (fu_main_engine_percentage_changed_cb),
 			  priv);
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_NONE, &error)) {
-		g_printerr ("Failed to load engine: %s\n", error->message);
-		return EXIT_FAILURE;
+
+	/* answer from the last device tree and rescan the hardware once
+	 * the name has been acquired, unless profiling the startup */
+	if (immediate_exit || timed_exit ||
+	    !fu_main_snapshot_load (priv, &error_snapshot)) {
+		if (error_snapshot != NULL)
+			g_debug ("not using snapshot: %s", error_snapshot->message);
+		if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_DEFER_PLUGINS, &error)) {
+			g_printerr ("Failed to load engine: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
 	}
 
 	g_unix_signal_add_full (G_PRIORITY_DEFAULT,
@@ -1626,7 +1937,7 @@ main (int argc, char *argv[])
 			  G_CALLBACK (fu_main_argv_changed_cb), priv);
 
 #if GLIB_CHECK_VERSION(2,63,3)
-	/* shut down on low memory event as we can just rescan hardware */
+	/* drop caches on low memory, and shut down if that is not enough */
 	priv->memory_monitor = g_memory_monitor_dup_default ();
 	g_signal_connect (G_OBJECT (priv->memory_monitor), "low-memory-warning",
 			  G_CALLBACK (fu_main_memory_monitor_warning_cb), priv);
@@ -1669,6 +1980,12 @@ main (int argc, char *argv[])
 	/* wait */
 	g_message ("Daemon ready for requests");
 	g_main_loop_run (priv->loop);
+	if (priv->load_failed)
+		return EXIT_FAILURE;
+
+	/* keep the old snapshot if the engine was never loaded */
+	if (priv->snapshot == NULL)
+		fu_main_snapshot_save (priv);
 
 	/* success */
 	return EXIT_SUCCESS;
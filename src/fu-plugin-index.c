@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuPluginIndex"
+
+#include "config.h"
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "fu-common.h"
+#include "fu-plugin-index.h"
+#include "fu-plugin-private.h"
+
+/**
+ * SECTION:fu-plugin-index
+ * @short_description: what each plugin did on this machine
+ *
+ * The index remembers which plugins produced devices and what they
+ * registered in their init() vfunc, so that plugins that are not needed on
+ * this hardware do not have to be opened at startup. Only plugins that called
+ * fu_plugin_set_open_on_demand() are deferred, as other plugins may create
+ * devices from their own listeners.
+ *
+ * The index is only valid for the key it was saved with, which should change
+ * whenever the hardware or the installed plugins change.
+ *
+ * See also: #FuPluginList
+ */
+
+static void fu_plugin_index_finalize	 (GObject *obj);
+
+struct _FuPluginIndex
+{
+	GObject			 parent_instance;
+	GKeyFile		*keyfile;
+	gchar			*filename;
+	gchar			*key;
+};
+
+G_DEFINE_TYPE (FuPluginIndex, fu_plugin_index, G_TYPE_OBJECT)
+
+static const gchar *rule_keys[] = {
+	[FU_PLUGIN_RULE_CONFLICTS]		= "Conflicts",
+	[FU_PLUGIN_RULE_RUN_AFTER]		= "RunAfter",
+	[FU_PLUGIN_RULE_RUN_BEFORE]		= "RunBefore",
+	[FU_PLUGIN_RULE_BETTER_THAN]		= "BetterThan",
+	[FU_PLUGIN_RULE_INHIBITS_IDLE]		= "InhibitsIdle",
+	[FU_PLUGIN_RULE_METADATA_SOURCE]	= "MetadataSource",
+};
+
+/* run for devices or events the plugin did not create, so the plugin is
+ * needed even without devices */
+static const gchar *hooks_global[] = {
+	"update_prepare",
+	"update_cleanup",
+	"composite_prepare",
+	"composite_cleanup",
+	"device_registered",
+	"device_removed",
+	"udev_device_changed",
+	NULL
+};
+
+/**
+ * fu_plugin_index_load:
+ * @self: A #FuPluginIndex
+ * @filename: A filename
+ * @key: A string that identifies the hardware and plugins
+ * @error: A #GError, or %NULL
+ *
+ * Loads the index from a file. A missing file or one saved with a different
+ * key is not an error, and results in an empty index.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_index_load (FuPluginIndex *self,
+		      const gchar *filename,
+		      const gchar *key,
+		      GError **error)
+{
+	g_autofree gchar *key_old = NULL;
+	g_autoptr(GKeyFile) keyfile = g_key_file_new ();
+
+	g_return_val_if_fail (FU_IS_PLUGIN_INDEX (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (key != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	g_free (self->filename);
+	self->filename = g_strdup (filename);
+	g_free (self->key);
+	self->key = g_strdup (key);
+	g_key_file_unref (self->keyfile);
+	self->keyfile = g_key_file_new ();
+
+	/* first start on this machine */
+	if (!g_file_test (filename, G_FILE_TEST_EXISTS))
+		return TRUE;
+	if (!g_key_file_load_from_file (keyfile, filename, G_KEY_FILE_NONE, error))
+		return FALSE;
+	key_old = g_key_file_get_string (keyfile, "fwupd", "Key", NULL);
+	if (g_strcmp0 (key_old, key) != 0) {
+		g_debug ("hardware or plugins changed, ignoring %s", filename);
+		return TRUE;
+	}
+	g_key_file_unref (self->keyfile);
+	self->keyfile = g_steal_pointer (&keyfile);
+	return TRUE;
+}
+
+/**
+ * fu_plugin_index_save:
+ * @self: A #FuPluginIndex
+ * @error: A #GError, or %NULL
+ *
+ * Saves the index to the file it was loaded from.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_index_save (FuPluginIndex *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_PLUGIN_INDEX (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (self->filename == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_INITIALIZED,
+				     "index has not been loaded");
+		return FALSE;
+	}
+	g_key_file_set_string (self->keyfile, "fwupd", "Key", self->key);
+	if (!fu_common_mkdir_parent (self->filename, error))
+		return FALSE;
+	return g_key_file_save_to_file (self->keyfile, self->filename, error);
+}
+
+/**
+ * fu_plugin_index_invalidate:
+ * @self: A #FuPluginIndex
+ * @error: A #GError, or %NULL
+ *
+ * Deletes the saved index so that a daemon that fails to start, or is
+ * killed before it calls fu_plugin_index_save(), opens every plugin next
+ * time rather than trusting what was saved before. The loaded data is
+ * kept and can still be used and saved.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_index_invalidate (FuPluginIndex *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_PLUGIN_INDEX (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (self->filename == NULL)
+		return TRUE;
+	if (!g_file_test (self->filename, G_FILE_TEST_EXISTS))
+		return TRUE;
+	if (g_unlink (self->filename) != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to delete %s",
+			     self->filename);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_plugin_index_set_udev_subsystems:
+ * @self: A #FuPluginIndex
+ * @name: A plugin name, e.g. `nvme`
+ * @udev_subsystems: (element-type utf8): subsystems added by the plugin
+ *
+ * Records the udev subsystems the plugin watched when it was opened.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_plugin_index_set_udev_subsystems (FuPluginIndex *self,
+				     const gchar *name,
+				     GPtrArray *udev_subsystems)
+{
+	g_return_if_fail (FU_IS_PLUGIN_INDEX (self));
+	g_return_if_fail (name != NULL);
+	g_key_file_set_string_list (self->keyfile, name, "UdevSubsystems",
+				    (const gchar * const *) udev_subsystems->pdata,
+				    udev_subsystems->len);
+}
+
+/**
+ * fu_plugin_index_add_plugin:
+ * @self: A #FuPluginIndex
+ * @plugin: An opened #FuPlugin
+ * @device_count: The number of devices the plugin produced
+ *
+ * Records the plugin rules, the hooks it exports and how many devices it
+ * found on this machine.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_plugin_index_add_plugin (FuPluginIndex *self, FuPlugin *plugin, guint device_count)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	gboolean hooks = FALSE;
+	guint64 device_count_old;
+
+	g_return_if_fail (FU_IS_PLUGIN_INDEX (self));
+	g_return_if_fail (FU_IS_PLUGIN (plugin));
+
+	/* devices may also be added after startup */
+	device_count_old = g_key_file_get_uint64 (self->keyfile, name, "Devices", NULL);
+	g_key_file_set_uint64 (self->keyfile, name, "Devices",
+			       MAX (device_count, device_count_old));
+	for (guint i = 0; hooks_global[i] != NULL; i++) {
+		if (fu_plugin_has_hook (plugin, hooks_global[i])) {
+			hooks = TRUE;
+			break;
+		}
+	}
+	g_key_file_set_boolean (self->keyfile, name, "Hooks", hooks);
+	g_key_file_set_boolean (self->keyfile, name, "OpenOnDemand",
+				fu_plugin_get_open_on_demand (plugin));
+	for (guint i = 0; i < FU_PLUGIN_RULE_LAST; i++) {
+		GPtrArray *rules = fu_plugin_get_rules (plugin, i);
+		if (rules->len == 0) {
+			g_key_file_remove_key (self->keyfile, name, rule_keys[i], NULL);
+			continue;
+		}
+		g_key_file_set_string_list (self->keyfile, name, rule_keys[i],
+					    (const gchar * const *) rules->pdata,
+					    rules->len);
+	}
+}
+
+/**
+ * fu_plugin_index_can_defer:
+ * @self: A #FuPluginIndex
+ * @name: A plugin name, e.g. `nvme`
+ *
+ * Determines if opening the plugin can wait until a device needs it.
+ *
+ * Returns: %TRUE if the plugin opted in, found no devices and runs no
+ * global hooks
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_plugin_index_can_defer (FuPluginIndex *self, const gchar *name)
+{
+	g_return_val_if_fail (FU_IS_PLUGIN_INDEX (self), FALSE);
+	g_return_val_if_fail (name != NULL, FALSE);
+
+	if (!g_key_file_has_key (self->keyfile, name, "Devices", NULL))
+		return FALSE;
+	if (!g_key_file_get_boolean (self->keyfile, name, "OpenOnDemand", NULL))
+		return FALSE;
+	if (g_key_file_get_uint64 (self->keyfile, name, "Devices", NULL) > 0)
+		return FALSE;
+	if (g_key_file_get_boolean (self->keyfile, name, "Hooks", NULL))
+		return FALSE;
+	if (g_key_file_has_key (self->keyfile, name,
+				rule_keys[FU_PLUGIN_RULE_INHIBITS_IDLE], NULL))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * fu_plugin_index_restore:
+ * @self: A #FuPluginIndex
+ * @plugin: A #FuPlugin that has not been opened
+ *
+ * Adds the rules and udev subsystems the plugin registered last time, so
+ * that the plugins can be depsolved and udev events routed without opening
+ * the plugin module.
+ *
+ * Since: 1.4.0
+ **/
+void
+fu_plugin_index_restore (FuPluginIndex *self, FuPlugin *plugin)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	g_auto(GStrv) udev_subsystems = NULL;
+
+	g_return_if_fail (FU_IS_PLUGIN_INDEX (self));
+	g_return_if_fail (FU_IS_PLUGIN (plugin));
+
+	for (guint i = 0; i < FU_PLUGIN_RULE_LAST; i++) {
+		g_auto(GStrv) rules = NULL;
+		rules = g_key_file_get_string_list (self->keyfile, name,
+						    rule_keys[i], NULL, NULL);
+		if (rules == NULL)
+			continue;
+		for (guint j = 0; rules[j] != NULL; j++)
+			fu_plugin_add_rule (plugin, i, rules[j]);
+	}
+	udev_subsystems = g_key_file_get_string_list (self->keyfile, name,
+						      "UdevSubsystems", NULL, NULL);
+	if (udev_subsystems != NULL) {
+		for (guint i = 0; udev_subsystems[i] != NULL; i++)
+			fu_plugin_add_udev_subsystem (plugin, udev_subsystems[i]);
+	}
+}
+
+static void
+fu_plugin_index_class_init (FuPluginIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_plugin_index_finalize;
+}
+
+static void
+fu_plugin_index_init (FuPluginIndex *self)
+{
+	self->keyfile = g_key_file_new ();
+}
+
+static void
+fu_plugin_index_finalize (GObject *obj)
+{
+	FuPluginIndex *self = FU_PLUGIN_INDEX (obj);
+	g_key_file_unref (self->keyfile);
+	g_free (self->filename);
+	g_free (self->key);
+	G_OBJECT_CLASS (fu_plugin_index_parent_class)->finalize (obj);
+}
+
+/**
+ * fu_plugin_index_new:
+ *
+ * Creates a new plugin index.
+ *
+ * Returns: (transfer full): a #FuPluginIndex
+ *
+ * Since: 1.4.0
+ **/
+FuPluginIndex *
+fu_plugin_index_new (void)
+{
+	FuPluginIndex *self;
+	self = g_object_new (FU_TYPE_PLUGIN_INDEX, NULL);
+	return FU_PLUGIN_INDEX (self);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "fu-plugin.h"
+
+#define FU_TYPE_PLUGIN_INDEX (fu_plugin_index_get_type ())
+G_DECLARE_FINAL_TYPE (FuPluginIndex, fu_plugin_index, FU, PLUGIN_INDEX, GObject)
+
+FuPluginIndex	*fu_plugin_index_new			(void);
+gboolean	 fu_plugin_index_load			(FuPluginIndex	*self,
+							 const gchar	*filename,
+							 const gchar	*key,
+							 GError		**error);
+gboolean	 fu_plugin_index_save			(FuPluginIndex	*self,
+							 GError		**error);
+gboolean	 fu_plugin_index_invalidate		(FuPluginIndex	*self,
+							 GError		**error);
+void		 fu_plugin_index_set_udev_subsystems	(FuPluginIndex	*self,
+							 const gchar	*name,
+							 GPtrArray	*udev_subsystems);
+void		 fu_plugin_index_add_plugin		(FuPluginIndex	*self,
+							 FuPlugin	*plugin,
+							 guint		 device_count);
+gboolean	 fu_plugin_index_can_defer		(FuPluginIndex	*self,
+							 const gchar	*name);
+void		 fu_plugin_index_restore		(FuPluginIndex	*self,
+							 FuPlugin	*plugin);
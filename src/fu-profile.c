@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuProfile"
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "fu-profile.h"
+
+/* stop recording rather than growing without bound */
+#define FU_PROFILE_SPANS_MAX			10000
+
+static void fu_profile_finalize	 (GObject *obj);
+
+typedef struct _FuProfileSpan FuProfileSpan;
+struct _FuProfileSpan {
+	gchar			*name;
+	gint64			 start;		/* us, monotonic */
+	gint64			 end;		/* us, monotonic, or 0 if open */
+	FuProfileSpan		*parent;
+	GPtrArray		*children;	/* of FuProfileSpan */
+};
+
+struct _FuProfile
+{
+	GObject			 parent_instance;
+	GPtrArray		*roots;		/* of FuProfileSpan */
+	FuProfileSpan		*current;
+	guint			 size;
+	guint			 depth_dropped;
+	gboolean		 enabled;
+};
+
+G_DEFINE_TYPE (FuProfile, fu_profile, G_TYPE_OBJECT)
+
+static void
+fu_profile_span_free (FuProfileSpan *span)
+{
+	g_ptr_array_unref (span->children);
+	g_free (span->name);
+	g_free (span);
+}
+
+static gint64
+fu_profile_span_get_duration (FuProfileSpan *span)
+{
+	gint64 end = span->end != 0 ? span->end : g_get_monotonic_time ();
+	return end - span->start;
+}
+
+FuProfileFormat
+fu_profile_format_from_string (const gchar *format)
+{
+	if (g_strcmp0 (format, "tree") == 0)
+		return FU_PROFILE_FORMAT_TREE;
+	if (g_strcmp0 (format, "folded") == 0)
+		return FU_PROFILE_FORMAT_FOLDED;
+	return FU_PROFILE_FORMAT_UNKNOWN;
+}
+
+void
+fu_profile_set_enabled (FuProfile *self, gboolean enabled)
+{
+	g_return_if_fail (FU_IS_PROFILE (self));
+	self->enabled = enabled;
+}
+
+gboolean
+fu_profile_get_enabled (FuProfile *self)
+{
+	g_return_val_if_fail (FU_IS_PROFILE (self), FALSE);
+	return self->enabled;
+}
+
+guint
+fu_profile_get_size (FuProfile *self)
+{
+	g_return_val_if_fail (FU_IS_PROFILE (self), 0);
+	return self->size;
+}
+
+/* starts a new span as a child of the currently open span, if any */
+void
+fu_profile_push (FuProfile *self, const gchar *name)
+{
+	FuProfileSpan *span;
+
+	g_return_if_fail (FU_IS_PROFILE (self));
+	g_return_if_fail (name != NULL);
+
+	if (!self->enabled)
+		return;
+
+	/* keep the push and pop balanced even when not recording */
+	if (self->depth_dropped > 0 || self->size >= FU_PROFILE_SPANS_MAX) {
+		self->depth_dropped++;
+		return;
+	}
+
+	span = g_new0 (FuProfileSpan, 1);
+	span->name = g_strdup (name);
+	span->start = g_get_monotonic_time ();
+	span->parent = self->current;
+	span->children = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_profile_span_free);
+	if (self->current != NULL)
+		g_ptr_array_add (self->current->children, span);
+	else
+		g_ptr_array_add (self->roots, span);
+	self->current = span;
+	self->size++;
+}
+
+/* finishes the most recently started span */
+void
+fu_profile_pop (FuProfile *self)
+{
+	g_return_if_fail (FU_IS_PROFILE (self));
+
+	if (!self->enabled)
+		return;
+	if (self->depth_dropped > 0) {
+		self->depth_dropped--;
+		return;
+	}
+	if (self->current == NULL) {
+		g_warning ("profile span popped without push");
+		return;
+	}
+	self->current->end = g_get_monotonic_time ();
+	self->current = self->current->parent;
+}
+
+static void
+fu_profile_span_to_string_tree (FuProfileSpan *span, guint depth, GString *str)
+{
+	gint64 duration = fu_profile_span_get_duration (span);
+	gint width = (gint) (50 - MIN (depth * 2, 40));
+	g_string_append_printf (str, "%*s%-*s %9.2fms%s\n",
+				(gint) depth * 2, "",
+				width, span->name,
+				(gdouble) duration / 1000.f,
+				span->end == 0 ? " (running)" : "");
+	for (guint i = 0; i < span->children->len; i++) {
+		FuProfileSpan *child = g_ptr_array_index (span->children, i);
+		fu_profile_span_to_string_tree (child, depth + 1, str);
+	}
+}
+
+static void
+fu_profile_span_to_string_folded (FuProfileSpan *span, const gchar *prefix, GString *str)
+{
+	gint64 self_time = fu_profile_span_get_duration (span);
+	g_autofree gchar *name = g_strdup (span->name);
+	g_autofree gchar *path = NULL;
+
+	/* the stack separator and value delimiter are reserved */
+	g_strdelimit (name, "; ", '_');
+	path = prefix != NULL ? g_strdup_printf ("%s;%s", prefix, name) : g_strdup (name);
+
+	for (guint i = 0; i < span->children->len; i++) {
+		FuProfileSpan *child = g_ptr_array_index (span->children, i);
+		self_time -= fu_profile_span_get_duration (child);
+		fu_profile_span_to_string_folded (child, path, str);
+	}
+	if (self_time > 0) {
+		g_string_append_printf (str, "%s %" G_GINT64_FORMAT "\n",
+					path, self_time);
+	}
+}
+
+/* the folded format can be passed directly to flamegraph.pl */
+gchar *
+fu_profile_to_string (FuProfile *self, FuProfileFormat format)
+{
+	GString *str = g_string_new (NULL);
+
+	g_return_val_if_fail (FU_IS_PROFILE (self), NULL);
+
+	for (guint i = 0; i < self->roots->len; i++) {
+		FuProfileSpan *span = g_ptr_array_index (self->roots, i);
+		if (format == FU_PROFILE_FORMAT_FOLDED)
+			fu_profile_span_to_string_folded (span, NULL, str);
+		else
+			fu_profile_span_to_string_tree (span, 0, str);
+	}
+	return g_string_free (str, FALSE);
+}
+
+static void
+fu_profile_class_init (FuProfileClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_profile_finalize;
+}
+
+static void
+fu_profile_init (FuProfile *self)
+{
+	self->enabled = TRUE;
+	self->roots = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_profile_span_free);
+}
+
+static void
+fu_profile_finalize (GObject *obj)
+{
+	FuProfile *self = FU_PROFILE (obj);
+	g_ptr_array_unref (self->roots);
+	G_OBJECT_CLASS (fu_profile_parent_class)->finalize (obj);
+}
+
+FuProfile *
+fu_profile_new (void)
+{
+	FuProfile *self;
+	self = g_object_new (FU_TYPE_PROFILE, NULL);
+	return FU_PROFILE (self);
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#define FU_TYPE_PROFILE (fu_profile_get_type ())
+G_DECLARE_FINAL_TYPE (FuProfile, fu_profile, FU, PROFILE, GObject)
+
+/**
+ * FuProfileFormat:
+ * @FU_PROFILE_FORMAT_UNKNOWN:		Unknown format
+ * @FU_PROFILE_FORMAT_TREE:		Indented tree with the duration of each span
+ * @FU_PROFILE_FORMAT_FOLDED:		Folded stacks with self-time in microseconds
+ *
+ * The format to use when exporting the profile.
+ **/
+typedef enum {
+	FU_PROFILE_FORMAT_UNKNOWN,
+	FU_PROFILE_FORMAT_TREE,
+	FU_PROFILE_FORMAT_FOLDED,
+	/*< private >*/
+	FU_PROFILE_FORMAT_LAST
+} FuProfileFormat;
+
+FuProfile	*fu_profile_new			(void);
+FuProfileFormat	 fu_profile_format_from_string	(const gchar	*format);
+void		 fu_profile_set_enabled		(FuProfile	*self,
+						 gboolean	 enabled);
+gboolean	 fu_profile_get_enabled		(FuProfile	*self);
+void		 fu_profile_push		(FuProfile	*self,
+						 const gchar	*name);
+void		 fu_profile_pop			(FuProfile	*self);
+guint		 fu_profile_get_size		(FuProfile	*self);
+gchar		*fu_profile_to_string		(FuProfile	*self,
+						 FuProfileFormat format);
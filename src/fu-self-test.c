@@ -19,10 +19,13 @@
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-engine.h"
+#include "fu-engine-helper.h"
 #include "fu-history.h"
 #include "fu-install-task.h"
 #include "fu-plugin-private.h"
+#include "fu-plugin-index.h"
 #include "fu-plugin-list.h"
+#include "fu-profile.h"
 #include "fu-progressbar.h"
 #include "fu-hash.h"
 #include "fu-smbios-private.h"
@@ -1371,6 +1374,171 @@ fu_engine_install_duration_func (gconstpointer user_data)
 	g_assert_cmpint (fwupd_release_get_install_duration (rel), ==, 120);
 }
 
+static void
+fu_engine_snapshot_func (gconstpointer user_data)
+{
+	gboolean ret;
+	const gchar *version = NULL;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) devices = NULL;
+	g_autoptr(GVariant) snapshot = NULL;
+	g_autoptr(GVariant) snapshot2 = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+
+	/* add a dummy device */
+	fu_device_set_id (device, "id1");
+	fu_device_set_name (device, "Snapshot device");
+	fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+	fu_device_set_version (device, "1.2.3");
+	fu_device_add_guid (device, "12345678-1234-1234-1234-123456789012");
+	fu_engine_add_device (engine, device);
+
+	/* save and load it back */
+	ret = fu_engine_save_snapshot (engine, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	snapshot = fu_engine_load_snapshot (&error);
+	g_assert_no_error (error);
+	g_assert_nonnull (snapshot);
+	g_variant_get_child (snapshot, 0, "&s", &version);
+	g_assert_cmpstr (version, ==, SOURCE_VERSION);
+	devices = g_variant_get_child_value (snapshot, 3);
+	g_assert_cmpint (g_variant_n_children (devices), ==, 1);
+
+	/* removing a missing snapshot is not an error */
+	ret = fu_engine_remove_snapshot (&error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_engine_remove_snapshot (&error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	snapshot2 = fu_engine_load_snapshot (&error);
+	g_assert_nonnull (error);
+	g_assert_null (snapshot2);
+}
+
+static void
+fu_engine_memory_stats_hotplug (FuEngine *engine)
+{
+	g_autoptr(FuDevice) device = fu_device_new ();
+	fu_device_set_id (device, "hotplug");
+	fu_device_set_name (device, "Hotplug device");
+	fu_device_set_plugin (device, "test");
+	fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+	fu_device_set_version (device, "1.2.3");
+	fu_device_add_guid (device, "12345678-1234-1234-1234-123456789012");
+	fu_engine_add_device (engine, device);
+	fu_engine_remove_device (engine, device);
+}
+
+static void
+fu_engine_memory_stats_func (gconstpointer user_data)
+{
+	gboolean instance_counting = FALSE;
+	gint devices_before;
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GVariant) stats = NULL;
+	g_autoptr(GVariant) types = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* GObject only counts instances if enabled when the process starts */
+	stats = fu_engine_get_memory_stats ();
+	g_assert_true (g_variant_lookup (stats, "InstanceCounting", "b", &instance_counting));
+	types = g_variant_lookup_value (stats, "Types", G_VARIANT_TYPE ("aa{sv}"));
+	g_assert_nonnull (types);
+	if (!instance_counting) {
+		g_test_skip ("GOBJECT_DEBUG=instance-count not set");
+		return;
+	}
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+
+	/* the first cycle may allocate things that are cached */
+	fu_engine_memory_stats_hotplug (engine);
+	devices_before = g_type_get_instance_count (FU_TYPE_DEVICE);
+	for (guint i = 0; i < 2000; i++)
+		fu_engine_memory_stats_hotplug (engine);
+	g_assert_cmpint (g_type_get_instance_count (FU_TYPE_DEVICE), ==, devices_before);
+}
+
+typedef struct {
+	guint		 cnt;
+	guint		 last;
+} FuTestPercentageHelper;
+
+static void
+_engine_percentage_changed_cb (FuEngine *engine, guint percentage, gpointer user_data)
+{
+	FuTestPercentageHelper *helper = (FuTestPercentageHelper *) user_data;
+	helper->cnt++;
+	helper->last = percentage;
+}
+
+static void
+_engine_device_changed_cb (FuEngine *engine, FuDevice *device, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	(*cnt)++;
+}
+
+static void
+fu_engine_progress_rate_func (gconstpointer user_data)
+{
+	guint device_changed_cnt = 0;
+	FuTestPercentageHelper helper = { 0 };
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+
+	fu_device_set_id (device, "progress");
+	fu_device_add_guid (device, "12345678-1234-1234-1234-123456789012");
+	fu_engine_add_device (engine, device);
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	g_signal_connect (engine, "percentage-changed",
+			  G_CALLBACK (_engine_percentage_changed_cb),
+			  &helper);
+	g_signal_connect (engine, "device-changed",
+			  G_CALLBACK (_engine_device_changed_cb),
+			  &device_changed_cnt);
+
+	/* use a fake clock so the result does not depend on how busy the
+	 * machine is, e.g. when running under valgrind */
+	fu_engine_set_monotonic_time (engine, 10 * G_USEC_PER_SEC);
+
+	/* a packet at a time, far faster than 10Hz: only the first change
+	 * is sent as nothing has been sent before */
+	for (guint i = 0; i < 10000; i++)
+		fu_device_set_progress_full (device, i, 10000);
+	g_assert_cmpint (helper.cnt, ==, 1);
+	g_assert_cmpint (device_changed_cnt, ==, 1);
+	g_assert_cmpint (helper.last, ==, 1);
+
+	/* the end is always sent */
+	fu_device_set_progress_full (device, 10000, 10000);
+	g_assert_cmpint (helper.last, ==, 100);
+
+	/* the main loop is not run during an update, but a packet every 10ms
+	 * still has to show the progress moving once every 100ms */
+	helper.cnt = 0;
+	device_changed_cnt = 0;
+	for (guint i = 0; i < 100; i++) {
+		fu_engine_set_monotonic_time (engine, 10 * G_USEC_PER_SEC + i * 10000);
+		fu_device_set_progress_full (device, i, 100);
+	}
+	g_assert_cmpint (helper.cnt, ==, 10);
+	g_assert_cmpint (device_changed_cnt, ==, 10);
+	g_assert_cmpint (helper.last, ==, 90);
+}
+
 static void
 fu_engine_history_func (gconstpointer user_data)
 {
@@ -2269,6 +2437,82 @@ fu_plugin_list_depsolve_func (gconstpointer user_data)
 	g_assert (!fu_plugin_get_enabled (plugin));
 }
 
+static void
+fu_plugin_index_func (gconstpointer user_data)
+{
+	gboolean ret;
+	const gchar *filename = "/tmp/fwupd-self-test/var/cache/fwupd/plugins.index";
+	g_autoptr(FuPlugin) plugin1 = fu_plugin_new ();
+	g_autoptr(FuPlugin) plugin2 = fu_plugin_new ();
+	g_autoptr(FuPlugin) plugin3 = fu_plugin_new ();
+	g_autoptr(FuPlugin) plugin4 = fu_plugin_new ();
+	g_autoptr(FuPluginIndex) plugin_index = fu_plugin_index_new ();
+	g_autoptr(FuPluginIndex) plugin_index2 = fu_plugin_index_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) udev_subsystems = g_ptr_array_new ();
+	g_autoptr(GPtrArray) udev_subsystems3 = g_ptr_array_new_with_free_func (g_free);
+
+	fu_plugin_set_name (plugin1, "plugin1");
+	fu_plugin_set_open_on_demand (plugin1, TRUE);
+	fu_plugin_add_rule (plugin1, FU_PLUGIN_RULE_RUN_AFTER, "plugin2");
+	fu_plugin_set_name (plugin2, "plugin2");
+	fu_plugin_set_open_on_demand (plugin2, TRUE);
+	fu_plugin_set_name (plugin4, "plugin4");
+
+	/* nothing known */
+	ret = fu_plugin_index_load (plugin_index, filename, "key1", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!fu_plugin_index_can_defer (plugin_index, "plugin1"));
+
+	/* plugin1 found nothing, plugin2 found a device, and plugin4 found
+	 * nothing but may add devices from its own listeners */
+	g_ptr_array_add (udev_subsystems, (gpointer) "hidraw");
+	fu_plugin_index_set_udev_subsystems (plugin_index, "plugin1", udev_subsystems);
+	fu_plugin_index_add_plugin (plugin_index, plugin1, 0);
+	fu_plugin_index_add_plugin (plugin_index, plugin2, 1);
+	fu_plugin_index_add_plugin (plugin_index, plugin4, 0);
+	ret = fu_plugin_index_save (plugin_index, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* same hardware */
+	ret = fu_plugin_index_load (plugin_index2, filename, "key1", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (fu_plugin_index_can_defer (plugin_index2, "plugin1"));
+	g_assert (!fu_plugin_index_can_defer (plugin_index2, "plugin2"));
+	g_assert (!fu_plugin_index_can_defer (plugin_index2, "plugin3"));
+	g_assert (!fu_plugin_index_can_defer (plugin_index2, "plugin4"));
+
+	/* rules and subsystems are restored without opening the plugin */
+	fu_plugin_set_name (plugin3, "plugin1");
+	fu_plugin_set_udev_subsystems (plugin3, udev_subsystems3);
+	fu_plugin_index_restore (plugin_index2, plugin3);
+	g_assert (fu_plugin_has_rule (plugin3, FU_PLUGIN_RULE_RUN_AFTER, "plugin2"));
+	g_assert_cmpint (udev_subsystems3->len, ==, 1);
+	g_assert_cmpstr (g_ptr_array_index (udev_subsystems3, 0), ==, "hidraw");
+
+	/* a load that did not finish does not trust the old index */
+	ret = fu_plugin_index_invalidate (plugin_index2, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (fu_plugin_index_can_defer (plugin_index2, "plugin1"));
+	ret = fu_plugin_index_load (plugin_index, filename, "key1", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!fu_plugin_index_can_defer (plugin_index, "plugin1"));
+	ret = fu_plugin_index_save (plugin_index2, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* different hardware */
+	ret = fu_plugin_index_load (plugin_index2, filename, "key2", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!fu_plugin_index_can_defer (plugin_index2, "plugin1"));
+}
+
 static void
 fu_history_migrate_func (gconstpointer user_data)
 {
@@ -2347,6 +2591,8 @@ fu_plugin_module_func (gconstpointer user_data)
 	g_autoptr(GBytes) blob_cab = NULL;
 	g_autoptr(GMappedFile) mapped_file = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+	g_autoptr(GString) stats_str = NULL;
+	g_autoptr(GVariant) stats = NULL;
 
 	/* no metadata in daemon */
 	fu_engine_set_silo (engine, silo_empty);
@@ -2366,6 +2612,13 @@ fu_plugin_module_func (gconstpointer user_data)
 	g_assert_no_error (error);
 	g_assert (ret);
 
+	/* each hook that was run has been recorded */
+	stats = fu_plugin_get_stats (self->plugin);
+	g_assert_cmpint (g_variant_n_children (stats), >=, 1);
+	stats_str = g_string_new (NULL);
+	fu_plugin_add_stats_string (self->plugin, 0, stats_str);
+	g_assert_nonnull (g_strstr_len (stats_str->str, -1, "coldplug:"));
+
 	/* check we did the right thing */
 	g_assert (device != NULL);
 	g_assert_cmpstr (fu_device_get_id (device), ==, "08d460be0f1f9f128413f816022a6439e0078018");
@@ -2462,6 +2715,66 @@ fu_plugin_module_func (gconstpointer user_data)
 	g_unlink (pending_cap);
 }
 
+static void
+fu_profile_func (gconstpointer user_data)
+{
+	g_autofree gchar *folded = NULL;
+	g_autofree gchar *tree = NULL;
+	g_auto(GStrv) folded_lines = NULL;
+	g_auto(GStrv) lines = NULL;
+	g_autoptr(FuProfile) profile = fu_profile_new ();
+
+	/* nested spans, with a name using the reserved separators */
+	fu_profile_push (profile, "load");
+	fu_profile_push (profile, "plugins");
+	fu_profile_push (profile, "dell esrt;1");
+	g_usleep (2000);
+	fu_profile_pop (profile);
+	fu_profile_pop (profile);
+	g_usleep (1000);
+	fu_profile_pop (profile);
+	g_assert_cmpint (fu_profile_get_size (profile), ==, 3);
+
+	/* tree is indented by depth */
+	tree = fu_profile_to_string (profile, FU_PROFILE_FORMAT_TREE);
+	g_test_message ("%s", tree);
+	lines = g_strsplit (tree, "\n", -1);
+	g_assert_cmpint (g_strv_length (lines), ==, 4);
+	g_assert_true (g_str_has_prefix (lines[0], "load "));
+	g_assert_true (g_str_has_prefix (lines[1], "  plugins "));
+	g_assert_true (g_str_has_prefix (lines[2], "    dell esrt;1 "));
+	g_assert_true (g_str_has_suffix (lines[2], "ms"));
+	g_assert_cmpstr (lines[3], ==, "");
+	g_assert_null (g_strstr_len (tree, -1, "running"));
+	g_assert_cmpfloat (g_ascii_strtod (lines[0] + 4, NULL), >=, 3.f);
+	g_assert_cmpfloat (g_ascii_strtod (lines[2] + 16, NULL), >=, 2.f);
+
+	/* folded stacks only show self-time, leaf first */
+	folded = fu_profile_to_string (profile, FU_PROFILE_FORMAT_FOLDED);
+	g_test_message ("%s", folded);
+	folded_lines = g_strsplit (folded, "\n", -1);
+	g_assert_cmpint (g_strv_length (folded_lines), >=, 3);
+	g_assert_true (g_str_has_prefix (folded_lines[0], "load;plugins;dell_esrt_1 "));
+	g_assert_cmpint (g_ascii_strtoull (folded_lines[0] + 25, NULL, 10), >=, 2000);
+	for (guint i = 0; folded_lines[i] != NULL; i++) {
+		const gchar *value;
+		if (folded_lines[i][0] == '\0')
+			continue;
+		value = g_strrstr (folded_lines[i], " ");
+		g_assert_nonnull (value);
+		g_assert_cmpint (g_ascii_strtoull (value + 1, NULL, 10), >, 0);
+		if (g_str_has_prefix (folded_lines[i], "load "))
+			g_assert_cmpint (g_ascii_strtoull (value + 1, NULL, 10), >=, 1000);
+	}
+	g_assert_nonnull (g_strstr_len (folded, -1, "\nload "));
+
+	/* nothing recorded when disabled */
+	fu_profile_set_enabled (profile, FALSE);
+	fu_profile_push (profile, "hotplug");
+	fu_profile_pop (profile);
+	g_assert_cmpint (fu_profile_get_size (profile), ==, 3);
+}
+
 static void
 fu_history_func (gconstpointer user_data)
 {
@@ -2961,6 +3274,12 @@ main (int argc, char **argv)
 			      fu_engine_device_unlock_func);
 	g_test_add_data_func ("/fwupd/engine{multiple-releases}", self,
 			      fu_engine_multiple_rels_func);
+	g_test_add_data_func ("/fwupd/engine{snapshot}", self,
+			      fu_engine_snapshot_func);
+	g_test_add_data_func ("/fwupd/engine{memory-stats}", self,
+			      fu_engine_memory_stats_func);
+	g_test_add_data_func ("/fwupd/engine{progress-rate}", self,
+			      fu_engine_progress_rate_func);
 	g_test_add_data_func ("/fwupd/engine{history-success}", self,
 			      fu_engine_history_func);
 	g_test_add_data_func ("/fwupd/engine{history-error}", self,
@@ -3013,6 +3332,8 @@ main (int argc, char **argv)
 			      fu_engine_requirements_other_device_func);
 	g_test_add_data_func ("/fwupd/plugin{composite}", self,
 			      fu_plugin_composite_func);
+	g_test_add_data_func ("/fwupd/profile", self,
+			      fu_profile_func);
 	g_test_add_data_func ("/fwupd/history", self,
 			      fu_history_func);
 	g_test_add_data_func ("/fwupd/history{migrate}", self,
@@ -3021,5 +3342,7 @@ main (int argc, char **argv)
 			      fu_plugin_list_func);
 	g_test_add_data_func ("/fwupd/plugin-list{depsolve}", self,
 			      fu_plugin_list_depsolve_func);
+	g_test_add_data_func ("/fwupd/plugin-index", self,
+			      fu_plugin_index_func);
 	return g_test_run ();
 }
@@ -266,16 +266,33 @@ fu_util_get_plugins (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	GPtrArray *plugins;
 	guint cnt = 0;
+	gboolean verbose = g_getenv ("FWUPD_VERBOSE") != NULL;
 
-	/* load engine */
-	if (!fu_engine_load_plugins (priv->engine, error))
-		return FALSE;
+	/* load engine, running the plugin startup if the statistics are
+	 * wanted; devices are not enumerated so the daemon can keep running */
+	if (verbose) {
+		if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, error))
+			return FALSE;
+	} else {
+		if (!fu_engine_load_plugins (priv->engine, error))
+			return FALSE;
+	}
 
 	/* print */
 	plugins = fu_engine_get_plugins (priv->engine);
 	g_ptr_array_sort (plugins, (GCompareFunc) fu_util_plugin_name_sort_cb);
 	for (guint i = 0; i < plugins->len; i++) {
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		if (verbose) {
+			g_autoptr(GString) str = g_string_new (NULL);
+			/* show plugins that disabled themselves on failure */
+			g_print ("%s%s\n", fu_plugin_get_name (plugin),
+				 fu_plugin_get_enabled (plugin) ? "" : " (disabled)");
+			fu_plugin_add_stats_string (plugin, 1, str);
+			g_print ("%s", str->str);
+			cnt++;
+			continue;
+		}
 		if (!fu_plugin_get_enabled (plugin))
 			continue;
 		g_print ("%s\n", fu_plugin_get_name (plugin));
@@ -638,7 +655,7 @@ fu_util_install_blob (FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* parse blob */
-	blob_fw = fu_common_get_contents_bytes (values[0], error);
+	blob_fw = fu_common_get_contents_bytes_mapped (values[0], error);
 	if (blob_fw == NULL) {
 		fu_util_maybe_prefix_sandbox_error (values[0], error);
 		return FALSE;
@@ -853,7 +870,7 @@ fu_util_install (FuUtilPrivate *priv, gchar **values, GError **error)
 		return FALSE;
 
 	/* parse silo */
-	blob_cab = fu_common_get_contents_bytes (filename, error);
+	blob_cab = fu_common_get_contents_bytes_mapped (filename, error);
 	if (blob_cab == NULL) {
 		fu_util_maybe_prefix_sandbox_error (filename, error);
 		return FALSE;
@@ -1917,6 +1934,8 @@ main (int argc, char *argv[])
 	g_autoptr(GPtrArray) cmd_array = fu_util_cmd_array_new ();
 	g_autofree gchar *cmd_descriptions = NULL;
 	g_autofree gchar *filter = NULL;
+	g_autofree gchar *profile = NULL;
+	FuProfileFormat profile_format = FU_PROFILE_FORMAT_UNKNOWN;
 	const GOptionEntry options[] = {
 		{ "version", '\0', 0, G_OPTION_ARG_NONE, &version,
 			/* TRANSLATORS: command line option */
@@ -1958,6 +1977,10 @@ main (int argc, char *argv[])
 			/* TRANSLATORS: command line option */
 			_("Filter with a set of device flags using a ~ prefix to "
 			  "exclude, e.g. 'internal,~needs-reboot'"), NULL },
+		{ "profile", '\0', 0, G_OPTION_ARG_STRING, &profile,
+			/* TRANSLATORS: command line option */
+			_("Show how long each startup phase took, "
+			  "as either 'tree' or 'folded'"), "FORMAT" },
 		{ NULL}
 	};
 
@@ -2205,6 +2228,16 @@ main (int argc, char *argv[])
 	}
 
 
+	/* parse the profile format before doing anything slow */
+	if (profile != NULL) {
+		profile_format = fu_profile_format_from_string (profile);
+		if (profile_format == FU_PROFILE_FORMAT_UNKNOWN) {
+			/* TRANSLATORS: the user didn't read the man page */
+			g_print ("%s: %s\n", _("Unknown profile format"), profile);
+			return EXIT_FAILURE;
+		}
+	}
+
 	/* set flags */
 	if (allow_reinstall)
 		priv->flags |= FWUPD_INSTALL_FLAG_ALLOW_REINSTALL;
@@ -2241,6 +2274,14 @@ main (int argc, char *argv[])
 
 	/* run the specified command */
 	ret = fu_util_cmd_array_run (cmd_array, priv, argv[1], (gchar**) &argv[2], &error);
+
+	/* show the startup profile even if the command failed */
+	if (profile_format != FU_PROFILE_FORMAT_UNKNOWN) {
+		g_autofree gchar *tmp = NULL;
+		tmp = fu_profile_to_string (fu_engine_get_profile (priv->engine),
+					    profile_format);
+		g_printerr ("%s", tmp);
+	}
 	if (!ret) {
 		if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_ARGS)) {
 			g_autofree gchar *tmp = NULL;
@@ -2302,6 +2302,67 @@ fu_util_get_approved_firmware (FuUtilPrivate *priv, gchar **values, GError **err
 	return TRUE;
 }
 
+static gboolean
+fu_util_get_memory_stats (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	gboolean instance_counting = FALSE;
+	guint64 tmp = 0;
+	g_autoptr(GVariant) stats = NULL;
+	g_autoptr(GVariant) types = NULL;
+
+	/* check args */
+	if (g_strv_length (values) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments: none expected");
+		return FALSE;
+	}
+
+	/* call into daemon */
+	stats = fwupd_client_get_memory_stats (priv->client,
+					       priv->cancellable,
+					       error);
+	if (stats == NULL)
+		return FALSE;
+	if (g_variant_lookup (stats, "ResidentSetSize", "t", &tmp)) {
+		g_autofree gchar *str = g_format_size (tmp * 1024);
+		/* TRANSLATORS: memory used by the daemon right now */
+		g_print ("%s: %s\n", _("Resident set size"), str);
+	}
+	if (g_variant_lookup (stats, "ResidentSetSizePeak", "t", &tmp)) {
+		g_autofree gchar *str = g_format_size (tmp * 1024);
+		/* TRANSLATORS: the most memory used by the daemon */
+		g_print ("%s: %s\n", _("Peak resident set size"), str);
+	}
+	if (g_variant_lookup (stats, "HeapUsed", "t", &tmp)) {
+		g_autofree gchar *str = g_format_size (tmp);
+		/* TRANSLATORS: memory allocated with malloc() */
+		g_print ("%s: %s\n", _("Heap used"), str);
+	}
+	g_variant_lookup (stats, "InstanceCounting", "b", &instance_counting);
+	if (!instance_counting) {
+		/* TRANSLATORS: the daemon has to be restarted to count objects,
+		 * do not translate the environment variable */
+		g_print ("%s\n", _("Start the daemon with GOBJECT_DEBUG=instance-count "
+				    "set to show the number of objects."));
+		return TRUE;
+	}
+	types = g_variant_lookup_value (stats, "Types", G_VARIANT_TYPE ("aa{sv}"));
+	for (gsize i = 0; types != NULL && i < g_variant_n_children (types); i++) {
+		const gchar *name = NULL;
+		guint32 instances = 0;
+		g_autofree gchar *str = NULL;
+		g_autoptr(GVariant) child = g_variant_get_child_value (types, i);
+		g_variant_lookup (child, "Type", "&s", &name);
+		g_variant_lookup (child, "Instances", "u", &instances);
+		g_variant_lookup (child, "Bytes", "t", &tmp);
+		str = g_format_size (tmp);
+		g_print ("  %-32s %6u %s\n", name, instances, str);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_modify_config (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -2644,6 +2705,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: firmware approved by the admin */
 		     _("Sets the list of approved firmware."),
 		     fu_util_set_approved_firmware);
+	fu_util_cmd_array_add (cmd_array,
+		     "get-memory-stats",
+		     NULL,
+		     /* TRANSLATORS: command description */
+		     _("Gets the memory used by the daemon."),
+		     fu_util_get_memory_stats);
 	fu_util_cmd_array_add (cmd_array,
 		     "modify-config",
 		     "KEY,VALUE",